@@ -6,17 +6,24 @@ endif()
 function(compile_shader)
     set(options)
     set(oneValueArgs SHADER SPIRV)
-    set(multiValueArgs)
+    set(multiValueArgs DEPENDS DEFINES)
     cmake_parse_arguments(
         GLSLC_SHADER "${options}" "${oneValueArgs}" "${multiValueArgs}" ${ARGN}
     )
 
+    set(GLSLC_DEFINES)
+    foreach(DEFINE IN LISTS GLSLC_SHADER_DEFINES)
+        list(APPEND GLSLC_DEFINES -D${DEFINE})
+    endforeach()
+
     add_custom_command(
         OUTPUT ${GLSLC_SHADER_SPIRV}
         COMMAND ${GLSLC_EXE}
             $<$<OR:$<CONFIG:RelWithDebInfo>,$<CONFIG:Release>>:-O> # Optimize in RelWithDebInfo and Release
             $<$<OR:$<CONFIG:Debug>,$<CONFIG:RelWithDebInfo>>:-g> # Add debug information in Debug or RelWithDebInfo
+            --target-env=vulkan1.3
+            ${GLSLC_DEFINES}
             ${GLSLC_SHADER_SHADER} -o ${GLSLC_SHADER_SPIRV}
-        DEPENDS ${GLSLC_SHADER_SHADER}
+        DEPENDS ${GLSLC_SHADER_SHADER} ${GLSLC_SHADER_DEPENDS}
     )
 endfunction()
@@ -0,0 +1,64 @@
+#ifndef ADAPTIVE_GLSL
+#define ADAPTIVE_GLSL
+
+#include "scene.glsl"
+
+const uint adaptiveTileSize = 16u;
+
+// Pixels are never considered converged before this many samples, variance
+// estimates of the first few samples are unreliable
+const uint adaptiveMinSamples = 16u;
+
+// Running luminance statistics of every pixel, x is the mean, y the sum of
+// squared differences from the mean and z the sample count
+layout(rgba32f, set = 0, binding = 5) uniform image2D variance;
+
+// Indirect dispatch arguments followed by tiles that haven't converged yet,
+// packed as x | y << 16. Run identifies the accumulation the statistics
+// were gathered for, it's set by the host.
+layout(std430, set = 0, binding = 6) buffer TileBuffer {
+    uint groupCountX;
+    uint groupCountY;
+    uint groupCountZ;
+    uint activePixels;
+    uint run;
+    uint pad0;
+    uint pad1;
+    uint pad2;
+    uint tiles[];
+} tileList;
+
+float luminance(vec3 color) {
+    return dot(color, vec3(0.2126, 0.7152, 0.0722));
+}
+
+vec4 loadStatistics(ivec2 texelCoord) {
+    return pc.totalSamples == 0 ? vec4(0) : imageLoad(variance, texelCoord);
+}
+
+// Welford's online update of mean and variance
+vec4 addSample(vec4 statistics, vec3 color) {
+    float l = luminance(color);
+    statistics.z += 1.0;
+    float delta = l - statistics.x;
+    statistics.x += delta / statistics.z;
+    statistics.y += delta * (l - statistics.x);
+    return statistics;
+}
+
+// Relative standard error of the mean luminance is below the threshold
+bool converged(vec4 statistics) {
+    if (pc.adaptiveThreshold <= 0.0 || statistics.z < adaptiveMinSamples) {
+        return false;
+    }
+
+    float variance = statistics.y / (statistics.z - 1.0);
+    float error = sqrt(variance / statistics.z);
+    return error <= pc.adaptiveThreshold * (statistics.x + 1e-3);
+}
+
+ivec2 tileOrigin(uint tile) {
+    return ivec2(tile & 0xFFFFu, tile >> 16u) * int(adaptiveTileSize);
+}
+
+#endif
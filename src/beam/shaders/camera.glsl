@@ -0,0 +1,69 @@
+#ifndef CAMERA_GLSL
+#define CAMERA_GLSL
+
+#include "random.glsl"
+#include "scene.glsl"
+
+struct Camera
+{
+    vec3 pixel00;
+    vec3 pixelDeltaU;
+    vec3 pixelDeltaV;
+    vec3 defocusDiskU;
+    vec3 defocusDiskV;
+};
+
+Camera makeCamera(ivec2 imageSize) {
+    float aspectRatio = float(imageSize.x) / imageSize.y;
+
+    vec3 w = normalize(frame.cameraPosition - frame.cameraFront);
+    vec3 u = normalize(cross(frame.cameraUp, w));
+    vec3 v = cross(w, u);
+
+    float theta = radians(frame.fovy);
+    float h = tan(theta / 2);
+
+    float viewportHeight = 2 * h * frame.focusDistance;
+    float viewportWidth = viewportHeight * aspectRatio;
+
+    vec3 viewportU = viewportWidth * u;
+    vec3 viewportV = viewportHeight * -v;
+
+    Camera c;
+    c.pixelDeltaU = viewportU / imageSize.x;
+    c.pixelDeltaV = viewportV / imageSize.y;
+
+    vec3 viewportUpperLeft = frame.cameraPosition
+                             - frame.focusDistance * w - viewportU / 2 - viewportV / 2;
+
+    c.pixel00 = viewportUpperLeft + 0.5 * (c.pixelDeltaU + c.pixelDeltaV);
+
+    float defocusRadius = frame.focusDistance * tan(radians(frame.defocusAngle / 2));
+    c.defocusDiskU = u * defocusRadius;
+    c.defocusDiskV = v * defocusRadius;
+
+    return c;
+}
+
+vec3 sampleSquare() {
+    return vec3(randomVec2() - 0.5, 0);
+}
+
+vec3 defocusDiskSample(vec3 defocusDiskU, vec3 defocusDiskV) {
+    vec2 p = randomInUnitDisk();
+    return frame.cameraPosition + p.x * defocusDiskU + p.y * defocusDiskV;
+}
+
+Ray getRay(Camera c, ivec2 texelCoord) {
+    vec3 offset = sampleSquare();
+    vec3 texsample = c.pixel00
+        + (texelCoord.x + offset.x) * c.pixelDeltaU
+        + (texelCoord.y + offset.y) * c.pixelDeltaV;
+
+    vec3 origin = (frame.defocusAngle <= 0 || pc.totalSamples == 0) ? frame.cameraPosition : defocusDiskSample(c.defocusDiskU, c.defocusDiskV);
+    vec3 direction = texsample - origin;
+
+    return Ray(origin, direction);
+}
+
+#endif
@@ -0,0 +1,31 @@
+#ifndef FEATURES_GLSL
+#define FEATURES_GLSL
+
+#include "scene.glsl"
+
+// Distance stored for rays that miss the scene, keeps the sky in a single
+// depth layer for the denoiser
+const float missDepth = 1e6;
+
+// First hit surface properties of every pixel used as edge stopping guides
+// by the denoiser. Normal in xyz and distance from the camera in w.
+layout(rgba16f, set = 0, binding = 7) uniform writeonly image2D albedo;
+layout(rgba32f, set = 0, binding = 8) uniform writeonly image2D normalDepth;
+
+void storeFeatures(ivec2 texelCoord, Ray r, HitRecord rec) {
+    // Dielectrics don't tint the light passing through them
+    vec3 color = rec.material >= frame.materialCount ||
+            materialType(rec.material) == dielectricMaterial
+        ? vec3(1)
+        : mat.materials[rec.material].color;
+
+    imageStore(albedo, texelCoord, vec4(color, 1.0));
+    imageStore(normalDepth, texelCoord, vec4(rec.normal, distance(r.origin, rec.p)));
+}
+
+void storeMissFeatures(ivec2 texelCoord, Ray r) {
+    imageStore(albedo, texelCoord, vec4(skyColor(r.direction), 1.0));
+    imageStore(normalDepth, texelCoord, vec4(-normalize(r.direction), missDepth));
+}
+
+#endif
@@ -0,0 +1,84 @@
+#ifndef LIGHTS_GLSL
+#define LIGHTS_GLSL
+
+#include "random.glsl"
+#include "scene.glsl"
+
+// Indices of spheres with an emissive material
+layout(std430, set = 0, binding = 9) readonly buffer LightBuffer {
+    uint spheres[];
+} lights;
+
+vec3 emission(HitRecord rec) {
+    return rec.frontFace ? mat.materials[rec.material].color * materialValue(rec.material) : vec3(0);
+}
+
+float powerHeuristic(float pdf, float otherPdf) {
+    float p2 = pdf * pdf;
+    return p2 / (p2 + otherPdf * otherPdf);
+}
+
+// Sine of the half angle of the cone the sphere subtends from the point,
+// squared. Values of 1 or more mean the point is inside the sphere.
+float sinThetaMax2(Sphere s, vec3 p) {
+    vec3 toCenter = s.center - p;
+    return s.radius * s.radius / dot(toCenter, toCenter);
+}
+
+// Solid angle density of picking the light and sampling its cone from the
+// point, zero when lights aren't sampled
+float lightPdf(uint sphere, vec3 p) {
+    float sin2 = sinThetaMax2(loadSphere(sphere), p);
+    if (frame.lightCount == 0 || sin2 >= 1.0) {
+        return 0.0;
+    }
+
+    float cosThetaMax = sqrt(1.0 - sin2);
+    return 1.0 / (2.0 * pi * (1.0 - cosThetaMax) * frame.lightCount);
+}
+
+// Direct light of a randomly picked light on a lambertian surface. A
+// direction is sampled uniformly in the cone the light subtends and traced
+// as a shadow ray, the result is weighted against scattering towards the
+// same light with the power heuristic.
+vec3 sampleLight(HitRecord rec, vec3 albedo) {
+    uint sphere = lights.spheres[min(uint(randomFloat() * frame.lightCount), frame.lightCount - 1)];
+    Sphere s = loadSphere(sphere);
+
+    float sin2 = sinThetaMax2(s, rec.p);
+    if (sin2 >= 1.0) {
+        return vec3(0);
+    }
+
+    float cosThetaMax = sqrt(1.0 - sin2);
+    vec2 xi = randomVec2();
+    float cosTheta = 1.0 - xi.x * (1.0 - cosThetaMax);
+    float sinTheta = sqrt(max(0.0, 1.0 - cosTheta * cosTheta));
+    float phi = 2.0 * pi * xi.y;
+
+    vec3 w = normalize(s.center - rec.p);
+    vec3 u = normalize(cross(abs(w.x) > 0.9 ? vec3(0, 1, 0) : vec3(1, 0, 0), w));
+    vec3 v = cross(w, u);
+    vec3 direction = (cos(phi) * u + sin(phi) * v) * sinTheta + w * cosTheta;
+
+    float cosSurface = dot(direction, rec.normal);
+    if (cosSurface <= 0.0) {
+        return vec3(0);
+    }
+
+    // Sphere and triangle materials are disjoint, the material tells a hit of
+    // the light apart from a triangle with the same index
+    HitRecord shadow;
+    if (!hitWorld(Ray(rec.p, direction), Interval(0.001, posInf), shadow) ||
+        shadow.primitive != sphere || shadow.material != sphereMaterials.materials[sphere]) {
+        return vec3(0);
+    }
+
+    float pdf = lightPdf(sphere, rec.p);
+    float bsdfPdf = cosSurface / pi;
+    vec3 brdf = albedo / pi;
+
+    return emission(shadow) * brdf * cosSurface / pdf * powerHeuristic(pdf, bsdfPdf);
+}
+
+#endif
@@ -0,0 +1,87 @@
+#ifndef MATERIAL_GLSL
+#define MATERIAL_GLSL
+
+#include "random.glsl"
+#include "scene.glsl"
+
+// Bit per material type present in the scene. Specialized variants of the
+// megakernel drop the code of types the scene doesn't use.
+layout (constant_id = 5) const uint materialMask = ~0u;
+
+bool hasMaterial(uint type) {
+    return (materialMask & (1u << type)) != 0u;
+}
+
+bool nearZero(vec3 direction) {
+    float eps = 1e-8;
+
+    direction = abs(direction);
+
+    return direction.x < eps && direction.y < eps && direction.z < eps;
+}
+
+float reflectance(float cosine, float refractionIndex) {
+    float r0 = (1 - refractionIndex) / (1 + refractionIndex);
+    r0 = r0 * r0;
+    return r0 + (1 - r0) * pow((1 - cosine), 5);
+}
+
+// Callers that already know the material type of the hit can pass it in
+// directly, e.g. when all invocations shade the same type
+bool scatter(uint type, Ray r, HitRecord rec, out vec3 attenuation, out Ray scattered) {
+    if (hasMaterial(lambertianMaterial) && type == lambertianMaterial) {
+        vec3 scatterDirection = rec.normal + randomNormVec3();
+
+        if (nearZero(scatterDirection)) {
+            scatterDirection = rec.normal;
+        }
+
+        scattered = Ray(rec.p, scatterDirection);
+        attenuation = mat.materials[rec.material].color;
+
+        return true;
+    }
+    
+    if (hasMaterial(metalMaterial) && type == metalMaterial) {
+        vec3 reflected = reflect(r.direction, rec.normal);
+        reflected = normalize(reflected + (materialValue(rec.material) * randomNormVec3()));
+
+        scattered = Ray(rec.p, reflected);
+        attenuation = mat.materials[rec.material].color;
+
+        return dot(scattered.direction, rec.normal) > 0;
+    }
+
+    if (hasMaterial(dielectricMaterial) && type == dielectricMaterial) {            
+        float ri = rec.frontFace ? (1.0 / materialValue(rec.material)) : materialValue(rec.material);
+
+        vec3 unitDirection = normalize(r.direction);
+        float cosTheta = min(dot(-unitDirection, rec.normal), 1.0);
+        float sinTheta = sqrt(1.0 - cosTheta * cosTheta);
+
+        bool cannotRefract = ri * sinTheta > 1.0;
+        vec3 direction;
+
+        if (cannotRefract || reflectance(cosTheta, ri) > randomFloat())
+            direction = reflect(unitDirection, rec.normal);
+        else
+            direction = refract(unitDirection, rec.normal, ri);
+
+        attenuation = vec3(1.0);
+        scattered = Ray(rec.p, direction);
+
+        return true;
+    }
+
+    return false;
+}
+
+bool scatter(Ray r, HitRecord rec, out vec3 attenuation, out Ray scattered) {
+    if (rec.material >= frame.materialCount) {
+        return false;
+    }
+
+    return scatter(materialType(rec.material), r, rec, attenuation, scattered);
+}
+
+#endif
@@ -0,0 +1,134 @@
+#ifndef RANDOM_GLSL
+#define RANDOM_GLSL
+
+#include "scene.glsl"
+
+const float pi = 3.14159265358979;
+
+// https://www.reedbeta.com/blog/hash-functions-for-gpu-rendering/
+uint hashPCG(uint x) {
+    uint state = x * 747796405u + 2891336453u;
+    uint word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+    return (word >> 22u) ^ word;
+}
+
+// Direction numbers of the first four Sobol dimensions, 32 per dimension
+const uint sobolDirections[128] = uint[](
+    0x80000000u, 0x40000000u, 0x20000000u, 0x10000000u,
+    0x08000000u, 0x04000000u, 0x02000000u, 0x01000000u,
+    0x00800000u, 0x00400000u, 0x00200000u, 0x00100000u,
+    0x00080000u, 0x00040000u, 0x00020000u, 0x00010000u,
+    0x00008000u, 0x00004000u, 0x00002000u, 0x00001000u,
+    0x00000800u, 0x00000400u, 0x00000200u, 0x00000100u,
+    0x00000080u, 0x00000040u, 0x00000020u, 0x00000010u,
+    0x00000008u, 0x00000004u, 0x00000002u, 0x00000001u,
+    0x80000000u, 0xc0000000u, 0xa0000000u, 0xf0000000u,
+    0x88000000u, 0xcc000000u, 0xaa000000u, 0xff000000u,
+    0x80800000u, 0xc0c00000u, 0xa0a00000u, 0xf0f00000u,
+    0x88880000u, 0xcccc0000u, 0xaaaa0000u, 0xffff0000u,
+    0x80008000u, 0xc000c000u, 0xa000a000u, 0xf000f000u,
+    0x88008800u, 0xcc00cc00u, 0xaa00aa00u, 0xff00ff00u,
+    0x80808080u, 0xc0c0c0c0u, 0xa0a0a0a0u, 0xf0f0f0f0u,
+    0x88888888u, 0xccccccccu, 0xaaaaaaaau, 0xffffffffu,
+    0x80000000u, 0xc0000000u, 0x60000000u, 0x90000000u,
+    0xe8000000u, 0x5c000000u, 0x8e000000u, 0xc5000000u,
+    0x68800000u, 0x9cc00000u, 0xee600000u, 0x55900000u,
+    0x80680000u, 0xc09c0000u, 0x60ee0000u, 0x90550000u,
+    0xe8808000u, 0x5cc0c000u, 0x8e606000u, 0xc5909000u,
+    0x6868e800u, 0x9c9c5c00u, 0xeeee8e00u, 0x5555c500u,
+    0x8000e880u, 0xc0005cc0u, 0x60008e60u, 0x9000c590u,
+    0xe8006868u, 0x5c009c9cu, 0x8e00eeeeu, 0xc5005555u,
+    0x80000000u, 0xc0000000u, 0x20000000u, 0x50000000u,
+    0xf8000000u, 0x74000000u, 0xa2000000u, 0x93000000u,
+    0xd8800000u, 0x25400000u, 0x59e00000u, 0xe6d00000u,
+    0x78080000u, 0xb40c0000u, 0x82020000u, 0xc3050000u,
+    0x208f8000u, 0x51474000u, 0xfbea2000u, 0x75d93000u,
+    0xa0858800u, 0x914e5400u, 0xdbe79e00u, 0x25db6d00u,
+    0x58800080u, 0xe54000c0u, 0x79e00020u, 0xb6d00050u,
+    0x800800f8u, 0xc00c0074u, 0x200200a2u, 0x50050093u
+);
+
+uint sobol(uint index, uint dimension) {
+    uint x = 0u;
+    for (uint bit = 0u; index != 0u; index >>= 1u, ++bit) {
+        if ((index & 1u) != 0u) {
+            x ^= sobolDirections[dimension * 32u + bit];
+        }
+    }
+    return x;
+}
+
+uint laineKarrasPermutation(uint x, uint seed) {
+    x += seed;
+    x ^= x * 0x6c50b47cu;
+    x ^= x * 0xb82f1e52u;
+    x ^= x * 0xc7afe638u;
+    x ^= x * 0x8d22f6e6u;
+    return x;
+}
+
+// Owen scrambling of the bits from the most significant one down
+uint nestedUniformScramble(uint x, uint seed) {
+    x = bitfieldReverse(x);
+    x = laineKarrasPermutation(x, seed);
+    return bitfieldReverse(x);
+}
+
+// Owen scrambled Sobol sequence with hash based scrambling, Burley 2020
+// "Practical Hash-based Owen Scrambling". Every pixel has its own scramble
+// of the sequence, dimensions past the first four are padded with
+// independently shuffled copies of them. Consecutive sample indices of a
+// pixel stay well stratified, there are no rejection loops.
+uint samplerSeed;
+uint samplerIndex;
+uint samplerDimension;
+
+void initSampler(ivec2 texelCoord, uint sampleIndex) {
+    samplerSeed = hashPCG(uint(texelCoord.x) + hashPCG(uint(texelCoord.y) + hashPCG(frame.sequenceSeed)));
+    samplerIndex = sampleIndex;
+    samplerDimension = 0u;
+}
+
+float randomFloat() {
+    uint dimension = samplerDimension & 3u;
+    uint seed = hashPCG(samplerSeed ^ hashPCG(samplerDimension >> 2u));
+    ++samplerDimension;
+
+    uint index = nestedUniformScramble(samplerIndex, seed);
+    uint x = nestedUniformScramble(sobol(index, dimension), hashPCG(seed + dimension));
+
+    // 24 bits keep the result below 1 after conversion
+    return float(x >> 8u) / 16777216.0;
+}
+
+// Both coordinates come from the same pair of dimensions of a padding group
+vec2 randomVec2() {
+    samplerDimension += samplerDimension & 1u;
+    float x = randomFloat();
+    return vec2(x, randomFloat());
+}
+
+vec3 randomNormVec3() {
+    vec2 u = randomVec2();
+    float z = 1.0 - 2.0 * u.x;
+    float r = sqrt(max(0.0, 1.0 - z * z));
+    float phi = 2.0 * pi * u.y;
+    return vec3(r * cos(phi), r * sin(phi), z);
+}
+
+vec3 randomOnHemisphere(vec3 normal) {
+    vec3 onUnitSphere = randomNormVec3();
+    if (dot(onUnitSphere, normal) > 0.0) {
+        return onUnitSphere;
+    }
+    return -onUnitSphere;
+}
+
+vec2 randomInUnitDisk() {
+    vec2 u = randomVec2();
+    float r = sqrt(u.x);
+    float phi = 2.0 * pi * u.y;
+    return vec2(r * cos(phi), r * sin(phi));
+}
+
+#endif
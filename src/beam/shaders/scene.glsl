@@ -0,0 +1,441 @@
+#ifndef SCENE_GLSL
+#define SCENE_GLSL
+
+uint uintMax = ~0;
+
+float posInf = 1.0 / 0.0;
+float negInf = -1.0 / 0.0;
+
+// Values that change between dispatches of a frame
+layout(push_constant) uniform PushConsts {
+    uint samplesPerPixel;
+    uint totalSamples;
+    uint useBvh;
+    uint bounce;
+    uint sampleIndex;
+    uint wavefrontStage;
+    uint materialBins;
+    uint shadeMaterial;
+    float adaptiveThreshold;
+    uint rowOffset;
+} pc;
+
+// Parameters shared by all dispatches of a frame, previous camera is the one
+// accumulated history was rendered with
+layout(std140, set = 0, binding = 10) uniform FrameUniforms {
+    vec3 cameraPosition;
+    uint worldCount;
+    vec3 cameraFront;
+    uint materialCount;
+    vec3 cameraUp;
+    uint maxDepth;
+    vec3 previousPosition;
+    float defocusAngle;
+    vec3 previousFront;
+    float focusDistance;
+    vec3 previousUp;
+    float fovy;
+    uint sequenceSeed;
+    uint triangleCount;
+    uint triangleRoot;
+    uint lightCount;
+    float skyIntensity;
+} frame;
+
+layout(rgba32f, set = 0, binding = 0) uniform image2D image;
+
+struct Sphere
+{
+    vec3 center;
+    float radius;
+};
+
+// Center in xyz and radius in w, the only sphere data intersection tests read
+layout(std430, binding = 1) readonly buffer WorldBuffer {
+    vec4 spheres[];
+} world;
+
+// Material index of each sphere, read once for the closest hit
+layout(std430, binding = 11) readonly buffer SphereMaterialBuffer {
+    uint materials[];
+} sphereMaterials;
+
+Sphere loadSphere(uint i) {
+    vec4 s = world.spheres[i];
+    return Sphere(s.xyz, s.w);
+}
+
+const uint lambertianMaterial = 0u;
+const uint metalMaterial = 1u;
+const uint dielectricMaterial = 2u;
+const uint materialTypeCount = 3u;
+// Emitters end paths, they aren't scattered and have no wavefront shade queue
+const uint emissiveMaterial = 3u;
+
+// Value is a half float in the low 16 bits of valueType, type is in the
+// high ones
+struct Material {
+    vec3 color;
+    uint valueType;
+};
+
+layout(std430, binding = 2) readonly buffer MaterialBuffer {
+    Material materials[];
+} mat;
+
+float materialValue(uint material) {
+    return unpackHalf2x16(mat.materials[material].valueType).x;
+}
+
+uint materialType(uint material) {
+    return mat.materials[material].valueType >> 16;
+}
+
+struct BvhNode {
+    vec3 min;
+    uint leftFirst;
+    vec3 max;
+    uint count;
+};
+
+layout(std430, binding = 3) readonly buffer BvhBuffer {
+    BvhNode nodes[];
+} bvh;
+
+struct Triangle {
+    vec3 v0;
+    uint material;
+    vec3 edge1;
+    float pad0;
+    vec3 edge2;
+    float pad1;
+};
+
+layout(std430, binding = 4) readonly buffer MeshBuffer {
+    Triangle triangles[];
+} mesh;
+
+struct Ray
+{
+    vec3 origin;
+    vec3 direction;
+};
+
+vec3 rayAt(Ray r, float t) {
+    return r.origin + t * r.direction;
+}
+
+struct HitRecord
+{
+    vec3 p;
+    vec3 normal;
+    float t;
+    uint material;
+    bool frontFace;
+    uint primitive;
+};
+
+void faceNormal(Ray r, vec3 outwardNormal, out bool frontFace, out vec3 normal) {
+    frontFace = dot(r.direction, outwardNormal) < 0;
+    normal = frontFace ? outwardNormal : -outwardNormal;
+}
+
+struct Interval
+{
+    float min;
+    float max;
+};
+
+Interval empty = Interval(posInf, negInf);
+Interval universe = Interval(negInf, posInf);
+
+bool surrounds(Interval i, float x) {
+    return i.min < x && x < i.max;
+}
+
+bool contains(Interval i, float x) {
+    return i.min <= x && x <= i.max;
+}
+
+bool hitSphere(Sphere s, Ray r, Interval inter, inout HitRecord rec) {
+    vec3 oc = s.center - r.origin;
+
+    float a = dot(r.direction, r.direction);
+    float h = dot(r.direction, oc);
+    float c = dot(oc, oc) - s.radius * s.radius;
+    float discriminant = h*h - a*c;
+
+    if (discriminant < 0) {
+        return false;
+    }
+    
+    float sqrtd = sqrt(discriminant);
+
+    float root = (h - sqrtd) / a;
+
+    if (!surrounds(inter, root)) {
+        root = (h + sqrtd) / a;
+        if (!surrounds(inter, root)) {
+            return false;
+        }
+    }
+
+    rec.t = root;
+    rec.p = rayAt(r, rec.t);
+    faceNormal(r, (rec.p - s.center) / s.radius, rec.frontFace, rec.normal);
+
+    return true;
+}
+
+// Moller-Trumbore, edges are precomputed on the host
+bool hitTriangle(Triangle tri, Ray r, Interval inter, inout HitRecord rec) {
+    vec3 pvec = cross(r.direction, tri.edge2);
+    float det = dot(tri.edge1, pvec);
+
+    if (abs(det) < 1e-12) {
+        return false;
+    }
+
+    float invDet = 1.0 / det;
+
+    vec3 tvec = r.origin - tri.v0;
+    float u = dot(tvec, pvec) * invDet;
+    if (u < 0.0 || u > 1.0) {
+        return false;
+    }
+
+    vec3 qvec = cross(tvec, tri.edge1);
+    float v = dot(r.direction, qvec) * invDet;
+    if (v < 0.0 || u + v > 1.0) {
+        return false;
+    }
+
+    float t = dot(tri.edge2, qvec) * invDet;
+    if (!surrounds(inter, t)) {
+        return false;
+    }
+
+    rec.t = t;
+    rec.p = rayAt(r, rec.t);
+    faceNormal(r, normalize(cross(tri.edge1, tri.edge2)), rec.frontFace, rec.normal);
+
+    return true;
+}
+
+// Material of a sphere hit is left to resolveSphereMaterial(), only the
+// closest hit of a traversal reads it
+bool hitPrimitive(bool triangles, uint i, Ray r, Interval inter, inout HitRecord rec) {
+    if (triangles) {
+        if (hitTriangle(mesh.triangles[i], r, inter, rec)) {
+            rec.material = mesh.triangles[i].material;
+            rec.primitive = i;
+            return true;
+        }
+        return false;
+    }
+
+    if (hitSphere(loadSphere(i), r, inter, rec)) {
+        rec.primitive = i;
+        return true;
+    }
+    return false;
+}
+
+void resolveSphereMaterial(inout HitRecord rec) {
+    rec.material = sphereMaterials.materials[rec.primitive];
+}
+
+bool hitWorldLinear(Ray r, Interval inter, inout HitRecord rec) {
+    bool hitAnything = false;
+    float closestSoFar = inter.max;
+
+    HitRecord tempRec;
+    for(uint i = 0; i != frame.worldCount; ++i) {
+        if (hitPrimitive(false, i, r, Interval(inter.min, closestSoFar), tempRec)) {
+            hitAnything = true;
+            closestSoFar = tempRec.t;
+            rec = tempRec;
+        }
+    }
+
+    if (hitAnything) {
+        resolveSphereMaterial(rec);
+    }
+
+    for(uint i = 0; i != frame.triangleCount; ++i) {
+        if (hitPrimitive(true, i, r, Interval(inter.min, closestSoFar), tempRec)) {
+            hitAnything = true;
+            closestSoFar = tempRec.t;
+            rec = tempRec;
+        }
+    }
+
+    return hitAnything;
+}
+
+float hitAabb(vec3 bmin, vec3 bmax, vec3 origin, vec3 invDirection, float tmin, float tmax) {
+    vec3 t0 = (bmin - origin) * invDirection;
+    vec3 t1 = (bmax - origin) * invDirection;
+
+    vec3 tsmaller = min(t0, t1);
+    vec3 tbigger = max(t0, t1);
+
+    float entry = max(tmin, max(tsmaller.x, max(tsmaller.y, tsmaller.z)));
+    float exit = min(tmax, min(tbigger.x, min(tbigger.y, tbigger.z)));
+
+    return entry <= exit ? entry : posInf;
+}
+
+// bvh_stack_size on the host, deeper hierarchies are rejected when a scene
+// is loaded
+const uint bvhStackSize = 64u;
+
+// Sphere and triangle hierarchies share the node buffer, the triangle one
+// starts at frame.triangleRoot
+bool hitBvh(uint root, bool triangles, Ray r, Interval inter, inout HitRecord rec) {
+    bool hitAnything = false;
+    float closestSoFar = inter.max;
+
+    vec3 invDirection = 1.0 / r.direction;
+
+    if (hitAabb(bvh.nodes[root].min, bvh.nodes[root].max, r.origin, invDirection, inter.min, closestSoFar) == posInf) {
+        return false;
+    }
+
+    uint stack[bvhStackSize];
+    uint stackSize = 0;
+    uint nodeIndex = root;
+
+    HitRecord tempRec;
+    while (true) {
+        BvhNode node = bvh.nodes[nodeIndex];
+
+        if (node.count != 0) {
+            for (uint i = node.leftFirst; i != node.leftFirst + node.count; ++i) {
+                if (hitPrimitive(triangles, i, r, Interval(inter.min, closestSoFar), tempRec)) {
+                    hitAnything = true;
+                    closestSoFar = tempRec.t;
+                    rec = tempRec;
+                }
+            }
+
+            if (stackSize == 0) {
+                break;
+            }
+            nodeIndex = stack[--stackSize];
+            continue;
+        }
+
+        uint nearChild = node.leftFirst;
+        uint farChild = node.leftFirst + 1;
+        float nearT = hitAabb(bvh.nodes[nearChild].min, bvh.nodes[nearChild].max, r.origin, invDirection, inter.min, closestSoFar);
+        float farT = hitAabb(bvh.nodes[farChild].min, bvh.nodes[farChild].max, r.origin, invDirection, inter.min, closestSoFar);
+
+        if (nearT > farT) {
+            float t = nearT;
+            nearT = farT;
+            farT = t;
+
+            uint c = nearChild;
+            nearChild = farChild;
+            farChild = c;
+        }
+
+        if (nearT == posInf) {
+            if (stackSize == 0) {
+                break;
+            }
+            nodeIndex = stack[--stackSize];
+        }
+        else {
+            nodeIndex = nearChild;
+            if (farT != posInf) {
+                stack[stackSize++] = farChild;
+            }
+        }
+    }
+
+    if (hitAnything && !triangles) {
+        resolveSphereMaterial(rec);
+    }
+
+    return hitAnything;
+}
+
+bool hitWorldBvh(Ray r, Interval inter, inout HitRecord rec) {
+    bool hitAnything = hitBvh(0, false, r, inter, rec);
+
+    if (frame.triangleCount != 0) {
+        Interval remaining = Interval(inter.min, hitAnything ? rec.t : inter.max);
+        hitAnything = hitBvh(frame.triangleRoot, true, r, remaining, rec) || hitAnything;
+    }
+
+    return hitAnything;
+}
+
+#ifdef RAY_QUERY
+layout(set = 1, binding = 0) uniform accelerationStructureEXT tlas;
+
+// Instance custom indices of the bottom level structures
+const uint sphereInstance = 0u;
+const uint triangleInstance = 1u;
+
+// Spheres are procedural AABB geometry, candidates are tested with
+// hitSphere(). Triangles are opaque and committed by the implementation.
+bool hitWorldRayQuery(Ray r, Interval inter, inout HitRecord rec) {
+    rayQueryEXT query;
+    rayQueryInitializeEXT(query, tlas, gl_RayFlagsNoneEXT, 0xFF, r.origin, inter.min, r.direction, inter.max);
+
+    HitRecord tempRec;
+    while (rayQueryProceedEXT(query)) {
+        if (rayQueryGetIntersectionTypeEXT(query, false) == gl_RayQueryCandidateIntersectionAABBEXT) {
+            float closestSoFar = rayQueryGetIntersectionTypeEXT(query, true) == gl_RayQueryCommittedIntersectionNoneEXT
+                ? inter.max
+                : rayQueryGetIntersectionTEXT(query, true);
+
+            uint i = rayQueryGetIntersectionPrimitiveIndexEXT(query, false);
+            if (hitSphere(loadSphere(i), r, Interval(inter.min, closestSoFar), tempRec)) {
+                rayQueryGenerateIntersectionEXT(query, tempRec.t);
+            }
+        }
+    }
+
+    if (rayQueryGetIntersectionTypeEXT(query, true) == gl_RayQueryCommittedIntersectionNoneEXT) {
+        return false;
+    }
+
+    // Committed primitive is the closest one, intersect it again to fill the
+    // hit record the same way as the software paths
+    uint i = rayQueryGetIntersectionPrimitiveIndexEXT(query, true);
+    bool triangles = rayQueryGetIntersectionInstanceCustomIndexEXT(query, true) == triangleInstance;
+    if (!hitPrimitive(triangles, i, r, inter, rec)) {
+        return false;
+    }
+
+    if (!triangles) {
+        resolveSphereMaterial(rec);
+    }
+    return true;
+}
+#endif
+
+bool hitWorld(Ray r, Interval inter, inout HitRecord rec) {
+#ifdef RAY_QUERY
+    return hitWorldRayQuery(r, inter, rec);
+#else
+    if (pc.useBvh != 0) {
+        return hitWorldBvh(r, inter, rec);
+    }
+    return hitWorldLinear(r, inter, rec);
+#endif
+}
+
+vec3 skyColor(vec3 direction) {
+    vec3 white = vec3(1);
+    vec3 blue = vec3(0.5, 0.7, 1.0);
+
+    float alpha = 0.5 * (normalize(direction).y + 1.0);
+    return ((1.0 - alpha) * white + alpha * blue) * frame.skyIntensity;
+}
+
+#endif
@@ -0,0 +1,69 @@
+#ifndef WAVEFRONT_GLSL
+#define WAVEFRONT_GLSL
+
+#include "scene.glsl"
+
+const uint wavefrontGroupSize = 64u;
+
+// Path state of a single sample, paths are indexed by pixel
+struct Path {
+    vec3 origin;
+    uint sampleDimension;
+    vec3 direction;
+    uint pad0;
+    vec3 throughput;
+    uint pad1;
+    vec4 radiance;
+};
+
+layout(std430, set = 1, binding = 0) buffer PathBuffer {
+    Path paths[];
+} state;
+
+struct Hit {
+    vec3 p;
+    float t;
+    vec3 normal;
+    uint material;
+    uint frontFace;
+};
+
+layout(std430, set = 1, binding = 1) buffer HitBuffer {
+    Hit hits[];
+} hit;
+
+// Two ray queues used in turns by consecutive bounces followed by a hit queue
+// per material type, each one has room for a path per pixel. Without material
+// binning all hits go to the first hit queue.
+layout(std430, set = 1, binding = 2) buffer QueueBuffer {
+    uint indices[];
+} queue;
+
+layout(std430, set = 1, binding = 3) buffer CounterBuffer {
+    uint rayCount[2];
+    uint hitCount[materialTypeCount];
+    uvec4 extendArgs;
+    uvec4 shadeArgs[materialTypeCount];
+} counter;
+
+const uint anyMaterial = ~0u;
+
+uint pathCount() {
+    ivec2 size = imageSize(image);
+    return uint(size.x * size.y);
+}
+
+uint rayQueueOffset(uint bounce) {
+    return (bounce & 1u) * pathCount();
+}
+
+uint hitQueueOffset(uint queue) {
+    return (2u + queue) * pathCount();
+}
+
+// Hit queue shaded by the current shade dispatch
+uint shadeQueue() {
+    return pc.shadeMaterial == anyMaterial ? 0u : pc.shadeMaterial;
+}
+
+#endif
@@ -0,0 +1,326 @@
+#include <acceleration_structures.hpp>
+
+#include <mesh.hpp>
+
+#include <vulkan_acceleration_structure.hpp>
+#include <vulkan_buffer.hpp>
+#include <vulkan_commands.hpp>
+#include <vulkan_descriptors.hpp>
+#include <vulkan_device.hpp>
+#include <vulkan_memory.hpp>
+#include <vulkan_queue.hpp>
+#include <vulkan_utility.hpp>
+
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+
+#include <vulkan/vulkan_core.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iterator>
+#include <span>
+#include <vector>
+
+namespace
+{
+    // Matches instance custom indices in scene.glsl
+    constexpr uint32_t sphere_instance{0};
+    constexpr uint32_t triangle_instance{1};
+
+    [[nodiscard]] VkDescriptorPool create_descriptor_pool(
+        vkrndr::vulkan_device const* const device)
+    {
+        VkDescriptorPoolSize pool_size{};
+        pool_size.type = VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR;
+        pool_size.descriptorCount = 1;
+
+        VkDescriptorPoolCreateInfo pool_info{};
+        pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        pool_info.poolSizeCount = 1;
+        pool_info.pPoolSizes = &pool_size;
+        pool_info.maxSets = 1;
+
+        VkDescriptorPool rv; // NOLINT
+        vkrndr::check_result(
+            vkCreateDescriptorPool(device->logical, &pool_info, nullptr, &rv));
+
+        return rv;
+    }
+
+    [[nodiscard]] VkDescriptorSetLayout create_descriptor_set_layout(
+        vkrndr::vulkan_device const* const device)
+    {
+        VkDescriptorSetLayoutBinding tlas_binding{};
+        tlas_binding.binding = 0;
+        tlas_binding.descriptorType =
+            VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR;
+        tlas_binding.descriptorCount = 1;
+        tlas_binding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+        VkDescriptorSetLayoutCreateInfo layout_info{};
+        layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        layout_info.bindingCount = 1;
+        layout_info.pBindings = &tlas_binding;
+
+        VkDescriptorSetLayout rv; // NOLINT
+        vkrndr::check_result(vkCreateDescriptorSetLayout(device->logical,
+            &layout_info,
+            nullptr,
+            &rv));
+
+        return rv;
+    }
+
+    // Inputs are read once by the build, host visible memory avoids a
+    // staging copy
+    template<typename T>
+    [[nodiscard]] vkrndr::vulkan_buffer create_input_buffer(
+        vkrndr::vulkan_device const& device,
+        std::span<T const> const data)
+    {
+        vkrndr::vulkan_buffer rv{vkrndr::create_buffer(device,
+            data.size_bytes(),
+            VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR |
+                VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)};
+
+        auto map{vkrndr::map_memory(device, rv)};
+        std::ranges::copy(data, map.as<T>());
+        unmap_memory(device, &map);
+
+        return rv;
+    }
+
+    [[nodiscard]] VkAccelerationStructureInstanceKHR make_instance(
+        vkrndr::vulkan_acceleration_structure const& blas,
+        uint32_t const custom_index)
+    {
+        VkAccelerationStructureInstanceKHR rv{};
+        rv.transform.matrix[0][0] = 1.0f;
+        rv.transform.matrix[1][1] = 1.0f;
+        rv.transform.matrix[2][2] = 1.0f;
+        rv.instanceCustomIndex = custom_index;
+        rv.mask = 0xFF;
+        rv.instanceShaderBindingTableRecordOffset = 0;
+        rv.flags = VK_GEOMETRY_INSTANCE_TRIANGLE_FACING_CULL_DISABLE_BIT_KHR;
+        rv.accelerationStructureReference = blas.device_address;
+        return rv;
+    }
+} // namespace
+
+beam::acceleration_structures::acceleration_structures(
+    vkrndr::vulkan_device* const device)
+    : device_{device}
+    , descriptor_pool_{create_descriptor_pool(device_)}
+    , descriptor_layout_{create_descriptor_set_layout(device_)}
+{
+    vkrndr::create_descriptor_sets(device_,
+        descriptor_layout_,
+        descriptor_pool_,
+        std::span{&descriptor_set_, 1});
+}
+
+beam::acceleration_structures::~acceleration_structures()
+{
+    destroy_structures();
+
+    vkDestroyDescriptorSetLayout(device_->logical, descriptor_layout_, nullptr);
+    vkDestroyDescriptorPool(device_->logical, descriptor_pool_, nullptr);
+}
+
+void beam::acceleration_structures::build(std::span<glm::vec4 const> spheres,
+    std::span<triangle const> triangles)
+{
+    destroy_structures();
+
+    auto const start{std::chrono::steady_clock::now()};
+
+    std::vector<VkAabbPositionsKHR> aabbs;
+    aabbs.reserve(spheres.size());
+    std::ranges::transform(spheres,
+        std::back_inserter(aabbs),
+        [](glm::vec4 const& s)
+        {
+            glm::vec3 const min{glm::vec3{s} - glm::vec3{s.w}};
+            glm::vec3 const max{glm::vec3{s} + glm::vec3{s.w}};
+            return VkAabbPositionsKHR{.minX = min.x,
+                .minY = min.y,
+                .minZ = min.z,
+                .maxX = max.x,
+                .maxY = max.y,
+                .maxZ = max.z};
+        });
+
+    std::vector<glm::vec3> vertices;
+    vertices.reserve(triangles.size() * 3);
+    for (triangle const& t : triangles)
+    {
+        vertices.push_back(t.v0);
+        vertices.push_back(t.v0 + t.edge1);
+        vertices.push_back(t.v0 + t.edge2);
+    }
+
+    vkrndr::vulkan_buffer aabb_buffer{create_input_buffer(*device_,
+        std::span<VkAabbPositionsKHR const>{aabbs})};
+    vkrndr::vulkan_buffer vertex_buffer;
+    if (!vertices.empty())
+    {
+        vertex_buffer = create_input_buffer(*device_,
+            std::span<glm::vec3 const>{vertices});
+    }
+
+    VkCommandPool const command_pool{
+        vkrndr::create_command_pool(*device_, device_->present_queue->family)};
+
+    VkCommandBuffer command_buffer; // NOLINT
+    vkrndr::begin_single_time_commands(*device_,
+        command_pool,
+        1,
+        std::span{&command_buffer, 1});
+
+    std::vector<vkrndr::vulkan_buffer> scratch_buffers;
+    std::vector<VkAccelerationStructureInstanceKHR> instances;
+
+    {
+        VkAccelerationStructureGeometryKHR geometry{};
+        geometry.sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_KHR;
+        geometry.geometryType = VK_GEOMETRY_TYPE_AABBS_KHR;
+        geometry.geometry.aabbs.sType =
+            VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_AABBS_DATA_KHR;
+        geometry.geometry.aabbs.data.deviceAddress =
+            vkrndr::device_address(*device_, aabb_buffer);
+        geometry.geometry.aabbs.stride = sizeof(VkAabbPositionsKHR);
+
+        auto const count{vkrndr::count_cast(aabbs.size())};
+        sphere_blas_ = vkrndr::create_acceleration_structure(*device_,
+            command_buffer,
+            VK_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL_KHR,
+            std::span{&geometry, 1},
+            std::span{&count, 1},
+            scratch_buffers.emplace_back());
+        instances.push_back(make_instance(sphere_blas_, sphere_instance));
+    }
+
+    if (!vertices.empty())
+    {
+        VkAccelerationStructureGeometryKHR geometry{};
+        geometry.sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_KHR;
+        geometry.geometryType = VK_GEOMETRY_TYPE_TRIANGLES_KHR;
+        geometry.flags = VK_GEOMETRY_OPAQUE_BIT_KHR;
+        geometry.geometry.triangles.sType =
+            VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_TRIANGLES_DATA_KHR;
+        geometry.geometry.triangles.vertexFormat = VK_FORMAT_R32G32B32_SFLOAT;
+        geometry.geometry.triangles.vertexData.deviceAddress =
+            vkrndr::device_address(*device_, vertex_buffer);
+        geometry.geometry.triangles.vertexStride = sizeof(glm::vec3);
+        geometry.geometry.triangles.maxVertex =
+            vkrndr::count_cast(vertices.size() - 1);
+        geometry.geometry.triangles.indexType = VK_INDEX_TYPE_NONE_KHR;
+
+        auto const count{vkrndr::count_cast(triangles.size())};
+        triangle_blas_ = vkrndr::create_acceleration_structure(*device_,
+            command_buffer,
+            VK_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL_KHR,
+            std::span{&geometry, 1},
+            std::span{&count, 1},
+            scratch_buffers.emplace_back());
+        instances.push_back(make_instance(triangle_blas_, triangle_instance));
+    }
+
+    vkrndr::memory_barrier(command_buffer,
+        VK_PIPELINE_STAGE_2_ACCELERATION_STRUCTURE_BUILD_BIT_KHR,
+        VK_ACCESS_2_ACCELERATION_STRUCTURE_WRITE_BIT_KHR,
+        VK_PIPELINE_STAGE_2_ACCELERATION_STRUCTURE_BUILD_BIT_KHR,
+        VK_ACCESS_2_ACCELERATION_STRUCTURE_READ_BIT_KHR);
+
+    vkrndr::vulkan_buffer instance_buffer{create_input_buffer(*device_,
+        std::span<VkAccelerationStructureInstanceKHR const>{instances})};
+    {
+        VkAccelerationStructureGeometryKHR geometry{};
+        geometry.sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_KHR;
+        geometry.geometryType = VK_GEOMETRY_TYPE_INSTANCES_KHR;
+        geometry.geometry.instances.sType =
+            VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_INSTANCES_DATA_KHR;
+        geometry.geometry.instances.arrayOfPointers = VK_FALSE;
+        geometry.geometry.instances.data.deviceAddress =
+            vkrndr::device_address(*device_, instance_buffer);
+
+        auto const count{vkrndr::count_cast(instances.size())};
+        tlas_ = vkrndr::create_acceleration_structure(*device_,
+            command_buffer,
+            VK_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL_KHR,
+            std::span{&geometry, 1},
+            std::span{&count, 1},
+            scratch_buffers.emplace_back());
+    }
+
+    vkrndr::end_single_time_commands(*device_,
+        device_->present_queue->queue,
+        std::span{&command_buffer, 1},
+        command_pool);
+    vkDestroyCommandPool(device_->logical, command_pool, nullptr);
+
+    std::chrono::duration<float> const elapsed{
+        std::chrono::steady_clock::now() - start};
+    build_time_ = elapsed.count();
+
+    for (vkrndr::vulkan_buffer& buffer : scratch_buffers)
+    {
+        destroy(device_, &buffer);
+    }
+    destroy(device_, &instance_buffer);
+    destroy(device_, &vertex_buffer);
+    destroy(device_, &aabb_buffer);
+
+    update_descriptor_set();
+}
+
+VkDescriptorSetLayout
+beam::acceleration_structures::descriptor_layout() const
+{
+    return descriptor_layout_;
+}
+
+VkDescriptorSet beam::acceleration_structures::descriptor_set() const
+{
+    return descriptor_set_;
+}
+
+float beam::acceleration_structures::build_time() const
+{
+    return build_time_;
+}
+
+void beam::acceleration_structures::destroy_structures()
+{
+    destroy(device_, &tlas_);
+    destroy(device_, &triangle_blas_);
+    destroy(device_, &sphere_blas_);
+
+    tlas_ = {};
+    triangle_blas_ = {};
+    sphere_blas_ = {};
+}
+
+void beam::acceleration_structures::update_descriptor_set()
+{
+    VkWriteDescriptorSetAccelerationStructureKHR tlas_info{};
+    tlas_info.sType =
+        VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET_ACCELERATION_STRUCTURE_KHR;
+    tlas_info.accelerationStructureCount = 1;
+    tlas_info.pAccelerationStructures = &tlas_.handle;
+
+    VkWriteDescriptorSet tlas_write{};
+    tlas_write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    tlas_write.pNext = &tlas_info;
+    tlas_write.dstSet = descriptor_set_;
+    tlas_write.dstBinding = 0;
+    tlas_write.dstArrayElement = 0;
+    tlas_write.descriptorType = VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR;
+    tlas_write.descriptorCount = 1;
+
+    vkUpdateDescriptorSets(device_->logical, 1, &tlas_write, 0, nullptr);
+}
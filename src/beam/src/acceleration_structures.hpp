@@ -0,0 +1,79 @@
+#ifndef BEAM_ACCELERATION_STRUCTURES_INCLUDED
+#define BEAM_ACCELERATION_STRUCTURES_INCLUDED
+
+#include <vulkan_acceleration_structure.hpp>
+
+#include <glm/vec4.hpp>
+
+#include <vulkan/vulkan_core.h>
+
+#include <span>
+
+namespace vkrndr
+{
+    struct vulkan_device;
+} // namespace vkrndr
+
+namespace beam
+{
+    struct triangle;
+} // namespace beam
+
+namespace beam
+{
+    // Hardware acceleration structures for ray queries. Spheres are a BLAS
+    // of procedural AABBs, triangles a BLAS of opaque triangles, both are
+    // instanced once in the TLAS bound to descriptor set 1.
+    class [[nodiscard]] acceleration_structures final
+    {
+    public:
+        explicit acceleration_structures(vkrndr::vulkan_device* device);
+
+        acceleration_structures(acceleration_structures const&) = delete;
+
+        acceleration_structures(acceleration_structures&&) noexcept = delete;
+
+    public:
+        ~acceleration_structures();
+
+    public:
+        // Primitive indices in the structures match the order of spheres and
+        // triangles in the storage buffers. Blocks until the build completes.
+        void build(std::span<glm::vec4 const> spheres,
+            std::span<triangle const> triangles);
+
+        [[nodiscard]] VkDescriptorSetLayout descriptor_layout() const;
+
+        [[nodiscard]] VkDescriptorSet descriptor_set() const;
+
+        // Seconds spent in the last build, including input upload
+        [[nodiscard]] float build_time() const;
+
+    public:
+        acceleration_structures& operator=(
+            acceleration_structures const&) = delete;
+
+        acceleration_structures& operator=(
+            acceleration_structures&&) noexcept = delete;
+
+    private:
+        void destroy_structures();
+
+        void update_descriptor_set();
+
+    private:
+        vkrndr::vulkan_device* device_;
+
+        VkDescriptorPool descriptor_pool_;
+        VkDescriptorSetLayout descriptor_layout_;
+        VkDescriptorSet descriptor_set_{VK_NULL_HANDLE};
+
+        vkrndr::vulkan_acceleration_structure sphere_blas_;
+        vkrndr::vulkan_acceleration_structure triangle_blas_;
+        vkrndr::vulkan_acceleration_structure tlas_;
+
+        float build_time_{};
+    };
+} // namespace beam
+
+#endif
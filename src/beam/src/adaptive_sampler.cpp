@@ -0,0 +1,243 @@
+#include <adaptive_sampler.hpp>
+
+#include <async_compute.hpp>
+#include <push_constants.hpp>
+
+#include <vulkan_buffer.hpp>
+#include <vulkan_commands.hpp>
+#include <vulkan_device.hpp>
+#include <vulkan_image.hpp>
+#include <vulkan_memory.hpp>
+#include <vulkan_pipeline.hpp>
+#include <vulkan_queue.hpp>
+#include <vulkan_utility.hpp>
+
+#include <vulkan/vulkan_core.h>
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+
+namespace
+{
+    constexpr uint32_t tile_size{16};
+
+    // Size of the TileBuffer header in adaptive.glsl
+    constexpr VkDeviceSize tile_header_size{32};
+    constexpr VkDeviceSize active_pixels_offset{12};
+
+    struct [[nodiscard]] readback final
+    {
+        uint32_t active_pixels;
+        uint32_t run;
+    };
+
+    [[nodiscard]] uint32_t tile_count(uint32_t const pixels)
+    {
+        return (pixels + tile_size - 1) / tile_size;
+    }
+
+    void transition_to_general(vkrndr::vulkan_device const& device,
+        VkImage const image)
+    {
+        VkCommandPool const command_pool{
+            vkrndr::create_command_pool(device, device.present_queue->family)};
+
+        VkCommandBuffer command_buffer; // NOLINT
+        vkrndr::begin_single_time_commands(device,
+            command_pool,
+            1,
+            std::span{&command_buffer, 1});
+
+        vkrndr::transition_image(image,
+            command_buffer,
+            VK_IMAGE_LAYOUT_UNDEFINED,
+            VK_PIPELINE_STAGE_2_NONE,
+            VK_ACCESS_2_NONE,
+            VK_IMAGE_LAYOUT_GENERAL,
+            VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+            VK_ACCESS_2_SHADER_STORAGE_READ_BIT |
+                VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+            1);
+
+        vkrndr::end_single_time_commands(device,
+            device.present_queue->queue,
+            std::span{&command_buffer, 1},
+            command_pool);
+        vkDestroyCommandPool(device.logical, command_pool, nullptr);
+    }
+} // namespace
+
+beam::adaptive_sampler::adaptive_sampler(vkrndr::vulkan_device* const device,
+    VkDescriptorSetLayout const scene_layout,
+    VkExtent2D const extent)
+    : device_{device}
+{
+    compact_pipeline_ = std::make_unique<vkrndr::vulkan_pipeline>(
+        vkrndr::vulkan_compute_pipeline_builder{device_,
+            vkrndr::vulkan_pipeline_layout_builder{device_}
+                .add_descriptor_set_layout(scene_layout)
+                .add_push_constants(VkPushConstantRange{
+                    .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+                    .offset = 0,
+                    .size = sizeof(push_constants),
+                })
+                .build()}
+            .with_shader("adaptive_compact.comp.spv", "main")
+            .build());
+
+    create_resources(extent);
+}
+
+beam::adaptive_sampler::~adaptive_sampler()
+{
+    destroy_resources();
+
+    destroy(device_, compact_pipeline_.get());
+}
+
+void beam::adaptive_sampler::resize(VkExtent2D const extent)
+{
+    destroy_resources();
+    create_resources(extent);
+}
+
+vkrndr::vulkan_image const& beam::adaptive_sampler::variance_image() const
+{
+    return variance_image_;
+}
+
+vkrndr::vulkan_buffer const& beam::adaptive_sampler::tile_buffer() const
+{
+    return tile_buffer_;
+}
+
+void beam::adaptive_sampler::compact(VkCommandBuffer command_buffer,
+    VkDescriptorSet const scene_descriptor_set,
+    uint32_t const frame_offset,
+    push_constants const& constants,
+    VkExtent2D const extent,
+    uint32_t const run)
+{
+    // Statistics written by the previous frame are read by the compaction,
+    // the tile list can be reset once the previous frame is done with it
+    vkrndr::memory_barrier(command_buffer,
+        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT |
+            VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT |
+            VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT,
+        VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT |
+            VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT,
+        VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_TRANSFER_WRITE_BIT);
+
+    std::array<uint32_t, 8> const header{0, 1, 1, 0, run, 0, 0, 0};
+    vkCmdUpdateBuffer(command_buffer,
+        tile_buffer_.buffer,
+        0,
+        sizeof(header),
+        header.data());
+
+    vkrndr::memory_barrier(command_buffer,
+        VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT,
+        VK_ACCESS_2_TRANSFER_WRITE_BIT,
+        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+        VK_ACCESS_2_SHADER_STORAGE_READ_BIT |
+            VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT);
+
+    vkCmdPushConstants(command_buffer,
+        *compact_pipeline_->layout,
+        VK_SHADER_STAGE_COMPUTE_BIT,
+        0,
+        sizeof(push_constants),
+        &constants);
+
+    vkrndr::bind_pipeline(command_buffer,
+        *compact_pipeline_,
+        0,
+        std::span{&scene_descriptor_set, 1},
+        std::span{&frame_offset, 1});
+
+    vkCmdDispatch(command_buffer,
+        tile_count(extent.width),
+        tile_count(extent.height),
+        1);
+
+    vkrndr::memory_barrier(command_buffer,
+        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+        VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT |
+            VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT |
+            VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT,
+        VK_ACCESS_2_SHADER_STORAGE_READ_BIT |
+            VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT |
+            VK_ACCESS_2_TRANSFER_READ_BIT);
+
+    VkBufferCopy const region{.srcOffset = active_pixels_offset,
+        .dstOffset = 0,
+        .size = sizeof(readback)};
+    vkCmdCopyBuffer(command_buffer,
+        tile_buffer_.buffer,
+        readback_buffer_.buffer,
+        1,
+        &region);
+
+    vkrndr::memory_barrier(command_buffer,
+        VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT,
+        VK_ACCESS_2_TRANSFER_WRITE_BIT,
+        VK_PIPELINE_STAGE_2_HOST_BIT,
+        VK_ACCESS_2_HOST_READ_BIT);
+}
+
+std::optional<uint32_t> beam::adaptive_sampler::active_pixels(
+    uint32_t const run) const
+{
+    readback const value{*readback_map_.as<readback>()};
+    if (value.run != run)
+    {
+        return std::nullopt;
+    }
+    return value.active_pixels;
+}
+
+void beam::adaptive_sampler::create_resources(VkExtent2D const extent)
+{
+    variance_image_ = vkrndr::create_image_and_view(*device_,
+        extent,
+        1,
+        VK_SAMPLE_COUNT_1_BIT,
+        VK_FORMAT_R32G32B32A32_SFLOAT,
+        VK_IMAGE_TILING_OPTIMAL,
+        VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        VK_IMAGE_ASPECT_COLOR_BIT,
+        async_compute::queue_families(*device_));
+    transition_to_general(*device_, variance_image_.image);
+
+    VkDeviceSize const tiles{VkDeviceSize{tile_count(extent.width)} *
+        VkDeviceSize{tile_count(extent.height)}};
+    tile_buffer_ = vkrndr::create_buffer(*device_,
+        tile_header_size + tiles * sizeof(uint32_t),
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+            VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT |
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT |
+            VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+    readback_buffer_ = vkrndr::create_buffer(*device_,
+        sizeof(readback),
+        VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+            VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    readback_map_ = vkrndr::map_memory(*device_, readback_buffer_);
+    *readback_map_.as<readback>() = {.active_pixels = 0, .run = ~0u};
+}
+
+void beam::adaptive_sampler::destroy_resources()
+{
+    unmap_memory(*device_, &readback_map_);
+    destroy(device_, &readback_buffer_);
+    destroy(device_, &tile_buffer_);
+    destroy(device_, &variance_image_);
+}
@@ -0,0 +1,89 @@
+#ifndef BEAM_ADAPTIVE_SAMPLER_INCLUDED
+#define BEAM_ADAPTIVE_SAMPLER_INCLUDED
+
+#include <vulkan_buffer.hpp>
+#include <vulkan_image.hpp>
+#include <vulkan_memory.hpp>
+
+#include <vulkan/vulkan_core.h>
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+
+namespace vkrndr
+{
+    struct vulkan_device;
+    struct vulkan_pipeline;
+} // namespace vkrndr
+
+namespace beam
+{
+    struct push_constants;
+} // namespace beam
+
+namespace beam
+{
+    // Per pixel luminance statistics and the list of 16x16 tiles that haven't
+    // converged yet. The variance image and the tile buffer are bound in the
+    // scene descriptor set, the megakernel updates the statistics and samples
+    // only the listed tiles when adaptive sampling is enabled.
+    class [[nodiscard]] adaptive_sampler final
+    {
+    public:
+        adaptive_sampler(vkrndr::vulkan_device* device,
+            VkDescriptorSetLayout scene_layout,
+            VkExtent2D extent);
+
+        adaptive_sampler(adaptive_sampler const&) = delete;
+
+        adaptive_sampler(adaptive_sampler&&) noexcept = delete;
+
+    public:
+        ~adaptive_sampler();
+
+    public:
+        void resize(VkExtent2D extent);
+
+        [[nodiscard]] vkrndr::vulkan_image const& variance_image() const;
+
+        [[nodiscard]] vkrndr::vulkan_buffer const& tile_buffer() const;
+
+        // Records compaction of tiles that haven't converged, leaves indirect
+        // dispatch arguments at the start of the tile buffer. Run identifies
+        // the accumulation, it should change whenever samples are reset.
+        void compact(VkCommandBuffer command_buffer,
+            VkDescriptorSet scene_descriptor_set,
+            uint32_t frame_offset,
+            push_constants const& constants,
+            VkExtent2D extent,
+            uint32_t run);
+
+        // Pixels that haven't converged in the last compaction of the given
+        // run that finished executing, or nullopt if there was none yet
+        [[nodiscard]] std::optional<uint32_t> active_pixels(
+            uint32_t run) const;
+
+    public:
+        adaptive_sampler& operator=(adaptive_sampler const&) = delete;
+
+        adaptive_sampler& operator=(adaptive_sampler&&) noexcept = delete;
+
+    private:
+        void create_resources(VkExtent2D extent);
+
+        void destroy_resources();
+
+    private:
+        vkrndr::vulkan_device* device_;
+
+        std::unique_ptr<vkrndr::vulkan_pipeline> compact_pipeline_;
+
+        vkrndr::vulkan_image variance_image_;
+        vkrndr::vulkan_buffer tile_buffer_;
+        vkrndr::vulkan_buffer readback_buffer_;
+        vkrndr::mapped_memory readback_map_{};
+    };
+} // namespace beam
+
+#endif
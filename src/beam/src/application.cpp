@@ -18,6 +18,7 @@
 #include <vulkan/vulkan_core.h>
 
 #include <cstdint>
+#include <filesystem>
 #include <memory>
 
 beam::application::application(bool const debug)
@@ -34,7 +35,8 @@ beam::application::application(bool const debug)
     , camera_controller_{&camera_, &mouse_}
     , renderer_{std::make_unique<renderer>(this->vulkan_device(),
           this->vulkan_renderer(),
-          this->vulkan_renderer()->extent())}
+          this->vulkan_renderer()->extent(),
+          this->vulkan_renderer()->image_format())}
     , raytracer_{std::make_unique<raytracer>(this->vulkan_device(),
           this->vulkan_renderer(),
           renderer_.get())}
@@ -52,6 +54,18 @@ beam::application::application(bool const debug)
 
 beam::application::~application() = default;
 
+void beam::application::load_model(std::filesystem::path const& path)
+{
+    if (path.extension() == ".beam")
+    {
+        raytracer_->load_scene_file(path);
+    }
+    else
+    {
+        raytracer_->load_model(path);
+    }
+}
+
 bool beam::application::handle_event(SDL_Event const& event)
 {
     camera_controller_.handle_event(event);
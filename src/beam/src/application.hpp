@@ -9,6 +9,7 @@
 
 #include <SDL2/SDL_events.h>
 
+#include <filesystem>
 #include <memory>
 
 namespace vkrndr
@@ -36,6 +37,10 @@ namespace beam
     public:
         ~application() override;
 
+    public:
+        // Scene files with the .beam extension, glTF models otherwise
+        void load_model(std::filesystem::path const& path);
+
     public:
         // cppcheck-suppress duplInheritedMember
         application& operator=(application const&) = delete;
@@ -0,0 +1,301 @@
+#include <async_compute.hpp>
+
+#include <cppext_cycled_buffer.hpp>
+#include <cppext_numeric.hpp>
+
+#include <vulkan_commands.hpp>
+#include <vulkan_device.hpp>
+#include <vulkan_image.hpp>
+#include <vulkan_query.hpp>
+#include <vulkan_queue.hpp>
+#include <vulkan_synchronization.hpp>
+#include <vulkan_utility.hpp>
+
+#include <vulkan/vulkan_core.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace
+{
+    [[nodiscard]] vkrndr::vulkan_image create_resolved_image(
+        vkrndr::vulkan_device const& device,
+        VkExtent2D const extent)
+    {
+        return vkrndr::create_image_and_view(device,
+            extent,
+            1,
+            VK_SAMPLE_COUNT_1_BIT,
+            VK_FORMAT_R32G32B32A32_SFLOAT,
+            VK_IMAGE_TILING_OPTIMAL,
+            VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            VK_IMAGE_ASPECT_COLOR_BIT);
+    }
+
+    // Resolved images are written by a copy and read in general layout by
+    // the display, the layout changes with the ownership transfer
+    void ownership_barrier(VkCommandBuffer command_buffer,
+        VkImage const image,
+        VkPipelineStageFlags2 const src_stage_mask,
+        VkAccessFlags2 const src_access_mask,
+        VkPipelineStageFlags2 const dst_stage_mask,
+        VkAccessFlags2 const dst_access_mask,
+        uint32_t const src_family,
+        uint32_t const dst_family)
+    {
+        VkImageMemoryBarrier2 barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
+        barrier.srcStageMask = src_stage_mask;
+        barrier.srcAccessMask = src_access_mask;
+        barrier.dstStageMask = dst_stage_mask;
+        barrier.dstAccessMask = dst_access_mask;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+        barrier.srcQueueFamilyIndex = src_family;
+        barrier.dstQueueFamilyIndex = dst_family;
+        barrier.image = image;
+        barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        barrier.subresourceRange.levelCount = 1;
+        barrier.subresourceRange.layerCount = 1;
+
+        VkDependencyInfo dependency{};
+        dependency.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+        dependency.imageMemoryBarrierCount = 1;
+        dependency.pImageMemoryBarriers = &barrier;
+
+        vkCmdPipelineBarrier2(command_buffer, &dependency);
+    }
+} // namespace
+
+beam::async_compute::async_compute(vkrndr::vulkan_device* const device,
+    uint32_t const frames_in_flight,
+    VkExtent2D const extent)
+    : device_{device}
+    , command_pool_{vkrndr::create_command_pool(*device_,
+          device_->compute_queue->family)}
+    , timestamp_period_{vkrndr::timestamp_period(*device_,
+          device_->compute_queue->family)}
+    , frames_{frames_in_flight, frames_in_flight}
+{
+    if (timestamp_period_ > 0.0f)
+    {
+        query_pool_ = vkrndr::create_query_pool(device_,
+            VK_QUERY_TYPE_TIMESTAMP,
+            2 * frames_in_flight);
+    }
+
+    for (frame_resources& frame : frames_.as_span())
+    {
+        vkrndr::create_command_buffers(*device_,
+            command_pool_,
+            1,
+            VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+            std::span{&frame.command_buffer, 1});
+        frame.finished = vkrndr::create_semaphore(device_);
+        frame.resolved = create_resolved_image(*device_, extent);
+    }
+}
+
+beam::async_compute::~async_compute()
+{
+    for (frame_resources& frame : frames_.as_span())
+    {
+        destroy(device_, &frame.resolved);
+        vkDestroySemaphore(device_->logical, frame.finished, nullptr);
+    }
+
+    vkDestroyQueryPool(device_->logical, query_pool_, nullptr);
+    vkDestroyCommandPool(device_->logical, command_pool_, nullptr);
+}
+
+bool beam::async_compute::supported(vkrndr::vulkan_device const& device)
+{
+    return device.compute_queue->family != device.present_queue->family;
+}
+
+std::vector<uint32_t> beam::async_compute::queue_families(
+    vkrndr::vulkan_device const& device)
+{
+    if (!supported(device))
+    {
+        return {};
+    }
+
+    return {device.present_queue->family, device.compute_queue->family};
+}
+
+std::vector<vkrndr::vulkan_image const*>
+beam::async_compute::resolved_images() const
+{
+    std::vector<vkrndr::vulkan_image const*> rv;
+    for (frame_resources const& frame : frames_.as_span())
+    {
+        rv.push_back(&frame.resolved);
+    }
+    return rv;
+}
+
+size_t beam::async_compute::index() const { return frames_.index(); }
+
+float beam::async_compute::copy_milliseconds() const
+{
+    return copy_milliseconds_;
+}
+
+void beam::async_compute::resize(VkExtent2D const extent)
+{
+    for (frame_resources& frame : frames_.as_span())
+    {
+        destroy(device_, &frame.resolved);
+        frame.resolved = create_resolved_image(*device_, extent);
+    }
+}
+
+VkCommandBuffer beam::async_compute::begin_frame()
+{
+    read_copy_time();
+
+    VkCommandBuffer const rv{frames_->command_buffer};
+    vkrndr::check_result(vkResetCommandBuffer(rv, 0));
+
+    VkCommandBufferBeginInfo begin_info{};
+    begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    vkrndr::check_result(vkBeginCommandBuffer(rv, &begin_info));
+
+    return rv;
+}
+
+VkSemaphore beam::async_compute::end_frame(VkCommandBuffer command_buffer,
+    vkrndr::vulkan_image const& source)
+{
+    vkrndr::vulkan_image const& resolved{frames_->resolved};
+
+    vkrndr::memory_barrier(command_buffer,
+        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+        VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+        VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT,
+        VK_ACCESS_2_TRANSFER_READ_BIT);
+
+    // Previous contents were displayed frames ago, they are discarded
+    vkrndr::transition_image(resolved.image,
+        command_buffer,
+        VK_IMAGE_LAYOUT_UNDEFINED,
+        VK_PIPELINE_STAGE_2_NONE,
+        VK_ACCESS_2_NONE,
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT,
+        VK_ACCESS_2_TRANSFER_WRITE_BIT,
+        1);
+
+    uint32_t const first_query{2 * cppext::narrow<uint32_t>(frames_.index())};
+    if (query_pool_ != VK_NULL_HANDLE)
+    {
+        vkCmdResetQueryPool(command_buffer, query_pool_, first_query, 2);
+        vkCmdWriteTimestamp2(command_buffer,
+            VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+            query_pool_,
+            first_query);
+    }
+
+    VkImageCopy region{};
+    region.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.srcSubresource.layerCount = 1;
+    region.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.dstSubresource.layerCount = 1;
+    region.extent = {resolved.extent.width, resolved.extent.height, 1};
+
+    vkCmdCopyImage(command_buffer,
+        source.image,
+        VK_IMAGE_LAYOUT_GENERAL,
+        resolved.image,
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        1,
+        &region);
+
+    if (query_pool_ != VK_NULL_HANDLE)
+    {
+        vkCmdWriteTimestamp2(command_buffer,
+            VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+            query_pool_,
+            first_query + 1);
+        frames_->copy_timed = true;
+    }
+
+    // The next frame writes the source after the copy read it
+    vkrndr::memory_barrier(command_buffer,
+        VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT,
+        VK_ACCESS_2_NONE,
+        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+        VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT);
+
+    // Destination masks are ignored by a release
+    ownership_barrier(command_buffer,
+        resolved.image,
+        VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT,
+        VK_ACCESS_2_TRANSFER_WRITE_BIT,
+        VK_PIPELINE_STAGE_2_NONE,
+        VK_ACCESS_2_NONE,
+        device_->compute_queue->family,
+        device_->present_queue->family);
+
+    vkrndr::check_result(vkEndCommandBuffer(command_buffer));
+
+    VkSubmitInfo submit_info{};
+    submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submit_info.commandBufferCount = 1;
+    submit_info.pCommandBuffers = &command_buffer;
+    submit_info.signalSemaphoreCount = 1;
+    submit_info.pSignalSemaphores = &frames_->finished;
+
+    vkrndr::check_result(vkQueueSubmit(device_->compute_queue->queue,
+        1,
+        &submit_info,
+        VK_NULL_HANDLE));
+
+    return frames_->finished;
+}
+
+void beam::async_compute::acquire(VkCommandBuffer command_buffer)
+{
+    // Source stage matches the stage waiting for the semaphore, the layout
+    // transition happens after the wait
+    ownership_barrier(command_buffer,
+        frames_->resolved.image,
+        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+        VK_ACCESS_2_NONE,
+        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+        VK_ACCESS_2_SHADER_STORAGE_READ_BIT,
+        device_->compute_queue->family,
+        device_->present_queue->family);
+}
+
+void beam::async_compute::next_frame() { frames_.cycle(); }
+
+void beam::async_compute::read_copy_time()
+{
+    if (!std::exchange(frames_->copy_timed, false))
+    {
+        return;
+    }
+
+    // The frame was waited for before its resources are reused
+    std::array<uint64_t, 2> timestamps{};
+    if (vkGetQueryPoolResults(device_->logical,
+            query_pool_,
+            2 * cppext::narrow<uint32_t>(frames_.index()),
+            2,
+            sizeof(timestamps),
+            timestamps.data(),
+            sizeof(uint64_t),
+            VK_QUERY_RESULT_64_BIT) == VK_SUCCESS)
+    {
+        copy_milliseconds_ = cppext::as_fp(timestamps[1] - timestamps[0]) *
+            timestamp_period_ / 1e6f;
+    }
+}
@@ -0,0 +1,122 @@
+#ifndef BEAM_ASYNC_COMPUTE_INCLUDED
+#define BEAM_ASYNC_COMPUTE_INCLUDED
+
+#include <cppext_cycled_buffer.hpp>
+
+#include <vulkan_image.hpp>
+
+#include <vulkan/vulkan_core.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace vkrndr
+{
+    struct vulkan_device;
+} // namespace vkrndr
+
+namespace beam
+{
+    // Raytracing on a dedicated compute queue. Work of a frame is recorded
+    // into a command buffer of the compute queue and its result is copied
+    // into the resolved image of the frame, which is then handed over to the
+    // present queue family. The present queue displays it after waiting for
+    // the semaphore of the frame while the compute queue traces the next one.
+    //
+    // Resources of a frame are reused once the frame fence of the present
+    // queue signals, the present submission waited for the compute work.
+    //
+    // The accumulator is copied rather than alternated between two images.
+    // Passes write only the pixels they trace, bands of the frame budget,
+    // tiles which adaptive sampling still refines and the rows merged from
+    // the host, so a second accumulator would have to carry every other
+    // pixel over in each pass. The copy moves 16 bytes per pixel on the
+    // compute queue after the trace, the next trace is submitted behind it
+    // on the same queue in either case. Its duration is measured with
+    // timestamps when the compute family supports them.
+    class [[nodiscard]] async_compute final
+    {
+    public:
+        async_compute(vkrndr::vulkan_device* device,
+            uint32_t frames_in_flight,
+            VkExtent2D extent);
+
+        async_compute(async_compute const&) = delete;
+
+        async_compute(async_compute&&) noexcept = delete;
+
+    public:
+        ~async_compute();
+
+    public:
+        // Work only overlaps when the compute queue is in another family
+        [[nodiscard]] static bool supported(
+            vkrndr::vulkan_device const& device);
+
+        // Families of the queues tracing can be recorded on, images that
+        // keep their contents across frames are shared concurrently by them
+        // so tracing can move between queues without ownership transfers.
+        // Empty when only the present queue traces.
+        [[nodiscard]] static std::vector<uint32_t> queue_families(
+            vkrndr::vulkan_device const& device);
+
+        // Resolved image of every frame in flight
+        [[nodiscard]] std::vector<vkrndr::vulkan_image const*>
+        resolved_images() const;
+
+        // Index of the resolved image of the current frame
+        [[nodiscard]] size_t index() const;
+
+        // Milliseconds the copy into the resolved image took in a recent
+        // frame, zero when it isn't measured
+        [[nodiscard]] float copy_milliseconds() const;
+
+        // Device has to be idle
+        void resize(VkExtent2D extent);
+
+        [[nodiscard]] VkCommandBuffer begin_frame();
+
+        // Copies the source into the resolved image, releases it to the
+        // present queue family and submits the frame. Returns the semaphore
+        // signaled when the frame is traced.
+        [[nodiscard]] VkSemaphore end_frame(VkCommandBuffer command_buffer,
+            vkrndr::vulkan_image const& source);
+
+        // Acquires the resolved image of the frame on the present queue,
+        // recorded before it is read by a compute shader
+        void acquire(VkCommandBuffer command_buffer);
+
+        void next_frame();
+
+    public:
+        async_compute& operator=(async_compute const&) = delete;
+
+        async_compute& operator=(async_compute&&) noexcept = delete;
+
+    private:
+        struct [[nodiscard]] frame_resources final
+        {
+            VkCommandBuffer command_buffer{VK_NULL_HANDLE};
+            VkSemaphore finished{VK_NULL_HANDLE};
+            vkrndr::vulkan_image resolved;
+            // Timestamps of the copy were written and not read yet
+            bool copy_timed{};
+        };
+
+    private:
+        void read_copy_time();
+
+    private:
+        vkrndr::vulkan_device* device_;
+        VkCommandPool command_pool_;
+        float timestamp_period_;
+        // Two timestamps for every frame in flight
+        VkQueryPool query_pool_{VK_NULL_HANDLE};
+
+        cppext::cycled_buffer<frame_resources> frames_;
+        float copy_milliseconds_{};
+    };
+} // namespace beam
+
+#endif
@@ -1,6 +1,14 @@
 #include <application.hpp>
+#include <headless.hpp>
 
+#include <cppext_numeric.hpp>
+
+#include <cstddef>
 #include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <span>
+#include <string_view>
 
 namespace
 {
@@ -11,9 +19,35 @@ namespace
 #endif
 } // namespace
 
-int main([[maybe_unused]] int argc, [[maybe_unused]] char** argv)
+int main(int argc, char** argv)
 {
+    std::span const args{argv, cppext::narrow<size_t>(argc)};
+
+    // beam --headless [--scene <path>] [--output <path>] [--width <n>]
+    //     [--height <n>] [--samples <n>] [--samples-per-frame <n>]
+    //     [--depth <n>] [--position <x> <y> <z>] [--yaw-pitch <yaw> <pitch>]
+    //     [--exposure <value>] [--no-tonemap] [--cpu] [--threads <n>]
+    if (args.size() > 1 && std::string_view{args[1]} == "--headless")
+    {
+        try
+        {
+            beam::render_offline(
+                beam::parse_offline_options(args.subspan(2)),
+                enable_validation_layers);
+        }
+        catch (std::exception const& e)
+        {
+            std::cerr << e.what() << '\n';
+            return EXIT_FAILURE;
+        }
+        return EXIT_SUCCESS;
+    }
+
     beam::application app{enable_validation_layers};
+    if (args.size() > 1)
+    {
+        app.load_model(args[1]);
+    }
     app.run();
     return EXIT_SUCCESS;
 }
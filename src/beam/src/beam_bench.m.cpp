@@ -0,0 +1,426 @@
+#include <headless.hpp>
+#include <raytracer.hpp>
+#include <scene_file.hpp>
+
+#include <cppext_numeric.hpp>
+
+#include <vulkan_device.hpp>
+#include <vulkan_query.hpp>
+#include <vulkan_queue.hpp>
+#include <vulkan_utility.hpp>
+
+#include <fmt/format.h>
+#include <fmt/std.h> // IWYU pragma: keep
+
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+
+#include <vulkan/vulkan_core.h>
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+// Traces fixed scenes with fixed sampling and reports the throughput of each
+// one as JSON:
+//
+//   beam_bench [--width <n>] [--height <n>] [--frames <n>] [--warmup <n>]
+//       [--samples-per-frame <n>] [--depth <n>] [--output <path>]
+//       [<model.gltf>...]
+//
+// The procedural scene is traced with a fixed seed, once at its default size
+// and in a sweep of sphere counts. Given glTF models are traced with the
+// default procedural scene around them.
+//
+// Startup until the first frame can be traced is reported together with the
+// size of the pipeline cache it began with. The first launch on a device
+// starts without one, the difference to a second launch is the time saved
+// by the cache.
+namespace
+{
+    constexpr uint32_t scene_seed{0};
+
+    constexpr int default_scene_extent{11};
+
+    constexpr std::array sweep_extents{2, 5, 22, 44};
+
+    constexpr glm::vec3 camera_position{13.0f, 2.0f, 3.0f};
+
+    constexpr glm::vec2 camera_yaw_pitch{-167.0f, -3.0f};
+
+    struct [[nodiscard]] bench_options final
+    {
+        VkExtent2D extent{640, 360};
+        uint32_t frames{32};
+        uint32_t warmup{4};
+        uint32_t samples_per_frame{1};
+        uint32_t max_depth{5};
+        std::filesystem::path output;
+        std::vector<std::filesystem::path> models;
+    };
+
+    struct [[nodiscard]] bench_result final
+    {
+        std::string name;
+        size_t spheres{};
+        size_t triangles{};
+        // Median, minimum and maximum over the measured frames
+        double ms_per_frame{};
+        double ms_min{};
+        double ms_max{};
+        double samples_per_second{};
+        double mrays_per_second{};
+    };
+
+    [[nodiscard]] uint32_t parse_count(std::string_view const option,
+        std::span<char* const> const args,
+        size_t& index)
+    {
+        if (++index == args.size())
+        {
+            throw std::runtime_error{
+                fmt::format("Missing value of {}", option)};
+        }
+
+        std::string_view const text{args[index]};
+
+        uint32_t rv{};
+        auto const [end, error]{
+            std::from_chars(text.data(), text.data() + text.size(), rv)};
+        if (error != std::errc{} || end != text.data() + text.size() ||
+            rv == 0)
+        {
+            throw std::runtime_error{
+                fmt::format("Invalid value {} of {}", text, option)};
+        }
+        return rv;
+    }
+
+    [[nodiscard]] bench_options parse_options(
+        std::span<char* const> const args)
+    {
+        bench_options rv;
+        for (size_t i{}; i != args.size(); ++i)
+        {
+            std::string_view const option{args[i]};
+            if (option == "--width")
+            {
+                rv.extent.width = parse_count(option, args, i);
+            }
+            else if (option == "--height")
+            {
+                rv.extent.height = parse_count(option, args, i);
+            }
+            else if (option == "--frames")
+            {
+                rv.frames = parse_count(option, args, i);
+            }
+            else if (option == "--warmup")
+            {
+                rv.warmup = parse_count(option, args, i);
+            }
+            else if (option == "--samples-per-frame")
+            {
+                rv.samples_per_frame = parse_count(option, args, i);
+            }
+            else if (option == "--depth")
+            {
+                rv.max_depth = parse_count(option, args, i);
+            }
+            else if (option == "--output")
+            {
+                if (i + 1 == args.size())
+                {
+                    throw std::runtime_error{
+                        fmt::format("Missing value of {}", option)};
+                }
+                rv.output = args[++i];
+            }
+            else if (option.starts_with("--"))
+            {
+                throw std::runtime_error{
+                    fmt::format("Unknown argument {}", option)};
+            }
+            else
+            {
+                rv.models.emplace_back(option);
+            }
+        }
+        return rv;
+    }
+
+    struct [[nodiscard]] startup_result final
+    {
+        // Device creation and compilation of the pipelines of the first
+        // scene
+        double milliseconds{};
+        size_t pipeline_cache_bytes{};
+    };
+
+    class [[nodiscard]] bench_runner final
+    {
+    public:
+        explicit bench_runner(bench_options const& options);
+
+        bench_runner(bench_runner const&) = delete;
+
+        bench_runner(bench_runner&&) noexcept = delete;
+
+    public:
+        ~bench_runner();
+
+    public:
+        // Measures the scene currently loaded in the raytracer
+        [[nodiscard]] bench_result measure(std::string name);
+
+        [[nodiscard]] beam::offline_renderer& offline();
+
+        // Frames are timed on the host when the queue can't write timestamps
+        [[nodiscard]] bool gpu_timestamps() const;
+
+    public:
+        bench_runner& operator=(bench_runner const&) = delete;
+
+        bench_runner& operator=(bench_runner&&) noexcept = delete;
+
+    private:
+        [[nodiscard]] double frame_milliseconds();
+
+    private:
+        bench_options const* options_;
+        beam::offline_renderer offline_;
+        float timestamp_period_;
+        VkQueryPool query_pool_{VK_NULL_HANDLE};
+    };
+
+    // Validation layers would be measured along with the raytracer, they are
+    // never enabled
+    bench_runner::bench_runner(bench_options const& options)
+        : options_{&options}
+        , offline_{options.extent, false}
+        , timestamp_period_{vkrndr::timestamp_period(offline_.device(),
+              offline_.device().present_queue->family)}
+    {
+        if (timestamp_period_ > 0.0f)
+        {
+            query_pool_ = vkrndr::create_query_pool(&offline_.device(),
+                VK_QUERY_TYPE_TIMESTAMP,
+                2);
+        }
+    }
+
+    bench_runner::~bench_runner()
+    {
+        vkDestroyQueryPool(offline_.device().logical, query_pool_, nullptr);
+    }
+
+    bench_result bench_runner::measure(std::string name)
+    {
+        beam::raytracer& tracer{offline_.tracer()};
+
+        offline_.set_camera(camera_position, camera_yaw_pitch);
+        tracer.set_sampling(options_->samples_per_frame, options_->max_depth);
+        tracer.wait_for_pipelines();
+
+        for (uint32_t i{}; i != options_->warmup; ++i)
+        {
+            offline_.trace_frame();
+        }
+
+        // Every measurement continues the accumulation of the warmup frames,
+        // restarting would measure the first frame repeatedly
+        std::vector<double> times;
+        times.reserve(options_->frames);
+        for (uint32_t i{}; i != options_->frames; ++i)
+        {
+            times.push_back(frame_milliseconds());
+        }
+        std::ranges::sort(times);
+
+        double const median{times[times.size() / 2]};
+
+        // Counts camera rays, secondary bounces depend on the scene
+        double const samples_per_second{
+            cppext::as_fp<double>(options_->extent.width) *
+            cppext::as_fp<double>(options_->extent.height) *
+            cppext::as_fp<double>(options_->samples_per_frame) / median *
+            1e3};
+
+        beam::scene_view const scene{tracer.current_scene()};
+
+        return {.name = std::move(name),
+            .spheres = scene.center_radius.size(),
+            .triangles = scene.triangles.size(),
+            .ms_per_frame = median,
+            .ms_min = times.front(),
+            .ms_max = times.back(),
+            .samples_per_second = samples_per_second,
+            .mrays_per_second = samples_per_second / 1e6};
+    }
+
+    beam::offline_renderer& bench_runner::offline() { return offline_; }
+
+    bool bench_runner::gpu_timestamps() const
+    {
+        return query_pool_ != VK_NULL_HANDLE;
+    }
+
+    double bench_runner::frame_milliseconds()
+    {
+        // Host time of a frame includes submission and the wait
+        if (!gpu_timestamps())
+        {
+            auto const start{std::chrono::steady_clock::now()};
+            offline_.trace_frame();
+            return std::chrono::duration<double, std::milli>{
+                std::chrono::steady_clock::now() - start}
+                .count();
+        }
+
+        offline_.trace_frame(query_pool_);
+
+        std::array<uint64_t, 2> timestamps{};
+        vkrndr::check_result(vkGetQueryPoolResults(offline_.device().logical,
+            query_pool_,
+            0,
+            2,
+            sizeof(timestamps),
+            timestamps.data(),
+            sizeof(uint64_t),
+            VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT));
+
+        return cppext::as_fp<double>(timestamps[1] - timestamps[0]) *
+            cppext::as_fp<double>(timestamp_period_) / 1e6;
+    }
+
+    [[nodiscard]] std::string to_json(bench_options const& options,
+        bool const gpu_timestamps,
+        startup_result const& startup,
+        std::span<bench_result const> const results)
+    {
+        std::string rv{fmt::format("{{\n"
+                                   "  \"width\": {},\n"
+                                   "  \"height\": {},\n"
+                                   "  \"samples_per_frame\": {},\n"
+                                   "  \"max_depth\": {},\n"
+                                   "  \"frames\": {},\n"
+                                   "  \"timing\": \"{}\",\n"
+                                   "  \"startup_ms\": {:.1f},\n"
+                                   "  \"pipeline_cache_bytes\": {},\n"
+                                   "  \"scenes\": [",
+            options.extent.width,
+            options.extent.height,
+            options.samples_per_frame,
+            options.max_depth,
+            options.frames,
+            gpu_timestamps ? "gpu" : "host",
+            startup.milliseconds,
+            startup.pipeline_cache_bytes)};
+
+        for (bool first{true}; bench_result const& result : results)
+        {
+            rv += fmt::format("{}\n    {{\n"
+                              "      \"name\": {:?},\n"
+                              "      \"spheres\": {},\n"
+                              "      \"triangles\": {},\n"
+                              "      \"ms_per_frame\": {:.4f},\n"
+                              "      \"ms_min\": {:.4f},\n"
+                              "      \"ms_max\": {:.4f},\n"
+                              "      \"samples_per_second\": {:.0f},\n"
+                              "      \"mrays_per_second\": {:.4f}\n"
+                              "    }}",
+                std::exchange(first, false) ? "" : ",",
+                result.name,
+                result.spheres,
+                result.triangles,
+                result.ms_per_frame,
+                result.ms_min,
+                result.ms_max,
+                result.samples_per_second,
+                result.mrays_per_second);
+        }
+
+        rv += "\n  ]\n}\n";
+        return rv;
+    }
+} // namespace
+
+int main(int argc, char** argv)
+{
+    std::span const args{argv, cppext::narrow<size_t>(argc)};
+
+    try
+    {
+        bench_options const options{parse_options(args.subspan(1))};
+
+        auto const start{std::chrono::steady_clock::now()};
+
+        bench_runner runner{options};
+        beam::raytracer& tracer{runner.offline().tracer()};
+        tracer.wait_for_pipelines();
+
+        std::chrono::duration<double, std::milli> const startup_time{
+            std::chrono::steady_clock::now() - start};
+        startup_result const startup{.milliseconds = startup_time.count(),
+            .pipeline_cache_bytes =
+                runner.offline().device().pipeline_cache_loaded};
+
+        std::vector<bench_result> results;
+
+        tracer.generate_scene(scene_seed, default_scene_extent);
+        results.push_back(runner.measure("spheres"));
+
+        for (int const extent : sweep_extents)
+        {
+            tracer.generate_scene(scene_seed, extent);
+            results.push_back(
+                runner.measure(fmt::format("spheres_sweep_{}", extent)));
+        }
+
+        tracer.generate_scene(scene_seed, default_scene_extent);
+        for (std::filesystem::path const& model : options.models)
+        {
+            runner.offline().load(model);
+            results.push_back(runner.measure(model.filename().string()));
+        }
+
+        std::string const json{
+            to_json(options, runner.gpu_timestamps(), startup, results)};
+
+        if (options.output.empty())
+        {
+            std::cout << json;
+        }
+        else
+        {
+            std::ofstream file{options.output};
+            if (!(file << json))
+            {
+                throw std::runtime_error{
+                    fmt::format("Unable to write {}", options.output)};
+            }
+        }
+    }
+    catch (std::exception const& e)
+    {
+        std::cerr << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
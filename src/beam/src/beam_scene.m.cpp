@@ -0,0 +1,157 @@
+#include <mesh.hpp>
+#include <scene_file.hpp>
+#include <sphere.hpp>
+
+#include <cppext_numeric.hpp>
+
+#include <fmt/format.h>
+
+#include <glm/vec3.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <span>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Converts a text scene description to the binary scene format. Every line
+// is a comment starting with #, a material or a sphere:
+//
+//   material <name> <lambertian|metal|dielectric|emissive> <r> <g> <b>
+//       <value>
+//   sphere <x> <y> <z> <radius> <material name>
+//
+// Value is the fuzz of metals, the refraction index of dielectrics and the
+// strength of emissive materials.
+namespace
+{
+    [[nodiscard]] uint32_t parse_material_type(std::string const& name)
+    {
+        constexpr std::array types{"lambertian",
+            "metal",
+            "dielectric",
+            "emissive"};
+
+        for (uint32_t i{}; char const* const type : types)
+        {
+            if (name == type)
+            {
+                return i;
+            }
+            ++i;
+        }
+
+        throw std::runtime_error{fmt::format("Unknown material type {}", name)};
+    }
+
+    struct [[nodiscard]] text_scene final
+    {
+        std::vector<beam::sphere> spheres;
+        std::vector<beam::material> materials;
+    };
+
+    [[nodiscard]] text_scene parse_scene(std::istream& stream)
+    {
+        text_scene rv;
+        std::map<std::string, uint32_t, std::less<>> material_names;
+
+        std::string line;
+        for (size_t line_number{1}; std::getline(stream, line); ++line_number)
+        {
+            std::istringstream tokens{line};
+
+            std::string keyword;
+            if (!(tokens >> keyword) || keyword.starts_with('#'))
+            {
+                continue;
+            }
+
+            if (keyword == "material")
+            {
+                std::string name;
+                std::string type;
+                beam::material m{};
+                if (tokens >> name >> type >> m.color.r >> m.color.g >>
+                    m.color.b >> m.value)
+                {
+                    m.type = parse_material_type(type);
+                    material_names.insert_or_assign(name,
+                        cppext::narrow<uint32_t>(rv.materials.size()));
+                    rv.materials.push_back(m);
+                    continue;
+                }
+            }
+            else if (keyword == "sphere")
+            {
+                std::string material_name;
+                beam::sphere s{};
+                if (tokens >> s.center.x >> s.center.y >> s.center.z >>
+                    s.radius >> material_name)
+                {
+                    auto const it{material_names.find(material_name)};
+                    if (it == material_names.cend())
+                    {
+                        throw std::runtime_error{
+                            fmt::format("Line {}: unknown material {}",
+                                line_number,
+                                material_name)};
+                    }
+
+                    s.material = it->second;
+                    rv.spheres.push_back(s);
+                    continue;
+                }
+            }
+
+            throw std::runtime_error{
+                fmt::format("Line {}: malformed {}", line_number, keyword)};
+        }
+
+        return rv;
+    }
+} // namespace
+
+int main(int argc, char** argv)
+{
+    std::span const args{argv, cppext::narrow<size_t>(argc)};
+    if (args.size() != 3)
+    {
+        std::cerr << "Usage: beam_scene <input.txt> <output.beam>\n";
+        return EXIT_FAILURE;
+    }
+
+    try
+    {
+        std::ifstream input{args[1]};
+        if (!input)
+        {
+            throw std::runtime_error{fmt::format("Unable to open {}", args[1])};
+        }
+
+        text_scene const scene{parse_scene(input)};
+        beam::scene_data const data{
+            beam::build_scene(scene.spheres, scene.materials, beam::mesh{})};
+        beam::write_scene_file(args[2], data.view());
+
+        std::cout << fmt::format("Wrote {} spheres and {} materials to {}\n",
+            scene.spheres.size(),
+            scene.materials.size(),
+            args[2]);
+    }
+    catch (std::exception const& e)
+    {
+        std::cerr << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,338 @@
+#include <bvh.hpp>
+
+#include <cppext_numeric.hpp>
+
+#include <glm/common.hpp>
+#include <glm/vec3.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
+#include <numeric>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace
+{
+    constexpr size_t bin_count{12};
+
+    struct [[nodiscard]] bin final
+    {
+        beam::aabb bounds;
+        uint32_t count{};
+    };
+
+    struct [[nodiscard]] split final
+    {
+        int axis{-1};
+        size_t bin{};
+        float cost{};
+    };
+
+    [[nodiscard]] split find_split(std::span<beam::aabb const> const bounds,
+        std::span<glm::vec3 const> const centroids,
+        std::span<uint32_t const> const indices,
+        beam::aabb const& centroid_bounds)
+    {
+        split rv;
+
+        for (int axis{}; axis != 3; ++axis)
+        {
+            float const axis_min{centroid_bounds.min[axis]};
+            float const extent{centroid_bounds.max[axis] - axis_min};
+            if (extent <= 0.0f)
+            {
+                continue;
+            }
+
+            float const scale{cppext::as_fp(bin_count) / extent};
+
+            std::array<bin, bin_count> bins{};
+            for (uint32_t const index : indices)
+            {
+                auto const b{std::min(bin_count - 1,
+                    static_cast<size_t>(
+                        (centroids[index][axis] - axis_min) * scale))};
+                grow(bins[b].bounds, bounds[index]);
+                ++bins[b].count;
+            }
+
+            std::array<float, bin_count - 1> left_area{};
+            std::array<float, bin_count - 1> right_area{};
+            std::array<uint32_t, bin_count - 1> left_count{};
+            std::array<uint32_t, bin_count - 1> right_count{};
+
+            beam::aabb left_box;
+            beam::aabb right_box;
+            uint32_t left_sum{};
+            uint32_t right_sum{};
+            for (size_t i{}; i != bin_count - 1; ++i)
+            {
+                grow(left_box, bins[i].bounds);
+                left_sum += bins[i].count;
+                left_area[i] = surface_area(left_box);
+                left_count[i] = left_sum;
+
+                size_t const j{bin_count - 1 - i};
+                grow(right_box, bins[j].bounds);
+                right_sum += bins[j].count;
+                right_area[j - 1] = surface_area(right_box);
+                right_count[j - 1] = right_sum;
+            }
+
+            for (size_t i{}; i != bin_count - 1; ++i)
+            {
+                float const cost{cppext::as_fp(left_count[i]) * left_area[i] +
+                    cppext::as_fp(right_count[i]) * right_area[i]};
+                if (rv.axis == -1 || cost < rv.cost)
+                {
+                    rv.axis = axis;
+                    rv.bin = i;
+                    rv.cost = cost;
+                }
+            }
+        }
+
+        return rv;
+    }
+} // namespace
+
+void beam::grow(aabb& box, glm::vec3 const& point)
+{
+    box.min = glm::min(box.min, point);
+    box.max = glm::max(box.max, point);
+}
+
+void beam::grow(aabb& box, aabb const& other)
+{
+    box.min = glm::min(box.min, other.min);
+    box.max = glm::max(box.max, other.max);
+}
+
+float beam::surface_area(aabb const& box)
+{
+    glm::vec3 const extent{box.max - box.min};
+    if (extent.x < 0.0f || extent.y < 0.0f || extent.z < 0.0f)
+    {
+        return 0.0f;
+    }
+
+    return 2.0f * (extent.x * extent.y + extent.y * extent.z +
+                      extent.z * extent.x);
+}
+
+glm::vec3 beam::centroid(aabb const& box) { return (box.min + box.max) * 0.5f; }
+
+beam::bvh beam::build_bvh(std::span<aabb const> const bounds,
+    uint32_t const max_leaf_size)
+{
+    bvh rv;
+    if (bounds.empty())
+    {
+        return rv;
+    }
+
+    rv.indices.resize(bounds.size());
+    std::iota(rv.indices.begin(), rv.indices.end(), uint32_t{0});
+
+    std::vector<glm::vec3> centroids;
+    centroids.reserve(bounds.size());
+    std::ranges::transform(bounds,
+        std::back_inserter(centroids),
+        [](aabb const& box) { return centroid(box); });
+
+    auto const make_node = [&](uint32_t const first, uint32_t const count)
+    {
+        aabb box;
+        for (uint32_t i{first}; i != first + count; ++i)
+        {
+            grow(box, bounds[rv.indices[i]]);
+        }
+        return bvh_node{.min = box.min,
+            .left_first = first,
+            .max = box.max,
+            .count = count};
+    };
+
+    rv.nodes.reserve(2 * bounds.size() - 1);
+    rv.nodes.push_back(make_node(0, cppext::narrow<uint32_t>(bounds.size())));
+
+    std::vector<size_t> stack{0};
+    while (!stack.empty())
+    {
+        size_t const node_index{stack.back()};
+        stack.pop_back();
+
+        uint32_t const first{rv.nodes[node_index].left_first};
+        uint32_t const count{rv.nodes[node_index].count};
+        if (count <= max_leaf_size)
+        {
+            continue;
+        }
+
+        std::span<uint32_t> const range{
+            std::next(rv.indices.begin(), first),
+            count};
+
+        aabb centroid_bounds;
+        for (uint32_t const index : range)
+        {
+            grow(centroid_bounds, centroids[index]);
+        }
+
+        split const best{find_split(bounds, centroids, range, centroid_bounds)};
+        aabb const node_bounds{rv.nodes[node_index].min,
+            rv.nodes[node_index].max};
+        if (best.axis == -1 ||
+            best.cost >= cppext::as_fp(count) * surface_area(node_bounds))
+        {
+            continue;
+        }
+
+        float const axis_min{centroid_bounds.min[best.axis]};
+        float const scale{cppext::as_fp(bin_count) /
+            (centroid_bounds.max[best.axis] - axis_min)};
+        auto const middle{std::partition(range.begin(),
+            range.end(),
+            [&](uint32_t const index)
+            {
+                auto const b{std::min(bin_count - 1,
+                    static_cast<size_t>(
+                        (centroids[index][best.axis] - axis_min) * scale))};
+                return b <= best.bin;
+            })};
+
+        auto const left_count{
+            cppext::narrow<uint32_t>(std::distance(range.begin(), middle))};
+        if (left_count == 0 || left_count == count)
+        {
+            continue;
+        }
+
+        auto const left_child{cppext::narrow<uint32_t>(rv.nodes.size())};
+        rv.nodes.push_back(make_node(first, left_count));
+        rv.nodes.push_back(
+            make_node(first + left_count, count - left_count));
+
+        rv.nodes[node_index].left_first = left_child;
+        rv.nodes[node_index].count = 0;
+
+        stack.push_back(left_child);
+        stack.push_back(left_child + 1);
+    }
+
+    return rv;
+}
+
+std::vector<beam::bvh_node> beam::build_indexed_bvh(
+    std::span<aabb const> const bounds)
+{
+    bvh hierarchy{build_bvh(bounds, 1)};
+    std::vector<bvh_node> nodes{std::move(hierarchy.nodes)};
+
+    auto const make_node = [&](uint32_t const first, uint32_t const count)
+    {
+        aabb box;
+        for (uint32_t i{first}; i != first + count; ++i)
+        {
+            grow(box, bounds[hierarchy.indices[i]]);
+        }
+        return bvh_node{.min = box.min,
+            .left_first = first,
+            .max = box.max,
+            .count = count};
+    };
+
+    // Leaves the SAH didn't split are halved until they hold one primitive,
+    // appended nodes are visited by the same loop
+    for (size_t i{}; i != nodes.size(); ++i)
+    {
+        uint32_t const first{nodes[i].left_first};
+        uint32_t const count{nodes[i].count};
+        if (count <= 1)
+        {
+            continue;
+        }
+
+        auto const left_child{cppext::narrow<uint32_t>(nodes.size())};
+        nodes.push_back(make_node(first, count / 2));
+        nodes.push_back(make_node(first + count / 2, count - count / 2));
+
+        nodes[i].left_first = left_child;
+        nodes[i].count = 0;
+    }
+
+    for (bvh_node& node : nodes)
+    {
+        if (node.count != 0)
+        {
+            node.left_first = hierarchy.indices[node.left_first];
+        }
+    }
+
+    return nodes;
+}
+
+uint32_t beam::bvh_depth(std::span<bvh_node const> const nodes,
+    uint32_t const root)
+{
+    uint32_t rv{};
+    if (root >= nodes.size())
+    {
+        return rv;
+    }
+
+    std::vector<std::pair<uint32_t, uint32_t>> stack{{root, 0}};
+    while (!stack.empty())
+    {
+        auto const [index, depth]{stack.back()};
+        stack.pop_back();
+
+        rv = std::max(rv, depth);
+
+        bvh_node const& node{nodes[index]};
+        if (node.count == 0 && node.left_first + 1 < nodes.size())
+        {
+            stack.emplace_back(node.left_first, depth + 1);
+            stack.emplace_back(node.left_first + 1, depth + 1);
+        }
+    }
+
+    return rv;
+}
+
+beam::bvh_links beam::link_bvh(std::span<bvh_node const> const nodes,
+    uint32_t const root,
+    size_t const primitive_count)
+{
+    bvh_links rv{.parents = std::vector<uint32_t>(nodes.size(), no_parent),
+        .leaves = std::vector<uint32_t>(primitive_count)};
+
+    std::vector<uint32_t> stack{root};
+    while (!stack.empty())
+    {
+        uint32_t const index{stack.back()};
+        stack.pop_back();
+
+        bvh_node const& node{nodes[index]};
+        if (node.count != 0)
+        {
+            std::fill_n(std::next(rv.leaves.begin(), node.left_first),
+                node.count,
+                index);
+            continue;
+        }
+
+        for (uint32_t const child : {node.left_first, node.left_first + 1})
+        {
+            rv.parents[child] = index;
+            stack.push_back(child);
+        }
+    }
+
+    return rv;
+}
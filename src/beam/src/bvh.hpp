@@ -0,0 +1,88 @@
+#ifndef BEAM_BVH_INCLUDED
+#define BEAM_BVH_INCLUDED
+
+#include <cppext_pragma_warning.hpp>
+
+#include <glm/vec3.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+
+namespace beam
+{
+    struct [[nodiscard]] aabb final
+    {
+        glm::vec3 min{std::numeric_limits<float>::max()};
+        glm::vec3 max{std::numeric_limits<float>::lowest()};
+    };
+
+    void grow(aabb& box, glm::vec3 const& point);
+
+    void grow(aabb& box, aabb const& other);
+
+    [[nodiscard]] float surface_area(aabb const& box);
+
+    [[nodiscard]] glm::vec3 centroid(aabb const& box);
+
+    DISABLE_WARNING_PUSH
+
+    DISABLE_WARNING_STRUCTURE_WAS_PADDED_DUE_TO_ALIGNMENT_SPECIFIER
+    // Matches the std430 layout of BvhNode in the shaders. Inner nodes have
+    // count == 0 and left_first pointing to the left child, the right child
+    // immediately follows it. Leaf nodes reference count primitives starting
+    // at left_first.
+    struct [[nodiscard]] alignas(16) bvh_node final
+    {
+        glm::vec3 min;
+        uint32_t left_first;
+        glm::vec3 max;
+        uint32_t count;
+    };
+
+    DISABLE_WARNING_POP
+
+    struct [[nodiscard]] bvh final
+    {
+        std::vector<bvh_node> nodes;
+        // Primitive order expected by the leaf ranges of nodes
+        std::vector<uint32_t> indices;
+    };
+
+    // Builds a binned SAH BVH over primitive bounds
+    bvh build_bvh(std::span<aabb const> bounds, uint32_t max_leaf_size = 4);
+
+    // Builds a binned SAH BVH whose leaves hold a single primitive each and
+    // reference it by its position in bounds, primitives keep their order
+    [[nodiscard]] std::vector<bvh_node> build_indexed_bvh(
+        std::span<aabb const> bounds);
+
+    // Entries of the traversal stack, bvhStackSize in scene.glsl. Traversal
+    // pushes at most one node for every level above the current one.
+    inline constexpr uint32_t bvh_stack_size{64};
+
+    // Levels below the root on the longest path to a leaf, traversal of the
+    // hierarchy needs as many stack entries
+    [[nodiscard]] uint32_t bvh_depth(std::span<bvh_node const> nodes,
+        uint32_t root);
+
+    inline constexpr uint32_t no_parent{std::numeric_limits<uint32_t>::max()};
+
+    // Links needed to refit a hierarchy after its primitives move
+    struct [[nodiscard]] bvh_links final
+    {
+        // Parent of every node, no_parent for the root and for nodes which
+        // aren't reachable from it
+        std::vector<uint32_t> parents;
+        // Leaf node of every primitive
+        std::vector<uint32_t> leaves;
+    };
+
+    [[nodiscard]] bvh_links link_bvh(std::span<bvh_node const> nodes,
+        uint32_t root,
+        size_t primitive_count);
+} // namespace beam
+
+#endif
@@ -0,0 +1,1145 @@
+#include <cpu_tracer.hpp>
+
+#include <bvh.hpp>
+#include <frame_uniforms.hpp>
+#include <mesh.hpp>
+#include <scene_file.hpp>
+#include <sobol.hpp>
+#include <sphere.hpp>
+
+#include <cppext_numeric.hpp>
+
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+#include <glm/trigonometric.hpp>
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+
+#include <vulkan/vulkan_core.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
+#include <mutex>
+#include <numbers>
+#include <optional>
+#include <span>
+#include <stop_token>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    constexpr uint32_t lambertian_material{0};
+    constexpr uint32_t metal_material{1};
+    constexpr uint32_t dielectric_material{2};
+    constexpr uint32_t emissive_material{3};
+
+    constexpr float pi{std::numbers::pi_v<float>};
+
+    constexpr float no_hit{std::numeric_limits<float>::infinity()};
+
+    constexpr float min_distance{0.001f};
+
+    // Bounces after which paths are terminated with russian roulette
+    constexpr uint32_t roulette_depth{3};
+
+    // Same size as the tiles of adaptive sampling
+    constexpr uint32_t tile_size{16};
+
+    // Spheres tested at once, eight floats fill an AVX2 register
+    constexpr uint32_t batch_width{8};
+
+    [[nodiscard]] float power_heuristic(float const pdf, float const other_pdf)
+    {
+        float const p2{pdf * pdf};
+        return p2 / (p2 + other_pdf * other_pdf);
+    }
+
+    [[nodiscard]] float reflectance(float const cosine,
+        float const refraction_index)
+    {
+        float r0{(1.0f - refraction_index) / (1.0f + refraction_index)};
+        r0 = r0 * r0;
+        return r0 + (1.0f - r0) * std::pow(1.0f - cosine, 5.0f);
+    }
+
+    [[nodiscard]] bool near_zero(glm::vec3 const& direction)
+    {
+        constexpr float eps{1e-8f};
+        glm::vec3 const a{glm::abs(direction)};
+        return a.x < eps && a.y < eps && a.z < eps;
+    }
+
+    [[nodiscard]] glm::vec3 sky_color(glm::vec3 const& direction,
+        float const intensity)
+    {
+        float const alpha{0.5f * (glm::normalize(direction).y + 1.0f)};
+        return ((1.0f - alpha) * glm::vec3{1.0f} +
+                   alpha * glm::vec3{0.5f, 0.7f, 1.0f}) *
+            intensity;
+    }
+
+    [[nodiscard]] float hit_aabb(beam::bvh_node const& node,
+        glm::vec3 const& origin,
+        glm::vec3 const& inv_direction,
+        float const tmax)
+    {
+        glm::vec3 const t0{(node.min - origin) * inv_direction};
+        glm::vec3 const t1{(node.max - origin) * inv_direction};
+
+        glm::vec3 const smaller{glm::min(t0, t1)};
+        glm::vec3 const bigger{glm::max(t0, t1)};
+
+        float const entry{
+            std::max({min_distance, smaller.x, smaller.y, smaller.z})};
+        float const exit{std::min({tmax, bigger.x, bigger.y, bigger.z})};
+
+        return entry <= exit ? entry : no_hit;
+    }
+
+    // Closest hit of a single ray against one hierarchy in the near child
+    // first order of raytracer.comp. Nodes with a range are tested with it
+    // instead of being descended into, the test shrinks closest on hits.
+    template<typename Range, typename TestRange>
+    [[nodiscard]] bool traverse(std::span<beam::bvh_node const> const nodes,
+        std::span<Range const> const ranges,
+        uint32_t const root,
+        glm::vec3 const& origin,
+        glm::vec3 const& direction,
+        float& closest,
+        TestRange&& test_range)
+    {
+        glm::vec3 const inv_direction{1.0f / direction};
+
+        if (hit_aabb(nodes[root], origin, inv_direction, closest) == no_hit)
+        {
+            return false;
+        }
+
+        std::array<uint32_t, beam::bvh_stack_size> stack; // NOLINT
+        uint32_t stack_size{};
+        uint32_t node_index{root};
+
+        bool hit_anything{false};
+        while (true)
+        {
+            if (ranges[node_index].count != 0)
+            {
+                hit_anything = test_range(node_index, closest) || hit_anything;
+
+                if (stack_size == 0)
+                {
+                    break;
+                }
+                node_index = stack[--stack_size];
+                continue;
+            }
+
+            beam::bvh_node const& node{nodes[node_index]};
+            uint32_t near_child{node.left_first};
+            uint32_t far_child{node.left_first + 1};
+            float near_t{hit_aabb(nodes[near_child],
+                origin,
+                inv_direction,
+                closest)};
+            float far_t{
+                hit_aabb(nodes[far_child], origin, inv_direction, closest)};
+
+            if (near_t > far_t)
+            {
+                std::swap(near_t, far_t);
+                std::swap(near_child, far_child);
+            }
+
+            if (near_t == no_hit)
+            {
+                if (stack_size == 0)
+                {
+                    break;
+                }
+                node_index = stack[--stack_size];
+            }
+            else
+            {
+                node_index = near_child;
+                if (far_t != no_hit)
+                {
+                    stack[stack_size++] = far_child;
+                }
+            }
+        }
+
+        return hit_anything;
+    }
+
+    struct [[nodiscard]] batch_hit final
+    {
+        float t{no_hit};
+        uint32_t lane{};
+    };
+
+    // Closest root of hitSphere() in (tmin, tmax) for each of count spheres
+    // starting at first, arrays are padded so a whole batch can be loaded
+    [[nodiscard]] batch_hit hit_sphere_batch(float const* const x,
+        float const* const y,
+        float const* const z,
+        float const* const radius,
+        uint32_t const count,
+        glm::vec3 const& origin,
+        glm::vec3 const& direction,
+        float const tmax)
+    {
+        std::array<float, batch_width> roots; // NOLINT
+
+        float const a{glm::dot(direction, direction)};
+
+#if defined(__AVX2__)
+        __m256 const ox{_mm256_sub_ps(_mm256_loadu_ps(x),
+            _mm256_set1_ps(origin.x))};
+        __m256 const oy{_mm256_sub_ps(_mm256_loadu_ps(y),
+            _mm256_set1_ps(origin.y))};
+        __m256 const oz{_mm256_sub_ps(_mm256_loadu_ps(z),
+            _mm256_set1_ps(origin.z))};
+        __m256 const r{_mm256_loadu_ps(radius)};
+
+        __m256 const h{_mm256_add_ps(
+            _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(direction.x), ox),
+                _mm256_mul_ps(_mm256_set1_ps(direction.y), oy)),
+            _mm256_mul_ps(_mm256_set1_ps(direction.z), oz))};
+        __m256 const c{_mm256_sub_ps(
+            _mm256_add_ps(
+                _mm256_add_ps(_mm256_mul_ps(ox, ox), _mm256_mul_ps(oy, oy)),
+                _mm256_mul_ps(oz, oz)),
+            _mm256_mul_ps(r, r))};
+
+        __m256 const va{_mm256_set1_ps(a)};
+        __m256 const discriminant{
+            _mm256_sub_ps(_mm256_mul_ps(h, h), _mm256_mul_ps(va, c))};
+        __m256 const sqrtd{
+            _mm256_sqrt_ps(_mm256_max_ps(discriminant, _mm256_setzero_ps()))};
+
+        __m256 const near{_mm256_div_ps(_mm256_sub_ps(h, sqrtd), va)};
+        __m256 const far{_mm256_div_ps(_mm256_add_ps(h, sqrtd), va)};
+
+        __m256 const vmin{_mm256_set1_ps(min_distance)};
+        __m256 const vmax{_mm256_set1_ps(tmax)};
+        __m256 const near_inside{
+            _mm256_and_ps(_mm256_cmp_ps(near, vmin, _CMP_GT_OQ),
+                _mm256_cmp_ps(near, vmax, _CMP_LT_OQ))};
+        __m256 const far_inside{
+            _mm256_and_ps(_mm256_cmp_ps(far, vmin, _CMP_GT_OQ),
+                _mm256_cmp_ps(far, vmax, _CMP_LT_OQ))};
+
+        __m256i const lanes{_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)};
+        __m256 const valid{_mm256_and_ps(
+            _mm256_cmp_ps(discriminant, _mm256_setzero_ps(), _CMP_GE_OQ),
+            _mm256_castsi256_ps(_mm256_cmpgt_epi32(
+                _mm256_set1_epi32(cppext::narrow<int>(count)),
+                lanes)))};
+
+        __m256 root{_mm256_blendv_ps(_mm256_set1_ps(no_hit), far, far_inside)};
+        root = _mm256_blendv_ps(root, near, near_inside);
+        root = _mm256_blendv_ps(_mm256_set1_ps(no_hit), root, valid);
+
+        _mm256_storeu_ps(roots.data(), root);
+#else
+        // Fixed trip count without branches, compilers vectorize it for the
+        // instruction set they target
+        for (uint32_t lane{}; lane != batch_width; ++lane)
+        {
+            glm::vec3 const oc{x[lane] - origin.x,
+                y[lane] - origin.y,
+                z[lane] - origin.z};
+
+            float const h{glm::dot(direction, oc)};
+            float const c{glm::dot(oc, oc) - radius[lane] * radius[lane]};
+            float const discriminant{h * h - a * c};
+            float const sqrtd{std::sqrt(std::max(discriminant, 0.0f))};
+
+            float const near{(h - sqrtd) / a};
+            float const far{(h + sqrtd) / a};
+
+            float root{far > min_distance && far < tmax ? far : no_hit};
+            root = near > min_distance && near < tmax ? near : root;
+            roots[lane] = discriminant >= 0.0f && lane < count ? root : no_hit;
+        }
+#endif
+
+        batch_hit rv;
+        for (uint32_t lane{}; lane != batch_width; ++lane)
+        {
+            if (roots[lane] < rv.t)
+            {
+                rv = {.t = roots[lane], .lane = lane};
+            }
+        }
+        return rv;
+    }
+
+    // Moller-Trumbore, edges are precomputed on the host
+    [[nodiscard]] float hit_triangle(beam::triangle const& tri,
+        glm::vec3 const& origin,
+        glm::vec3 const& direction,
+        float const tmax)
+    {
+        glm::vec3 const pvec{glm::cross(direction, tri.edge2)};
+        float const det{glm::dot(tri.edge1, pvec)};
+
+        if (std::abs(det) < 1e-12f)
+        {
+            return no_hit;
+        }
+
+        float const inv_det{1.0f / det};
+
+        glm::vec3 const tvec{origin - tri.v0};
+        float const u{glm::dot(tvec, pvec) * inv_det};
+        if (u < 0.0f || u > 1.0f)
+        {
+            return no_hit;
+        }
+
+        glm::vec3 const qvec{glm::cross(tvec, tri.edge1)};
+        float const v{glm::dot(direction, qvec) * inv_det};
+        if (v < 0.0f || u + v > 1.0f)
+        {
+            return no_hit;
+        }
+
+        float const t{glm::dot(tri.edge2, qvec) * inv_det};
+        return t > min_distance && t < tmax ? t : no_hit;
+    }
+
+    [[nodiscard]] float luminance(glm::vec3 const& color)
+    {
+        return glm::dot(color, glm::vec3{0.2126f, 0.7152f, 0.0722f});
+    }
+
+    // Welford's online update of mean and variance, same as in adaptive.glsl
+    [[nodiscard]] glm::vec4 add_sample(glm::vec4 statistics,
+        glm::vec3 const& color)
+    {
+        float const l{luminance(color)};
+        statistics.z += 1.0f;
+        float const delta{l - statistics.x};
+        statistics.x += delta / statistics.z;
+        statistics.y += delta * (l - statistics.x);
+        return statistics;
+    }
+
+    struct [[nodiscard]] tile_queue final
+    {
+        std::mutex mutex;
+        std::deque<uint32_t> tiles;
+    };
+
+    // Own tiles are taken from the front, tiles of other workers are stolen
+    // from the back, away from the ones their owner takes next
+    [[nodiscard]] std::optional<uint32_t> take_tile(
+        std::span<tile_queue> const queues,
+        size_t const worker)
+    {
+        for (size_t i{}; i != queues.size(); ++i)
+        {
+            tile_queue& queue{queues[(worker + i) % queues.size()]};
+
+            std::scoped_lock const lock{queue.mutex};
+            if (queue.tiles.empty())
+            {
+                continue;
+            }
+
+            uint32_t rv; // NOLINT
+            if (i == 0)
+            {
+                rv = queue.tiles.front();
+                queue.tiles.pop_front();
+            }
+            else
+            {
+                rv = queue.tiles.back();
+                queue.tiles.pop_back();
+            }
+            return rv;
+        }
+
+        return std::nullopt;
+    }
+} // namespace
+
+struct [[nodiscard]] beam::cpu_tracer::ray final
+{
+    glm::vec3 origin;
+    glm::vec3 direction;
+
+    [[nodiscard]] glm::vec3 at(float const t) const
+    {
+        return origin + t * direction;
+    }
+};
+
+struct [[nodiscard]] beam::cpu_tracer::hit_record final
+{
+    glm::vec3 p;
+    glm::vec3 normal;
+    float t;
+    uint32_t material;
+    bool front_face;
+    bool triangle;
+    uint32_t primitive;
+};
+
+struct [[nodiscard]] beam::cpu_tracer::camera final
+{
+    glm::vec3 pixel00;
+    glm::vec3 pixel_delta_u;
+    glm::vec3 pixel_delta_v;
+    glm::vec3 defocus_disk_u;
+    glm::vec3 defocus_disk_v;
+};
+
+// Owen scrambled Sobol sequence of random.glsl, the same pixel, sequence
+// seed and sample index give the same numbers as the shaders
+class [[nodiscard]] beam::cpu_tracer::sampler final
+{
+public:
+    sampler(uint32_t const x,
+        uint32_t const y,
+        uint32_t const sequence_seed,
+        uint32_t const sample_index)
+        : seed_{pixel_seed(x, y, sequence_seed)}
+        , index_{sample_index}
+    {
+    }
+
+public:
+    [[nodiscard]] float next()
+    {
+        uint32_t const x{scrambled_sobol(seed_, index_, dimension_++)};
+
+        // 24 bits keep the result below 1 after conversion
+        return cppext::as_fp(x >> 8u) / 16777216.0f;
+    }
+
+    // Both coordinates come from the same pair of dimensions of a padding
+    // group
+    [[nodiscard]] glm::vec2 next_vec2()
+    {
+        dimension_ += dimension_ & 1u;
+        float const x{next()};
+        return {x, next()};
+    }
+
+    [[nodiscard]] glm::vec3 norm_vec3()
+    {
+        glm::vec2 const u{next_vec2()};
+        float const z{1.0f - 2.0f * u.x};
+        float const r{std::sqrt(std::max(0.0f, 1.0f - z * z))};
+        float const phi{2.0f * pi * u.y};
+        return {r * std::cos(phi), r * std::sin(phi), z};
+    }
+
+    [[nodiscard]] glm::vec2 in_unit_disk()
+    {
+        glm::vec2 const u{next_vec2()};
+        float const r{std::sqrt(u.x)};
+        float const phi{2.0f * pi * u.y};
+        return {r * std::cos(phi), r * std::sin(phi)};
+    }
+
+private:
+    uint32_t seed_;
+    uint32_t index_;
+    uint32_t dimension_{};
+};
+
+beam::cpu_tracer::cpu_tracer(scene_view const& scene,
+    VkExtent2D const extent,
+    uint32_t const thread_count)
+    : extent_{extent}
+    , thread_count_{thread_count != 0
+              ? thread_count
+              : std::max(std::thread::hardware_concurrency(), 1u)}
+    , sphere_materials_{scene.sphere_materials.begin(),
+          scene.sphere_materials.end()}
+    , nodes_{scene.nodes.begin(), scene.nodes.end()}
+    , triangles_{scene.triangles.begin(), scene.triangles.end()}
+    , triangle_root_{scene.triangle_root}
+    , lights_{scene.lights.begin(), scene.lights.end()}
+    , image_(size_t{extent.width} * extent.height, glm::vec4{0.0f})
+{
+    size_t const padded{scene.center_radius.size() + batch_width};
+    sphere_x_.reserve(padded);
+    sphere_y_.reserve(padded);
+    sphere_z_.reserve(padded);
+    sphere_radius_.reserve(padded);
+    for (glm::vec4 const& s : scene.center_radius)
+    {
+        sphere_x_.push_back(s.x);
+        sphere_y_.push_back(s.y);
+        sphere_z_.push_back(s.z);
+        sphere_radius_.push_back(s.w);
+    }
+    sphere_x_.resize(padded);
+    sphere_y_.resize(padded);
+    sphere_z_.resize(padded);
+    sphere_radius_.resize(padded);
+
+    std::ranges::transform(scene.materials,
+        std::back_inserter(materials_),
+        unpack_material);
+
+    node_ranges_.reserve(nodes_.size());
+    std::ranges::transform(nodes_,
+        std::back_inserter(node_ranges_),
+        [](bvh_node const& node) -> primitive_range
+        { return {.first = node.left_first, .count = node.count}; });
+
+    if (!scene.center_radius.empty())
+    {
+        static_cast<void>(collapse_sphere_nodes(0));
+    }
+
+    workers_.reserve(thread_count_ - 1);
+    for (size_t worker{1}; worker != thread_count_; ++worker)
+    {
+        workers_.emplace_back([this, worker](std::stop_token const& stop)
+            { run_worker(stop, worker); });
+    }
+}
+
+beam::cpu_tracer::~cpu_tracer() = default;
+
+template<typename TraceTile>
+void beam::cpu_tracer::for_each_tile(uint32_t const first_row,
+    uint32_t const row_count,
+    TraceTile const& trace_tile) const
+{
+    uint32_t const tiles_x{(extent_.width + tile_size - 1) / tile_size};
+    uint32_t const tiles_y{(row_count + tile_size - 1) / tile_size};
+    uint32_t const tile_count{tiles_x * tiles_y};
+    uint32_t const end_row{first_row + row_count};
+
+    // Workers start with consecutive runs of tiles, neighbouring pixels
+    // take similar paths through the scene
+    std::vector<tile_queue> queues(thread_count_);
+    for (uint32_t tile{}; tile != tile_count; ++tile)
+    {
+        queues[size_t{tile} * thread_count_ / tile_count].tiles.push_back(
+            tile);
+    }
+
+    auto const work = [&](size_t const worker)
+    {
+        while (std::optional<uint32_t> const tile{take_tile(queues, worker)})
+        {
+            uint32_t const x0{(*tile % tiles_x) * tile_size};
+            uint32_t const y0{first_row + (*tile / tiles_x) * tile_size};
+            trace_tile(tile_bounds{.x0 = x0,
+                .y0 = y0,
+                .x1 = std::min(x0 + tile_size, extent_.width),
+                .y1 = std::min(y0 + tile_size, end_row)});
+        }
+    };
+
+    {
+        std::scoped_lock const lock{work_mutex_};
+        work_ = [&work](size_t const worker) { work(worker); };
+        busy_workers_ = workers_.size();
+        ++work_generation_;
+    }
+    work_ready_.notify_all();
+
+    work(0);
+
+    std::unique_lock lock{work_mutex_};
+    work_done_.wait(lock, [this] { return busy_workers_ == 0; });
+    work_ = nullptr;
+}
+
+void beam::cpu_tracer::run_worker(std::stop_token const& stop,
+    size_t const worker) const
+{
+    uint64_t generation{};
+    while (true)
+    {
+        {
+            std::unique_lock lock{work_mutex_};
+            if (!work_ready_.wait(lock,
+                    stop,
+                    [this, generation]
+                    { return work_generation_ != generation; }))
+            {
+                return;
+            }
+            generation = work_generation_;
+        }
+
+        // Unchanged until every worker is done with it
+        work_(worker);
+
+        std::scoped_lock const lock{work_mutex_};
+        if (--busy_workers_ == 0)
+        {
+            work_done_.notify_one();
+        }
+    }
+}
+
+void beam::cpu_tracer::trace(frame_uniforms const& frame,
+    uint32_t const samples)
+{
+    camera const c{make_camera(frame)};
+
+    // The first samples of an accumulation are taken without defocus blur,
+    // like the shader does for frames with no samples yet
+    bool const pinhole{frame.defocus_angle <= 0.0f || total_samples_ == 0};
+
+    for_each_tile(0,
+        extent_.height,
+        [&](tile_bounds const& tile)
+        {
+            for (uint32_t y{tile.y0}; y != tile.y1; ++y)
+            {
+                for (uint32_t x{tile.x0}; x != tile.x1; ++x)
+                {
+                    glm::vec4& pixel{image_[size_t{y} * extent_.width + x]};
+                    glm::vec4 color{pixel * cppext::as_fp(total_samples_)};
+                    for (uint32_t i{}; i != samples; ++i)
+                    {
+                        color += trace_sample(frame,
+                            c,
+                            x,
+                            y,
+                            total_samples_ + i,
+                            pinhole);
+                    }
+                    pixel = color / cppext::as_fp(total_samples_ + samples);
+                }
+            }
+        });
+
+    total_samples_ += samples;
+}
+
+void beam::cpu_tracer::trace_band(frame_uniforms const& frame,
+    std::span<uint32_t const> const first_samples,
+    uint32_t const samples,
+    uint32_t const first_row,
+    uint32_t const row_count,
+    std::span<glm::vec4> const colors,
+    std::span<glm::vec4> const statistics) const
+{
+    camera const c{make_camera(frame)};
+
+    for_each_tile(first_row,
+        row_count,
+        [&](tile_bounds const& tile)
+        {
+            for (uint32_t y{tile.y0}; y != tile.y1; ++y)
+            {
+                uint32_t const first_sample{first_samples[y - first_row]};
+                bool const pinhole{
+                    frame.defocus_angle <= 0.0f || first_sample == 0};
+                for (uint32_t x{tile.x0}; x != tile.x1; ++x)
+                {
+                    glm::vec4 color{0.0f};
+                    glm::vec4 pixel_statistics{0.0f};
+                    for (uint32_t i{}; i != samples; ++i)
+                    {
+                        glm::vec4 const sample{trace_sample(frame,
+                            c,
+                            x,
+                            y,
+                            first_sample + i,
+                            pinhole)};
+                        color += sample;
+                        pixel_statistics =
+                            add_sample(pixel_statistics, glm::vec3{sample});
+                    }
+
+                    size_t const index{
+                        size_t{y - first_row} * extent_.width + x};
+                    colors[index] = color;
+                    statistics[index] = pixel_statistics;
+                }
+            }
+        });
+}
+
+void beam::cpu_tracer::reset()
+{
+    std::ranges::fill(image_, glm::vec4{0.0f});
+    total_samples_ = 0;
+}
+
+uint32_t beam::cpu_tracer::total_samples() const { return total_samples_; }
+
+std::span<glm::vec4 const> beam::cpu_tracer::image() const { return image_; }
+
+VkExtent2D beam::cpu_tracer::extent() const { return extent_; }
+
+uint32_t beam::cpu_tracer::thread_count() const { return thread_count_; }
+
+beam::cpu_tracer::primitive_range beam::cpu_tracer::collapse_sphere_nodes(
+    uint32_t const node)
+{
+    bvh_node const& n{nodes_[node]};
+    if (n.count != 0)
+    {
+        return node_ranges_[node];
+    }
+
+    primitive_range const left{collapse_sphere_nodes(n.left_first)};
+    primitive_range const right{collapse_sphere_nodes(n.left_first + 1)};
+    if (left.count == 0 || right.count == 0)
+    {
+        return {};
+    }
+
+    primitive_range rv;
+    if (left.first + left.count == right.first)
+    {
+        rv = {.first = left.first, .count = left.count + right.count};
+    }
+    else if (right.first + right.count == left.first)
+    {
+        rv = {.first = right.first, .count = left.count + right.count};
+    }
+    else
+    {
+        return {};
+    }
+
+    if (rv.count <= batch_width)
+    {
+        node_ranges_[node] = rv;
+    }
+    return rv;
+}
+
+beam::cpu_tracer::camera beam::cpu_tracer::make_camera(
+    frame_uniforms const& frame) const
+{
+    float const aspect_ratio{
+        cppext::as_fp(extent_.width) / cppext::as_fp(extent_.height)};
+
+    glm::vec3 const w{
+        glm::normalize(frame.camera_position - frame.camera_front)};
+    glm::vec3 const u{glm::normalize(glm::cross(frame.camera_up, w))};
+    glm::vec3 const v{glm::cross(w, u)};
+
+    float const h{std::tan(glm::radians(frame.fovy) / 2.0f)};
+
+    float const viewport_height{2.0f * h * frame.focus_distance};
+    float const viewport_width{viewport_height * aspect_ratio};
+
+    glm::vec3 const viewport_u{viewport_width * u};
+    glm::vec3 const viewport_v{viewport_height * -v};
+
+    camera rv; // NOLINT
+    rv.pixel_delta_u = viewport_u / cppext::as_fp(extent_.width);
+    rv.pixel_delta_v = viewport_v / cppext::as_fp(extent_.height);
+
+    glm::vec3 const viewport_upper_left{frame.camera_position -
+        frame.focus_distance * w - viewport_u / 2.0f - viewport_v / 2.0f};
+    rv.pixel00 = viewport_upper_left +
+        0.5f * (rv.pixel_delta_u + rv.pixel_delta_v);
+
+    float const defocus_radius{frame.focus_distance *
+        std::tan(glm::radians(frame.defocus_angle / 2.0f))};
+    rv.defocus_disk_u = u * defocus_radius;
+    rv.defocus_disk_v = v * defocus_radius;
+
+    return rv;
+}
+
+glm::vec4 beam::cpu_tracer::trace_sample(frame_uniforms const& frame,
+    camera const& c,
+    uint32_t const x,
+    uint32_t const y,
+    uint32_t const sample,
+    bool const pinhole) const
+{
+    sampler s{x, y, frame.sequence_seed, sample};
+
+    glm::vec2 const offset{s.next_vec2() - 0.5f};
+    glm::vec3 const target{c.pixel00 +
+        (cppext::as_fp(x) + offset.x) * c.pixel_delta_u +
+        (cppext::as_fp(y) + offset.y) * c.pixel_delta_v};
+
+    glm::vec3 origin{frame.camera_position};
+    if (!pinhole)
+    {
+        glm::vec2 const p{s.in_unit_disk()};
+        origin += p.x * c.defocus_disk_u + p.y * c.defocus_disk_v;
+    }
+
+    return glm::vec4{
+        ray_color({.origin = origin, .direction = target - origin}, frame, s),
+        1.0f};
+}
+
+glm::vec3 beam::cpu_tracer::ray_color(ray r,
+    frame_uniforms const& frame,
+    sampler& s) const
+{
+    glm::vec3 throughput{1.0f};
+    glm::vec3 radiance{0.0f};
+
+    // Solid angle density of the scattered ray, zero for camera rays and
+    // specular scattering which can't be matched by light sampling
+    float bsdf_pdf{0.0f};
+    glm::vec3 origin{r.origin};
+
+    for (uint32_t i{}; i != frame.max_depth; ++i)
+    {
+        hit_record rec; // NOLINT
+        if (!hit_world(r, no_hit, rec))
+        {
+            radiance +=
+                throughput * sky_color(r.direction, frame.sky_intensity);
+            break;
+        }
+
+        if (rec.material >= materials_.size())
+        {
+            break;
+        }
+
+        material const& m{materials_[rec.material]};
+        if (m.type == emissive_material)
+        {
+            float const weight{bsdf_pdf > 0.0f && !rec.triangle
+                    ? power_heuristic(bsdf_pdf,
+                          light_pdf(rec.primitive, origin, frame.light_count))
+                    : 1.0f};
+            glm::vec3 const emission{
+                rec.front_face ? m.color * m.value : glm::vec3{0.0f}};
+            radiance += throughput * emission * weight;
+            break;
+        }
+
+        // Light samples are paths one bounce longer, the last bounce can't
+        // take one without a scattered counterpart
+        if (m.type == lambertian_material && frame.light_count != 0 &&
+            i + 1 < frame.max_depth)
+        {
+            radiance += throughput *
+                sample_light(rec, m.color, frame.light_count, s);
+        }
+
+        ray scattered; // NOLINT
+        glm::vec3 attenuation; // NOLINT
+        if (!scatter(m, r, rec, s, attenuation, scattered))
+        {
+            break;
+        }
+
+        bsdf_pdf = m.type == lambertian_material
+            ? std::max(glm::dot(glm::normalize(scattered.direction),
+                           rec.normal),
+                  0.0f) /
+                pi
+            : 0.0f;
+        origin = rec.p;
+
+        throughput *= attenuation;
+        r = scattered;
+
+        if (i >= roulette_depth)
+        {
+            float const survival{std::min(
+                std::max({throughput.r, throughput.g, throughput.b}),
+                0.95f)};
+            if (s.next() >= survival)
+            {
+                break;
+            }
+            throughput /= survival;
+        }
+    }
+
+    return radiance;
+}
+
+bool beam::cpu_tracer::hit_world(ray const& r,
+    float const tmax,
+    hit_record& rec) const
+{
+    bool hit_anything{hit_spheres(r, tmax, rec)};
+
+    if (!triangles_.empty())
+    {
+        hit_anything =
+            hit_triangles(r, hit_anything ? rec.t : tmax, rec) || hit_anything;
+    }
+
+    return hit_anything;
+}
+
+bool beam::cpu_tracer::hit_spheres(ray const& r,
+    float const tmax,
+    hit_record& rec) const
+{
+    if (sphere_materials_.empty())
+    {
+        return false;
+    }
+
+    float closest{tmax};
+    uint32_t sphere{};
+
+    auto const test_range = [&](uint32_t const node, float& closest_so_far)
+    {
+        primitive_range const range{node_ranges_[node]};
+
+        bool hit{false};
+        for (uint32_t first{range.first}; first < range.first + range.count;
+            first += batch_width)
+        {
+            batch_hit const batch{hit_sphere_batch(sphere_x_.data() + first,
+                sphere_y_.data() + first,
+                sphere_z_.data() + first,
+                sphere_radius_.data() + first,
+                std::min(batch_width, range.first + range.count - first),
+                r.origin,
+                r.direction,
+                closest_so_far)};
+            if (batch.t < closest_so_far)
+            {
+                closest_so_far = batch.t;
+                sphere = first + batch.lane;
+                hit = true;
+            }
+        }
+        return hit;
+    };
+
+    if (!traverse(std::span{nodes_},
+            std::span{node_ranges_},
+            0,
+            r.origin,
+            r.direction,
+            closest,
+            test_range))
+    {
+        return false;
+    }
+
+    glm::vec3 const center{sphere_x_[sphere],
+        sphere_y_[sphere],
+        sphere_z_[sphere]};
+
+    rec.t = closest;
+    rec.p = r.at(closest);
+    glm::vec3 const outward{(rec.p - center) / sphere_radius_[sphere]};
+    rec.front_face = glm::dot(r.direction, outward) < 0.0f;
+    rec.normal = rec.front_face ? outward : -outward;
+    rec.material = sphere_materials_[sphere];
+    rec.triangle = false;
+    rec.primitive = sphere;
+
+    return true;
+}
+
+bool beam::cpu_tracer::hit_triangles(ray const& r,
+    float const tmax,
+    hit_record& rec) const
+{
+    float closest{tmax};
+    uint32_t index{};
+
+    auto const test_range = [&](uint32_t const node, float& closest_so_far)
+    {
+        primitive_range const range{node_ranges_[node]};
+
+        bool hit{false};
+        for (uint32_t i{range.first}; i != range.first + range.count; ++i)
+        {
+            float const t{hit_triangle(triangles_[i],
+                r.origin,
+                r.direction,
+                closest_so_far)};
+            if (t < closest_so_far)
+            {
+                closest_so_far = t;
+                index = i;
+                hit = true;
+            }
+        }
+        return hit;
+    };
+
+    if (!traverse(std::span{nodes_},
+            std::span{node_ranges_},
+            triangle_root_,
+            r.origin,
+            r.direction,
+            closest,
+            test_range))
+    {
+        return false;
+    }
+
+    triangle const& tri{triangles_[index]};
+    glm::vec3 const outward{glm::normalize(glm::cross(tri.edge1, tri.edge2))};
+
+    rec.t = closest;
+    rec.p = r.at(closest);
+    rec.front_face = glm::dot(r.direction, outward) < 0.0f;
+    rec.normal = rec.front_face ? outward : -outward;
+    rec.material = tri.material;
+    rec.triangle = true;
+    rec.primitive = index;
+
+    return true;
+}
+
+bool beam::cpu_tracer::scatter(material const& m,
+    ray const& r,
+    hit_record const& rec,
+    sampler& s,
+    glm::vec3& attenuation,
+    ray& scattered) const
+{
+    if (m.type == lambertian_material)
+    {
+        glm::vec3 direction{rec.normal + s.norm_vec3()};
+        if (near_zero(direction))
+        {
+            direction = rec.normal;
+        }
+
+        scattered = {.origin = rec.p, .direction = direction};
+        attenuation = m.color;
+        return true;
+    }
+
+    if (m.type == metal_material)
+    {
+        glm::vec3 const reflected{glm::normalize(
+            glm::reflect(r.direction, rec.normal) + m.value * s.norm_vec3())};
+
+        scattered = {.origin = rec.p, .direction = reflected};
+        attenuation = m.color;
+        return glm::dot(reflected, rec.normal) > 0.0f;
+    }
+
+    if (m.type == dielectric_material)
+    {
+        float const ri{rec.front_face ? 1.0f / m.value : m.value};
+
+        glm::vec3 const unit_direction{glm::normalize(r.direction)};
+        float const cos_theta{
+            std::min(glm::dot(-unit_direction, rec.normal), 1.0f)};
+        float const sin_theta{std::sqrt(1.0f - cos_theta * cos_theta)};
+
+        bool const cannot_refract{ri * sin_theta > 1.0f};
+
+        glm::vec3 const direction{
+            cannot_refract || reflectance(cos_theta, ri) > s.next()
+                ? glm::reflect(unit_direction, rec.normal)
+                : glm::refract(unit_direction, rec.normal, ri)};
+
+        scattered = {.origin = rec.p, .direction = direction};
+        attenuation = glm::vec3{1.0f};
+        return true;
+    }
+
+    return false;
+}
+
+float beam::cpu_tracer::light_pdf(uint32_t const sphere,
+    glm::vec3 const& p,
+    uint32_t const light_count) const
+{
+    glm::vec3 const to_center{sphere_x_[sphere] - p.x,
+        sphere_y_[sphere] - p.y,
+        sphere_z_[sphere] - p.z};
+    float const sin2{sphere_radius_[sphere] * sphere_radius_[sphere] /
+        glm::dot(to_center, to_center)};
+    if (light_count == 0 || sin2 >= 1.0f)
+    {
+        return 0.0f;
+    }
+
+    float const cos_theta_max{std::sqrt(1.0f - sin2)};
+    return 1.0f /
+        (2.0f * pi * (1.0f - cos_theta_max) * cppext::as_fp(light_count));
+}
+
+glm::vec3 beam::cpu_tracer::sample_light(hit_record const& rec,
+    glm::vec3 const& albedo,
+    uint32_t const light_count,
+    sampler& s) const
+{
+    uint32_t const sphere{lights_[std::min(
+        static_cast<uint32_t>(s.next() * cppext::as_fp(light_count)),
+        light_count - 1)]};
+    glm::vec3 const center{sphere_x_[sphere],
+        sphere_y_[sphere],
+        sphere_z_[sphere]};
+
+    glm::vec3 const to_center{center - rec.p};
+    float const sin2{sphere_radius_[sphere] * sphere_radius_[sphere] /
+        glm::dot(to_center, to_center)};
+    if (sin2 >= 1.0f)
+    {
+        return glm::vec3{0.0f};
+    }
+
+    float const cos_theta_max{std::sqrt(1.0f - sin2)};
+    glm::vec2 const xi{s.next_vec2()};
+    float const cos_theta{1.0f - xi.x * (1.0f - cos_theta_max)};
+    float const sin_theta{
+        std::sqrt(std::max(0.0f, 1.0f - cos_theta * cos_theta))};
+    float const phi{2.0f * pi * xi.y};
+
+    glm::vec3 const w{glm::normalize(to_center)};
+    glm::vec3 const u{glm::normalize(glm::cross(
+        std::abs(w.x) > 0.9f ? glm::vec3{0.0f, 1.0f, 0.0f}
+                             : glm::vec3{1.0f, 0.0f, 0.0f},
+        w))};
+    glm::vec3 const v{glm::cross(w, u)};
+    glm::vec3 const direction{
+        (std::cos(phi) * u + std::sin(phi) * v) * sin_theta + w * cos_theta};
+
+    float const cos_surface{glm::dot(direction, rec.normal)};
+    if (cos_surface <= 0.0f)
+    {
+        return glm::vec3{0.0f};
+    }
+
+    hit_record shadow; // NOLINT
+    if (!hit_world({.origin = rec.p, .direction = direction}, no_hit, shadow) ||
+        shadow.triangle || shadow.primitive != sphere)
+    {
+        return glm::vec3{0.0f};
+    }
+
+    material const& light{materials_[shadow.material]};
+    glm::vec3 const emission{
+        shadow.front_face ? light.color * light.value : glm::vec3{0.0f}};
+
+    float const pdf{light_pdf(sphere, rec.p, light_count)};
+    float const bsdf_pdf{cos_surface / pi};
+    glm::vec3 const brdf{albedo / pi};
+
+    return emission * brdf * cos_surface / pdf *
+        power_heuristic(pdf, bsdf_pdf);
+}
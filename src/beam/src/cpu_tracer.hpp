@@ -0,0 +1,201 @@
+#ifndef BEAM_CPU_TRACER_INCLUDED
+#define BEAM_CPU_TRACER_INCLUDED
+
+#include <bvh.hpp>
+#include <frame_uniforms.hpp>
+#include <mesh.hpp>
+#include <scene_file.hpp>
+#include <sphere.hpp>
+
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+
+#include <vulkan/vulkan_core.h>
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <span>
+#include <stop_token>
+#include <thread>
+#include <vector>
+
+namespace beam
+{
+    // Host implementation of raytracer.comp for machines without a GPU. It
+    // follows the camera, sample sequence, materials and light sampling of
+    // the shader, the same scene and frame uniforms converge to the same
+    // image. The image is split into tiles, worker threads take tiles from
+    // their own queue and steal from the others once it is empty. Workers
+    // live as long as the tracer and wait for the next call in between, a
+    // tracer is used by one thread at a time. Spheres
+    // are intersected a batch at a time, with AVX2 when the build targets it.
+    // Bands of rows can also be traced without accumulating them, for
+    // merging into the image of the GPU.
+    class [[nodiscard]] cpu_tracer final
+    {
+    public:
+        // Zero threads uses every hardware thread
+        cpu_tracer(scene_view const& scene,
+            VkExtent2D extent,
+            uint32_t thread_count = 0);
+
+        cpu_tracer(cpu_tracer const&) = delete;
+
+        cpu_tracer(cpu_tracer&&) noexcept = delete;
+
+    public:
+        ~cpu_tracer();
+
+    public:
+        // Adds samples to every pixel. Scene counts of the uniforms are
+        // ignored, the scene is the one the tracer was created with.
+        void trace(frame_uniforms const& frame, uint32_t samples);
+
+        // Samples of a band of rows, written instead of accumulated so they
+        // can be merged into an image accumulated elsewhere. Colors get the
+        // sum of the samples of every pixel of the band and statistics their
+        // luminance mean, sum of squared differences from it and count, in
+        // the layout of the variance image. Samples continue the sequence of
+        // pixels that already have first_samples samples, one count for
+        // every row of the band. Both image spans hold row_count rows.
+        void trace_band(frame_uniforms const& frame,
+            std::span<uint32_t const> first_samples,
+            uint32_t samples,
+            uint32_t first_row,
+            uint32_t row_count,
+            std::span<glm::vec4> colors,
+            std::span<glm::vec4> statistics) const;
+
+        // Accumulation starts over
+        void reset();
+
+        [[nodiscard]] uint32_t total_samples() const;
+
+        // Mean radiance of every pixel, row by row, in the layout of the
+        // color image of the renderer
+        [[nodiscard]] std::span<glm::vec4 const> image() const;
+
+        [[nodiscard]] VkExtent2D extent() const;
+
+        [[nodiscard]] uint32_t thread_count() const;
+
+    public:
+        cpu_tracer& operator=(cpu_tracer const&) = delete;
+
+        cpu_tracer& operator=(cpu_tracer&&) noexcept = delete;
+
+    private:
+        struct camera;
+        struct hit_record;
+        struct ray;
+        class sampler;
+
+        struct [[nodiscard]] tile_bounds final
+        {
+            uint32_t x0{};
+            uint32_t y0{};
+            uint32_t x1{};
+            uint32_t y1{};
+        };
+
+        // Primitives of a node tested instead of descending into it
+        struct [[nodiscard]] primitive_range final
+        {
+            uint32_t first{};
+            uint32_t count{};
+        };
+
+    private:
+        // Sphere subtrees with few enough primitives in consecutive slots
+        // are tested as a single batch
+        [[nodiscard]] primitive_range collapse_sphere_nodes(uint32_t node);
+
+        [[nodiscard]] camera make_camera(frame_uniforms const& frame) const;
+
+        // Calls trace_tile for every tile of the rows on the worker threads
+        template<typename TraceTile>
+        void for_each_tile(uint32_t first_row,
+            uint32_t row_count,
+            TraceTile const& trace_tile) const;
+
+        // Runs the work of each call of for_each_tile on a worker thread
+        // until the tracer is destroyed
+        void run_worker(std::stop_token const& stop, size_t worker) const;
+
+        [[nodiscard]] glm::vec4 trace_sample(frame_uniforms const& frame,
+            camera const& c,
+            uint32_t x,
+            uint32_t y,
+            uint32_t sample,
+            bool pinhole) const;
+
+        [[nodiscard]] glm::vec3 ray_color(ray r,
+            frame_uniforms const& frame,
+            sampler& s) const;
+
+        [[nodiscard]] bool hit_world(ray const& r,
+            float tmax,
+            hit_record& rec) const;
+
+        [[nodiscard]] bool hit_spheres(ray const& r,
+            float tmax,
+            hit_record& rec) const;
+
+        [[nodiscard]] bool hit_triangles(ray const& r,
+            float tmax,
+            hit_record& rec) const;
+
+        [[nodiscard]] bool scatter(material const& m,
+            ray const& r,
+            hit_record const& rec,
+            sampler& s,
+            glm::vec3& attenuation,
+            ray& scattered) const;
+
+        [[nodiscard]] float light_pdf(uint32_t sphere,
+            glm::vec3 const& p,
+            uint32_t light_count) const;
+
+        [[nodiscard]] glm::vec3 sample_light(hit_record const& rec,
+            glm::vec3 const& albedo,
+            uint32_t light_count,
+            sampler& s) const;
+
+    private:
+        VkExtent2D extent_;
+        uint32_t thread_count_;
+
+        // Centers and radii of spheres in separate arrays, padded so a
+        // batch starting at any sphere can be loaded
+        std::vector<float> sphere_x_;
+        std::vector<float> sphere_y_;
+        std::vector<float> sphere_z_;
+        std::vector<float> sphere_radius_;
+        std::vector<uint32_t> sphere_materials_;
+        std::vector<material> materials_;
+        std::vector<bvh_node> nodes_;
+        std::vector<primitive_range> node_ranges_;
+        std::vector<triangle> triangles_;
+        uint32_t triangle_root_;
+        std::vector<uint32_t> lights_;
+
+        std::vector<glm::vec4> image_;
+        uint32_t total_samples_{};
+
+        // Work of the current call of for_each_tile, called with the index
+        // of the worker. Workers pick it up when the generation changes.
+        mutable std::mutex work_mutex_;
+        mutable std::condition_variable_any work_ready_;
+        mutable std::condition_variable work_done_;
+        mutable std::function<void(size_t)> work_;
+        mutable uint64_t work_generation_{};
+        mutable size_t busy_workers_{};
+        // Threads other than the calling one, destroyed first
+        std::vector<std::jthread> workers_;
+    };
+} // namespace beam
+
+#endif
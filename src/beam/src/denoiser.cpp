@@ -0,0 +1,382 @@
+#include <denoiser.hpp>
+
+#include <async_compute.hpp>
+
+#include <cppext_numeric.hpp>
+
+#include <vulkan_commands.hpp>
+#include <vulkan_descriptors.hpp>
+#include <vulkan_device.hpp>
+#include <vulkan_image.hpp>
+#include <vulkan_pipeline.hpp>
+#include <vulkan_queue.hpp>
+#include <vulkan_utility.hpp>
+
+#include <imgui.h>
+
+#include <vulkan/vulkan_core.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <span>
+
+namespace
+{
+    constexpr uint32_t binding_count{4};
+
+    constexpr int max_iterations{5};
+
+    // Matches PushConsts in denoise.comp
+    struct [[nodiscard]] push_constants final
+    {
+        int32_t step_width;
+        float color_phi;
+        float normal_phi;
+        float depth_phi;
+        uint32_t demodulate;
+        uint32_t remodulate;
+    };
+
+    // Images are referred to by index, color image is 0, intermediate images
+    // 1 and 2 and the output image 3
+    struct [[nodiscard]] pass final
+    {
+        uint32_t source;
+        uint32_t target;
+    };
+
+    // First iteration reads the color image, the last one writes the output
+    // image and the ones in between alternate the intermediate images
+    constexpr std::array<pass, 6> passes{{{0, 1},
+        {0, 3},
+        {1, 2},
+        {1, 3},
+        {2, 1},
+        {2, 3}}};
+
+    [[nodiscard]] size_t pass_index(uint32_t const source,
+        uint32_t const target)
+    {
+        auto const it{std::ranges::find_if(passes,
+            [source, target](pass const& p)
+            { return p.source == source && p.target == target; })};
+        return cppext::narrow<size_t>(std::distance(passes.cbegin(), it));
+    }
+
+    [[nodiscard]] VkDescriptorPool create_descriptor_pool(
+        vkrndr::vulkan_device const* const device)
+    {
+        VkDescriptorPoolSize storage_image_pool_size{};
+        storage_image_pool_size.type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        storage_image_pool_size.descriptorCount =
+            binding_count * vkrndr::count_cast(passes.size());
+
+        VkDescriptorPoolCreateInfo pool_info{};
+        pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        pool_info.poolSizeCount = 1;
+        pool_info.pPoolSizes = &storage_image_pool_size;
+        pool_info.maxSets = vkrndr::count_cast(passes.size());
+
+        VkDescriptorPool rv; // NOLINT
+        vkrndr::check_result(
+            vkCreateDescriptorPool(device->logical, &pool_info, nullptr, &rv));
+
+        return rv;
+    }
+
+    [[nodiscard]] VkDescriptorSetLayout create_descriptor_set_layout(
+        vkrndr::vulkan_device const* const device)
+    {
+        std::array<VkDescriptorSetLayoutBinding, binding_count> bindings{};
+        for (uint32_t i{}; VkDescriptorSetLayoutBinding & binding : bindings)
+        {
+            binding.binding = i++;
+            binding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+            binding.descriptorCount = 1;
+            binding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        }
+
+        VkDescriptorSetLayoutCreateInfo layout_info{};
+        layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        layout_info.bindingCount = vkrndr::count_cast(bindings.size());
+        layout_info.pBindings = bindings.data();
+
+        VkDescriptorSetLayout rv; // NOLINT
+        vkrndr::check_result(vkCreateDescriptorSetLayout(device->logical,
+            &layout_info,
+            nullptr,
+            &rv));
+
+        return rv;
+    }
+
+    [[nodiscard]] vkrndr::vulkan_image create_storage_image(
+        vkrndr::vulkan_device const& device,
+        VkExtent2D const extent,
+        VkFormat const format,
+        VkImageUsageFlags const usage = VK_IMAGE_USAGE_STORAGE_BIT)
+    {
+        return vkrndr::create_image_and_view(device,
+            extent,
+            1,
+            VK_SAMPLE_COUNT_1_BIT,
+            format,
+            VK_IMAGE_TILING_OPTIMAL,
+            usage,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            VK_IMAGE_ASPECT_COLOR_BIT,
+            beam::async_compute::queue_families(device));
+    }
+
+    void transition_to_general(vkrndr::vulkan_device const& device,
+        std::span<VkImage const> const images)
+    {
+        VkCommandPool const command_pool{
+            vkrndr::create_command_pool(device, device.present_queue->family)};
+
+        VkCommandBuffer command_buffer; // NOLINT
+        vkrndr::begin_single_time_commands(device,
+            command_pool,
+            1,
+            std::span{&command_buffer, 1});
+
+        for (VkImage const image : images)
+        {
+            vkrndr::transition_image(image,
+                command_buffer,
+                VK_IMAGE_LAYOUT_UNDEFINED,
+                VK_PIPELINE_STAGE_2_NONE,
+                VK_ACCESS_2_NONE,
+                VK_IMAGE_LAYOUT_GENERAL,
+                VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                VK_ACCESS_2_SHADER_STORAGE_READ_BIT |
+                    VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+                1);
+        }
+
+        vkrndr::end_single_time_commands(device,
+            device.present_queue->queue,
+            std::span{&command_buffer, 1},
+            command_pool);
+        vkDestroyCommandPool(device.logical, command_pool, nullptr);
+    }
+} // namespace
+
+beam::denoiser::denoiser(vkrndr::vulkan_device* const device,
+    vkrndr::vulkan_image const& color_image)
+    : device_{device}
+    , descriptor_pool_{create_descriptor_pool(device_)}
+    , descriptor_layout_{create_descriptor_set_layout(device_)}
+{
+    vkrndr::create_descriptor_sets(device_,
+        descriptor_layout_,
+        descriptor_pool_,
+        descriptor_sets_);
+
+    pipeline_ = std::make_unique<vkrndr::vulkan_pipeline>(
+        vkrndr::vulkan_compute_pipeline_builder{device_,
+            vkrndr::vulkan_pipeline_layout_builder{device_}
+                .add_descriptor_set_layout(descriptor_layout_)
+                .add_push_constants(VkPushConstantRange{
+                    .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+                    .offset = 0,
+                    .size = sizeof(push_constants),
+                })
+                .build()}
+            .with_shader("denoise.comp.spv", "main")
+            .build());
+
+    create_resources(color_image.extent);
+    update_descriptor_sets(color_image);
+}
+
+beam::denoiser::~denoiser()
+{
+    destroy_resources();
+
+    destroy(device_, pipeline_.get());
+
+    vkDestroyDescriptorSetLayout(device_->logical, descriptor_layout_, nullptr);
+    vkDestroyDescriptorPool(device_->logical, descriptor_pool_, nullptr);
+}
+
+void beam::denoiser::resize(vkrndr::vulkan_image const& color_image)
+{
+    destroy_resources();
+    create_resources(color_image.extent);
+    update_descriptor_sets(color_image);
+}
+
+bool beam::denoiser::enabled() const { return enabled_; }
+
+vkrndr::vulkan_image const& beam::denoiser::albedo_image() const
+{
+    return albedo_image_;
+}
+
+vkrndr::vulkan_image const& beam::denoiser::normal_depth_image() const
+{
+    return normal_depth_image_;
+}
+
+vkrndr::vulkan_image const& beam::denoiser::output_image() const
+{
+    return output_image_;
+}
+
+void beam::denoiser::draw(VkCommandBuffer command_buffer)
+{
+    // Features written by the raytracer are read, intermediate and output
+    // images are written after the previous frame is done reading them
+    vkrndr::memory_barrier(command_buffer,
+        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+        VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+        VK_ACCESS_2_SHADER_STORAGE_READ_BIT |
+            VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT);
+
+    auto const& extent{output_image_.extent};
+    auto const iterations{cppext::narrow<uint32_t>(iterations_)};
+    for (uint32_t i{}; i != iterations; ++i)
+    {
+        bool const first{i == 0};
+        bool const last{i + 1 == iterations};
+
+        uint32_t const source{first ? 0 : 1 + (i - 1) % 2};
+        uint32_t const target{last ? 3 : 1 + i % 2};
+
+        // Color similarity is tightened as the kernel widens, Dammertz et
+        // al. halve it every iteration
+        push_constants const pc{.step_width = 1 << i,
+            .color_phi = std::ldexp(color_phi_, -cppext::narrow<int>(i)),
+            .normal_phi = normal_phi_,
+            .depth_phi = depth_phi_,
+            .demodulate = first ? 1u : 0u,
+            .remodulate = last ? 1u : 0u};
+
+        vkCmdPushConstants(command_buffer,
+            *pipeline_->layout,
+            VK_SHADER_STAGE_COMPUTE_BIT,
+            0,
+            sizeof(push_constants),
+            &pc);
+
+        vkrndr::bind_pipeline(command_buffer,
+            *pipeline_,
+            0,
+            std::span{&descriptor_sets_[pass_index(source, target)], 1});
+
+        vkCmdDispatch(command_buffer,
+            static_cast<uint32_t>(
+                std::ceil(cppext::as_fp(extent.width) / 16.0f)),
+            static_cast<uint32_t>(
+                std::ceil(cppext::as_fp(extent.height) / 16.0f)),
+            1);
+
+        vkrndr::memory_barrier(command_buffer,
+            VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+            VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+            VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+            VK_ACCESS_2_SHADER_STORAGE_READ_BIT |
+                VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT);
+    }
+}
+
+void beam::denoiser::draw_imgui()
+{
+    ImGui::Begin("Denoiser");
+    ImGui::Checkbox("Enabled", &enabled_);
+    ImGui::SliderInt("Iterations", &iterations_, 1, max_iterations);
+    ImGui::SliderFloat("Color phi", &color_phi_, 0.01f, 10.0f);
+    ImGui::SliderFloat("Normal phi", &normal_phi_, 1.0f, 128.0f);
+    ImGui::SliderFloat("Depth phi", &depth_phi_, 0.001f, 0.1f);
+    ImGui::End();
+}
+
+void beam::denoiser::create_resources(VkExtent2D const extent)
+{
+    albedo_image_ = create_storage_image(*device_,
+        extent,
+        VK_FORMAT_R16G16B16A16_SFLOAT);
+    // Copied into the history of temporal reprojection
+    normal_depth_image_ = create_storage_image(*device_,
+        extent,
+        VK_FORMAT_R32G32B32A32_SFLOAT,
+        VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT);
+    for (vkrndr::vulkan_image& image : intermediate_images_)
+    {
+        image = create_storage_image(*device_,
+            extent,
+            VK_FORMAT_R32G32B32A32_SFLOAT);
+    }
+    output_image_ = create_storage_image(*device_,
+        extent,
+        VK_FORMAT_R32G32B32A32_SFLOAT);
+
+    std::array const images{albedo_image_.image,
+        normal_depth_image_.image,
+        intermediate_images_[0].image,
+        intermediate_images_[1].image,
+        output_image_.image};
+    transition_to_general(*device_, images);
+}
+
+void beam::denoiser::destroy_resources()
+{
+    destroy(device_, &output_image_);
+    for (vkrndr::vulkan_image& image : intermediate_images_)
+    {
+        destroy(device_, &image);
+    }
+    destroy(device_, &normal_depth_image_);
+    destroy(device_, &albedo_image_);
+}
+
+void beam::denoiser::update_descriptor_sets(
+    vkrndr::vulkan_image const& color_image)
+{
+    std::array const views{color_image.view,
+        intermediate_images_[0].view,
+        intermediate_images_[1].view,
+        output_image_.view};
+
+    std::array<VkDescriptorImageInfo, binding_count * passes.size()>
+        image_infos{};
+    std::array<VkWriteDescriptorSet, binding_count * passes.size()>
+        descriptor_writes{};
+    for (size_t i{}; i != passes.size(); ++i)
+    {
+        std::array const pass_views{views[passes[i].source],
+            views[passes[i].target],
+            albedo_image_.view,
+            normal_depth_image_.view};
+
+        for (size_t j{}; j != binding_count; ++j)
+        {
+            size_t const index{i * binding_count + j};
+
+            image_infos[index].imageView = pass_views[j];
+            image_infos[index].imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+            VkWriteDescriptorSet& write{descriptor_writes[index]};
+            write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            write.dstSet = descriptor_sets_[i];
+            write.dstBinding = cppext::narrow<uint32_t>(j);
+            write.dstArrayElement = 0;
+            write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+            write.descriptorCount = 1;
+            write.pImageInfo = &image_infos[index];
+        }
+    }
+
+    vkUpdateDescriptorSets(device_->logical,
+        vkrndr::count_cast(descriptor_writes.size()),
+        descriptor_writes.data(),
+        0,
+        nullptr);
+}
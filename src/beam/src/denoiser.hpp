@@ -0,0 +1,89 @@
+#ifndef BEAM_DENOISER_INCLUDED
+#define BEAM_DENOISER_INCLUDED
+
+#include <vulkan_image.hpp>
+
+#include <vulkan/vulkan_core.h>
+
+#include <array>
+#include <memory>
+
+namespace vkrndr
+{
+    struct vulkan_device;
+    struct vulkan_pipeline;
+} // namespace vkrndr
+
+namespace beam
+{
+    // Edge-avoiding a-trous wavelet filter of the accumulated image. Albedo,
+    // normal and depth of the first hit are written by the raytracer into
+    // the feature images and guide the filter, each iteration doubles the
+    // spacing of the 5x5 kernel taps.
+    class [[nodiscard]] denoiser final
+    {
+    public:
+        denoiser(vkrndr::vulkan_device* device,
+            vkrndr::vulkan_image const& color_image);
+
+        denoiser(denoiser const&) = delete;
+
+        denoiser(denoiser&&) noexcept = delete;
+
+    public:
+        ~denoiser();
+
+    public:
+        void resize(vkrndr::vulkan_image const& color_image);
+
+        [[nodiscard]] bool enabled() const;
+
+        [[nodiscard]] vkrndr::vulkan_image const& albedo_image() const;
+
+        [[nodiscard]] vkrndr::vulkan_image const& normal_depth_image() const;
+
+        [[nodiscard]] vkrndr::vulkan_image const& output_image() const;
+
+        // Color and feature images have to be in general layout with
+        // finished writes, the result is left in the output image
+        void draw(VkCommandBuffer command_buffer);
+
+        void draw_imgui();
+
+    public:
+        denoiser& operator=(denoiser const&) = delete;
+
+        denoiser& operator=(denoiser&&) noexcept = delete;
+
+    private:
+        void create_resources(VkExtent2D extent);
+
+        void destroy_resources();
+
+        void update_descriptor_sets(vkrndr::vulkan_image const& color_image);
+
+    private:
+        vkrndr::vulkan_device* device_;
+
+        VkDescriptorPool descriptor_pool_;
+        VkDescriptorSetLayout descriptor_layout_;
+        // A set for every pair of source and target images an iteration can
+        // read from and write to
+        std::array<VkDescriptorSet, 6> descriptor_sets_{};
+
+        std::unique_ptr<vkrndr::vulkan_pipeline> pipeline_;
+
+        vkrndr::vulkan_image albedo_image_;
+        vkrndr::vulkan_image normal_depth_image_;
+        std::array<vkrndr::vulkan_image, 2> intermediate_images_;
+        vkrndr::vulkan_image output_image_;
+
+        bool enabled_{false};
+        int iterations_{5};
+        float color_phi_{0.5f};
+        float normal_phi_{64.0f};
+        float depth_phi_{0.01f};
+    };
+} // namespace beam
+
+#endif
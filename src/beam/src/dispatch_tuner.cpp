@@ -0,0 +1,299 @@
+#include <dispatch_tuner.hpp>
+
+#include <cppext_numeric.hpp>
+
+#include <vulkan_commands.hpp>
+#include <vulkan_device.hpp>
+#include <vulkan_query.hpp>
+#include <vulkan_queue.hpp>
+#include <vulkan_utility.hpp>
+
+#include <imgui.h>
+
+#include <vulkan/vulkan_core.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <span>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace
+{
+    // Matches orderBlockSize in raytracer.comp
+    constexpr uint32_t order_block_size{8};
+
+    constexpr std::array<std::pair<uint32_t, uint32_t>, 10> shapes{{{8, 4},
+        {4, 8},
+        {8, 8},
+        {16, 4},
+        {16, 8},
+        {8, 16},
+        {32, 4},
+        {16, 16},
+        {32, 8},
+        {32, 16}}};
+
+    constexpr std::array orders{beam::workgroup_order::linear,
+        beam::workgroup_order::morton,
+        beam::workgroup_order::hilbert};
+
+    constexpr char const* cache_file{"dispatch_tuner.cache"};
+
+    [[nodiscard]] char const* order_name(beam::workgroup_order const order)
+    {
+        switch (order)
+        {
+        case beam::workgroup_order::morton:
+            return "Morton";
+        case beam::workgroup_order::hilbert:
+            return "Hilbert";
+        default:
+            return "Linear";
+        }
+    }
+
+    [[nodiscard]] uint32_t divide_up(uint32_t const value,
+        uint32_t const divisor)
+    {
+        return (value + divisor - 1) / divisor;
+    }
+
+    [[nodiscard]] std::string device_uuid(vkrndr::vulkan_device const& device)
+    {
+        VkPhysicalDeviceIDProperties id_properties{};
+        id_properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ID_PROPERTIES;
+
+        VkPhysicalDeviceProperties2 properties{};
+        properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+        properties.pNext = &id_properties;
+        vkGetPhysicalDeviceProperties2(device.physical, &properties);
+
+        std::ostringstream stream;
+        stream << std::hex << std::setfill('0');
+        for (uint8_t const byte : id_properties.deviceUUID)
+        {
+            stream << std::setw(2) << static_cast<uint32_t>(byte);
+        }
+        return stream.str();
+    }
+
+    [[nodiscard]] VkPhysicalDeviceLimits device_limits(
+        vkrndr::vulkan_device const& device)
+    {
+        VkPhysicalDeviceProperties properties; // NOLINT
+        vkGetPhysicalDeviceProperties(device.physical, &properties);
+        return properties.limits;
+    }
+} // namespace
+
+std::array<uint32_t, 3> beam::workgroup_counts(dispatch_config const& config,
+    uint32_t const width,
+    uint32_t const rows)
+{
+    uint32_t const groups_x{divide_up(width, config.width)};
+    uint32_t const groups_y{divide_up(rows, config.height)};
+
+    if (config.order == workgroup_order::linear)
+    {
+        return {groups_x, groups_y, 1};
+    }
+
+    return {order_block_size * order_block_size,
+        divide_up(groups_x, order_block_size),
+        divide_up(groups_y, order_block_size)};
+}
+
+beam::dispatch_tuner::dispatch_tuner(vkrndr::vulkan_device* const device)
+    : device_{device}
+    , timestamp_period_{vkrndr::timestamp_period(*device_,
+          device_->present_queue->family)}
+    , limits_{device_limits(*device_)}
+    , device_uuid_{device_uuid(*device_)}
+    , cache_path_{cache_file}
+{
+    if (supported())
+    {
+        query_pool_ =
+            vkrndr::create_query_pool(device_, VK_QUERY_TYPE_TIMESTAMP, 2);
+    }
+
+    load_cache();
+}
+
+beam::dispatch_tuner::~dispatch_tuner()
+{
+    vkDestroyQueryPool(device_->logical, query_pool_, nullptr);
+}
+
+bool beam::dispatch_tuner::supported() const
+{
+    return timestamp_period_ > 0.0f;
+}
+
+beam::dispatch_config const& beam::dispatch_tuner::config() const
+{
+    return config_;
+}
+
+void beam::dispatch_tuner::tune(record_function const& record)
+{
+    VkCommandPool const command_pool{
+        vkrndr::create_command_pool(*device_, device_->present_queue->family)};
+
+    measurements_.clear();
+    for (dispatch_config const& candidate : candidates())
+    {
+        VkCommandBuffer command_buffer; // NOLINT
+        vkrndr::begin_single_time_commands(*device_,
+            command_pool,
+            1,
+            std::span{&command_buffer, 1});
+
+        vkCmdResetQueryPool(command_buffer, query_pool_, 0, 2);
+        vkCmdWriteTimestamp2(command_buffer,
+            VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+            query_pool_,
+            0);
+
+        record(command_buffer, candidate);
+
+        vkCmdWriteTimestamp2(command_buffer,
+            VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+            query_pool_,
+            1);
+
+        vkrndr::end_single_time_commands(*device_,
+            device_->present_queue->queue,
+            std::span{&command_buffer, 1},
+            command_pool);
+
+        std::array<uint64_t, 2> timestamps{};
+        vkrndr::check_result(vkGetQueryPoolResults(device_->logical,
+            query_pool_,
+            0,
+            2,
+            sizeof(timestamps),
+            timestamps.data(),
+            sizeof(uint64_t),
+            VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT));
+
+        measurements_.push_back({.config = candidate,
+            .milliseconds = cppext::as_fp(timestamps[1] - timestamps[0]) *
+                timestamp_period_ / 1e6f});
+    }
+
+    vkDestroyCommandPool(device_->logical, command_pool, nullptr);
+
+    std::ranges::sort(measurements_, {}, &measurement::milliseconds);
+    if (!measurements_.empty())
+    {
+        config_ = measurements_.front().config;
+        cached_ = false;
+        store_cache();
+    }
+}
+
+void beam::dispatch_tuner::draw_imgui()
+{
+    ImGui::Text("Workgroup: %ux%u %s%s",
+        config_.width,
+        config_.height,
+        order_name(config_.order),
+        cached_ ? " (cached)" : "");
+
+    if (!measurements_.empty() &&
+        ImGui::BeginTable("Dispatch configurations", 2))
+    {
+        for (measurement const& m : measurements_)
+        {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::Text("%ux%u %s",
+                m.config.width,
+                m.config.height,
+                order_name(m.config.order));
+            ImGui::TableNextColumn();
+            ImGui::Text("%.2f ms", cppext::as_fp<double>(m.milliseconds));
+        }
+        ImGui::EndTable();
+    }
+}
+
+std::vector<beam::dispatch_config> beam::dispatch_tuner::candidates() const
+{
+    std::vector<dispatch_config> rv;
+    for (auto const& [width, height] : shapes)
+    {
+        if (width * height > limits_.maxComputeWorkGroupInvocations ||
+            width > limits_.maxComputeWorkGroupSize[0] ||
+            height > limits_.maxComputeWorkGroupSize[1])
+        {
+            continue;
+        }
+
+        for (workgroup_order const order : orders)
+        {
+            rv.push_back({.width = width, .height = height, .order = order});
+        }
+    }
+    return rv;
+}
+
+void beam::dispatch_tuner::load_cache()
+{
+    std::ifstream stream{cache_path_};
+
+    // Each line holds a device UUID followed by its configuration
+    std::string uuid;
+    uint32_t width{};
+    uint32_t height{};
+    uint32_t order{};
+    while (stream >> uuid >> width >> height >> order)
+    {
+        if (uuid != device_uuid_)
+        {
+            continue;
+        }
+
+        dispatch_config const cached{.width = width,
+            .height = height,
+            .order = static_cast<workgroup_order>(order)};
+        std::vector<dispatch_config> const supported{candidates()};
+        if (std::ranges::find(supported, cached) != supported.cend())
+        {
+            config_ = cached;
+            cached_ = true;
+        }
+    }
+}
+
+void beam::dispatch_tuner::store_cache() const
+{
+    // Entries of other devices are kept
+    std::vector<std::string> lines;
+    {
+        std::ifstream stream{cache_path_};
+        for (std::string line; std::getline(stream, line);)
+        {
+            if (!line.starts_with(device_uuid_))
+            {
+                lines.push_back(std::move(line));
+            }
+        }
+    }
+
+    std::ofstream stream{cache_path_, std::ios::trunc};
+    for (std::string const& line : lines)
+    {
+        stream << line << '\n';
+    }
+    stream << device_uuid_ << ' ' << config_.width << ' ' << config_.height
+           << ' ' << std::to_underlying(config_.order) << '\n';
+}
@@ -0,0 +1,113 @@
+#ifndef BEAM_DISPATCH_TUNER_INCLUDED
+#define BEAM_DISPATCH_TUNER_INCLUDED
+
+#include <vulkan/vulkan_core.h>
+
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace vkrndr
+{
+    struct vulkan_device;
+} // namespace vkrndr
+
+namespace beam
+{
+    // Matches the order constants in raytracer.comp
+    enum class workgroup_order : uint32_t
+    {
+        linear,
+        morton,
+        hilbert
+    };
+
+    // Workgroup shape of the megakernel and the order workgroups are
+    // dispatched in
+    struct [[nodiscard]] dispatch_config final
+    {
+        uint32_t width{16};
+        uint32_t height{16};
+        workgroup_order order{workgroup_order::linear};
+
+        [[nodiscard]] bool operator==(dispatch_config const&) const = default;
+    };
+
+    // Workgroup counts covering width x rows pixels with the configuration
+    [[nodiscard]] std::array<uint32_t, 3> workgroup_counts(
+        dispatch_config const& config,
+        uint32_t width,
+        uint32_t rows);
+
+    // Picks the fastest dispatch configuration of the megakernel for the
+    // device. Candidates are timed with GPU timestamps on the current scene,
+    // the winner is stored in a cache file keyed by the device UUID and used
+    // on the next start without tuning again.
+    class [[nodiscard]] dispatch_tuner final
+    {
+    public:
+        explicit dispatch_tuner(vkrndr::vulkan_device* device);
+
+        dispatch_tuner(dispatch_tuner const&) = delete;
+
+        dispatch_tuner(dispatch_tuner&&) noexcept = delete;
+
+    public:
+        ~dispatch_tuner();
+
+    public:
+        // Timestamps are supported by the queue used for raytracing
+        [[nodiscard]] bool supported() const;
+
+        // Cached or tuned configuration, the default one otherwise
+        [[nodiscard]] dispatch_config const& config() const;
+
+        // Records the work to measure with the given configuration, pipelines
+        // have to be ready before the function returns
+        using record_function =
+            std::function<void(VkCommandBuffer, dispatch_config const&)>;
+
+        // Measures all candidates supported by the device and keeps the
+        // fastest one. Blocks until the GPU is done with every candidate.
+        void tune(record_function const& record);
+
+        void draw_imgui();
+
+    public:
+        dispatch_tuner& operator=(dispatch_tuner const&) = delete;
+
+        dispatch_tuner& operator=(dispatch_tuner&&) noexcept = delete;
+
+    private:
+        struct [[nodiscard]] measurement final
+        {
+            dispatch_config config;
+            float milliseconds{};
+        };
+
+    private:
+        [[nodiscard]] std::vector<dispatch_config> candidates() const;
+
+        void load_cache();
+
+        void store_cache() const;
+
+    private:
+        vkrndr::vulkan_device* device_;
+
+        float timestamp_period_;
+        VkQueryPool query_pool_{VK_NULL_HANDLE};
+        VkPhysicalDeviceLimits limits_;
+        std::string device_uuid_;
+        std::filesystem::path cache_path_;
+
+        dispatch_config config_;
+        bool cached_{false};
+        std::vector<measurement> measurements_;
+    };
+} // namespace beam
+
+#endif
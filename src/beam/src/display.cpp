@@ -0,0 +1,322 @@
+#include <display.hpp>
+
+#include <cppext_numeric.hpp>
+
+#include <vulkan_commands.hpp>
+#include <vulkan_descriptors.hpp>
+#include <vulkan_device.hpp>
+#include <vulkan_image.hpp>
+#include <vulkan_pipeline.hpp>
+#include <vulkan_utility.hpp>
+
+#include <imgui.h>
+
+#include <vulkan/vulkan_core.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace
+{
+    constexpr uint32_t binding_count{2};
+
+    constexpr VkFormat display_format{VK_FORMAT_R8G8B8A8_UNORM};
+
+    // Matches PushConsts in display.comp
+    struct [[nodiscard]] push_constants final
+    {
+        float exposure;
+        uint32_t tonemap;
+        uint32_t swizzle;
+        uint32_t frame;
+    };
+
+    [[nodiscard]] bool is_bgra(VkFormat const format)
+    {
+        return format == VK_FORMAT_B8G8R8A8_UNORM ||
+            format == VK_FORMAT_B8G8R8A8_SRGB;
+    }
+
+    // Formats with the same texel size as the display image, copies between
+    // them reinterpret the bytes without conversion
+    [[nodiscard]] bool is_copy_compatible(VkFormat const format)
+    {
+        return is_bgra(format) || format == VK_FORMAT_R8G8B8A8_UNORM ||
+            format == VK_FORMAT_R8G8B8A8_SRGB;
+    }
+
+    [[nodiscard]] VkDescriptorPool create_descriptor_pool(
+        vkrndr::vulkan_device const* const device,
+        uint32_t const set_count)
+    {
+        VkDescriptorPoolSize storage_image_pool_size{};
+        storage_image_pool_size.type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        storage_image_pool_size.descriptorCount = set_count * binding_count;
+
+        VkDescriptorPoolCreateInfo pool_info{};
+        pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        pool_info.poolSizeCount = 1;
+        pool_info.pPoolSizes = &storage_image_pool_size;
+        pool_info.maxSets = set_count;
+
+        VkDescriptorPool rv; // NOLINT
+        vkrndr::check_result(
+            vkCreateDescriptorPool(device->logical, &pool_info, nullptr, &rv));
+
+        return rv;
+    }
+
+    [[nodiscard]] VkDescriptorSetLayout create_descriptor_set_layout(
+        vkrndr::vulkan_device const* const device)
+    {
+        std::array<VkDescriptorSetLayoutBinding, binding_count> bindings{};
+        for (uint32_t i{}; VkDescriptorSetLayoutBinding & binding : bindings)
+        {
+            binding.binding = i++;
+            binding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+            binding.descriptorCount = 1;
+            binding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        }
+
+        VkDescriptorSetLayoutCreateInfo layout_info{};
+        layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        layout_info.bindingCount = vkrndr::count_cast(bindings.size());
+        layout_info.pBindings = bindings.data();
+
+        VkDescriptorSetLayout rv; // NOLINT
+        vkrndr::check_result(vkCreateDescriptorSetLayout(device->logical,
+            &layout_info,
+            nullptr,
+            &rv));
+
+        return rv;
+    }
+
+    [[nodiscard]] vkrndr::vulkan_image create_display_image(
+        vkrndr::vulkan_device const& device,
+        VkExtent2D const extent)
+    {
+        return vkrndr::create_image_and_view(device,
+            extent,
+            1,
+            VK_SAMPLE_COUNT_1_BIT,
+            display_format,
+            VK_IMAGE_TILING_OPTIMAL,
+            VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            VK_IMAGE_ASPECT_COLOR_BIT);
+    }
+} // namespace
+
+beam::display::display(vkrndr::vulkan_device* const device,
+    std::span<vkrndr::vulkan_image const* const> const sources,
+    VkFormat const target_format)
+    : device_{device}
+    , descriptor_pool_{create_descriptor_pool(device_,
+          vkrndr::count_cast(sources.size()))}
+    , descriptor_layout_{create_descriptor_set_layout(device_)}
+    , descriptor_sets_(sources.size())
+    , display_image_{create_display_image(*device_, sources[0]->extent)}
+    , swizzle_{is_bgra(target_format)}
+    , raw_copy_{is_copy_compatible(target_format)}
+{
+    vkrndr::create_descriptor_sets(device_,
+        descriptor_layout_,
+        descriptor_pool_,
+        descriptor_sets_);
+
+    pipeline_ = std::make_unique<vkrndr::vulkan_pipeline>(
+        vkrndr::vulkan_compute_pipeline_builder{device_,
+            vkrndr::vulkan_pipeline_layout_builder{device_}
+                .add_descriptor_set_layout(descriptor_layout_)
+                .add_push_constants(VkPushConstantRange{
+                    .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+                    .offset = 0,
+                    .size = sizeof(push_constants),
+                })
+                .build()}
+            .with_shader("display.comp.spv", "main")
+            .build());
+
+    update_descriptor_sets(sources);
+}
+
+beam::display::~display()
+{
+    destroy(device_, pipeline_.get());
+    destroy(device_, &display_image_);
+
+    vkDestroyDescriptorSetLayout(device_->logical, descriptor_layout_, nullptr);
+    vkDestroyDescriptorPool(device_->logical, descriptor_pool_, nullptr);
+}
+
+void beam::display::resize(
+    std::span<vkrndr::vulkan_image const* const> const sources)
+{
+    destroy(device_, &display_image_);
+    display_image_ = create_display_image(*device_, sources[0]->extent);
+    update_descriptor_sets(sources);
+}
+
+void beam::display::draw(VkCommandBuffer command_buffer,
+    vkrndr::vulkan_image const& target_image,
+    size_t const source)
+{
+    // Every texel is overwritten, previous contents are discarded. The
+    // source stage orders this after the copy of the previous frame.
+    vkrndr::transition_image(display_image_.image,
+        command_buffer,
+        VK_IMAGE_LAYOUT_UNDEFINED,
+        VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT,
+        VK_ACCESS_2_NONE,
+        VK_IMAGE_LAYOUT_GENERAL,
+        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+        VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+        1);
+
+    push_constants const pc{.exposure = exposure_,
+        .tonemap = tonemap_ ? 1u : 0u,
+        .swizzle = swizzle_ && raw_copy_ ? 1u : 0u,
+        .frame = frame_++};
+
+    vkCmdPushConstants(command_buffer,
+        *pipeline_->layout,
+        VK_SHADER_STAGE_COMPUTE_BIT,
+        0,
+        sizeof(push_constants),
+        &pc);
+
+    vkrndr::bind_pipeline(command_buffer,
+        *pipeline_,
+        0,
+        std::span{&descriptor_sets_[source], 1});
+
+    vkCmdDispatch(command_buffer,
+        static_cast<uint32_t>(
+            std::ceil(cppext::as_fp(display_image_.extent.width) / 16.0f)),
+        static_cast<uint32_t>(
+            std::ceil(cppext::as_fp(display_image_.extent.height) / 16.0f)),
+        1);
+
+    vkrndr::transition_image(display_image_.image,
+        command_buffer,
+        VK_IMAGE_LAYOUT_GENERAL,
+        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+        VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+        VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT,
+        VK_ACCESS_2_TRANSFER_READ_BIT,
+        1);
+
+    vkrndr::transition_image(target_image.image,
+        command_buffer,
+        VK_IMAGE_LAYOUT_UNDEFINED,
+        VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+        VK_ACCESS_2_NONE,
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT,
+        VK_ACCESS_2_TRANSFER_WRITE_BIT,
+        1);
+
+    VkExtent2D const size{
+        std::min(display_image_.extent.width, target_image.extent.width),
+        std::min(display_image_.extent.height, target_image.extent.height)};
+
+    if (raw_copy_)
+    {
+        VkImageCopy region{};
+        region.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.srcSubresource.layerCount = 1;
+        region.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.dstSubresource.layerCount = 1;
+        region.extent = {size.width, size.height, 1};
+
+        vkCmdCopyImage(command_buffer,
+            display_image_.image,
+            VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+            target_image.image,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            1,
+            &region);
+    }
+    else
+    {
+        // Other swap chain formats are assumed to be UNORM, the blit
+        // converts encoded values without decoding them
+        VkOffset3D const offset{.x = cppext::narrow<int32_t>(size.width),
+            .y = cppext::narrow<int32_t>(size.height),
+            .z = 1};
+        VkImageBlit region{};
+        region.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.srcSubresource.layerCount = 1;
+        region.srcOffsets[1] = offset;
+        region.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.dstSubresource.layerCount = 1;
+        region.dstOffsets[1] = offset;
+
+        vkCmdBlitImage(command_buffer,
+            display_image_.image,
+            VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+            target_image.image,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            1,
+            &region,
+            VK_FILTER_NEAREST);
+    }
+
+    vkrndr::transition_image(target_image.image,
+        command_buffer,
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT,
+        VK_ACCESS_2_TRANSFER_WRITE_BIT,
+        VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
+        VK_PIPELINE_STAGE_2_BOTTOM_OF_PIPE_BIT,
+        VK_ACCESS_2_NONE,
+        1);
+}
+
+void beam::display::draw_imgui()
+{
+    ImGui::Begin("Display");
+    ImGui::SliderFloat("Exposure", &exposure_, 0.1f, 4.0f);
+    ImGui::Checkbox("Tonemap", &tonemap_);
+    ImGui::End();
+}
+
+void beam::display::update_descriptor_sets(
+    std::span<vkrndr::vulkan_image const* const> const sources)
+{
+    size_t const write_count{sources.size() * binding_count};
+
+    std::vector<VkDescriptorImageInfo> image_infos(write_count);
+    std::vector<VkWriteDescriptorSet> descriptor_writes(write_count);
+    for (size_t i{}; i != write_count; ++i)
+    {
+        size_t const set{i / binding_count};
+        size_t const binding{i % binding_count};
+
+        image_infos[i].imageView =
+            binding == 0 ? sources[set]->view : display_image_.view;
+        image_infos[i].imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+        descriptor_writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptor_writes[i].dstSet = descriptor_sets_[set];
+        descriptor_writes[i].dstBinding = cppext::narrow<uint32_t>(binding);
+        descriptor_writes[i].dstArrayElement = 0;
+        descriptor_writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        descriptor_writes[i].descriptorCount = 1;
+        descriptor_writes[i].pImageInfo = &image_infos[i];
+    }
+
+    vkUpdateDescriptorSets(device_->logical,
+        vkrndr::count_cast(descriptor_writes.size()),
+        descriptor_writes.data(),
+        0,
+        nullptr);
+}
@@ -0,0 +1,82 @@
+#ifndef BEAM_DISPLAY_INCLUDED
+#define BEAM_DISPLAY_INCLUDED
+
+#include <vulkan_image.hpp>
+
+#include <vulkan/vulkan_core.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace vkrndr
+{
+    struct vulkan_device;
+    struct vulkan_pipeline;
+} // namespace vkrndr
+
+namespace beam
+{
+    // Resolves the floating point accumulator, or its denoised version, into
+    // an 8 bit image with tonemapping, sRGB encoding and dithering, then
+    // copies it to the swap chain. Swap chain images aren't created with
+    // storage usage, the copy avoids a format converting blit for 8 bit swap
+    // chain formats. Any of the source images can be displayed, they are
+    // selected by their index.
+    class [[nodiscard]] display final
+    {
+    public:
+        display(vkrndr::vulkan_device* device,
+            std::span<vkrndr::vulkan_image const* const> sources,
+            VkFormat target_format);
+
+        display(display const&) = delete;
+
+        display(display&&) noexcept = delete;
+
+    public:
+        ~display();
+
+    public:
+        void resize(std::span<vkrndr::vulkan_image const* const> sources);
+
+        // Displayed image has to be in general layout with finished writes
+        void draw(VkCommandBuffer command_buffer,
+            vkrndr::vulkan_image const& target_image,
+            size_t source);
+
+        void draw_imgui();
+
+    public:
+        display& operator=(display const&) = delete;
+
+        display& operator=(display&&) noexcept = delete;
+
+    private:
+        void update_descriptor_sets(
+            std::span<vkrndr::vulkan_image const* const> sources);
+
+    private:
+        vkrndr::vulkan_device* device_;
+
+        VkDescriptorPool descriptor_pool_;
+        VkDescriptorSetLayout descriptor_layout_;
+        // Set per source image
+        std::vector<VkDescriptorSet> descriptor_sets_;
+
+        std::unique_ptr<vkrndr::vulkan_pipeline> pipeline_;
+
+        vkrndr::vulkan_image display_image_;
+
+        bool swizzle_{};
+        bool raw_copy_{};
+
+        float exposure_{1.0f};
+        bool tonemap_{true};
+        uint32_t frame_{};
+    };
+} // namespace beam
+
+#endif
@@ -0,0 +1,72 @@
+#include <frame_uniforms.hpp>
+
+#include <cppext_cycled_buffer.hpp>
+#include <cppext_numeric.hpp>
+
+#include <vulkan_buffer.hpp>
+#include <vulkan_device.hpp>
+#include <vulkan_memory.hpp>
+
+#include <vulkan/vulkan_core.h>
+
+#include <cstdint>
+
+namespace
+{
+    // Dynamic offsets have to be multiples of the device alignment
+    [[nodiscard]] VkDeviceSize aligned_slot_size(
+        vkrndr::vulkan_device const& device)
+    {
+        VkPhysicalDeviceProperties properties; // NOLINT
+        vkGetPhysicalDeviceProperties(device.physical, &properties);
+
+        VkDeviceSize const alignment{
+            properties.limits.minUniformBufferOffsetAlignment};
+        VkDeviceSize const size{sizeof(beam::frame_uniforms)};
+        return alignment == 0
+            ? size
+            : (size + alignment - 1) / alignment * alignment;
+    }
+} // namespace
+
+beam::frame_uniform_ring::frame_uniform_ring(
+    vkrndr::vulkan_device* const device,
+    uint32_t const slots)
+    : device_{device}
+    , slot_size_{aligned_slot_size(*device_)}
+    , buffer_{vkrndr::create_buffer(*device_,
+          slot_size_ * slots,
+          VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+          VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+              VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)}
+    , map_{vkrndr::map_memory(*device_, buffer_)}
+    , offsets_{slots}
+{
+    for (uint32_t i{}; i != slots; ++i)
+    {
+        offsets_.push(cppext::narrow<uint32_t>(i * slot_size_));
+        *map_.as<frame_uniforms>(i * slot_size_) = {};
+    }
+}
+
+beam::frame_uniform_ring::~frame_uniform_ring()
+{
+    unmap_memory(*device_, &map_);
+    destroy(device_, &buffer_);
+}
+
+VkDescriptorBufferInfo beam::frame_uniform_ring::descriptor_info() const
+{
+    return {.buffer = buffer_.buffer,
+        .offset = 0,
+        .range = sizeof(frame_uniforms)};
+}
+
+uint32_t beam::frame_uniform_ring::offset() const { return *offsets_; }
+
+void beam::frame_uniform_ring::cycle() { offsets_.cycle(); }
+
+void beam::frame_uniform_ring::write(frame_uniforms const& uniforms)
+{
+    *map_.as<frame_uniforms>(*offsets_) = uniforms;
+}
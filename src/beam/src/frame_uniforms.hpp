@@ -0,0 +1,92 @@
+#ifndef BEAM_FRAME_UNIFORMS_INCLUDED
+#define BEAM_FRAME_UNIFORMS_INCLUDED
+
+#include <cppext_cycled_buffer.hpp>
+
+#include <vulkan_buffer.hpp>
+#include <vulkan_memory.hpp>
+
+#include <glm/vec3.hpp>
+
+#include <vulkan/vulkan_core.h>
+
+#include <cstdint>
+
+namespace vkrndr
+{
+    struct vulkan_device;
+} // namespace vkrndr
+
+namespace beam
+{
+    // Matches FrameUniforms in scene.glsl. Parameters that stay the same for
+    // every dispatch of a frame, per dispatch values are push constants.
+    // Previous camera is the one accumulated history was rendered with.
+    struct [[nodiscard]] frame_uniforms final
+    {
+        glm::vec3 camera_position;
+        uint32_t world_count;
+        glm::vec3 camera_front;
+        uint32_t material_count;
+        glm::vec3 camera_up;
+        uint32_t max_depth;
+        glm::vec3 previous_position;
+        float defocus_angle;
+        glm::vec3 previous_front;
+        float focus_distance;
+        glm::vec3 previous_up;
+        float fovy;
+        uint32_t sequence_seed;
+        uint32_t triangle_count;
+        uint32_t triangle_root;
+        uint32_t light_count;
+        float sky_intensity;
+    };
+
+    // Persistently mapped uniform buffer with a slot of frame uniforms for
+    // each frame in flight. The slot is written through the mapping when a
+    // frame is recorded, the frame that used it last has already finished so
+    // writes don't wait for the GPU. Shaders see the current slot through a
+    // dynamic offset.
+    class [[nodiscard]] frame_uniform_ring final
+    {
+    public:
+        frame_uniform_ring(vkrndr::vulkan_device* device, uint32_t slots);
+
+        frame_uniform_ring(frame_uniform_ring const&) = delete;
+
+        frame_uniform_ring(frame_uniform_ring&&) noexcept = delete;
+
+    public:
+        ~frame_uniform_ring();
+
+    public:
+        // Buffer range of a single slot, bound as a dynamic uniform buffer
+        [[nodiscard]] VkDescriptorBufferInfo descriptor_info() const;
+
+        // Dynamic offset of the current slot
+        [[nodiscard]] uint32_t offset() const;
+
+        // Moves to the slot of the next frame
+        void cycle();
+
+        // Overwrites the current slot, dispatches recorded afterwards in the
+        // same frame see the new values
+        void write(frame_uniforms const& uniforms);
+
+    public:
+        frame_uniform_ring& operator=(frame_uniform_ring const&) = delete;
+
+        frame_uniform_ring& operator=(frame_uniform_ring&&) noexcept = delete;
+
+    private:
+        vkrndr::vulkan_device* device_;
+
+        VkDeviceSize slot_size_;
+        vkrndr::vulkan_buffer buffer_;
+        vkrndr::mapped_memory map_;
+        cppext::cycled_buffer<uint32_t> offsets_;
+    };
+} // namespace beam
+
+#endif
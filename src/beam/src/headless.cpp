@@ -0,0 +1,400 @@
+#include <headless.hpp>
+
+#include <cpu_tracer.hpp>
+#include <frame_uniforms.hpp>
+#include <image_file.hpp>
+#include <mesh.hpp>
+#include <perspective_camera.hpp>
+#include <raytracer.hpp>
+#include <renderer.hpp>
+#include <scene_file.hpp>
+#include <sphere.hpp>
+
+#include <cppext_numeric.hpp>
+
+#include <vkrndr_render_settings.hpp>
+#include <vulkan_buffer.hpp>
+#include <vulkan_commands.hpp>
+#include <vulkan_device.hpp>
+#include <vulkan_image.hpp>
+#include <vulkan_memory.hpp>
+#include <vulkan_queue.hpp>
+#include <vulkan_renderer.hpp>
+
+#include <fmt/format.h>
+#include <fmt/std.h> // IWYU pragma: keep
+
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+
+#include <vulkan/vulkan_core.h>
+
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+namespace
+{
+    // Display format of the renderer, nothing is presented
+    constexpr VkFormat target_format{VK_FORMAT_R8G8B8A8_UNORM};
+
+    template<typename T>
+    [[nodiscard]] T parse_value(std::string_view const option,
+        std::span<char* const> const args,
+        size_t& index)
+    {
+        if (++index == args.size())
+        {
+            throw std::runtime_error{
+                fmt::format("Missing value of {}", option)};
+        }
+
+        std::string_view const text{args[index]};
+
+        T rv{};
+        auto const [end, error]{
+            std::from_chars(text.data(), text.data() + text.size(), rv)};
+        if (error != std::errc{} || end != text.data() + text.size())
+        {
+            throw std::runtime_error{
+                fmt::format("Invalid value {} of {}", text, option)};
+        }
+        return rv;
+    }
+
+    // Scene and camera of the GPU path with the default settings of the
+    // raytracer, the sample sequence isn't scrambled
+    void render_offline_cpu(beam::offline_options const& options)
+    {
+        std::optional<beam::scene_file> file;
+        beam::scene_data procedural;
+        beam::scene_view scene;
+        if (options.scene.empty())
+        {
+            beam::procedural_scene const spheres{
+                beam::generate_procedural_scene(0, 11, false)};
+            procedural = beam::build_scene(spheres.spheres,
+                spheres.materials,
+                beam::mesh{});
+            scene = procedural.view();
+        }
+        else if (options.scene.extension() == ".beam")
+        {
+            scene = file.emplace(options.scene).view();
+        }
+        else
+        {
+            throw std::runtime_error{fmt::format(
+                "Models are only traced on the GPU, convert {} with "
+                "beam_scene first",
+                options.scene)};
+        }
+
+        beam::perspective_camera camera;
+        camera.set_position(options.position);
+        camera.set_yaw_pitch(options.yaw_pitch);
+        camera.resize({options.extent.width, options.extent.height});
+        camera.update();
+
+        beam::frame_uniforms const uniforms{
+            .camera_position = camera.position(),
+            .world_count = cppext::narrow<uint32_t>(scene.center_radius.size()),
+            .camera_front = camera.position() + camera.front_direction(),
+            .material_count = cppext::narrow<uint32_t>(scene.materials.size()),
+            .camera_up = camera.up_direction(),
+            .max_depth = options.max_depth,
+            .previous_position = camera.position(),
+            .defocus_angle = 0.6f,
+            .previous_front = camera.position() + camera.front_direction(),
+            .focus_distance = 10.0f,
+            .previous_up = camera.up_direction(),
+            .fovy = 20.0f,
+            .sequence_seed = 0,
+            .triangle_count = cppext::narrow<uint32_t>(scene.triangles.size()),
+            .triangle_root = scene.triangle_root,
+            .light_count = cppext::narrow<uint32_t>(scene.lights.size()),
+            .sky_intensity = 1.0f};
+
+        beam::cpu_tracer tracer{scene, options.extent, options.threads};
+        while (tracer.total_samples() < options.samples)
+        {
+            tracer.trace(uniforms, options.samples_per_frame);
+        }
+
+        beam::write_image(options.output,
+            options.extent,
+            tracer.image(),
+            options.exposure,
+            options.tonemap);
+    }
+} // namespace
+
+beam::offline_renderer::offline_renderer(VkExtent2D const extent,
+    bool const debug)
+    : extent_{extent}
+    , backend_{std::make_unique<vkrndr::vulkan_renderer>(nullptr,
+          vkrndr::render_settings{},
+          debug)}
+    , scene_{std::make_unique<renderer>(&backend_->device(),
+          backend_.get(),
+          extent_,
+          target_format)}
+    , tracer_{std::make_unique<raytracer>(&backend_->device(),
+          backend_.get(),
+          scene_.get())}
+    , command_pool_{vkrndr::create_command_pool(backend_->device(),
+          backend_->device().present_queue->family)}
+{
+    scene_->set_raytracer(tracer_.get());
+}
+
+beam::offline_renderer::~offline_renderer()
+{
+    vkDeviceWaitIdle(backend_->device().logical);
+
+    vkDestroyCommandPool(backend_->device().logical, command_pool_, nullptr);
+
+    tracer_.reset();
+    scene_.reset();
+}
+
+vkrndr::vulkan_device& beam::offline_renderer::device()
+{
+    return backend_->device();
+}
+
+beam::raytracer& beam::offline_renderer::tracer() { return *tracer_; }
+
+void beam::offline_renderer::load(std::filesystem::path const& path)
+{
+    if (path.extension() == ".beam")
+    {
+        tracer_->load_scene_file(path);
+    }
+    else
+    {
+        tracer_->load_model(path);
+    }
+}
+
+void beam::offline_renderer::set_camera(glm::vec3 const& position,
+    glm::vec2 const& yaw_pitch)
+{
+    perspective_camera camera;
+    camera.set_position(position);
+    camera.set_yaw_pitch(yaw_pitch);
+    camera.resize({extent_.width, extent_.height});
+    camera.update();
+    tracer_->update(camera);
+}
+
+void beam::offline_renderer::trace_frame(VkQueryPool const timestamps)
+{
+    vkrndr::vulkan_device const& device{backend_->device()};
+
+    VkCommandBuffer command_buffer; // NOLINT
+    vkrndr::begin_single_time_commands(device,
+        command_pool_,
+        1,
+        std::span{&command_buffer, 1});
+
+    if (timestamps != VK_NULL_HANDLE)
+    {
+        vkCmdResetQueryPool(command_buffer, timestamps, 0, 2);
+        vkCmdWriteTimestamp2(command_buffer,
+            VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+            timestamps,
+            0);
+    }
+
+    scene_->trace(command_buffer);
+
+    if (timestamps != VK_NULL_HANDLE)
+    {
+        vkCmdWriteTimestamp2(command_buffer,
+            VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+            timestamps,
+            1);
+    }
+
+    // Every frame waits for the previous one, the frame uniform ring is
+    // rewritten by each of them
+    vkrndr::end_single_time_commands(device,
+        device.present_queue->queue,
+        std::span{&command_buffer, 1},
+        command_pool_);
+}
+
+std::vector<glm::vec4> beam::offline_renderer::read_back()
+{
+    vkrndr::vulkan_device const& device{backend_->device()};
+    vkrndr::vulkan_image const& image{scene_->color_image()};
+
+    size_t const pixel_count{size_t{extent_.width} * extent_.height};
+
+    vkrndr::vulkan_buffer readback{vkrndr::create_buffer(device,
+        pixel_count * sizeof(glm::vec4),
+        VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+            VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)};
+
+    VkCommandBuffer command_buffer; // NOLINT
+    vkrndr::begin_single_time_commands(device,
+        command_pool_,
+        1,
+        std::span{&command_buffer, 1});
+
+    VkBufferImageCopy region{};
+    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.layerCount = 1;
+    region.imageExtent = {extent_.width, extent_.height, 1};
+
+    // Accumulator stays in general layout, it is created for transfers
+    vkCmdCopyImageToBuffer(command_buffer,
+        image.image,
+        VK_IMAGE_LAYOUT_GENERAL,
+        readback.buffer,
+        1,
+        &region);
+
+    vkrndr::memory_barrier(command_buffer,
+        VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT,
+        VK_ACCESS_2_TRANSFER_WRITE_BIT,
+        VK_PIPELINE_STAGE_2_HOST_BIT,
+        VK_ACCESS_2_HOST_READ_BIT);
+
+    vkrndr::end_single_time_commands(device,
+        device.present_queue->queue,
+        std::span{&command_buffer, 1},
+        command_pool_);
+
+    vkrndr::mapped_memory map{vkrndr::map_memory(device, readback)};
+    glm::vec4 const* const pixels{map.as<glm::vec4>()};
+    std::vector<glm::vec4> rv{pixels, std::next(pixels, pixel_count)};
+    vkrndr::unmap_memory(device, &map);
+
+    destroy(&device, &readback);
+
+    return rv;
+}
+
+beam::offline_options beam::parse_offline_options(
+    std::span<char* const> const args)
+{
+    offline_options rv;
+    for (size_t i{}; i != args.size(); ++i)
+    {
+        std::string_view const option{args[i]};
+        if (option == "--scene" || option == "--output")
+        {
+            if (i + 1 == args.size())
+            {
+                throw std::runtime_error{
+                    fmt::format("Missing value of {}", option)};
+            }
+            (option == "--scene" ? rv.scene : rv.output) = args[++i];
+        }
+        else if (option == "--width")
+        {
+            rv.extent.width = parse_value<uint32_t>(option, args, i);
+        }
+        else if (option == "--height")
+        {
+            rv.extent.height = parse_value<uint32_t>(option, args, i);
+        }
+        else if (option == "--samples")
+        {
+            rv.samples = parse_value<uint32_t>(option, args, i);
+        }
+        else if (option == "--samples-per-frame")
+        {
+            rv.samples_per_frame = parse_value<uint32_t>(option, args, i);
+        }
+        else if (option == "--depth")
+        {
+            rv.max_depth = parse_value<uint32_t>(option, args, i);
+        }
+        else if (option == "--position")
+        {
+            rv.position.x = parse_value<float>(option, args, i);
+            rv.position.y = parse_value<float>(option, args, i);
+            rv.position.z = parse_value<float>(option, args, i);
+        }
+        else if (option == "--yaw-pitch")
+        {
+            rv.yaw_pitch.x = parse_value<float>(option, args, i);
+            rv.yaw_pitch.y = parse_value<float>(option, args, i);
+        }
+        else if (option == "--exposure")
+        {
+            rv.exposure = parse_value<float>(option, args, i);
+        }
+        else if (option == "--no-tonemap")
+        {
+            rv.tonemap = false;
+        }
+        else if (option == "--cpu")
+        {
+            rv.cpu = true;
+        }
+        else if (option == "--threads")
+        {
+            rv.threads = parse_value<uint32_t>(option, args, i);
+        }
+        else
+        {
+            throw std::runtime_error{
+                fmt::format("Unknown argument {}", option)};
+        }
+    }
+
+    if (rv.extent.width == 0 || rv.extent.height == 0 ||
+        rv.samples_per_frame == 0 || rv.max_depth == 0)
+    {
+        throw std::runtime_error{
+            "Image size, samples per frame and depth can't be zero"};
+    }
+
+    return rv;
+}
+
+void beam::render_offline(offline_options const& options, bool const debug)
+{
+    if (options.cpu)
+    {
+        render_offline_cpu(options);
+        return;
+    }
+
+    offline_renderer offline{options.extent, debug};
+    raytracer& tracer{offline.tracer()};
+
+    if (!options.scene.empty())
+    {
+        offline.load(options.scene);
+    }
+
+    offline.set_camera(options.position, options.yaw_pitch);
+    tracer.set_sampling(options.samples_per_frame, options.max_depth);
+
+    while (tracer.total_samples() < options.samples)
+    {
+        offline.trace_frame();
+    }
+
+    write_image(options.output,
+        options.extent,
+        offline.read_back(),
+        options.exposure,
+        options.tonemap);
+}
@@ -0,0 +1,103 @@
+#ifndef BEAM_HEADLESS_INCLUDED
+#define BEAM_HEADLESS_INCLUDED
+
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+
+#include <vulkan/vulkan_core.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace vkrndr
+{
+    struct vulkan_device;
+    class vulkan_renderer;
+} // namespace vkrndr
+
+namespace beam
+{
+    class raytracer;
+    class renderer;
+} // namespace beam
+
+namespace beam
+{
+    struct [[nodiscard]] offline_options final
+    {
+        // Scene file or glTF model, the procedural scene when empty
+        std::filesystem::path scene;
+        std::filesystem::path output{"beam.png"};
+        VkExtent2D extent{1280, 720};
+        uint32_t samples{64};
+        uint32_t samples_per_frame{4};
+        uint32_t max_depth{5};
+        glm::vec3 position{13.0f, 2.0f, 3.0f};
+        glm::vec2 yaw_pitch{-167.0f, -3.0f};
+        float exposure{1.0f};
+        bool tonemap{true};
+        // Traced by cpu_tracer without a Vulkan device, glTF models aren't
+        // supported
+        bool cpu{false};
+        // Zero uses every hardware thread
+        uint32_t threads{0};
+    };
+
+    // Parses arguments following --headless. Throws on unknown or malformed
+    // arguments.
+    [[nodiscard]] offline_options parse_offline_options(
+        std::span<char* const> args);
+
+    // Device, renderer and raytracer without a window. Frames are traced
+    // one at a time, each one is waited for before the next is recorded.
+    class [[nodiscard]] offline_renderer final
+    {
+    public:
+        offline_renderer(VkExtent2D extent, bool debug);
+
+        offline_renderer(offline_renderer const&) = delete;
+
+        offline_renderer(offline_renderer&&) noexcept = delete;
+
+    public:
+        ~offline_renderer();
+
+    public:
+        [[nodiscard]] vkrndr::vulkan_device& device();
+
+        [[nodiscard]] raytracer& tracer();
+
+        // Scene file or glTF model
+        void load(std::filesystem::path const& path);
+
+        void set_camera(glm::vec3 const& position, glm::vec2 const& yaw_pitch);
+
+        // When a pool is given the first two timestamp queries of it are
+        // written before and after the traced work
+        void trace_frame(VkQueryPool timestamps = VK_NULL_HANDLE);
+
+        // Accumulated radiance of every pixel, row by row
+        [[nodiscard]] std::vector<glm::vec4> read_back();
+
+    public:
+        offline_renderer& operator=(offline_renderer const&) = delete;
+
+        offline_renderer& operator=(offline_renderer&&) noexcept = delete;
+
+    private:
+        VkExtent2D extent_;
+        std::unique_ptr<vkrndr::vulkan_renderer> backend_;
+        std::unique_ptr<renderer> scene_;
+        std::unique_ptr<raytracer> tracer_;
+        VkCommandPool command_pool_{VK_NULL_HANDLE};
+    };
+
+    // Renders the scene without a window, presentation support isn't needed
+    // from the device. Blocks until the image is written.
+    void render_offline(offline_options const& options, bool debug);
+} // namespace beam
+
+#endif
@@ -0,0 +1,483 @@
+#include <hybrid_tracer.hpp>
+
+#include <cpu_tracer.hpp>
+#include <frame_uniforms.hpp>
+#include <push_constants.hpp>
+#include <scene_file.hpp>
+
+#include <cppext_cycled_buffer.hpp>
+#include <cppext_numeric.hpp>
+
+#include <vulkan_buffer.hpp>
+#include <vulkan_commands.hpp>
+#include <vulkan_descriptors.hpp>
+#include <vulkan_device.hpp>
+#include <vulkan_image.hpp>
+#include <vulkan_memory.hpp>
+#include <vulkan_pipeline.hpp>
+#include <vulkan_utility.hpp>
+
+#include <glm/vec4.hpp>
+
+#include <imgui.h>
+
+#include <vulkan/vulkan_core.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <initializer_list>
+#include <memory>
+#include <optional>
+#include <span>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    constexpr uint32_t upload_image_count{2};
+
+    // Workgroup size of hybrid_merge.comp, host rows are whole workgroups
+    constexpr uint32_t merge_group_size{16};
+
+    constexpr float split_smoothing{0.2f};
+
+    [[nodiscard]] VkDescriptorPool create_descriptor_pool(
+        vkrndr::vulkan_device const* const device)
+    {
+        VkDescriptorPoolSize pool_size{};
+        pool_size.type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        pool_size.descriptorCount = upload_image_count;
+
+        VkDescriptorPoolCreateInfo pool_info{};
+        pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        pool_info.poolSizeCount = 1;
+        pool_info.pPoolSizes = &pool_size;
+        pool_info.maxSets = 1;
+
+        VkDescriptorPool rv; // NOLINT
+        vkrndr::check_result(
+            vkCreateDescriptorPool(device->logical, &pool_info, nullptr, &rv));
+
+        return rv;
+    }
+
+    [[nodiscard]] VkDescriptorSetLayout create_descriptor_set_layout(
+        vkrndr::vulkan_device const* const device)
+    {
+        std::array<VkDescriptorSetLayoutBinding, upload_image_count>
+            bindings{};
+        for (uint32_t i{}; VkDescriptorSetLayoutBinding & binding : bindings)
+        {
+            binding.binding = i++;
+            binding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+            binding.descriptorCount = 1;
+            binding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        }
+
+        VkDescriptorSetLayoutCreateInfo layout_info{};
+        layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        layout_info.bindingCount = vkrndr::count_cast(bindings.size());
+        layout_info.pBindings = bindings.data();
+
+        VkDescriptorSetLayout rv; // NOLINT
+        vkrndr::check_result(vkCreateDescriptorSetLayout(device->logical,
+            &layout_info,
+            nullptr,
+            &rv));
+
+        return rv;
+    }
+
+    [[nodiscard]] vkrndr::vulkan_image create_upload_image(
+        vkrndr::vulkan_device const& device,
+        VkExtent2D const extent)
+    {
+        return vkrndr::create_image_and_view(device,
+            extent,
+            1,
+            VK_SAMPLE_COUNT_1_BIT,
+            VK_FORMAT_R32G32B32A32_SFLOAT,
+            VK_IMAGE_TILING_OPTIMAL,
+            VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            VK_IMAGE_ASPECT_COLOR_BIT);
+    }
+
+    void copy_rows(VkCommandBuffer command_buffer,
+        VkBuffer const source,
+        VkDeviceSize const offset,
+        vkrndr::vulkan_image const& target,
+        uint32_t const rows)
+    {
+        VkBufferImageCopy region{};
+        region.bufferOffset = offset;
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.layerCount = 1;
+        region.imageExtent = {target.extent.width, rows, 1};
+
+        vkCmdCopyBufferToImage(command_buffer,
+            source,
+            target.image,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            1,
+            &region);
+    }
+
+    // Rows at the top of the image, returns milliseconds spent tracing
+    [[nodiscard]] float timed_band(beam::cpu_tracer const& tracer,
+        beam::frame_uniforms const& frame,
+        std::vector<uint32_t> const& first_samples,
+        uint32_t const samples,
+        uint32_t const rows,
+        std::span<glm::vec4> const colors,
+        std::span<glm::vec4> const statistics)
+    {
+        auto const start{std::chrono::steady_clock::now()};
+        tracer.trace_band(frame,
+            first_samples,
+            samples,
+            0,
+            rows,
+            colors,
+            statistics);
+        std::chrono::duration<float, std::milli> const elapsed{
+            std::chrono::steady_clock::now() - start};
+        return elapsed.count();
+    }
+
+    void add_samples(std::span<uint32_t> const rows, uint32_t const samples)
+    {
+        for (uint32_t& row : rows)
+        {
+            row += samples;
+        }
+    }
+
+    // The render thread records frames while the workers trace
+    [[nodiscard]] uint32_t host_thread_count()
+    {
+        return std::max(std::thread::hardware_concurrency(), 2u) - 1;
+    }
+} // namespace
+
+beam::hybrid_tracer::hybrid_tracer(vkrndr::vulkan_device* const device,
+    VkDescriptorSetLayout const scene_layout,
+    uint32_t const frames_in_flight,
+    VkExtent2D const extent)
+    : device_{device}
+    , frames_in_flight_{frames_in_flight}
+    , descriptor_pool_{create_descriptor_pool(device_)}
+    , descriptor_layout_{create_descriptor_set_layout(device_)}
+    , extent_{extent}
+{
+    vkrndr::create_descriptor_sets(device_,
+        descriptor_layout_,
+        descriptor_pool_,
+        std::span{&descriptor_set_, 1});
+
+    pipeline_ = std::make_unique<vkrndr::vulkan_pipeline>(
+        vkrndr::vulkan_compute_pipeline_builder{device_,
+            vkrndr::vulkan_pipeline_layout_builder{device_}
+                .add_descriptor_set_layout(scene_layout)
+                .add_descriptor_set_layout(descriptor_layout_)
+                .add_push_constants(VkPushConstantRange{
+                    .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+                    .offset = 0,
+                    .size = sizeof(push_constants),
+                })
+                .build()}
+            .with_shader("hybrid_merge.comp.spv", "main")
+            .build());
+
+    create_resources(extent);
+    update_descriptor_set();
+}
+
+beam::hybrid_tracer::~hybrid_tracer()
+{
+    pending_.reset();
+    destroy_resources();
+
+    destroy(device_, pipeline_.get());
+
+    vkDestroyDescriptorSetLayout(device_->logical, descriptor_layout_, nullptr);
+    vkDestroyDescriptorPool(device_->logical, descriptor_pool_, nullptr);
+}
+
+void beam::hybrid_tracer::resize(VkExtent2D const extent)
+{
+    pending_.reset();
+    tracer_.reset();
+
+    destroy_resources();
+    create_resources(extent);
+    update_descriptor_set();
+}
+
+void beam::hybrid_tracer::invalidate_scene()
+{
+    // Rows of a dropped pass keep their count, they didn't get its samples
+    pending_.reset();
+    tracer_.reset();
+}
+
+void beam::hybrid_tracer::reset()
+{
+    pending_.reset();
+    std::ranges::fill(row_samples_, 0);
+}
+
+uint32_t beam::hybrid_tracer::trace(scene_view const& scene,
+    frame_uniforms const& frame,
+    uint32_t const samples,
+    float const device_cost)
+{
+    if (device_cost > 0.0f)
+    {
+        device_cost_ = device_cost;
+    }
+
+    // Host and device take the same time when the band is proportional to
+    // the throughput of the host
+    if (host_cost_ > 0.0f && device_cost_ > 0.0f)
+    {
+        host_fraction_ = std::lerp(host_fraction_,
+            device_cost_ / (device_cost_ + host_cost_),
+            split_smoothing);
+    }
+
+    if (pending_)
+    {
+        add_samples(std::span{row_samples_}.subspan(pending_->rows), samples);
+        return pending_->rows;
+    }
+
+    bool const first_pass{std::ranges::find(row_samples_, 0u) !=
+        std::ranges::end(row_samples_)};
+    uint32_t const rows{first_pass ? 0 : host_rows()};
+    add_samples(std::span{row_samples_}.subspan(rows), samples);
+    if (rows == 0)
+    {
+        return 0;
+    }
+
+    if (!tracer_)
+    {
+        tracer_ =
+            std::make_unique<cpu_tracer>(scene, extent_, host_thread_count());
+    }
+
+    VkDeviceSize const offset{*offsets_};
+    offsets_.cycle();
+
+    size_t const pixels{size_t{extent_.width} * rows};
+    std::span const colors{staging_map_.as<glm::vec4>(offset), pixels};
+    std::span const statistics{
+        staging_map_.as<glm::vec4>(offset + slot_size_ / 2),
+        pixels};
+
+    pending_ = host_pass{.time = std::async(std::launch::async,
+                             timed_band,
+                             std::cref(*tracer_),
+                             frame,
+                             std::vector<uint32_t>{row_samples_.cbegin(),
+                                 row_samples_.cbegin() + rows},
+                             samples,
+                             rows,
+                             colors,
+                             statistics),
+        .rows = rows,
+        .samples = samples,
+        .offset = offset};
+    last_rows_ = rows;
+
+    return rows;
+}
+
+void beam::hybrid_tracer::merge(VkCommandBuffer command_buffer,
+    VkDescriptorSet const scene_descriptor_set,
+    uint32_t const frame_offset,
+    push_constants const& constants)
+{
+    if (!pending_ ||
+        pending_->time.wait_for(std::chrono::seconds{0}) !=
+            std::future_status::ready)
+    {
+        return;
+    }
+
+    float const time{pending_->time.get()};
+    host_cost_ = time /
+        (cppext::as_fp(extent_.width) * cppext::as_fp(pending_->rows) *
+            cppext::as_fp(pending_->samples));
+    add_samples(std::span{row_samples_}.first(pending_->rows),
+        pending_->samples);
+
+    // Upload images were last read by the previous merge, their contents
+    // are replaced
+    for (vkrndr::vulkan_image const* const image :
+        {&color_upload_, &statistics_upload_})
+    {
+        vkrndr::transition_image(image->image,
+            command_buffer,
+            VK_IMAGE_LAYOUT_UNDEFINED,
+            VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+            VK_ACCESS_2_NONE,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT,
+            VK_ACCESS_2_TRANSFER_WRITE_BIT,
+            1);
+    }
+
+    copy_rows(command_buffer,
+        staging_buffer_.buffer,
+        pending_->offset,
+        color_upload_,
+        pending_->rows);
+    copy_rows(command_buffer,
+        staging_buffer_.buffer,
+        pending_->offset + slot_size_ / 2,
+        statistics_upload_,
+        pending_->rows);
+
+    for (vkrndr::vulkan_image const* const image :
+        {&color_upload_, &statistics_upload_})
+    {
+        vkrndr::transition_image(image->image,
+            command_buffer,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT,
+            VK_ACCESS_2_TRANSFER_WRITE_BIT,
+            VK_IMAGE_LAYOUT_GENERAL,
+            VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+            VK_ACCESS_2_SHADER_STORAGE_READ_BIT,
+            1);
+    }
+
+    // Accumulated images were last written by compute shaders of the
+    // previous frame
+    vkrndr::memory_barrier(command_buffer,
+        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+        VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+        VK_ACCESS_2_SHADER_STORAGE_READ_BIT |
+            VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT);
+
+    vkCmdPushConstants(command_buffer,
+        *pipeline_->layout,
+        VK_SHADER_STAGE_COMPUTE_BIT,
+        0,
+        sizeof(push_constants),
+        &constants);
+
+    std::array const descriptor_sets{scene_descriptor_set, descriptor_set_};
+    vkrndr::bind_pipeline(command_buffer,
+        *pipeline_,
+        0,
+        descriptor_sets,
+        std::span{&frame_offset, 1});
+
+    vkCmdDispatch(command_buffer,
+        static_cast<uint32_t>(std::ceil(
+            cppext::as_fp(extent_.width) / cppext::as_fp(merge_group_size))),
+        pending_->rows / merge_group_size,
+        1);
+
+    pending_.reset();
+}
+
+void beam::hybrid_tracer::draw_imgui()
+{
+    ImGui::Text("Host rows: %u of %u", last_rows_, extent_.height);
+    if (host_cost_ > 0.0f)
+    {
+        ImGui::Text("Host: %.2f Msamples/s",
+            cppext::as_fp<double>(1e-3f / host_cost_));
+    }
+    if (device_cost_ > 0.0f)
+    {
+        ImGui::Text("GPU: %.2f Msamples/s",
+            cppext::as_fp<double>(1e-3f / device_cost_));
+    }
+}
+
+uint32_t beam::hybrid_tracer::host_rows() const
+{
+    // Both sides keep at least a workgroup row so their cost stays measured
+    uint32_t const groups{extent_.height / merge_group_size};
+    if (groups < 2)
+    {
+        return 0;
+    }
+
+    auto const host_groups{static_cast<uint32_t>(
+        std::lround(host_fraction_ * cppext::as_fp(groups)))};
+    return std::clamp(host_groups, 1u, groups - 1) * merge_group_size;
+}
+
+void beam::hybrid_tracer::create_resources(VkExtent2D const extent)
+{
+    extent_ = extent;
+    row_samples_.assign(extent_.height, 0);
+    color_upload_ = create_upload_image(*device_, extent_);
+    statistics_upload_ = create_upload_image(*device_, extent_);
+
+    // A slot is written while the frame that read it last may still be
+    // executing, frames in flight only guarantee the one before it finished
+    uint32_t const slots{frames_in_flight_ + 1};
+    slot_size_ = 2 * VkDeviceSize{extent_.width} * extent_.height *
+        sizeof(glm::vec4);
+    staging_buffer_ = vkrndr::create_buffer(*device_,
+        slot_size_ * slots,
+        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+            VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    staging_map_ = vkrndr::map_memory(*device_, staging_buffer_);
+
+    offsets_ = cppext::cycled_buffer<VkDeviceSize>{slots};
+    for (uint32_t i{}; i != slots; ++i)
+    {
+        offsets_.push(i * slot_size_);
+    }
+}
+
+void beam::hybrid_tracer::destroy_resources()
+{
+    unmap_memory(*device_, &staging_map_);
+    destroy(device_, &staging_buffer_);
+    destroy(device_, &statistics_upload_);
+    destroy(device_, &color_upload_);
+}
+
+void beam::hybrid_tracer::update_descriptor_set()
+{
+    std::array const views{color_upload_.view, statistics_upload_.view};
+
+    std::array<VkDescriptorImageInfo, upload_image_count> image_infos{};
+    std::array<VkWriteDescriptorSet, upload_image_count> descriptor_writes{};
+    for (uint32_t i{}; i != upload_image_count; ++i)
+    {
+        image_infos[i].imageView = views[i];
+        image_infos[i].imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+        descriptor_writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptor_writes[i].dstSet = descriptor_set_;
+        descriptor_writes[i].dstBinding = i;
+        descriptor_writes[i].dstArrayElement = 0;
+        descriptor_writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        descriptor_writes[i].descriptorCount = 1;
+        descriptor_writes[i].pImageInfo = &image_infos[i];
+    }
+
+    vkUpdateDescriptorSets(device_->logical,
+        vkrndr::count_cast(descriptor_writes.size()),
+        descriptor_writes.data(),
+        0,
+        nullptr);
+}
@@ -0,0 +1,155 @@
+#ifndef BEAM_HYBRID_TRACER_INCLUDED
+#define BEAM_HYBRID_TRACER_INCLUDED
+
+#include <cppext_cycled_buffer.hpp>
+
+#include <vulkan_buffer.hpp>
+#include <vulkan_image.hpp>
+#include <vulkan_memory.hpp>
+
+#include <vulkan/vulkan_core.h>
+
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace vkrndr
+{
+    struct vulkan_device;
+    struct vulkan_pipeline;
+} // namespace vkrndr
+
+namespace beam
+{
+    class cpu_tracer;
+    struct frame_uniforms;
+    struct push_constants;
+    struct scene_view;
+} // namespace beam
+
+namespace beam
+{
+    // Splits progressive passes between the GPU and host worker threads. The
+    // host traces a band of rows at the top of the image with the CPU tracer
+    // while the megakernel traces the rest. Host samples are written into a
+    // persistently mapped staging buffer, copied into upload images and
+    // merged into the color and statistics images by a compute shader.
+    //
+    // A pass is merged in the first frame after the host is done with it,
+    // the render thread never waits for the workers. Until then the GPU
+    // leaves its rows out and no other pass is started, host rows fall
+    // behind instead of the frame rate. The band follows the measured cost
+    // of a pixel sample on both sides so they finish at the same time.
+    class [[nodiscard]] hybrid_tracer final
+    {
+    public:
+        hybrid_tracer(vkrndr::vulkan_device* device,
+            VkDescriptorSetLayout scene_layout,
+            uint32_t frames_in_flight,
+            VkExtent2D extent);
+
+        hybrid_tracer(hybrid_tracer const&) = delete;
+
+        hybrid_tracer(hybrid_tracer&&) noexcept = delete;
+
+    public:
+        ~hybrid_tracer();
+
+    public:
+        // Device has to be idle
+        void resize(VkExtent2D extent);
+
+        // The host copy of the scene is taken again for the next pass
+        void invalidate_scene();
+
+        // Accumulation starts over. Drops the pass that wasn't merged yet,
+        // blocks until the host is done with it.
+        void reset();
+
+        // Returns the rows at the top of the image the GPU leaves out of the
+        // frame, it traces samples into the rest. These are the rows of a
+        // pass still being traced or of a new one started on worker threads.
+        // The first pass is left to the GPU as host rows would show the
+        // previous image until merged. Device cost is the measured cost of a
+        // pixel sample on the GPU in milliseconds, zero while unknown.
+        [[nodiscard]] uint32_t trace(scene_view const& scene,
+            frame_uniforms const& frame,
+            uint32_t samples,
+            float device_cost);
+
+        // Merges the pass the host is done with into the color and
+        // statistics images bound in the scene descriptor set, a pass still
+        // being traced is left for a later frame. Has to be recorded before
+        // anything else of the frame accesses the host rows.
+        void merge(VkCommandBuffer command_buffer,
+            VkDescriptorSet scene_descriptor_set,
+            uint32_t frame_offset,
+            push_constants const& constants);
+
+        void draw_imgui();
+
+    public:
+        hybrid_tracer& operator=(hybrid_tracer const&) = delete;
+
+        hybrid_tracer& operator=(hybrid_tracer&&) noexcept = delete;
+
+    private:
+        struct [[nodiscard]] host_pass final
+        {
+            // Milliseconds spent tracing
+            std::future<float> time;
+            uint32_t rows{};
+            uint32_t samples{};
+            VkDeviceSize offset{};
+        };
+
+    private:
+        // Multiple of the merge workgroup height
+        [[nodiscard]] uint32_t host_rows() const;
+
+        void create_resources(VkExtent2D extent);
+
+        void destroy_resources();
+
+        void update_descriptor_set();
+
+    private:
+        vkrndr::vulkan_device* device_;
+        uint32_t frames_in_flight_;
+
+        VkDescriptorPool descriptor_pool_;
+        VkDescriptorSetLayout descriptor_layout_;
+        VkDescriptorSet descriptor_set_{VK_NULL_HANDLE};
+
+        std::unique_ptr<vkrndr::vulkan_pipeline> pipeline_;
+
+        VkExtent2D extent_;
+        vkrndr::vulkan_image color_upload_;
+        vkrndr::vulkan_image statistics_upload_;
+
+        // Slots of host samples, each holds colors of the whole image
+        // followed by statistics
+        VkDeviceSize slot_size_{};
+        vkrndr::vulkan_buffer staging_buffer_;
+        vkrndr::mapped_memory staging_map_{};
+        cppext::cycled_buffer<VkDeviceSize> offsets_;
+
+        std::unique_ptr<cpu_tracer> tracer_;
+        std::optional<host_pass> pending_;
+
+        // Samples accumulated in every row, rows of a host pass are counted
+        // once it is merged
+        std::vector<uint32_t> row_samples_;
+
+        // Fraction of the image traced on the host, smoothed over passes
+        float host_fraction_{0.25f};
+        // Milliseconds per sample of a single pixel on each side
+        float host_cost_{};
+        float device_cost_{};
+        uint32_t last_rows_{};
+    };
+} // namespace beam
+
+#endif
@@ -0,0 +1,101 @@
+#include <image_file.hpp>
+
+#include <cppext_numeric.hpp>
+
+#include <fmt/format.h>
+#include <fmt/std.h> // IWYU pragma: keep
+
+#include <glm/common.hpp>
+#include <glm/exponential.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+
+#include <stb_image_write.h>
+
+#include <vulkan/vulkan_core.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <initializer_list>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+    // Same curve and encoding as display.comp
+    [[nodiscard]] glm::vec3 aces_film(glm::vec3 const& x)
+    {
+        constexpr float a{2.51f};
+        constexpr float b{0.03f};
+        constexpr float c{2.43f};
+        constexpr float d{0.59f};
+        constexpr float e{0.14f};
+        return glm::clamp((x * (a * x + b)) / (x * (c * x + d) + e),
+            0.0f,
+            1.0f);
+    }
+
+    [[nodiscard]] float linear_to_srgb(float const value)
+    {
+        return value < 0.0031308f
+            ? value * 12.92f
+            : 1.055f * glm::pow(value, 1.0f / 2.4f) - 0.055f;
+    }
+
+    [[nodiscard]] uint8_t encode(float const value)
+    {
+        return static_cast<uint8_t>(linear_to_srgb(value) * 255.0f + 0.5f);
+    }
+} // namespace
+
+void beam::write_image(std::filesystem::path const& path,
+    VkExtent2D const extent,
+    std::span<glm::vec4 const> const pixels,
+    float const exposure,
+    bool const tonemap)
+{
+    auto const width{cppext::narrow<int>(extent.width)};
+    auto const height{cppext::narrow<int>(extent.height)};
+    std::string const filename{path.string()};
+
+    int result{};
+    if (path.extension() == ".hdr")
+    {
+        std::vector<float> rgb;
+        rgb.reserve(pixels.size() * 3);
+        for (glm::vec4 const& pixel : pixels)
+        {
+            rgb.insert(rgb.end(), {pixel.r, pixel.g, pixel.b});
+        }
+
+        result = stbi_write_hdr(filename.c_str(), width, height, 3, rgb.data());
+    }
+    else
+    {
+        std::vector<uint8_t> rgb;
+        rgb.reserve(pixels.size() * 3);
+        for (glm::vec4 const& pixel : pixels)
+        {
+            glm::vec3 color{glm::max(glm::vec3{pixel}, glm::vec3{0.0f}) *
+                exposure};
+            color = tonemap ? aces_film(color)
+                            : glm::clamp(color, 0.0f, 1.0f);
+            rgb.insert(rgb.end(),
+                {encode(color.r), encode(color.g), encode(color.b)});
+        }
+
+        result = stbi_write_png(filename.c_str(),
+            width,
+            height,
+            3,
+            rgb.data(),
+            width * 3);
+    }
+
+    if (result == 0)
+    {
+        throw std::runtime_error{fmt::format("Unable to write {}", path)};
+    }
+}
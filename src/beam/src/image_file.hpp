@@ -0,0 +1,23 @@
+#ifndef BEAM_IMAGE_FILE_INCLUDED
+#define BEAM_IMAGE_FILE_INCLUDED
+
+#include <glm/vec4.hpp>
+
+#include <vulkan/vulkan_core.h>
+
+#include <filesystem>
+#include <span>
+
+namespace beam
+{
+    // Writes linear radiance with rows from top to bottom. Radiance HDR
+    // files (.hdr) store it as is, other extensions are written as PNG with
+    // the tonemapping and sRGB encoding of the display.
+    void write_image(std::filesystem::path const& path,
+        VkExtent2D extent,
+        std::span<glm::vec4 const> pixels,
+        float exposure,
+        bool tonemap);
+} // namespace beam
+
+#endif
@@ -0,0 +1,98 @@
+#include <mesh.hpp>
+
+#include <sphere.hpp>
+
+#include <cppext_numeric.hpp>
+
+#include <gltf_manager.hpp>
+
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace
+{
+    constexpr uint32_t lambertian{0};
+    constexpr uint32_t metal{1};
+
+    [[nodiscard]] beam::material to_material(
+        vkrndr::gltf_material const& material)
+    {
+        glm::vec3 const color{material.base_color_factor};
+
+        // The raytracer has no PBR model, pick the closest of the analytic
+        // materials
+        if (material.metallic_factor >= 0.5f)
+        {
+            return {color, material.roughness_factor, metal};
+        }
+
+        return {color, 0.0f, lambertian};
+    }
+
+    [[nodiscard]] glm::vec3 to_world(glm::mat4 const& matrix,
+        glm::vec3 const& position)
+    {
+        return glm::vec3{matrix * glm::vec4{position, 1.0f}};
+    }
+} // namespace
+
+beam::mesh beam::flatten_model(vkrndr::gltf_model const& model)
+{
+    mesh rv;
+
+    rv.materials.reserve(model.materials.size());
+    for (vkrndr::gltf_material const& material : model.materials)
+    {
+        rv.materials.push_back(to_material(material));
+    }
+
+    // Default material is always the last one
+    auto const default_material{
+        cppext::narrow<uint32_t>(model.materials.size() - 1)};
+
+    for (vkrndr::gltf_node const& node : model.nodes)
+    {
+        if (!node.mesh)
+        {
+            continue;
+        }
+
+        glm::mat4 const matrix{vkrndr::local_matrix(node)};
+
+        for (vkrndr::gltf_primitive const& primitive : node.mesh->primitives)
+        {
+            uint32_t const material{primitive.material
+                    ? cppext::narrow<uint32_t>(
+                          primitive.material - model.materials.data())
+                    : default_material};
+
+            auto const vertex_at = [&](size_t const i)
+            {
+                size_t const index{
+                    primitive.indices.empty() ? i : primitive.indices[i]};
+                return to_world(matrix, primitive.vertices[index].position);
+            };
+
+            size_t const count{primitive.indices.empty()
+                    ? primitive.vertices.size()
+                    : primitive.indices.size()};
+            for (size_t i{}; i + 2 < count; i += 3)
+            {
+                glm::vec3 const v0{vertex_at(i)};
+                glm::vec3 const v1{vertex_at(i + 1)};
+                glm::vec3 const v2{vertex_at(i + 2)};
+
+                rv.triangles.push_back({.v0 = v0,
+                    .material = material,
+                    .edge1 = v1 - v0,
+                    .edge2 = v2 - v0});
+            }
+        }
+    }
+
+    return rv;
+}
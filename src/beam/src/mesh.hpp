@@ -0,0 +1,45 @@
+#ifndef BEAM_MESH_INCLUDED
+#define BEAM_MESH_INCLUDED
+
+#include <sphere.hpp>
+
+#include <cppext_pragma_warning.hpp>
+
+#include <glm/vec3.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace vkrndr
+{
+    struct gltf_model;
+} // namespace vkrndr
+
+namespace beam
+{
+    DISABLE_WARNING_PUSH
+
+    DISABLE_WARNING_STRUCTURE_WAS_PADDED_DUE_TO_ALIGNMENT_SPECIFIER
+    // Matches the std430 layout of Triangle in the shaders
+    struct [[nodiscard]] alignas(16) triangle final
+    {
+        glm::vec3 v0;
+        uint32_t material;
+        alignas(16) glm::vec3 edge1;
+        alignas(16) glm::vec3 edge2;
+    };
+
+    DISABLE_WARNING_POP
+
+    struct [[nodiscard]] mesh final
+    {
+        std::vector<triangle> triangles;
+        // Triangle material indices are relative to the start of this array
+        std::vector<material> materials;
+    };
+
+    // Flattens all node primitives of the model to world space triangles
+    [[nodiscard]] mesh flatten_model(vkrndr::gltf_model const& model);
+} // namespace beam
+
+#endif
@@ -0,0 +1,222 @@
+#include <pipeline_variants.hpp>
+
+#include <vulkan_device.hpp>
+#include <vulkan_pipeline.hpp>
+
+#include <spdlog/spdlog.h>
+
+#include <vulkan/vulkan_core.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <future>
+#include <utility>
+#include <vector>
+
+namespace
+{
+    // First specialization constant of the variant in raytracer.comp, the
+    // ones before it select the dispatch configuration
+    constexpr uint32_t first_constant_id{3};
+
+    [[nodiscard]] beam::pipeline_variant build_variant(
+        beam::pipeline_variants::build_function const& build,
+        beam::variant_key const key)
+    {
+        std::array<VkSpecializationMapEntry, 3> const entries{
+            VkSpecializationMapEntry{.constantID = first_constant_id,
+                .offset = offsetof(beam::variant_key, max_depth),
+                .size = sizeof(uint32_t)},
+            VkSpecializationMapEntry{.constantID = first_constant_id + 1,
+                .offset = offsetof(beam::variant_key, samples),
+                .size = sizeof(uint32_t)},
+            VkSpecializationMapEntry{.constantID = first_constant_id + 2,
+                .offset = offsetof(beam::variant_key, material_mask),
+                .size = sizeof(uint32_t)}};
+
+        return build({.mapEntryCount = static_cast<uint32_t>(entries.size()),
+            .pMapEntries = entries.data(),
+            .dataSize = sizeof(key),
+            .pData = &key});
+    }
+
+    void destroy_variant(vkrndr::vulkan_device* const device,
+        beam::pipeline_variant* const variant)
+    {
+        if (variant->ray_query)
+        {
+            destroy(device, variant->ray_query.get());
+        }
+        if (variant->compute)
+        {
+            destroy(device, variant->compute.get());
+        }
+    }
+} // namespace
+
+beam::pipeline_variants::pipeline_variants(
+    vkrndr::vulkan_device* const device,
+    size_t const capacity,
+    uint32_t const frames_in_flight)
+    : device_{device}
+    , capacity_{capacity}
+    , frames_in_flight_{frames_in_flight}
+{
+}
+
+beam::pipeline_variants::~pipeline_variants() { clear(); }
+
+void beam::pipeline_variants::reset(build_function build)
+{
+    clear();
+    build_ = std::move(build);
+}
+
+void beam::pipeline_variants::begin_frame()
+{
+    ++frame_;
+
+    // A variant evicted while recording frame N can be bound in it, the
+    // frame has finished when frame N + frames in flight starts
+    std::erase_if(retired_,
+        [this](retired_variant& retired)
+        {
+            if (frame_ - retired.frame < frames_in_flight_)
+            {
+                return false;
+            }
+
+            destroy_variant(device_, &retired.variant);
+            return true;
+        });
+}
+
+beam::pipeline_variant const* beam::pipeline_variants::find(
+    variant_key const& key)
+{
+    collect_finished();
+
+    if (auto const it{ready_.find(key)}; it != ready_.cend())
+    {
+        it->second.last_use = ++use_counter_;
+        return &it->second.variant;
+    }
+
+    if (build_ && !pending_.contains(key) && !failed_.contains(key))
+    {
+        pending_.emplace(key,
+            std::async(std::launch::async,
+                [build = build_, key]() { return build_variant(build, key); }));
+    }
+
+    return nullptr;
+}
+
+beam::pipeline_variant const* beam::pipeline_variants::wait(
+    variant_key const& key)
+{
+    if (pipeline_variant const* const variant{find(key)})
+    {
+        return variant;
+    }
+
+    auto const it{pending_.find(key)};
+    if (it == pending_.cend())
+    {
+        return nullptr;
+    }
+
+    it->second.wait();
+    return find(key);
+}
+
+size_t beam::pipeline_variants::ready_count() const { return ready_.size(); }
+
+size_t beam::pipeline_variants::pending_count() const
+{
+    return pending_.size();
+}
+
+void beam::pipeline_variants::collect_finished()
+{
+    for (auto it{pending_.begin()}; it != pending_.end();)
+    {
+        if (it->second.wait_for(std::chrono::seconds{0}) !=
+            std::future_status::ready)
+        {
+            ++it;
+            continue;
+        }
+
+        pipeline_variant variant;
+        try
+        {
+            variant = it->second.get();
+        }
+        catch (std::exception const& e)
+        {
+            spdlog::error("Unable to compile pipeline variant: {}", e.what());
+            failed_.insert(it->first);
+            it = pending_.erase(it);
+            continue;
+        }
+
+        if (ready_.size() == capacity_)
+        {
+            evict();
+        }
+
+        ready_.emplace(it->first,
+            entry{.variant = std::move(variant), .last_use = ++use_counter_});
+        it = pending_.erase(it);
+    }
+}
+
+void beam::pipeline_variants::evict()
+{
+    auto const oldest{std::ranges::min_element(ready_,
+        {},
+        [](auto const& pair) { return pair.second.last_use; })};
+
+    // The variant may still be used by frames in flight
+    retired_.push_back({.variant = std::move(oldest->second.variant),
+        .frame = frame_});
+    ready_.erase(oldest);
+}
+
+void beam::pipeline_variants::clear()
+{
+    for (auto& [key, future] : pending_)
+    {
+        try
+        {
+            pipeline_variant variant{future.get()};
+            destroy_variant(device_, &variant);
+        }
+        catch (std::exception const&)
+        {
+            // A failed build left nothing to destroy
+        }
+    }
+    pending_.clear();
+    failed_.clear();
+
+    if (!ready_.empty() || !retired_.empty())
+    {
+        vkDeviceWaitIdle(device_->logical);
+    }
+    for (auto& [key, e] : ready_)
+    {
+        destroy_variant(device_, &e.variant);
+    }
+    ready_.clear();
+    for (retired_variant& retired : retired_)
+    {
+        destroy_variant(device_, &retired.variant);
+    }
+    retired_.clear();
+}
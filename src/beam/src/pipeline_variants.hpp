@@ -0,0 +1,129 @@
+#ifndef BEAM_PIPELINE_VARIANTS_INCLUDED
+#define BEAM_PIPELINE_VARIANTS_INCLUDED
+
+#include <vulkan/vulkan_core.h>
+
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <set>
+#include <vector>
+
+namespace vkrndr
+{
+    struct vulkan_device;
+    struct vulkan_pipeline;
+} // namespace vkrndr
+
+namespace beam
+{
+    // Matches specialization constants of raytracer.comp, zero bounce or
+    // sample count leaves the value to runtime
+    struct [[nodiscard]] variant_key final
+    {
+        uint32_t max_depth{};
+        uint32_t samples{};
+        uint32_t material_mask{};
+
+        [[nodiscard]] auto operator<=>(variant_key const&) const = default;
+    };
+
+    // Megakernel pipelines specialized for a key, the ray query one is
+    // missing on devices without ray queries
+    struct [[nodiscard]] pipeline_variant final
+    {
+        std::unique_ptr<vkrndr::vulkan_pipeline> compute;
+        std::unique_ptr<vkrndr::vulkan_pipeline> ray_query;
+    };
+
+    // Small cache of specialized megakernel pipelines. Variants are compiled
+    // on a background thread when first requested, the generic pipelines are
+    // used until they are ready or when compiling fails. The least recently
+    // used variant is evicted when the cache is full, it is destroyed once
+    // the frames in flight that could use it have finished.
+    class [[nodiscard]] pipeline_variants final
+    {
+    public:
+        using build_function =
+            std::function<pipeline_variant(VkSpecializationInfo const&)>;
+
+    public:
+        pipeline_variants(vkrndr::vulkan_device* device,
+            size_t capacity,
+            uint32_t frames_in_flight);
+
+        pipeline_variants(pipeline_variants const&) = delete;
+
+        pipeline_variants(pipeline_variants&&) noexcept = delete;
+
+    public:
+        ~pipeline_variants();
+
+    public:
+        // Drops all variants, new ones are compiled with the function. It is
+        // called from a background thread and can't touch the caller's state.
+        void reset(build_function build);
+
+        // Has to be called when recording of a frame starts, after the frame
+        // that used its slot last has finished
+        void begin_frame();
+
+        // Variant for the key if it's ready, otherwise starts compiling it
+        // and returns nullptr
+        [[nodiscard]] pipeline_variant const* find(variant_key const& key);
+
+        // Variant for the key, blocks until it's compiled. Returns nullptr
+        // without a build function or when compiling failed.
+        [[nodiscard]] pipeline_variant const* wait(variant_key const& key);
+
+        [[nodiscard]] size_t ready_count() const;
+
+        [[nodiscard]] size_t pending_count() const;
+
+    public:
+        pipeline_variants& operator=(pipeline_variants const&) = delete;
+
+        pipeline_variants& operator=(pipeline_variants&&) noexcept = delete;
+
+    private:
+        struct [[nodiscard]] entry final
+        {
+            pipeline_variant variant;
+            uint64_t last_use{};
+        };
+
+        struct [[nodiscard]] retired_variant final
+        {
+            pipeline_variant variant;
+            // Frame in which the variant was evicted
+            uint64_t frame{};
+        };
+
+    private:
+        void collect_finished();
+
+        void evict();
+
+        void clear();
+
+    private:
+        vkrndr::vulkan_device* device_;
+        size_t capacity_;
+        uint32_t frames_in_flight_;
+
+        build_function build_;
+        std::map<variant_key, entry> ready_;
+        std::map<variant_key, std::future<pipeline_variant>> pending_;
+        // Keys whose build threw, they aren't compiled again until reset
+        std::set<variant_key> failed_;
+        std::vector<retired_variant> retired_;
+        uint64_t use_counter_{};
+        uint64_t frame_{};
+    };
+} // namespace beam
+
+#endif
@@ -0,0 +1,29 @@
+#ifndef BEAM_PUSH_CONSTANTS_INCLUDED
+#define BEAM_PUSH_CONSTANTS_INCLUDED
+
+#include <cstdint>
+
+namespace beam
+{
+    // Matches PushConsts in scene.glsl, shared by the megakernel and the
+    // wavefront kernels. Values that change between dispatches of a frame,
+    // the rest of the parameters are in frame uniforms.
+    struct [[nodiscard]] push_constants final
+    {
+        uint32_t samples_per_pixel;
+        uint32_t total_samples;
+        uint32_t use_bvh;
+        uint32_t bounce;
+        uint32_t sample_index;
+        uint32_t wavefront_stage;
+        uint32_t material_bins;
+        uint32_t shade_material;
+        float adaptive_threshold;
+        uint32_t row_offset;
+    };
+
+    // Minimum of maxPushConstantsSize guaranteed by the specification
+    static_assert(sizeof(push_constants) <= 128);
+} // namespace beam
+
+#endif
@@ -1,23 +1,45 @@
 #include <raytracer.hpp>
 
+#include <acceleration_structures.hpp>
+#include <adaptive_sampler.hpp>
+#include <bvh.hpp>
+#include <dispatch_tuner.hpp>
+#include <frame_uniforms.hpp>
+#include <hybrid_tracer.hpp>
+#include <mesh.hpp>
 #include <perspective_camera.hpp>
+#include <pipeline_variants.hpp>
+#include <push_constants.hpp>
 #include <renderer.hpp>
+#include <reprojection.hpp>
+#include <sample_scheduler.hpp>
+#include <scene_buffer.hpp>
+#include <scene_file.hpp>
 #include <sphere.hpp>
+#include <wavefront.hpp>
 
 #include <cppext_numeric.hpp>
 #include <cppext_pragma_warning.hpp>
 
+#include <gltf_manager.hpp>
+
 #include <vulkan_buffer.hpp>
+#include <vulkan_commands.hpp>
 #include <vulkan_descriptors.hpp>
 #include <vulkan_device.hpp>
 #include <vulkan_image.hpp>
 #include <vulkan_memory.hpp>
 #include <vulkan_pipeline.hpp>
+#include <vulkan_query.hpp>
+#include <vulkan_queue.hpp>
 #include <vulkan_renderer.hpp>
 #include <vulkan_utility.hpp>
 
 #include <glm/geometric.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <glm/trigonometric.hpp>
 #include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
 
 #include <imgui.h>
 
@@ -25,35 +47,65 @@
 
 #include <algorithm>
 #include <array>
+#include <chrono>
 #include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <optional>
 #include <random>
+#include <span>
+#include <utility>
 #include <vector>
 
-// IWYU pragma: no_include <filesystem>
-
 namespace
 {
     // NOLINTBEGIN(cppcoreguidelines-avoid-non-const-global-variables)
     std::default_random_engine rng{std::random_device{}()};
-    std::uniform_int_distribution<uint32_t> frame_dist{};
+    std::uniform_int_distribution<uint32_t> seed_dist{};
 
     // NOLINTEND(cppcoreguidelines-avoid-non-const-global-variables)
 
-    struct [[nodiscard]] push_constants
-    {
-        glm::vec3 camera_position;
-        uint32_t world_count;
-        glm::vec3 camera_front;
-        uint32_t material_count;
-        glm::vec3 camera_up;
-        uint32_t samples_per_pixel;
-        uint32_t max_depth;
-        float defocus_angle;
-        float focus_distance;
-        float fovy;
-        uint32_t total_samples;
-        uint32_t frame_seed;
-    };
+    constexpr uint32_t benchmark_dispatches{4};
+
+    constexpr size_t max_variants{8};
+
+    // Linear intersection is O(N) per ray, don't stall the GPU for seconds on
+    // scenes where it won't finish in a reasonable amount of time
+    constexpr uint32_t linear_benchmark_primitive_limit{50000};
+
+    // Camera rays per side of the grid the scene fetch is measured with
+    constexpr uint32_t fetch_benchmark_grid{64};
+
+    [[nodiscard]] std::unique_ptr<vkrndr::vulkan_pipeline> create_megakernel(
+        vkrndr::vulkan_device* const device,
+        std::shared_ptr<VkPipelineLayout> layout,
+        std::filesystem::path const& shader,
+        beam::dispatch_config const& config,
+        VkSpecializationInfo const* const variant = nullptr)
+    {
+        vkrndr::vulkan_compute_pipeline_builder builder{device,
+            std::move(layout)};
+        builder.with_shader(shader, "main")
+            .add_specialization_constant(0, config.width)
+            .add_specialization_constant(1, config.height)
+            .add_specialization_constant(2, std::to_underlying(config.order));
+        if (variant)
+        {
+            builder.with_specialization(*variant);
+        }
+        return std::make_unique<vkrndr::vulkan_pipeline>(builder.build());
+    }
+
+    [[nodiscard]] beam::aabb sphere_bounds(glm::vec4 const& center_radius)
+    {
+        glm::vec3 const center{center_radius};
+        return {.min = center - glm::vec3{center_radius.w},
+            .max = center + glm::vec3{center_radius.w}};
+    }
 
     [[nodiscard]] VkDescriptorSetLayout create_descriptor_set_layout(
         vkrndr::vulkan_device const* const device)
@@ -77,9 +129,79 @@ namespace
         material_buffer_binding.descriptorCount = 1;
         material_buffer_binding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
 
+        VkDescriptorSetLayoutBinding bvh_buffer_binding{};
+        bvh_buffer_binding.binding = 3;
+        bvh_buffer_binding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bvh_buffer_binding.descriptorCount = 1;
+        bvh_buffer_binding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+        VkDescriptorSetLayoutBinding triangle_buffer_binding{};
+        triangle_buffer_binding.binding = 4;
+        triangle_buffer_binding.descriptorType =
+            VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        triangle_buffer_binding.descriptorCount = 1;
+        triangle_buffer_binding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+        VkDescriptorSetLayoutBinding variance_image_binding{};
+        variance_image_binding.binding = 5;
+        variance_image_binding.descriptorType =
+            VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        variance_image_binding.descriptorCount = 1;
+        variance_image_binding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+        VkDescriptorSetLayoutBinding tile_buffer_binding{};
+        tile_buffer_binding.binding = 6;
+        tile_buffer_binding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        tile_buffer_binding.descriptorCount = 1;
+        tile_buffer_binding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+        VkDescriptorSetLayoutBinding light_buffer_binding{};
+        light_buffer_binding.binding = 9;
+        light_buffer_binding.descriptorType =
+            VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        light_buffer_binding.descriptorCount = 1;
+        light_buffer_binding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+        VkDescriptorSetLayoutBinding albedo_image_binding{};
+        albedo_image_binding.binding = 7;
+        albedo_image_binding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        albedo_image_binding.descriptorCount = 1;
+        albedo_image_binding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+        VkDescriptorSetLayoutBinding normal_depth_image_binding{};
+        normal_depth_image_binding.binding = 8;
+        normal_depth_image_binding.descriptorType =
+            VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        normal_depth_image_binding.descriptorCount = 1;
+        normal_depth_image_binding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+        VkDescriptorSetLayoutBinding frame_uniforms_binding{};
+        frame_uniforms_binding.binding = 10;
+        frame_uniforms_binding.descriptorType =
+            VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+        frame_uniforms_binding.descriptorCount = 1;
+        frame_uniforms_binding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+        VkDescriptorSetLayoutBinding sphere_material_buffer_binding{};
+        sphere_material_buffer_binding.binding = 11;
+        sphere_material_buffer_binding.descriptorType =
+            VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        sphere_material_buffer_binding.descriptorCount = 1;
+        sphere_material_buffer_binding.stageFlags =
+            VK_SHADER_STAGE_COMPUTE_BIT;
+
         std::array const bindings{target_image_binding,
             world_buffer_binding,
-            material_buffer_binding};
+            material_buffer_binding,
+            bvh_buffer_binding,
+            triangle_buffer_binding,
+            variance_image_binding,
+            tile_buffer_binding,
+            albedo_image_binding,
+            normal_depth_image_binding,
+            light_buffer_binding,
+            frame_uniforms_binding,
+            sphere_material_buffer_binding};
 
         VkDescriptorSetLayoutCreateInfo layout_info{};
         layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
@@ -99,7 +221,16 @@ namespace
         VkDescriptorSet const& descriptor_set,
         VkDescriptorImageInfo const target_image_info,
         VkDescriptorBufferInfo const world_buffer_info,
-        VkDescriptorBufferInfo const material_buffer_info)
+        VkDescriptorBufferInfo const material_buffer_info,
+        VkDescriptorBufferInfo const bvh_buffer_info,
+        VkDescriptorBufferInfo const triangle_buffer_info,
+        VkDescriptorImageInfo const variance_image_info,
+        VkDescriptorBufferInfo const tile_buffer_info,
+        VkDescriptorImageInfo const albedo_image_info,
+        VkDescriptorImageInfo const normal_depth_image_info,
+        VkDescriptorBufferInfo const light_buffer_info,
+        VkDescriptorBufferInfo const frame_uniforms_info,
+        VkDescriptorBufferInfo const sphere_material_buffer_info)
     {
         VkWriteDescriptorSet target_image_write{};
         target_image_write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
@@ -129,9 +260,106 @@ namespace
         material_buffer_write.descriptorCount = 1;
         material_buffer_write.pBufferInfo = &material_buffer_info;
 
+        VkWriteDescriptorSet bvh_buffer_write{};
+        bvh_buffer_write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        bvh_buffer_write.dstSet = descriptor_set;
+        bvh_buffer_write.dstBinding = 3;
+        bvh_buffer_write.dstArrayElement = 0;
+        bvh_buffer_write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bvh_buffer_write.descriptorCount = 1;
+        bvh_buffer_write.pBufferInfo = &bvh_buffer_info;
+
+        VkWriteDescriptorSet triangle_buffer_write{};
+        triangle_buffer_write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        triangle_buffer_write.dstSet = descriptor_set;
+        triangle_buffer_write.dstBinding = 4;
+        triangle_buffer_write.dstArrayElement = 0;
+        triangle_buffer_write.descriptorType =
+            VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        triangle_buffer_write.descriptorCount = 1;
+        triangle_buffer_write.pBufferInfo = &triangle_buffer_info;
+
+        VkWriteDescriptorSet variance_image_write{};
+        variance_image_write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        variance_image_write.dstSet = descriptor_set;
+        variance_image_write.dstBinding = 5;
+        variance_image_write.dstArrayElement = 0;
+        variance_image_write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        variance_image_write.descriptorCount = 1;
+        variance_image_write.pImageInfo = &variance_image_info;
+
+        VkWriteDescriptorSet tile_buffer_write{};
+        tile_buffer_write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        tile_buffer_write.dstSet = descriptor_set;
+        tile_buffer_write.dstBinding = 6;
+        tile_buffer_write.dstArrayElement = 0;
+        tile_buffer_write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        tile_buffer_write.descriptorCount = 1;
+        tile_buffer_write.pBufferInfo = &tile_buffer_info;
+
+        VkWriteDescriptorSet albedo_image_write{};
+        albedo_image_write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        albedo_image_write.dstSet = descriptor_set;
+        albedo_image_write.dstBinding = 7;
+        albedo_image_write.dstArrayElement = 0;
+        albedo_image_write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        albedo_image_write.descriptorCount = 1;
+        albedo_image_write.pImageInfo = &albedo_image_info;
+
+        VkWriteDescriptorSet normal_depth_image_write{};
+        normal_depth_image_write.sType =
+            VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        normal_depth_image_write.dstSet = descriptor_set;
+        normal_depth_image_write.dstBinding = 8;
+        normal_depth_image_write.dstArrayElement = 0;
+        normal_depth_image_write.descriptorType =
+            VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        normal_depth_image_write.descriptorCount = 1;
+        normal_depth_image_write.pImageInfo = &normal_depth_image_info;
+
+        VkWriteDescriptorSet light_buffer_write{};
+        light_buffer_write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        light_buffer_write.dstSet = descriptor_set;
+        light_buffer_write.dstBinding = 9;
+        light_buffer_write.dstArrayElement = 0;
+        light_buffer_write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        light_buffer_write.descriptorCount = 1;
+        light_buffer_write.pBufferInfo = &light_buffer_info;
+
+        VkWriteDescriptorSet frame_uniforms_write{};
+        frame_uniforms_write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        frame_uniforms_write.dstSet = descriptor_set;
+        frame_uniforms_write.dstBinding = 10;
+        frame_uniforms_write.dstArrayElement = 0;
+        frame_uniforms_write.descriptorType =
+            VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+        frame_uniforms_write.descriptorCount = 1;
+        frame_uniforms_write.pBufferInfo = &frame_uniforms_info;
+
+        VkWriteDescriptorSet sphere_material_buffer_write{};
+        sphere_material_buffer_write.sType =
+            VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        sphere_material_buffer_write.dstSet = descriptor_set;
+        sphere_material_buffer_write.dstBinding = 11;
+        sphere_material_buffer_write.dstArrayElement = 0;
+        sphere_material_buffer_write.descriptorType =
+            VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        sphere_material_buffer_write.descriptorCount = 1;
+        sphere_material_buffer_write.pBufferInfo =
+            &sphere_material_buffer_info;
+
         std::array const descriptor_writes{target_image_write,
             world_buffer_write,
-            material_buffer_write};
+            material_buffer_write,
+            bvh_buffer_write,
+            triangle_buffer_write,
+            variance_image_write,
+            tile_buffer_write,
+            albedo_image_write,
+            normal_depth_image_write,
+            light_buffer_write,
+            frame_uniforms_write,
+            sphere_material_buffer_write};
 
         vkUpdateDescriptorSets(device->logical,
             vkrndr::count_cast(descriptor_writes.size()),
@@ -148,114 +376,245 @@ beam::raytracer::raytracer(vkrndr::vulkan_device* device,
     , renderer_{renderer}
     , scene_{scene}
     , descriptor_layout_{create_descriptor_set_layout(device_)}
+    , world_buffer_{device_, renderer_}
+    , sphere_material_buffer_{device_, renderer_}
+    , material_buffer_{device_, renderer_}
+    , bvh_buffer_{device_, renderer_}
+    , triangle_buffer_{device_, renderer_}
+    , light_buffer_{device_, renderer_}
 {
+    if (device_->ray_query)
+    {
+        acceleration_structures_ =
+            std::make_unique<acceleration_structures>(device_);
+        options_.ray_query = true;
+    }
+
+    // Loading the scene invalidates the host copy of the hybrid tracer
+    hybrid_tracer_ = std::make_unique<hybrid_tracer>(device_,
+        descriptor_layout_,
+        renderer_->frames_in_flight(),
+        scene_->color_image().extent);
+
     fill_world_and_materials();
 
+    frame_uniforms_ = std::make_unique<frame_uniform_ring>(device_,
+        renderer_->frames_in_flight());
+
     vkrndr::create_descriptor_sets(device_,
         descriptor_layout_,
         renderer_->descriptor_pool(),
         std::span{&descriptor_set_, 1});
 
-    compute_pipeline_ = std::make_unique<vkrndr::vulkan_pipeline>(
-        vkrndr::vulkan_compute_pipeline_builder{device_,
-            vkrndr::vulkan_pipeline_layout_builder{device_}
-                .add_descriptor_set_layout(descriptor_layout_)
-                .add_push_constants(VkPushConstantRange{
-                    .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
-                    .offset = 0,
-                    .size = sizeof(push_constants),
-                })
-                .build()}
-            .with_shader("raytracer.comp.spv", "main")
-            .build());
+    dispatch_tuner_ = std::make_unique<dispatch_tuner>(device_);
+    variants_ = std::make_unique<pipeline_variants>(device_,
+        max_variants,
+        renderer_->frames_in_flight());
+    create_pipelines(active_dispatch_config());
 
-    DISABLE_WARNING_PUSH
-    DISABLE_WARNING_MISSING_FIELD_INITIALIZERS
-    bind_descriptor_set(device_,
-        descriptor_set_,
-        VkDescriptorImageInfo{.imageView = scene_->color_image().view,
-            .imageLayout = VK_IMAGE_LAYOUT_GENERAL},
-        VkDescriptorBufferInfo{.buffer = world_buffer_.buffer,
-            .offset = 0,
-            .range = world_buffer_.size},
-        VkDescriptorBufferInfo{.buffer = material_buffer_.buffer,
-            .offset = 0,
-            .range = material_buffer_.size});
-    DISABLE_WARNING_POP
+    wavefront_ = std::make_unique<wavefront>(device_,
+        descriptor_layout_,
+        scene_->color_image().extent);
+
+    adaptive_sampler_ = std::make_unique<adaptive_sampler>(device_,
+        descriptor_layout_,
+        scene_->color_image().extent);
+
+    sample_scheduler_ = std::make_unique<sample_scheduler>(device_);
+
+    reprojection_ = std::make_unique<reprojection>(device_,
+        descriptor_layout_,
+        scene_->color_image().extent);
+
+    update_descriptor_set();
 }
 
 beam::raytracer::~raytracer()
 {
-    destroy(device_, &material_buffer_);
-    destroy(device_, &world_buffer_);
+    hybrid_tracer_.reset();
+    reprojection_.reset();
+    dispatch_tuner_.reset();
+    sample_scheduler_.reset();
+    adaptive_sampler_.reset();
+    wavefront_.reset();
 
-    destroy(device_, compute_pipeline_.get());
+    variants_.reset();
+    destroy_pipelines();
+    acceleration_structures_.reset();
+
+    frame_uniforms_.reset();
 
     vkDestroyDescriptorSetLayout(device_->logical, descriptor_layout_, nullptr);
 }
 
+void beam::raytracer::load_model(std::filesystem::path const& path)
+{
+    std::unique_ptr<vkrndr::gltf_model> model{renderer_->load_model(path)};
+    mesh_ = flatten_model(*model);
+
+    // Only geometry and material factors are used, textures aren't sampled
+    for (vkrndr::gltf_texture& texture : model->textures)
+    {
+        destroy(device_, &texture.image);
+    }
+
+    vkDeviceWaitIdle(device_->logical);
+    fill_world_and_materials();
+    update_descriptor_set();
+    reset_accumulation();
+}
+
+void beam::raytracer::load_scene_file(std::filesystem::path const& path)
+{
+    scene_file const file{path};
+
+    // Sections are copied whole from the mapping into the host copies of the
+    // scene buffers, edits are applied to those
+    vkDeviceWaitIdle(device_->logical);
+    load_scene(file.view());
+    update_descriptor_set();
+    reset_accumulation();
+}
+
+void beam::raytracer::save_scene_file(std::filesystem::path const& path) const
+{
+    write_scene_file(path, current_scene());
+}
+
 void beam::raytracer::update(perspective_camera const& camera)
 {
+    // Wavefront accumulation doesn't keep per pixel sample counts, it can't
+    // carry history over. Host samples of hybrid passes continue the
+    // sequence from the pass count, which has to match every pixel.
+    bool const reproject{temporal_reprojection_ && !options_.wavefront &&
+        !hybrid_active() && total_samples_ != 0};
+    if (reproject && !previous_camera_)
+    {
+        previous_camera_ = camera_pose{.position = camera_position_,
+            .front = camera_position_ + camera_front_,
+            .up = camera_up_};
+    }
+
+    // Reprojected history is continued with a fresh scramble of the sequence
+    // so it doesn't correlate with samples taken from the old camera
+    if (reproject)
+    {
+        sequence_seed_ = seed_dist(rng);
+    }
+
     camera_position_ = camera.position();
     camera_front_ = camera.front_direction();
     camera_up_ = camera.up_direction();
-    total_samples_ = 0;
+
+    if (!reproject)
+    {
+        reset_accumulation();
+    }
 }
 
 void beam::raytracer::draw(VkCommandBuffer command_buffer)
 {
-    auto const& target_extent{scene_->color_image().extent};
+    frame_uniforms_->cycle();
+    variants_->begin_frame();
 
-    push_constants const pc{.camera_position = camera_position_,
-        .world_count = sphere_count_,
-        .camera_front = camera_position_ + camera_front_,
-        .material_count = material_count_,
-        .camera_up = camera_up_,
-        .samples_per_pixel = cppext::narrow<uint32_t>(samples_per_pixel_),
-        .max_depth = cppext::narrow<uint32_t>(max_depth_),
-        .defocus_angle = defocus_angle_,
-        .focus_distance = focus_distance_,
-        .fovy = fovy_,
-        .total_samples = total_samples_,
-        .frame_seed = frame_dist(rng)};
+    // Scene buffers and descriptors can't change once they are bound in a
+    // command buffer, do the requested work before recording this frame
+    if (std::exchange(rebuild_scene_, false))
+    {
+        vkDeviceWaitIdle(device_->logical);
+        fill_world_and_materials();
+        update_descriptor_set();
+        reset_accumulation();
+    }
 
-    vkCmdPushConstants(command_buffer,
-        *compute_pipeline_->layout,
-        VK_SHADER_STAGE_COMPUTE_BIT,
-        0,
-        sizeof(push_constants),
-        &pc);
+    apply_scene_edits(command_buffer);
 
-    vkrndr::bind_pipeline(command_buffer,
-        *compute_pipeline_,
-        0,
-        std::span{&descriptor_set_, 1});
+    bool const benchmark{std::exchange(benchmark_requested_, false)};
+    bool const autotune{std::exchange(autotune_requested_, false)};
+    if (benchmark || autotune)
+    {
+        write_frame_uniforms();
+        if (autotune)
+        {
+            run_autotune();
+        }
+        if (benchmark)
+        {
+            run_benchmark();
+        }
+        reset_accumulation();
+    }
+
+    // Adaptive sampling can't use the tuned configuration, switching is
+    // done before anything is recorded with the old pipelines
+    use_dispatch_config(active_dispatch_config());
+
+    write_frame_uniforms();
+
+    if (previous_camera_)
+    {
+        reprojection_->reproject(command_buffer,
+            descriptor_set_,
+            frame_uniforms_->offset(),
+            make_push_constants(options_, full_region()),
+            scene_->color_image(),
+            adaptive_sampler_->variance_image(),
+            scene_->normal_depth_image());
+        previous_camera_.reset();
+    }
+
+    auto const& extent{scene_->color_image().extent};
+    if (hybrid_active())
+    {
+        // A finished host pass is merged before its rows are traced again,
+        // rows of a pass still being traced are left out of the region
+        hybrid_tracer_->merge(command_buffer,
+            descriptor_set_,
+            frame_uniforms_->offset(),
+            make_push_constants(options_, full_region()));
 
-    vkCmdDispatch(command_buffer,
-        static_cast<uint32_t>(
-            std::ceil(cppext::as_fp(target_extent.width) / 16.0f)),
-        static_cast<uint32_t>(
-            std::ceil(cppext::as_fp(target_extent.height) / 16.0f)),
-        1);
+        sample_region region{full_region()};
+        region.first_row = hybrid_tracer_->trace(current_scene(),
+            current_frame_uniforms(),
+            region.samples,
+            sample_scheduler_->sample_cost());
+        region.row_count -= region.first_row;
 
-    total_samples_ += cppext::narrow<uint32_t>(samples_per_pixel_);
+        sample_scheduler_->begin(command_buffer);
+        dispatch(command_buffer, options_, region);
+        sample_scheduler_->end(command_buffer,
+            uint64_t{region.samples} * extent.width * region.row_count);
+    }
+    else if (frame_budget_ && sample_scheduler_->supported())
+    {
+        // Bands rely on per pixel sample counts kept by the megakernel,
+        // the other paths trace the whole image
+        bool const restart{std::exchange(restart_, false)};
+        sample_region const region{sample_scheduler_->next_region(extent,
+            restart,
+            !options_.wavefront && !options_.adaptive)};
+
+        sample_scheduler_->begin(command_buffer);
+        dispatch(command_buffer, options_, region);
+        sample_scheduler_->end(command_buffer,
+            uint64_t{region.samples} * extent.width * region.row_count);
+    }
+    else
+    {
+        dispatch(command_buffer, options_, full_region());
+    }
+
+    update_convergence();
 }
 
 void beam::raytracer::on_resize()
 {
-    DISABLE_WARNING_PUSH
-    DISABLE_WARNING_MISSING_FIELD_INITIALIZERS
-    bind_descriptor_set(device_,
-        descriptor_set_,
-        VkDescriptorImageInfo{.imageView = scene_->color_image().view,
-            .imageLayout = VK_IMAGE_LAYOUT_GENERAL},
-        VkDescriptorBufferInfo{.buffer = world_buffer_.buffer,
-            .offset = 0,
-            .range = world_buffer_.size},
-        VkDescriptorBufferInfo{.buffer = material_buffer_.buffer,
-            .offset = 0,
-            .range = material_buffer_.size});
-    DISABLE_WARNING_POP
+    wavefront_->resize(scene_->color_image().extent);
+    adaptive_sampler_->resize(scene_->color_image().extent);
+    reprojection_->resize(scene_->color_image().extent);
+    hybrid_tracer_->resize(scene_->color_image().extent);
+    update_descriptor_set();
+    reset_accumulation();
 }
 
 void beam::raytracer::draw_imgui()
@@ -263,144 +622,1200 @@ void beam::raytracer::draw_imgui()
     bool reset{};
 
     ImGui::Begin("Raytracer");
-    ImGui::SliderInt("Samples per pixel", &samples_per_pixel_, 1, 5);
+    if (sample_scheduler_->supported())
+    {
+        ImGui::Checkbox("Frame budget", &frame_budget_);
+        if (!options_.wavefront && !options_.adaptive)
+        {
+            reset |= ImGui::Checkbox("Hybrid CPU + GPU", &options_.hybrid);
+        }
+    }
+    if (hybrid_active())
+    {
+        ImGui::SliderInt("Samples per pixel", &samples_per_pixel_, 1, 5);
+        hybrid_tracer_->draw_imgui();
+    }
+    else if (frame_budget_ && sample_scheduler_->supported())
+    {
+        sample_scheduler_->draw_imgui(scene_->color_image().extent);
+    }
+    else
+    {
+        ImGui::SliderInt("Samples per pixel", &samples_per_pixel_, 1, 5);
+    }
     reset |= ImGui::SliderInt("Max depth", &max_depth_, 1, 10);
     reset |= ImGui::SliderFloat("Focus distance", &focus_distance_, 0, 100);
     reset |= ImGui::SliderFloat("Defocus angle", &defocus_angle_, -1, 10);
     reset |= ImGui::SliderFloat("FOV Y", &fovy_, 0, 120);
+    if (!options_.wavefront)
+    {
+        ImGui::Checkbox("Temporal reprojection", &temporal_reprojection_);
+        if (temporal_reprojection_)
+        {
+            reprojection_->draw_imgui();
+        }
+    }
+
+    ImGui::SeparatorText("Scene");
+    ImGui::InputInt("Seed", &scene_seed_);
+    rebuild_scene_ |= ImGui::IsItemDeactivatedAfterEdit();
+    ImGui::SliderInt("Scene extent", &scene_extent_, 1, 500);
+    rebuild_scene_ |= ImGui::IsItemDeactivatedAfterEdit();
+    rebuild_scene_ |= ImGui::Checkbox("Small lights", &small_lights_);
+    reset |= ImGui::SliderFloat("Sky intensity", &sky_intensity_, 0.0f, 1.0f);
+    ImGui::Text("Spheres: %u", sphere_count_);
+    ImGui::Text("Lights: %u", light_count_);
+    if (triangle_count_ != 0)
+    {
+        ImGui::Text("Triangles: %u", triangle_count_);
+        ImGui::Text("Triangle BVH: %.2f ms (%.2f Mtris/s)",
+            cppext::as_fp<double>(triangle_bvh_build_time_ * 1e3f),
+            cppext::as_fp<double>(cppext::as_fp(triangle_count_) /
+                triangle_bvh_build_time_ / 1e6f));
+    }
+    ImGui::Text("Sphere BVH: %.2f ms",
+        cppext::as_fp<double>(sphere_bvh_build_time_ * 1e3f));
+    if (acceleration_structures_)
+    {
+        ImGui::Text("Acceleration structures: %.2f ms",
+            cppext::as_fp<double>(
+                acceleration_structures_->build_time() * 1e3f));
+    }
+    ImGui::Checkbox("BVH", &options_.bvh);
+    reset |= ImGui::Checkbox("Wavefront", &options_.wavefront);
+    if (!options_.wavefront)
+    {
+        ImGui::Checkbox("Specialized variants", &options_.specialized);
+        ImGui::SameLine();
+        ImGui::Text("%zu ready, %zu compiling",
+            variants_->ready_count(),
+            variants_->pending_count());
+    }
+    if (options_.wavefront)
+    {
+        ImGui::Checkbox("Material binning", &options_.bin_materials);
+    }
+    else
+    {
+        reset |= ImGui::Checkbox("Next event estimation",
+            &next_event_estimation_);
+
+        if (acceleration_structures_)
+        {
+            ImGui::Checkbox("Ray query", &options_.ray_query);
+        }
+        else
+        {
+            ImGui::Text("Ray query: unsupported");
+        }
+
+        reset |= ImGui::Checkbox("Adaptive sampling", &options_.adaptive);
+        if (options_.adaptive)
+        {
+            reset |= ImGui::SliderFloat("Error threshold",
+                &adaptive_threshold_,
+                0.001f,
+                0.1f,
+                "%.3f",
+                ImGuiSliderFlags_Logarithmic);
+            ImGui::Text("Active pixels: %.1f%%",
+                cppext::as_fp<double>(active_pixel_ratio_ * 100.0f));
+            if (time_to_threshold_)
+            {
+                ImGui::Text("Time to threshold: %.2f s",
+                    cppext::as_fp<double>(*time_to_threshold_));
+            }
+            else
+            {
+                ImGui::Text("Time to threshold: converging");
+            }
+        }
+    }
+
+    benchmark_requested_ |= ImGui::Button("Benchmark");
+    if (benchmark_.bvh > 0.0f)
+    {
+        if (benchmark_.linear > 0.0f)
+        {
+            ImGui::Text("Linear: %.2f Mrays/s",
+                cppext::as_fp<double>(benchmark_.linear / 1e6f));
+        }
+        else
+        {
+            ImGui::Text("Linear: skipped");
+        }
+        ImGui::Text("BVH: %.2f Mrays/s",
+            cppext::as_fp<double>(benchmark_.bvh / 1e6f));
+        ImGui::Text("BVH specialized: %.2f Mrays/s",
+            cppext::as_fp<double>(benchmark_.specialized / 1e6f));
+        ImGui::Text("Wavefront BVH: %.2f Mrays/s",
+            cppext::as_fp<double>(benchmark_.wavefront / 1e6f));
+        ImGui::Text("Wavefront BVH binned: %.2f Mrays/s",
+            cppext::as_fp<double>(benchmark_.wavefront_binned / 1e6f));
+        if (benchmark_.ray_query > 0.0f)
+        {
+            ImGui::Text("Ray query: %.2f Mrays/s",
+                cppext::as_fp<double>(benchmark_.ray_query / 1e6f));
+        }
+        ImGui::Text("Sphere fetch per camera ray: %.0f B (%.0f B unpacked)",
+            cppext::as_fp<double>(benchmark_.fetch_packed),
+            cppext::as_fp<double>(benchmark_.fetch_unpacked));
+    }
+
+    ImGui::SeparatorText("Edit");
+    if (sphere_count_ != 0)
+    {
+        ImGui::InputInt("Sphere", &edited_sphere_);
+        edited_sphere_ = std::clamp(edited_sphere_,
+            0,
+            cppext::narrow<int>(sphere_count_) - 1);
+        auto const index{cppext::narrow<uint32_t>(edited_sphere_)};
+
+        sphere edited{sphere_at(index)};
+        bool sphere_changed{ImGui::DragFloat3("Center",
+            glm::value_ptr(edited.center),
+            0.01f)};
+        sphere_changed |=
+            ImGui::DragFloat("Radius", &edited.radius, 0.01f, 0.0f, 1000.0f);
+        if (sphere_changed)
+        {
+            set_sphere(index, edited);
+        }
+
+        if (edited.material < material_count_)
+        {
+            material edited_material{material_at(edited.material)};
+            if (ImGui::ColorEdit3("Color",
+                    glm::value_ptr(edited_material.color)))
+            {
+                set_material(edited.material, edited_material);
+            }
+        }
+
+        if (ImGui::Button("Duplicate"))
+        {
+            edited.center.y += 2.0f * edited.radius;
+            edited_sphere_ = cppext::narrow<int>(add_sphere(edited));
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Remove"))
+        {
+            remove_sphere(index);
+        }
+    }
+    if (ImGui::Button("Save scene"))
+    {
+        save_scene_file("scene.beam");
+    }
+
+    ImGui::SeparatorText("Dispatch");
+    if (dispatch_tuner_->supported())
+    {
+        autotune_requested_ |= ImGui::Button("Autotune");
+    }
+    dispatch_tuner_->draw_imgui();
     ImGui::End();
 
     if (reset)
     {
-        total_samples_ = 0;
+        reset_accumulation();
     }
 }
 
-void beam::raytracer::fill_world(std::span<sphere const> spheres)
+void beam::raytracer::set_sampling(uint32_t const samples_per_frame,
+    uint32_t const max_depth)
 {
-    vkrndr::vulkan_buffer staging_buffer{vkrndr::create_buffer(*device_,
-        spheres.size() * sizeof(sphere),
-        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-            VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)};
+    samples_per_pixel_ = cppext::narrow<int>(samples_per_frame);
+    max_depth_ = cppext::narrow<int>(max_depth);
+    // Band sizes follow frame times and reprojected history depends on
+    // earlier cameras, the image wouldn't be reproducible
+    frame_budget_ = false;
+    temporal_reprojection_ = false;
+    fixed_sequence_ = true;
+    reset_accumulation();
+}
 
-    {
-        auto world_map{vkrndr::map_memory(*device_, staging_buffer)};
-        sphere* const sph{world_map.as<sphere>()};
-        std::ranges::copy(spheres, sph);
-        unmap_memory(*device_, &world_map);
-    }
+void beam::raytracer::generate_scene(uint32_t const seed, int const extent)
+{
+    scene_seed_ = cppext::narrow<int>(seed);
+    scene_extent_ = extent;
+
+    vkDeviceWaitIdle(device_->logical);
+    fill_world_and_materials();
+    update_descriptor_set();
+    reset_accumulation();
+}
 
-    world_buffer_ = create_buffer(*device_,
-        staging_buffer.size,
-        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-    sphere_count_ = cppext::narrow<uint32_t>(spheres.size());
+void beam::raytracer::wait_for_pipelines()
+{
+    static_cast<void>(variants_->wait(make_variant_key(full_region())));
+}
 
-    renderer_->transfer_buffer(staging_buffer, world_buffer_);
+uint32_t beam::raytracer::total_samples() const { return total_samples_; }
+
+beam::sample_region beam::raytracer::full_region() const
+{
+    return {.samples = cppext::narrow<uint32_t>(samples_per_pixel_),
+        .first_row = 0,
+        .row_count = scene_->color_image().extent.height};
+}
 
-    destroy(device_, &staging_buffer);
+bool beam::raytracer::hybrid_active() const
+{
+    return options_.hybrid && sample_scheduler_->supported() &&
+        !options_.wavefront && !options_.adaptive;
 }
 
-void beam::raytracer::fill_materials(std::span<material const> materials)
+void beam::raytracer::reset_accumulation()
 {
-    vkrndr::vulkan_buffer staging_buffer{vkrndr::create_buffer(*device_,
-        materials.size() * sizeof(material),
-        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-            VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)};
+    hybrid_tracer_->reset();
+    total_samples_ = 0;
+    sequence_seed_ = fixed_sequence_ ? 0 : seed_dist(rng);
+    restart_ = true;
+    previous_camera_.reset();
+}
 
-    {
-        auto world_map{vkrndr::map_memory(*device_, staging_buffer)};
-        material* const mat{world_map.as<material>()};
-        std::ranges::copy(materials, mat);
-        unmap_memory(*device_, &world_map);
-    }
+beam::frame_uniforms beam::raytracer::current_frame_uniforms() const
+{
+    // Without history to reproject the previous camera is the current one
+    camera_pose const previous{previous_camera_.value_or(
+        camera_pose{.position = camera_position_,
+            .front = camera_position_ + camera_front_,
+            .up = camera_up_})};
 
-    material_buffer_ = create_buffer(*device_,
-        staging_buffer.size,
-        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-    material_count_ = cppext::narrow<uint32_t>(materials.size());
+    return {.camera_position = camera_position_,
+        .world_count = sphere_count_,
+        .camera_front = camera_position_ + camera_front_,
+        .material_count = material_count_,
+        .camera_up = camera_up_,
+        .max_depth = cppext::narrow<uint32_t>(max_depth_),
+        .previous_position = previous.position,
+        .defocus_angle = defocus_angle_,
+        .previous_front = previous.front,
+        .focus_distance = focus_distance_,
+        .previous_up = previous.up,
+        .fovy = fovy_,
+        .sequence_seed = sequence_seed_,
+        .triangle_count = triangle_count_,
+        .triangle_root = triangle_root_,
+        .light_count = next_event_estimation_ ? light_count_ : 0,
+        .sky_intensity = sky_intensity_};
+}
 
-    renderer_->transfer_buffer(staging_buffer, material_buffer_);
+void beam::raytracer::write_frame_uniforms()
+{
+    frame_uniforms_->write(current_frame_uniforms());
+}
 
-    destroy(device_, &staging_buffer);
+beam::variant_key beam::raytracer::make_variant_key(
+    sample_region const& region) const
+{
+    // Frame budget changes the sample count every frame, specializing it
+    // would compile a variant for each of them
+    return {.max_depth = cppext::narrow<uint32_t>(max_depth_),
+        .samples = frame_budget_ ? 0 : region.samples,
+        .material_mask = material_mask_};
 }
 
-void beam::raytracer::fill_world_and_materials()
+beam::push_constants beam::raytracer::make_push_constants(
+    trace_options const& options,
+    sample_region const& region)
 {
-    static constexpr uint32_t lambertian{0};
-    static constexpr uint32_t metal{1};
-    static constexpr uint32_t dielectric{2};
+    return {.samples_per_pixel = region.samples,
+        .total_samples = total_samples_,
+        .use_bvh = options.bvh ? 1u : 0u,
+        .bounce = 0,
+        .sample_index = 0,
+        .wavefront_stage = 0,
+        .material_bins = 0,
+        .shade_material = 0,
+        .adaptive_threshold = options.adaptive && !options.wavefront
+            ? adaptive_threshold_
+            : 0.0f,
+        .row_offset = region.first_row};
+}
 
-    std::uniform_real_distribution<float> dist{0.0f, 1.0f};
-    std::uniform_real_distribution<float> lower_dist{0.0f, 0.5f};
-    std::uniform_real_distribution<float> upper_dist{0.5f, 1.0f};
+void beam::raytracer::dispatch(VkCommandBuffer command_buffer,
+    trace_options const& options,
+    sample_region const& region)
+{
+    auto const& target_extent{scene_->color_image().extent};
 
-    std::vector<sphere> spheres;
-    std::vector<material> materials;
-    materials.emplace_back(glm::vec3{0.5f, 0.5f, 0.5f}, 0.0f, lambertian);
-    spheres.emplace_back(glm::vec3{0.0f, -1000.0f, 0.0f},
-        1000.0f,
-        cppext::narrow<uint32_t>(materials.size() - 1));
+    if (total_samples_ == 0)
+    {
+        ++adaptive_run_;
+        adaptive_start_ = std::chrono::steady_clock::now();
+        active_pixel_ratio_ = 1.0f;
+        time_to_threshold_.reset();
+    }
 
-    auto gen_color = [&]()
-    { return glm::vec3{dist(rng), dist(rng), dist(rng)}; };
+    push_constants const pc{make_push_constants(options, region)};
 
-    for (int a = -11; a < 11; a++)
+    if (options.wavefront)
     {
-        for (int b = -11; b < 11; b++)
-        {
-            auto const choose_mat{dist(rng)};
-            glm::vec3 const center{cppext::as_fp(a) + 0.9f * dist(rng),
-                0.2f,
-                cppext::as_fp(b) + 0.9f * dist(rng)};
+        wavefront_->dispatch(command_buffer,
+            descriptor_set_,
+            frame_uniforms_->offset(),
+            pc,
+            cppext::narrow<uint32_t>(max_depth_),
+            target_extent,
+            options.bin_materials);
 
-            if (glm::length(center - glm::vec3{4.0f, 0.2f, 0.0f}) > 0.9f)
-            {
-                if (choose_mat < 0.8f)
-                {
-                    // diffuse
-                    glm::vec3 const albedo{gen_color() * gen_color()};
-                    materials.emplace_back(albedo, 0.0f, lambertian);
-                }
-                else if (choose_mat < 0.95f)
-                {
-                    // metal
-                    glm::vec3 const albedo{upper_dist(rng),
-                        upper_dist(rng),
-                        upper_dist(rng)};
-                    float const fuzz{lower_dist(rng)};
-                    materials.emplace_back(albedo, fuzz, metal);
-                }
-                else
-                {
-                    materials.emplace_back(glm::vec3{}, 1.5f, dielectric);
-                }
+        total_samples_ += region.samples;
+        return;
+    }
 
-                spheres.emplace_back(center,
-                    0.2f,
-                    cppext::narrow<uint32_t>(materials.size() - 1));
-            }
-        }
+    // Pixel statistics written by the previous dispatch are read back
+    vkrndr::memory_barrier(command_buffer,
+        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+        VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+        VK_ACCESS_2_SHADER_STORAGE_READ_BIT |
+            VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT);
+
+    bool const adaptive{pc.adaptive_threshold > 0.0f};
+    if (adaptive)
+    {
+        adaptive_sampler_->compact(command_buffer,
+            descriptor_set_,
+            frame_uniforms_->offset(),
+            pc,
+            target_extent,
+            adaptive_run_);
     }
 
-    materials.emplace_back(glm::vec3{}, 1.5f, dielectric);
-    spheres.emplace_back(glm::vec3{0.0f, 1.0f, 0.0f},
-        1.0f,
-        cppext::narrow<uint32_t>(materials.size() - 1));
+    // Hardware traversal replaces the software BVH in the megakernel, the
+    // rest of the shader is shared
+    bool const ray_query{options.ray_query && ray_query_pipeline_};
+    vkrndr::vulkan_pipeline const* pipeline{
+        ray_query ? ray_query_pipeline_.get() : compute_pipeline_.get()};
 
-    materials.emplace_back(glm::vec3{0.4f, 0.2f, 0.1f}, 0.0f, lambertian);
-    spheres.emplace_back(glm::vec3{-4.0f, 1.0f, 0.0f},
-        1.0f,
-        cppext::narrow<uint32_t>(materials.size() - 1));
+    // Generic pipelines are used until the variant finishes compiling
+    if (options.specialized)
+    {
+        if (pipeline_variant const* const variant{
+                variants_->find(make_variant_key(region))})
+        {
+            pipeline = ray_query ? variant->ray_query.get()
+                                 : variant->compute.get();
+        }
+    }
+
+    vkCmdPushConstants(command_buffer,
+        *pipeline->layout,
+        VK_SHADER_STAGE_COMPUTE_BIT,
+        0,
+        sizeof(push_constants),
+        &pc);
+
+    uint32_t const frame_offset{frame_uniforms_->offset()};
+    if (ray_query)
+    {
+        std::array const descriptor_sets{descriptor_set_,
+            acceleration_structures_->descriptor_set()};
+        vkrndr::bind_pipeline(command_buffer,
+            *pipeline,
+            0,
+            std::span<VkDescriptorSet const>{descriptor_sets},
+            std::span{&frame_offset, 1});
+    }
+    else
+    {
+        vkrndr::bind_pipeline(command_buffer,
+            *pipeline,
+            0,
+            std::span{&descriptor_set_, 1},
+            std::span{&frame_offset, 1});
+    }
+
+    if (adaptive)
+    {
+        vkCmdDispatchIndirect(command_buffer,
+            adaptive_sampler_->tile_buffer().buffer,
+            0);
+    }
+    else
+    {
+        auto const [x, y, z]{workgroup_counts(pipeline_config_,
+            target_extent.width,
+            region.row_count)};
+        vkCmdDispatch(command_buffer, x, y, z);
+    }
+
+    // Accumulation counts whole passes over the image, samples of a band
+    // are tracked per pixel by the megakernel
+    if (region.first_row + region.row_count >= target_extent.height)
+    {
+        total_samples_ += region.samples;
+    }
+}
+
+void beam::raytracer::run_benchmark()
+{
+    // Dispatches are timed on the device, submission and the wait for the
+    // fence aren't included
+    float const period{
+        vkrndr::timestamp_period(*device_, device_->present_queue->family)};
+    if (period <= 0.0f)
+    {
+        return;
+    }
+
+    vkDeviceWaitIdle(device_->logical);
+
+    VkCommandPool const command_pool{
+        vkrndr::create_command_pool(*device_, device_->present_queue->family)};
+    VkQueryPool const query_pool{
+        vkrndr::create_query_pool(device_, VK_QUERY_TYPE_TIMESTAMP, 2)};
+
+    auto const& color_image{scene_->color_image()};
+
+    auto const measure = [&](trace_options const& options)
+    {
+        VkCommandBuffer command_buffer; // NOLINT
+        vkrndr::begin_single_time_commands(*device_,
+            command_pool,
+            1,
+            std::span{&command_buffer, 1});
+
+        vkCmdResetQueryPool(command_buffer, query_pool, 0, 2);
+
+        vkrndr::transition_image(color_image.image,
+            command_buffer,
+            VK_IMAGE_LAYOUT_UNDEFINED,
+            VK_PIPELINE_STAGE_2_NONE,
+            VK_ACCESS_2_NONE,
+            VK_IMAGE_LAYOUT_GENERAL,
+            VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+            VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+            1);
+
+        vkCmdWriteTimestamp2(command_buffer,
+            VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+            query_pool,
+            0);
+
+        total_samples_ = 0;
+        for (uint32_t i{}; i != benchmark_dispatches; ++i)
+        {
+            if (i != 0)
+            {
+                vkrndr::transition_image(color_image.image,
+                    command_buffer,
+                    VK_IMAGE_LAYOUT_GENERAL,
+                    VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                    VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+                    VK_IMAGE_LAYOUT_GENERAL,
+                    VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                    VK_ACCESS_2_SHADER_STORAGE_READ_BIT |
+                        VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+                    1);
+            }
+            dispatch(command_buffer, options, full_region());
+        }
+
+        vkCmdWriteTimestamp2(command_buffer,
+            VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+            query_pool,
+            1);
+
+        vkrndr::end_single_time_commands(*device_,
+            device_->present_queue->queue,
+            std::span{&command_buffer, 1},
+            command_pool);
+
+        std::array<uint64_t, 2> timestamps{};
+        vkrndr::check_result(vkGetQueryPoolResults(device_->logical,
+            query_pool,
+            0,
+            2,
+            sizeof(timestamps),
+            timestamps.data(),
+            sizeof(uint64_t),
+            VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT));
+        float const seconds{
+            cppext::as_fp(timestamps[1] - timestamps[0]) * period / 1e9f};
+
+        // Counts camera rays, secondary bounces depend on the scene
+        float const rays{cppext::as_fp(color_image.extent.width) *
+            cppext::as_fp(color_image.extent.height) *
+            cppext::as_fp(total_samples_)};
+        return rays / seconds;
+    };
+
+    DISABLE_WARNING_PUSH
+    DISABLE_WARNING_MISSING_FIELD_INITIALIZERS
+    benchmark_.linear =
+        sphere_count_ + triangle_count_ <= linear_benchmark_primitive_limit
+        ? measure({.bvh = false, .bin_materials = false, .specialized = false})
+        : 0.0f;
+    benchmark_.bvh = measure({.bin_materials = false, .specialized = false});
+    static_cast<void>(variants_->wait(make_variant_key(full_region())));
+    benchmark_.specialized = measure({.bin_materials = false});
+    benchmark_.wavefront =
+        measure({.wavefront = true, .bin_materials = false});
+    benchmark_.wavefront_binned = measure({.wavefront = true});
+    benchmark_.ray_query =
+        acceleration_structures_
+        ? measure({.ray_query = true, .specialized = false})
+        : 0.0f;
+    DISABLE_WARNING_POP
+
+    vkDestroyQueryPool(device_->logical, query_pool, nullptr);
+    vkDestroyCommandPool(device_->logical, command_pool, nullptr);
+
+    measure_scene_fetch();
+}
+
+void beam::raytracer::measure_scene_fetch()
+{
+    VkExtent2D const& extent{scene_->color_image().extent};
+
+    // Camera rays through a grid of points on the viewport, same basis as
+    // makeCamera() in camera.glsl without the defocus. Frame uniforms hold
+    // the point the camera looks at, camera_front_ is the direction to it.
+    glm::vec3 const w{-glm::normalize(camera_front_)};
+    glm::vec3 const u{glm::normalize(glm::cross(camera_up_, w))};
+    glm::vec3 const v{glm::cross(w, u)};
+
+    float const viewport_height{2.0f * std::tan(glm::radians(fovy_) / 2.0f)};
+    float const viewport_width{viewport_height *
+        cppext::as_fp(extent.width) / cppext::as_fp(extent.height)};
+
+    size_t packed{};
+    size_t unpacked{};
+    for (uint32_t y{}; y != fetch_benchmark_grid; ++y)
+    {
+        for (uint32_t x{}; x != fetch_benchmark_grid; ++x)
+        {
+            float const s{(cppext::as_fp(x) + 0.5f) /
+                    cppext::as_fp(fetch_benchmark_grid) -
+                0.5f};
+            float const t{(cppext::as_fp(y) + 0.5f) /
+                    cppext::as_fp(fetch_benchmark_grid) -
+                0.5f};
+            glm::vec3 const direction{
+                -w + s * viewport_width * u - t * viewport_height * v};
+
+            ray_fetch const fetch{
+                measure_ray_fetch(bvh_buffer_.view<bvh_node>(),
+                    world_buffer_.view<glm::vec4>(),
+                    camera_position_,
+                    direction)};
+            packed += fetch.packed;
+            unpacked += fetch.unpacked;
+        }
+    }
+
+    float const rays{
+        cppext::as_fp(fetch_benchmark_grid * fetch_benchmark_grid)};
+    benchmark_.fetch_packed = cppext::as_fp(packed) / rays;
+    benchmark_.fetch_unpacked = cppext::as_fp(unpacked) / rays;
+}
+
+void beam::raytracer::run_autotune()
+{
+    vkDeviceWaitIdle(device_->logical);
+
+    // Tuning measures the megakernel alone, adaptive sampling is excluded as
+    // it always uses the default configuration
+    trace_options options{options_};
+    options.wavefront = false;
+    options.adaptive = false;
+
+    dispatch_tuner_->tune(
+        [this, &options](VkCommandBuffer command_buffer,
+            dispatch_config const& config)
+        {
+            use_dispatch_config(config);
+
+            total_samples_ = 0;
+            for (uint32_t i{}; i != benchmark_dispatches; ++i)
+            {
+                dispatch(command_buffer, options, full_region());
+            }
+        });
+}
+
+beam::dispatch_config beam::raytracer::active_dispatch_config() const
+{
+    if (options_.adaptive && !options_.wavefront)
+    {
+        return {};
+    }
+    return dispatch_tuner_->config();
+}
+
+void beam::raytracer::use_dispatch_config(dispatch_config const& config)
+{
+    if (config == pipeline_config_)
+    {
+        return;
+    }
+
+    // Variants hold the pipeline layouts too, they are dropped first so the
+    // layouts get destroyed with the generic pipelines
+    vkDeviceWaitIdle(device_->logical);
+    variants_->reset({});
+    destroy_pipelines();
+    create_pipelines(config);
+}
+
+void beam::raytracer::create_pipelines(dispatch_config const& config)
+{
+    VkPushConstantRange const push_constants_range{
+        .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+        .offset = 0,
+        .size = sizeof(push_constants),
+    };
+
+    compute_pipeline_ = create_megakernel(device_,
+        vkrndr::vulkan_pipeline_layout_builder{device_}
+            .add_descriptor_set_layout(descriptor_layout_)
+            .add_push_constants(push_constants_range)
+            .build(),
+        "raytracer.comp.spv",
+        config);
+
+    if (acceleration_structures_)
+    {
+        ray_query_pipeline_ = create_megakernel(device_,
+            vkrndr::vulkan_pipeline_layout_builder{device_}
+                .add_descriptor_set_layout(descriptor_layout_)
+                .add_descriptor_set_layout(
+                    acceleration_structures_->descriptor_layout())
+                .add_push_constants(push_constants_range)
+                .build(),
+            "raytracer_ray_query.comp.spv",
+            config);
+    }
+
+    pipeline_config_ = config;
+
+    // Variants share layouts and the dispatch configuration with the generic
+    // pipelines, they are rebuilt together
+    variants_->reset(
+        [device = device_,
+            config,
+            compute_layout = compute_pipeline_->layout,
+            ray_query_layout = ray_query_pipeline_
+                ? ray_query_pipeline_->layout
+                : nullptr](VkSpecializationInfo const& info)
+        {
+            pipeline_variant rv;
+            rv.compute = create_megakernel(device,
+                compute_layout,
+                "raytracer.comp.spv",
+                config,
+                &info);
+            if (ray_query_layout)
+            {
+                rv.ray_query = create_megakernel(device,
+                    ray_query_layout,
+                    "raytracer_ray_query.comp.spv",
+                    config,
+                    &info);
+            }
+            return rv;
+        });
+}
+
+void beam::raytracer::destroy_pipelines()
+{
+    if (ray_query_pipeline_)
+    {
+        destroy(device_, ray_query_pipeline_.get());
+    }
+    destroy(device_, compute_pipeline_.get());
+}
+
+void beam::raytracer::update_convergence()
+{
+    if (!options_.adaptive || options_.wavefront || time_to_threshold_)
+    {
+        return;
+    }
+
+    std::optional<uint32_t> const active{
+        adaptive_sampler_->active_pixels(adaptive_run_)};
+    if (!active)
+    {
+        return;
+    }
+
+    auto const& extent{scene_->color_image().extent};
+    active_pixel_ratio_ = cppext::as_fp(*active) /
+        (cppext::as_fp(extent.width) * cppext::as_fp(extent.height));
+
+    if (*active == 0)
+    {
+        std::chrono::duration<float> const elapsed{
+            std::chrono::steady_clock::now() - adaptive_start_};
+        time_to_threshold_ = elapsed.count();
+    }
+}
+
+void beam::raytracer::update_descriptor_set()
+{
+    DISABLE_WARNING_PUSH
+    DISABLE_WARNING_MISSING_FIELD_INITIALIZERS
+    bind_descriptor_set(device_,
+        descriptor_set_,
+        VkDescriptorImageInfo{.imageView = scene_->color_image().view,
+            .imageLayout = VK_IMAGE_LAYOUT_GENERAL},
+        world_buffer_.descriptor_info(),
+        material_buffer_.descriptor_info(),
+        bvh_buffer_.descriptor_info(),
+        triangle_buffer_.descriptor_info(),
+        VkDescriptorImageInfo{
+            .imageView = adaptive_sampler_->variance_image().view,
+            .imageLayout = VK_IMAGE_LAYOUT_GENERAL},
+        VkDescriptorBufferInfo{
+            .buffer = adaptive_sampler_->tile_buffer().buffer,
+            .offset = 0,
+            .range = adaptive_sampler_->tile_buffer().size},
+        VkDescriptorImageInfo{.imageView = scene_->albedo_image().view,
+            .imageLayout = VK_IMAGE_LAYOUT_GENERAL},
+        VkDescriptorImageInfo{.imageView = scene_->normal_depth_image().view,
+            .imageLayout = VK_IMAGE_LAYOUT_GENERAL},
+        light_buffer_.descriptor_info(),
+        frame_uniforms_->descriptor_info(),
+        sphere_material_buffer_.descriptor_info());
+    DISABLE_WARNING_POP
+}
+
+void beam::raytracer::load_scene(scene_view const& scene)
+{
+    world_buffer_.assign(scene.center_radius);
+    sphere_material_buffer_.assign(scene.sphere_materials);
+    sphere_count_ = cppext::narrow<uint32_t>(scene.center_radius.size());
+    free_spheres_.clear();
+
+    material_buffer_.assign(scene.materials);
+    material_count_ = cppext::narrow<uint32_t>(scene.materials.size());
+    free_materials_.clear();
+
+    material_type_counts_ = {};
+    material_mask_ = 0;
+    for (packed_material const& m : scene.materials)
+    {
+        count_material_type(unpack_material(m).type, 1);
+    }
+
+    bvh_buffer_.assign(scene.nodes);
+    triangle_root_ = scene.triangle_root;
+    // Without spheres the first node is the triangle root, if there is one
+    sphere_links_ = scene.center_radius.empty()
+        ? bvh_links{}
+        : link_bvh(scene.nodes, 0, scene.center_radius.size());
+
+    triangle_buffer_.assign(scene.triangles);
+    triangle_count_ = cppext::narrow<uint32_t>(scene.triangles.size());
+
+    light_buffer_.assign(scene.lights);
+    light_count_ = cppext::narrow<uint32_t>(scene.lights.size());
+
+    transfer_scene_buffers();
+
+    scene_edited_ = false;
+    lights_changed_ = false;
+    geometry_changed_ = false;
+    hybrid_tracer_->invalidate_scene();
+
+    if (acceleration_structures_)
+    {
+        acceleration_structures_->build(scene.center_radius, scene.triangles);
+    }
+}
+
+beam::scene_view beam::raytracer::current_scene() const
+{
+    return {.center_radius = world_buffer_.view<glm::vec4>(),
+        .sphere_materials = sphere_material_buffer_.view<uint32_t>(),
+        .materials = material_buffer_.view<packed_material>(),
+        .nodes = bvh_buffer_.view<bvh_node>(),
+        .triangles = triangle_buffer_.view<triangle>(),
+        .lights = light_buffer_.view<uint32_t>(),
+        .triangle_root = triangle_root_};
+}
+
+beam::sphere beam::raytracer::sphere_at(uint32_t const index) const
+{
+    glm::vec4 const& center_radius{world_buffer_.view<glm::vec4>()[index]};
+    return {.center = glm::vec3{center_radius},
+        .radius = center_radius.w,
+        .material = sphere_material_buffer_.view<uint32_t>()[index]};
+}
+
+beam::material beam::raytracer::material_at(uint32_t const index) const
+{
+    return unpack_material(material_buffer_.view<packed_material>()[index]);
+}
+
+void beam::raytracer::fill_lights()
+{
+    std::vector<uint32_t> lights;
+    for (uint32_t i{}; i != sphere_count_; ++i)
+    {
+        if (is_light(sphere_at(i)))
+        {
+            lights.push_back(i);
+        }
+    }
+
+    light_buffer_.assign(std::span<uint32_t const>{lights});
+    light_count_ = cppext::narrow<uint32_t>(lights.size());
+}
+
+bool beam::raytracer::transfer_scene_buffers()
+{
+    bool rv{false};
+    for (scene_buffer* const buffer : {&world_buffer_,
+             &sphere_material_buffer_,
+             &material_buffer_,
+             &bvh_buffer_,
+             &triangle_buffer_,
+             &light_buffer_})
+    {
+        rv |= buffer->transfer();
+    }
+    return rv;
+}
+
+void beam::raytracer::apply_scene_edits(VkCommandBuffer command_buffer)
+{
+    if (!std::exchange(scene_edited_, false))
+    {
+        return;
+    }
+
+    if (std::exchange(lights_changed_, false))
+    {
+        fill_lights();
+    }
+
+    std::array const buffers{&world_buffer_,
+        &sphere_material_buffer_,
+        &material_buffer_,
+        &bvh_buffer_,
+        &triangle_buffer_,
+        &light_buffer_};
+
+    // Ray query structures have no incremental path, they are rebuilt
+    bool const rebuild_structures{
+        std::exchange(geometry_changed_, false) && acceleration_structures_};
+    if (rebuild_structures ||
+        std::ranges::any_of(buffers, &scene_buffer::needs_transfer))
+    {
+        // Grown buffers are new objects, same as a scene rebuild nothing may
+        // use the old ones
+        vkDeviceWaitIdle(device_->logical);
+        if (transfer_scene_buffers())
+        {
+            update_descriptor_set();
+        }
+
+        if (rebuild_structures)
+        {
+            acceleration_structures_->build(world_buffer_.view<glm::vec4>(),
+                triangle_buffer_.view<triangle>());
+        }
+    }
+
+    for (scene_buffer* const buffer : buffers)
+    {
+        buffer->upload(command_buffer);
+    }
+
+    hybrid_tracer_->invalidate_scene();
+    reset_accumulation();
+}
+
+bool beam::raytracer::is_light(sphere const& s) const
+{
+    static constexpr uint32_t emissive{3};
+
+    return s.radius > 0.0f && s.material < material_count_ &&
+        material_at(s.material).type == emissive;
+}
+
+void beam::raytracer::count_material_type(uint32_t const type,
+    int const change)
+{
+    uint32_t& count{material_type_counts_[type]};
+    count = change > 0 ? count + 1 : count - 1;
+
+    material_mask_ = 0;
+    for (uint32_t i{}; i != material_type_counts_.size(); ++i)
+    {
+        if (material_type_counts_[i] != 0)
+        {
+            material_mask_ |= 1u << i;
+        }
+    }
+}
+
+uint32_t beam::raytracer::add_material(material const& m)
+{
+    if (!free_materials_.empty())
+    {
+        uint32_t const index{free_materials_.back()};
+        free_materials_.pop_back();
+        set_material(index, m);
+        return index;
+    }
+
+    auto const index{cppext::narrow<uint32_t>(
+        material_buffer_.append(pack_material(m)))};
+    material_count_ = index + 1;
+    count_material_type(m.type, 1);
+
+    scene_edited_ = true;
+    return index;
+}
+
+void beam::raytracer::set_material(uint32_t const index, material const& m)
+{
+    static constexpr uint32_t emissive{3};
+
+    material const current{material_at(index)};
+    if ((current.type == emissive) != (m.type == emissive))
+    {
+        lights_changed_ = true;
+    }
+
+    count_material_type(current.type, -1);
+    count_material_type(m.type, 1);
+
+    material_buffer_.write(index, pack_material(m));
+    scene_edited_ = true;
+}
+
+void beam::raytracer::remove_material(uint32_t const index)
+{
+    static constexpr uint32_t lambertian{0};
+
+    if (std::ranges::find(free_materials_, index) != free_materials_.cend())
+    {
+        return;
+    }
+
+    set_material(index, {glm::vec3{0.0f}, 0.0f, lambertian});
+    free_materials_.push_back(index);
+}
+
+uint32_t beam::raytracer::add_sphere(sphere const& s)
+{
+    if (!free_spheres_.empty())
+    {
+        uint32_t const index{free_spheres_.back()};
+        free_spheres_.pop_back();
+        set_sphere(index, s);
+        return index;
+    }
+
+    auto const index{cppext::narrow<uint32_t>(
+        world_buffer_.append(glm::vec4{s.center, s.radius}))};
+    static_cast<void>(sphere_material_buffer_.append(s.material));
+    sphere_count_ = index + 1;
+
+    insert_sphere_node(index);
+
+    // Every insert adds a level below a leaf, the hierarchy is built again
+    // before traversal runs out of stack
+    if (bvh_depth(bvh_buffer_.view<bvh_node>(), 0) > bvh_stack_size)
+    {
+        rebuild_sphere_nodes();
+    }
+
+    lights_changed_ |= is_light(s);
+    geometry_changed_ = true;
+    scene_edited_ = true;
+    return index;
+}
+
+void beam::raytracer::set_sphere(uint32_t const index, sphere const& s)
+{
+    if (is_light(sphere_at(index)) != is_light(s))
+    {
+        lights_changed_ = true;
+    }
+
+    if (s.radius > 0.0f)
+    {
+        std::erase(free_spheres_, index);
+    }
+
+    world_buffer_.write(index, glm::vec4{s.center, s.radius});
+    sphere_material_buffer_.write(index, s.material);
+    refit_sphere_nodes(sphere_links_.leaves[index]);
+
+    geometry_changed_ = true;
+    scene_edited_ = true;
+}
+
+void beam::raytracer::remove_sphere(uint32_t const index)
+{
+    if (std::ranges::find(free_spheres_, index) != free_spheres_.cend())
+    {
+        return;
+    }
+
+    // A sphere of zero radius is never hit, refits leave it out of the
+    // bounds of its leaf
+    sphere removed{sphere_at(index)};
+    removed.radius = 0.0f;
+    set_sphere(index, removed);
+    free_spheres_.push_back(index);
+}
+
+void beam::raytracer::refit_sphere_nodes(uint32_t node)
+{
+    std::span<bvh_node const> const nodes{bvh_buffer_.view<bvh_node>()};
+    std::span<glm::vec4 const> const spheres{world_buffer_.view<glm::vec4>()};
+
+    while (node != no_parent)
+    {
+        bvh_node updated{nodes[node]};
+
+        aabb bounds;
+        if (updated.count != 0)
+        {
+            for (uint32_t i{updated.left_first};
+                 i != updated.left_first + updated.count;
+                 ++i)
+            {
+                if (spheres[i].w > 0.0f)
+                {
+                    grow(bounds, sphere_bounds(spheres[i]));
+                }
+            }
+
+            // An inverted box would pass the slab test of every ray, a leaf
+            // of removed spheres keeps a box without volume at the center
+            if (bounds.min.x > bounds.max.x)
+            {
+                bounds = sphere_bounds(
+                    glm::vec4{glm::vec3{spheres[updated.left_first]}, 0.0f});
+            }
+        }
+        else
+        {
+            for (uint32_t const child :
+                {updated.left_first, updated.left_first + 1})
+            {
+                grow(bounds,
+                    aabb{.min = nodes[child].min, .max = nodes[child].max});
+            }
+        }
+
+        if (bounds.min == updated.min && bounds.max == updated.max)
+        {
+            break;
+        }
+
+        updated.min = bounds.min;
+        updated.max = bounds.max;
+        bvh_buffer_.write(node, updated);
+
+        node = sphere_links_.parents[node];
+    }
+}
+
+void beam::raytracer::insert_sphere_node(uint32_t const index)
+{
+    aabb const bounds{
+        sphere_bounds(world_buffer_.view<glm::vec4>()[index])};
+
+    // Descends towards the child whose surface area grows the least
+    uint32_t target{0};
+    {
+        std::span<bvh_node const> const nodes{bvh_buffer_.view<bvh_node>()};
+        auto const growth = [&](uint32_t const node)
+        {
+            aabb box{.min = nodes[node].min, .max = nodes[node].max};
+            float const before{surface_area(box)};
+            grow(box, bounds);
+            return surface_area(box) - before;
+        };
+
+        while (nodes[target].count == 0)
+        {
+            uint32_t const left{nodes[target].left_first};
+            target = growth(left) <= growth(left + 1) ? left : left + 1;
+        }
+    }
+
+    // The leaf moves to the end of the node buffer next to a new leaf of the
+    // sphere, its old position becomes their parent
+    bvh_node const sibling{bvh_buffer_.view<bvh_node>()[target]};
+    auto const first{
+        cppext::narrow<uint32_t>(bvh_buffer_.append(sibling))};
+    static_cast<void>(bvh_buffer_.append(bvh_node{.min = bounds.min,
+        .left_first = index,
+        .max = bounds.max,
+        .count = 1}));
+    bvh_buffer_.write(target,
+        bvh_node{.min = sibling.min,
+            .left_first = first,
+            .max = sibling.max,
+            .count = 0});
+
+    sphere_links_.parents.push_back(target);
+    sphere_links_.parents.push_back(target);
+    std::fill_n(std::next(sphere_links_.leaves.begin(), sibling.left_first),
+        sibling.count,
+        first);
+    sphere_links_.leaves.push_back(first + 1);
+
+    refit_sphere_nodes(target);
+}
+
+void beam::raytracer::rebuild_sphere_nodes()
+{
+    std::span<glm::vec4 const> const spheres{world_buffer_.view<glm::vec4>()};
+
+    std::vector<aabb> bounds;
+    bounds.reserve(spheres.size());
+    std::ranges::transform(spheres, std::back_inserter(bounds), sphere_bounds);
+
+    std::vector<bvh_node> nodes{build_indexed_bvh(bounds)};
+
+    // Triangle nodes move after the new sphere nodes, children of a node
+    // stay next to each other
+    auto const triangle_root{cppext::narrow<uint32_t>(nodes.size())};
+    if (triangle_count_ != 0)
+    {
+        std::span<bvh_node const> const old{bvh_buffer_.view<bvh_node>()};
+        nodes.push_back(old[triangle_root_]);
+        for (size_t i{triangle_root}; i != nodes.size(); ++i)
+        {
+            if (nodes[i].count == 0)
+            {
+                uint32_t const left{nodes[i].left_first};
+                nodes[i].left_first = cppext::narrow<uint32_t>(nodes.size());
+                nodes.push_back(old[left]);
+                nodes.push_back(old[left + 1]);
+            }
+        }
+    }
+
+    bvh_buffer_.assign(std::span<bvh_node const>{nodes});
+    triangle_root_ = triangle_root;
+    sphere_links_ = link_bvh(nodes, 0, spheres.size());
+}
+
+void beam::raytracer::fill_world_and_materials()
+{
+    procedural_scene const procedural{generate_procedural_scene(
+        static_cast<uint32_t>(scene_seed_),
+        scene_extent_,
+        small_lights_)};
 
-    materials.emplace_back(glm::vec3{0.7f, 0.6f, 0.5f}, 0.0f, metal);
-    spheres.emplace_back(glm::vec3{4.0f, 1.0f, 0.0f},
-        1.0f,
-        cppext::narrow<uint32_t>(materials.size() - 1));
+    scene_data const scene{
+        build_scene(procedural.spheres, procedural.materials, mesh_)};
+    sphere_bvh_build_time_ = scene.sphere_bvh_build_time;
+    triangle_bvh_build_time_ = scene.triangle_bvh_build_time;
 
-    fill_materials(materials);
-    fill_world(spheres);
+    load_scene(scene.view());
 }
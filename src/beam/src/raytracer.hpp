@@ -1,17 +1,30 @@
 #ifndef BEAM_RAYTRACER_INCLUDED
 #define BEAM_RAYTRACER_INCLUDED
 
+#include <bvh.hpp>
+#include <dispatch_tuner.hpp>
+#include <frame_uniforms.hpp>
+#include <mesh.hpp>
+#include <pipeline_variants.hpp>
+#include <reprojection.hpp>
+#include <scene_buffer.hpp>
+#include <scene_file.hpp>
 #include <sphere.hpp> // IWYU pragma: keep
 
-#include <vulkan_buffer.hpp>
-
 #include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
 
 #include <vulkan/vulkan_core.h>
 
+#include <array>
+#include <chrono>
+#include <cstddef>
 #include <cstdint>
+#include <filesystem>
 #include <memory>
+#include <optional>
 #include <span>
+#include <vector>
 
 namespace vkrndr
 {
@@ -22,8 +35,16 @@ namespace vkrndr
 
 namespace beam
 {
+    class acceleration_structures;
+    class adaptive_sampler;
+    struct bvh_node;
+    class hybrid_tracer;
+    struct push_constants;
     class renderer;
     class perspective_camera;
+    struct sample_region;
+    class sample_scheduler;
+    class wavefront;
 } // namespace beam
 
 namespace beam
@@ -43,6 +64,14 @@ namespace beam
         ~raytracer();
 
     public:
+        void load_model(std::filesystem::path const& path);
+
+        // Replaces the scene with the contents of a file written by
+        // save_scene_file() or the beam_scene converter
+        void load_scene_file(std::filesystem::path const& path);
+
+        void save_scene_file(std::filesystem::path const& path) const;
+
         void update(perspective_camera const& camera);
 
         void draw(VkCommandBuffer command_buffer);
@@ -51,16 +80,153 @@ namespace beam
 
         void draw_imgui();
 
+        // Fixed sampling for offline rendering, accumulation starts over.
+        // The sample sequence isn't scrambled afterwards, the same scene and
+        // camera give the same image.
+        void set_sampling(uint32_t samples_per_frame, uint32_t max_depth);
+
+        // Replaces the spheres with the procedural ones of the given seed,
+        // placed on a grid of 2 * extent cells per side. A loaded model is
+        // kept.
+        void generate_scene(uint32_t seed, int extent);
+
+        // Blocks until the specialized pipeline of the current scene and
+        // options is compiled
+        void wait_for_pipelines();
+
+        // Samples accumulated in every pixel of the image
+        [[nodiscard]] uint32_t total_samples() const;
+
+        // Host copies of the scene buffers, valid until the scene changes
+        [[nodiscard]] scene_view current_scene() const;
+
+        // Uniforms the next frame is traced with
+        [[nodiscard]] frame_uniforms current_frame_uniforms() const;
+
+        // Scene edits are kept on the host and recorded into the next frame.
+        // Sphere and material indices are positions in the storage buffers,
+        // they stay valid until the scene is regenerated. Removed slots are
+        // reused by later adds.
+        [[nodiscard]] uint32_t add_material(material const& m);
+
+        void set_material(uint32_t index, material const& m);
+
+        // Spheres using a removed material absorb all light
+        void remove_material(uint32_t index);
+
+        [[nodiscard]] uint32_t add_sphere(sphere const& s);
+
+        void set_sphere(uint32_t index, sphere const& s);
+
+        void remove_sphere(uint32_t index);
+
     public:
         raytracer& operator=(raytracer const&) = delete;
 
         raytracer& operator=(raytracer&&) noexcept = delete;
 
     private:
-        void fill_world(std::span<sphere const> spheres);
-        void fill_materials(std::span<material const> materials);
+        struct [[nodiscard]] benchmark_result final
+        {
+            float linear{};
+            float bvh{};
+            float wavefront{};
+            float wavefront_binned{};
+            float ray_query{};
+            float specialized{};
+            // Average bytes requested from the sphere buffers
+            float fetch_packed{};
+            float fetch_unpacked{};
+        };
+
+        struct [[nodiscard]] trace_options final
+        {
+            bool bvh{true};
+            bool wavefront{false};
+            bool bin_materials{true};
+            bool ray_query{false};
+            bool adaptive{false};
+            // Bands of progressive passes are traced on the host
+            bool hybrid{false};
+            // Megakernel variants specialized for the settings and scene
+            // are used once compiled
+            bool specialized{true};
+        };
+
+    private:
+        [[nodiscard]] sample_region full_region() const;
+
+        // Hybrid passes need timestamps and the same sample count in every
+        // pixel
+        [[nodiscard]] bool hybrid_active() const;
+
+        void reset_accumulation();
+
+        void write_frame_uniforms();
+
+        [[nodiscard]] variant_key make_variant_key(
+            sample_region const& region) const;
+
+        [[nodiscard]] push_constants make_push_constants(
+            trace_options const& options,
+            sample_region const& region);
+
+        void dispatch(VkCommandBuffer command_buffer,
+            trace_options const& options,
+            sample_region const& region);
+
+        void run_benchmark();
+
+        void measure_scene_fetch();
+
+        void run_autotune();
+
+        [[nodiscard]] dispatch_config active_dispatch_config() const;
+
+        // Rebuilds the megakernel pipelines when the configuration differs
+        // from the one they were built with
+        void use_dispatch_config(dispatch_config const& config);
+
+        void create_pipelines(dispatch_config const& config);
+
+        void destroy_pipelines();
+
+        void update_convergence();
+
+        void update_descriptor_set();
+
+        // Copies the scene into the host copies of the buffers and uploads
+        // them, the device has to be idle
+        void load_scene(scene_view const& scene);
+        void fill_lights();
         void fill_world_and_materials();
 
+        [[nodiscard]] sphere sphere_at(uint32_t index) const;
+
+        [[nodiscard]] material material_at(uint32_t index) const;
+
+        // Returns true if any of the buffers was recreated, the device has
+        // to be idle
+        bool transfer_scene_buffers();
+
+        void apply_scene_edits(VkCommandBuffer command_buffer);
+
+        [[nodiscard]] bool is_light(sphere const& s) const;
+
+        void count_material_type(uint32_t type, int change);
+
+        // Recomputes bounds of the node and its ancestors until they stop
+        // changing
+        void refit_sphere_nodes(uint32_t node);
+
+        // Pairs the new sphere with the leaf where it enlarges the hierarchy
+        // the least
+        void insert_sphere_node(uint32_t index);
+
+        // Builds the sphere hierarchy again without moving spheres, leaves
+        // reference a single sphere
+        void rebuild_sphere_nodes();
+
     private:
         vkrndr::vulkan_device* device_;
         vkrndr::vulkan_renderer* renderer_;
@@ -68,12 +234,34 @@ namespace beam
 
         VkDescriptorSetLayout descriptor_layout_;
         VkDescriptorSet descriptor_set_{VK_NULL_HANDLE};
+        std::unique_ptr<frame_uniform_ring> frame_uniforms_;
 
         std::unique_ptr<vkrndr::vulkan_pipeline> compute_pipeline_;
+        std::unique_ptr<wavefront> wavefront_;
+        std::unique_ptr<acceleration_structures> acceleration_structures_;
+        std::unique_ptr<vkrndr::vulkan_pipeline> ray_query_pipeline_;
+        std::unique_ptr<adaptive_sampler> adaptive_sampler_;
+        std::unique_ptr<sample_scheduler> sample_scheduler_;
+        std::unique_ptr<reprojection> reprojection_;
+        std::unique_ptr<hybrid_tracer> hybrid_tracer_;
+        std::unique_ptr<dispatch_tuner> dispatch_tuner_;
+        dispatch_config pipeline_config_;
+        std::unique_ptr<pipeline_variants> variants_;
 
         int samples_per_pixel_{1};
         int max_depth_{5};
         uint32_t total_samples_{0};
+        // Scramble of the sample sequence, changes only when accumulation
+        // starts over so samples of a pixel stay stratified across frames
+        uint32_t sequence_seed_{0};
+        bool fixed_sequence_{false};
+        bool restart_{true};
+        bool frame_budget_{false};
+
+        bool temporal_reprojection_{true};
+        // Camera of the accumulated image, set when it should be reprojected
+        // before the next dispatch
+        std::optional<camera_pose> previous_camera_;
 
         glm::vec3 camera_position_{};
         glm::vec3 camera_front_{};
@@ -84,10 +272,51 @@ namespace beam
         float defocus_angle_{0.6f};
         float focus_distance_{10.0f};
 
-        vkrndr::vulkan_buffer world_buffer_;
+        // Centers and radii, material indices of spheres are in a separate
+        // buffer
+        scene_buffer world_buffer_;
+        scene_buffer sphere_material_buffer_;
         uint32_t sphere_count_{};
-        vkrndr::vulkan_buffer material_buffer_;
+        scene_buffer material_buffer_;
         uint32_t material_count_{};
+        // Bit per material type used by the scene
+        uint32_t material_mask_{};
+        std::array<uint32_t, material_type_count> material_type_counts_{};
+        scene_buffer bvh_buffer_;
+        scene_buffer triangle_buffer_;
+        uint32_t triangle_count_{};
+        uint32_t triangle_root_{};
+        scene_buffer light_buffer_;
+        uint32_t light_count_{};
+
+        // Edits are applied to the host copies of the scene buffers
+        std::vector<uint32_t> free_spheres_;
+        std::vector<uint32_t> free_materials_;
+        bvh_links sphere_links_;
+        bool scene_edited_{false};
+        bool lights_changed_{false};
+        bool geometry_changed_{false};
+        int edited_sphere_{};
+
+        mesh mesh_;
+        float sphere_bvh_build_time_{};
+        float triangle_bvh_build_time_{};
+
+        int scene_seed_{};
+        int scene_extent_{11};
+        bool small_lights_{false};
+        float sky_intensity_{1.0f};
+        bool next_event_estimation_{true};
+        bool rebuild_scene_{false};
+        trace_options options_;
+        float adaptive_threshold_{0.02f};
+        uint32_t adaptive_run_{};
+        std::chrono::steady_clock::time_point adaptive_start_;
+        float active_pixel_ratio_{1.0f};
+        std::optional<float> time_to_threshold_;
+        bool benchmark_requested_{false};
+        bool autotune_requested_{false};
+        benchmark_result benchmark_;
     };
 } // namespace beam
 
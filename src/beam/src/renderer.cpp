@@ -1,44 +1,126 @@
 #include <renderer.hpp>
 
+#include <async_compute.hpp>
+#include <denoiser.hpp>
+#include <display.hpp>
 #include <raytracer.hpp>
 
 #include <cppext_numeric.hpp>
 
+#include <vkrndr_gpu_profiler.hpp>
 #include <vulkan_commands.hpp>
 #include <vulkan_device.hpp>
 #include <vulkan_image.hpp>
+#include <vulkan_queue.hpp>
+#include <vulkan_renderer.hpp>
 
 #include <imgui.h>
 
 #include <vulkan/vulkan_core.h>
 
 #include <algorithm>
+#include <cstddef>
 #include <cstdint>
+#include <iterator>
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace
+{
+    // Display sources, the resolved images of asynchronous compute follow
+    // the accumulator and the denoised image
+    constexpr size_t accumulator_source{0};
+    constexpr size_t denoised_source{1};
+    constexpr size_t resolved_source{2};
+} // namespace
 
 beam::renderer::renderer(vkrndr::vulkan_device* const device,
     vkrndr::vulkan_renderer* const renderer,
-    VkExtent2D const extent)
+    VkExtent2D const extent,
+    VkFormat const target_format)
     : device_{device}
     , renderer_{renderer}
     , color_image_{create_color_image(extent)}
+    , denoiser_{std::make_unique<denoiser>(device_, color_image_)}
 {
+    if (async_compute::supported(*device_))
+    {
+        async_compute_ = std::make_unique<async_compute>(device_,
+            renderer_->frames_in_flight(),
+            extent);
+    }
+
+    display_ = std::make_unique<display>(device_,
+        display_sources(),
+        target_format);
 }
 
-beam::renderer::~renderer() { destroy(device_, &color_image_); }
+beam::renderer::~renderer()
+{
+    display_.reset();
+    async_compute_.reset();
+    denoiser_.reset();
+    destroy(device_, &color_image_);
+}
 
 vkrndr::vulkan_image& beam::renderer::color_image() { return color_image_; }
 
+vkrndr::vulkan_image const& beam::renderer::albedo_image() const
+{
+    return denoiser_->albedo_image();
+}
+
+vkrndr::vulkan_image const& beam::renderer::normal_depth_image() const
+{
+    return denoiser_->normal_depth_image();
+}
+
 void beam::renderer::set_raytracer(raytracer* raytracer)
 {
     raytracer_ = raytracer;
 }
 
+void beam::renderer::trace(VkCommandBuffer command_buffer)
+{
+    // Accumulator stays in general layout, previous contents are read back
+    // by the raytracer. Orders this frame after the display of the previous.
+    vkrndr::transition_image(color_image_.image,
+        command_buffer,
+        VK_IMAGE_LAYOUT_GENERAL,
+        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+        VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+        VK_IMAGE_LAYOUT_GENERAL,
+        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+        VK_ACCESS_2_SHADER_STORAGE_READ_BIT |
+            VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+        1);
+
+    raytracer_->draw(command_buffer);
+
+    vkrndr::transition_image(color_image_.image,
+        command_buffer,
+        VK_IMAGE_LAYOUT_GENERAL,
+        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+        VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+        VK_IMAGE_LAYOUT_GENERAL,
+        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+        VK_ACCESS_2_SHADER_STORAGE_READ_BIT,
+        1);
+}
+
 void beam::renderer::resize(VkExtent2D const extent)
 {
     vkDeviceWaitIdle(device_->logical); // TODO-JK
 
     destroy(device_, &color_image_);
     color_image_ = create_color_image(extent);
+    denoiser_->resize(color_image_);
+    if (async_compute_)
+    {
+        async_compute_->resize(extent);
+    }
+    display_->resize(display_sources());
     raytracer_->on_resize();
 }
 
@@ -57,88 +139,131 @@ void beam::renderer::draw(vkrndr::vulkan_image const& target_image,
     VkRect2D const scissor{{0, 0}, extent};
     vkCmdSetScissor(command_buffer, 0, 1, &scissor);
 
-    vkrndr::transition_image(color_image_.image,
-        command_buffer,
-        VK_IMAGE_LAYOUT_UNDEFINED,
-        VK_PIPELINE_STAGE_2_BLIT_BIT,
-        VK_ACCESS_2_TRANSFER_READ_BIT,
-        VK_IMAGE_LAYOUT_GENERAL,
-        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
-        VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
-        1);
+    vkrndr::gpu_profiler* const profiler{renderer_->profiler()};
 
-    raytracer_->draw(command_buffer);
+    if (async_compute_ && use_async_compute_)
+    {
+        // Compute queue work isn't profiled, queries of the frame are reset
+        // by the present queue after it was submitted
+        VkCommandBuffer compute_buffer{async_compute_->begin_frame()};
+        trace(compute_buffer);
+        if (denoiser_->enabled())
+        {
+            denoiser_->draw(compute_buffer);
+        }
+        renderer_->wait_semaphore(
+            async_compute_->end_frame(compute_buffer,
+                denoiser_->enabled() ? denoiser_->output_image()
+                                     : color_image_),
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
 
-    vkrndr::transition_image(color_image_.image,
-        command_buffer,
-        VK_IMAGE_LAYOUT_GENERAL,
-        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
-        VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
-        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-        VK_PIPELINE_STAGE_2_BLIT_BIT,
-        VK_ACCESS_2_TRANSFER_READ_BIT,
-        1);
+        uint32_t const display_scope{
+            profiler->begin_scope(command_buffer, "Display", true)};
+        async_compute_->acquire(command_buffer);
+        display_->draw(command_buffer,
+            target_image,
+            resolved_source + async_compute_->index());
+        profiler->end_scope(command_buffer, display_scope);
 
-    vkrndr::transition_image(target_image.image,
-        command_buffer,
-        VK_IMAGE_LAYOUT_UNDEFINED,
-        VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
-        VK_ACCESS_2_NONE,
-        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-        VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT,
-        VK_ACCESS_2_TRANSFER_WRITE_BIT,
-        1);
+        async_compute_->next_frame();
+        return;
+    }
 
-    VkOffset3D const size{
-        .x = cppext::narrow<int32_t>(
-            std::min(color_image_.extent.width, target_image.extent.width)),
-        .y = cppext::narrow<int32_t>(
-            std::min(color_image_.extent.height, target_image.extent.height)),
-        .z = 1};
-    VkImageBlit region{};
-    region.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    region.srcSubresource.layerCount = 1;
-    region.srcOffsets[1] = size;
-    region.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    region.dstSubresource.layerCount = 1;
-    region.dstOffsets[1] = size;
-
-    vkCmdBlitImage(command_buffer,
-        color_image_.image,
-        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-        target_image.image,
-        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-        1,
-        &region,
-        VK_FILTER_NEAREST);
+    uint32_t const trace_scope{
+        profiler->begin_scope(command_buffer, "Raytrace", true)};
+    trace(command_buffer);
+    profiler->end_scope(command_buffer, trace_scope);
 
-    vkrndr::transition_image(target_image.image,
-        command_buffer,
-        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-        VK_PIPELINE_STAGE_2_BLIT_BIT,
-        VK_ACCESS_2_TRANSFER_WRITE_BIT,
-        VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
-        VK_PIPELINE_STAGE_2_BOTTOM_OF_PIPE_BIT,
-        VK_ACCESS_2_NONE,
-        1);
+    if (denoiser_->enabled())
+    {
+        uint32_t const denoise_scope{
+            profiler->begin_scope(command_buffer, "Denoise", true)};
+        denoiser_->draw(command_buffer);
+        profiler->end_scope(command_buffer, denoise_scope);
+    }
+
+    uint32_t const display_scope{
+        profiler->begin_scope(command_buffer, "Display", true)};
+    display_->draw(command_buffer,
+        target_image,
+        denoiser_->enabled() ? denoised_source : accumulator_source);
+    profiler->end_scope(command_buffer, display_scope);
 }
 
 void beam::renderer::draw_imgui()
 {
     ImGui::ShowMetricsWindow();
+    if (async_compute_)
+    {
+        ImGui::Begin("Renderer");
+        // Images are shared by both queue families, switching only needs
+        // the work of previous frames on the other queue to finish
+        if (ImGui::Checkbox("Async compute", &use_async_compute_))
+        {
+            vkDeviceWaitIdle(device_->logical);
+        }
+        ImGui::Text("Resolve copy: %.3f ms",
+            cppext::as_fp<double>(async_compute_->copy_milliseconds()));
+        ImGui::End();
+    }
+    display_->draw_imgui();
+    denoiser_->draw_imgui();
     raytracer_->draw_imgui();
 }
 
+std::vector<vkrndr::vulkan_image const*> beam::renderer::display_sources()
+    const
+{
+    std::vector<vkrndr::vulkan_image const*> rv{&color_image_,
+        &denoiser_->output_image()};
+    if (async_compute_)
+    {
+        std::ranges::copy(async_compute_->resolved_images(),
+            std::back_inserter(rv));
+    }
+    return rv;
+}
+
 vkrndr::vulkan_image beam::renderer::create_color_image(
     VkExtent2D const extent) const
 {
-    return vkrndr::create_image_and_view(*device_,
+    vkrndr::vulkan_image rv{vkrndr::create_image_and_view(*device_,
         extent,
         1,
         VK_SAMPLE_COUNT_1_BIT,
         VK_FORMAT_R32G32B32A32_SFLOAT,
-        VK_IMAGE_TILING_LINEAR,
-        VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_STORAGE_BIT,
+        VK_IMAGE_TILING_OPTIMAL,
+        VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
         VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-        VK_IMAGE_ASPECT_COLOR_BIT);
+        VK_IMAGE_ASPECT_COLOR_BIT,
+        async_compute::queue_families(*device_))};
+
+    // Transitioned once, frames only synchronize access to it
+    VkCommandPool const command_pool{
+        vkrndr::create_command_pool(*device_, device_->present_queue->family)};
+
+    VkCommandBuffer command_buffer; // NOLINT
+    vkrndr::begin_single_time_commands(*device_,
+        command_pool,
+        1,
+        std::span{&command_buffer, 1});
+
+    vkrndr::transition_image(rv.image,
+        command_buffer,
+        VK_IMAGE_LAYOUT_UNDEFINED,
+        VK_PIPELINE_STAGE_2_NONE,
+        VK_ACCESS_2_NONE,
+        VK_IMAGE_LAYOUT_GENERAL,
+        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+        VK_ACCESS_2_SHADER_STORAGE_READ_BIT |
+            VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+        1);
+
+    vkrndr::end_single_time_commands(*device_,
+        device_->present_queue->queue,
+        std::span{&command_buffer, 1},
+        command_pool);
+    vkDestroyCommandPool(device_->logical, command_pool, nullptr);
+
+    return rv;
 }
@@ -6,6 +6,9 @@
 
 #include <vulkan/vulkan_core.h>
 
+#include <memory>
+#include <vector>
+
 namespace vkrndr
 {
     class vulkan_renderer;
@@ -14,6 +17,9 @@ namespace vkrndr
 
 namespace beam
 {
+    class async_compute;
+    class denoiser;
+    class display;
     class raytracer;
 } // namespace beam
 
@@ -22,9 +28,11 @@ namespace beam
     class [[nodiscard]] renderer final : public vkrndr::scene
     {
     public:
+        // Target format is the format of images passed to draw()
         renderer(vkrndr::vulkan_device* device,
             vkrndr::vulkan_renderer* renderer,
-            VkExtent2D extent);
+            VkExtent2D extent,
+            VkFormat target_format);
 
         renderer(renderer const&) = delete;
 
@@ -36,8 +44,17 @@ namespace beam
     public:
         [[nodiscard]] vkrndr::vulkan_image& color_image();
 
+        // First hit features written by the raytracer for the denoiser
+        [[nodiscard]] vkrndr::vulkan_image const& albedo_image() const;
+
+        [[nodiscard]] vkrndr::vulkan_image const& normal_depth_image() const;
+
         void set_raytracer(raytracer* raytracer);
 
+        // Records the raytracer work of a frame without displaying it, the
+        // accumulator is left in general layout with finished writes
+        void trace(VkCommandBuffer command_buffer);
+
     public: // vkrndr::scene overrides
         void resize(VkExtent2D extent) override;
 
@@ -53,6 +70,9 @@ namespace beam
         scene& operator=(scene&&) = delete;
 
     private:
+        [[nodiscard]] std::vector<vkrndr::vulkan_image const*>
+        display_sources() const;
+
         vkrndr::vulkan_image create_color_image(VkExtent2D extent) const;
 
     private:
@@ -62,6 +82,11 @@ namespace beam
         raytracer* raytracer_{};
 
         vkrndr::vulkan_image color_image_;
+        std::unique_ptr<denoiser> denoiser_;
+        // Present only when the device has a dedicated compute family
+        std::unique_ptr<async_compute> async_compute_;
+        bool use_async_compute_{true};
+        std::unique_ptr<display> display_;
     };
 } // namespace beam
 
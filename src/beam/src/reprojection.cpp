@@ -0,0 +1,354 @@
+#include <reprojection.hpp>
+
+#include <async_compute.hpp>
+#include <push_constants.hpp>
+
+#include <cppext_numeric.hpp>
+
+#include <vulkan_buffer.hpp>
+#include <vulkan_commands.hpp>
+#include <vulkan_descriptors.hpp>
+#include <vulkan_device.hpp>
+#include <vulkan_image.hpp>
+#include <vulkan_pipeline.hpp>
+#include <vulkan_queue.hpp>
+#include <vulkan_utility.hpp>
+
+#include <imgui.h>
+
+#include <vulkan/vulkan_core.h>
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <span>
+
+namespace
+{
+    constexpr uint32_t history_image_count{3};
+
+    // Matches Settings in reproject.comp
+    struct [[nodiscard]] settings final
+    {
+        uint32_t max_age;
+        float depth_tolerance;
+        float normal_tolerance;
+    };
+
+    [[nodiscard]] VkDescriptorPool create_descriptor_pool(
+        vkrndr::vulkan_device const* const device)
+    {
+        VkDescriptorPoolSize storage_image_pool_size{};
+        storage_image_pool_size.type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        storage_image_pool_size.descriptorCount = history_image_count;
+
+        VkDescriptorPoolSize uniform_buffer_pool_size{};
+        uniform_buffer_pool_size.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        uniform_buffer_pool_size.descriptorCount = 1;
+
+        std::array const pool_sizes{storage_image_pool_size,
+            uniform_buffer_pool_size};
+
+        VkDescriptorPoolCreateInfo pool_info{};
+        pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        pool_info.poolSizeCount = vkrndr::count_cast(pool_sizes.size());
+        pool_info.pPoolSizes = pool_sizes.data();
+        pool_info.maxSets = 1;
+
+        VkDescriptorPool rv; // NOLINT
+        vkrndr::check_result(
+            vkCreateDescriptorPool(device->logical, &pool_info, nullptr, &rv));
+
+        return rv;
+    }
+
+    [[nodiscard]] VkDescriptorSetLayout create_descriptor_set_layout(
+        vkrndr::vulkan_device const* const device)
+    {
+        std::array<VkDescriptorSetLayoutBinding, history_image_count + 1>
+            bindings{};
+        for (uint32_t i{}; VkDescriptorSetLayoutBinding & binding : bindings)
+        {
+            // History images followed by the settings uniform
+            binding.binding = i;
+            binding.descriptorType = i < history_image_count
+                ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE
+                : VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+            binding.descriptorCount = 1;
+            binding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+            ++i;
+        }
+
+        VkDescriptorSetLayoutCreateInfo layout_info{};
+        layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        layout_info.bindingCount = vkrndr::count_cast(bindings.size());
+        layout_info.pBindings = bindings.data();
+
+        VkDescriptorSetLayout rv; // NOLINT
+        vkrndr::check_result(vkCreateDescriptorSetLayout(device->logical,
+            &layout_info,
+            nullptr,
+            &rv));
+
+        return rv;
+    }
+
+    [[nodiscard]] vkrndr::vulkan_image create_history_image(
+        vkrndr::vulkan_device const& device,
+        VkExtent2D const extent)
+    {
+        return vkrndr::create_image_and_view(device,
+            extent,
+            1,
+            VK_SAMPLE_COUNT_1_BIT,
+            VK_FORMAT_R32G32B32A32_SFLOAT,
+            VK_IMAGE_TILING_OPTIMAL,
+            VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            VK_IMAGE_ASPECT_COLOR_BIT,
+            beam::async_compute::queue_families(device));
+    }
+
+    void transition_to_general(vkrndr::vulkan_device const& device,
+        std::span<VkImage const> const images)
+    {
+        VkCommandPool const command_pool{
+            vkrndr::create_command_pool(device, device.present_queue->family)};
+
+        VkCommandBuffer command_buffer; // NOLINT
+        vkrndr::begin_single_time_commands(device,
+            command_pool,
+            1,
+            std::span{&command_buffer, 1});
+
+        for (VkImage const image : images)
+        {
+            vkrndr::transition_image(image,
+                command_buffer,
+                VK_IMAGE_LAYOUT_UNDEFINED,
+                VK_PIPELINE_STAGE_2_NONE,
+                VK_ACCESS_2_NONE,
+                VK_IMAGE_LAYOUT_GENERAL,
+                VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT,
+                VK_ACCESS_2_TRANSFER_WRITE_BIT,
+                1);
+        }
+
+        vkrndr::end_single_time_commands(device,
+            device.present_queue->queue,
+            std::span{&command_buffer, 1},
+            command_pool);
+        vkDestroyCommandPool(device.logical, command_pool, nullptr);
+    }
+
+    void copy_image(VkCommandBuffer command_buffer,
+        vkrndr::vulkan_image const& source,
+        vkrndr::vulkan_image const& target)
+    {
+        VkImageCopy region{};
+        region.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.srcSubresource.layerCount = 1;
+        region.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.dstSubresource.layerCount = 1;
+        region.extent = {target.extent.width, target.extent.height, 1};
+
+        vkCmdCopyImage(command_buffer,
+            source.image,
+            VK_IMAGE_LAYOUT_GENERAL,
+            target.image,
+            VK_IMAGE_LAYOUT_GENERAL,
+            1,
+            &region);
+    }
+} // namespace
+
+beam::reprojection::reprojection(vkrndr::vulkan_device* const device,
+    VkDescriptorSetLayout const scene_layout,
+    VkExtent2D const extent)
+    : device_{device}
+    , descriptor_pool_{create_descriptor_pool(device_)}
+    , descriptor_layout_{create_descriptor_set_layout(device_)}
+{
+    vkrndr::create_descriptor_sets(device_,
+        descriptor_layout_,
+        descriptor_pool_,
+        std::span{&descriptor_set_, 1});
+
+    pipeline_ = std::make_unique<vkrndr::vulkan_pipeline>(
+        vkrndr::vulkan_compute_pipeline_builder{device_,
+            vkrndr::vulkan_pipeline_layout_builder{device_}
+                .add_descriptor_set_layout(scene_layout)
+                .add_descriptor_set_layout(descriptor_layout_)
+                .add_push_constants(VkPushConstantRange{
+                    .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+                    .offset = 0,
+                    .size = sizeof(push_constants),
+                })
+                .build()}
+            .with_shader("reproject.comp.spv", "main")
+            .build());
+
+    settings_buffer_ = vkrndr::create_buffer(*device_,
+        sizeof(settings),
+        VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+    create_resources(extent);
+    update_descriptor_set();
+}
+
+beam::reprojection::~reprojection()
+{
+    destroy_resources();
+    destroy(device_, &settings_buffer_);
+
+    destroy(device_, pipeline_.get());
+
+    vkDestroyDescriptorSetLayout(device_->logical, descriptor_layout_, nullptr);
+    vkDestroyDescriptorPool(device_->logical, descriptor_pool_, nullptr);
+}
+
+void beam::reprojection::resize(VkExtent2D const extent)
+{
+    destroy_resources();
+    create_resources(extent);
+    update_descriptor_set();
+}
+
+void beam::reprojection::reproject(VkCommandBuffer command_buffer,
+    VkDescriptorSet const scene_descriptor_set,
+    uint32_t const frame_offset,
+    push_constants const& constants,
+    vkrndr::vulkan_image const& color_image,
+    vkrndr::vulkan_image const& statistics_image,
+    vkrndr::vulkan_image const& normal_depth_image)
+{
+    // Images were last written by compute shaders of the previous frame,
+    // history images were last read by the previous reprojection
+    vkrndr::memory_barrier(command_buffer,
+        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+        VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+        VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT,
+        VK_ACCESS_2_TRANSFER_READ_BIT | VK_ACCESS_2_TRANSFER_WRITE_BIT);
+
+    copy_image(command_buffer, color_image, color_history_);
+    copy_image(command_buffer, statistics_image, statistics_history_);
+    copy_image(command_buffer, normal_depth_image, normal_depth_history_);
+
+    settings const values{.max_age = cppext::narrow<uint32_t>(max_age_),
+        .depth_tolerance = depth_tolerance_,
+        .normal_tolerance = normal_tolerance_};
+    vkCmdUpdateBuffer(command_buffer,
+        settings_buffer_.buffer,
+        0,
+        sizeof(values),
+        &values);
+
+    // Sources of the copies are overwritten by the reprojection
+    vkrndr::memory_barrier(command_buffer,
+        VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT,
+        VK_ACCESS_2_TRANSFER_WRITE_BIT,
+        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+        VK_ACCESS_2_SHADER_STORAGE_READ_BIT |
+            VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT |
+            VK_ACCESS_2_UNIFORM_READ_BIT);
+
+    vkCmdPushConstants(command_buffer,
+        *pipeline_->layout,
+        VK_SHADER_STAGE_COMPUTE_BIT,
+        0,
+        sizeof(push_constants),
+        &constants);
+
+    std::array const descriptor_sets{scene_descriptor_set, descriptor_set_};
+    vkrndr::bind_pipeline(command_buffer,
+        *pipeline_,
+        0,
+        descriptor_sets,
+        std::span{&frame_offset, 1});
+
+    vkCmdDispatch(command_buffer,
+        static_cast<uint32_t>(
+            std::ceil(cppext::as_fp(color_history_.extent.width) / 16.0f)),
+        static_cast<uint32_t>(
+            std::ceil(cppext::as_fp(color_history_.extent.height) / 16.0f)),
+        1);
+
+    vkrndr::memory_barrier(command_buffer,
+        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+        VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+        VK_ACCESS_2_SHADER_STORAGE_READ_BIT |
+            VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT);
+}
+
+void beam::reprojection::draw_imgui()
+{
+    ImGui::SliderInt("History age", &max_age_, 1, 256);
+    ImGui::SliderFloat("Depth tolerance", &depth_tolerance_, 0.001f, 0.5f);
+    ImGui::SliderFloat("Normal tolerance", &normal_tolerance_, 0.0f, 1.0f);
+}
+
+void beam::reprojection::create_resources(VkExtent2D const extent)
+{
+    color_history_ = create_history_image(*device_, extent);
+    statistics_history_ = create_history_image(*device_, extent);
+    normal_depth_history_ = create_history_image(*device_, extent);
+
+    std::array const images{color_history_.image,
+        statistics_history_.image,
+        normal_depth_history_.image};
+    transition_to_general(*device_, images);
+}
+
+void beam::reprojection::destroy_resources()
+{
+    destroy(device_, &normal_depth_history_);
+    destroy(device_, &statistics_history_);
+    destroy(device_, &color_history_);
+}
+
+void beam::reprojection::update_descriptor_set()
+{
+    std::array const views{color_history_.view,
+        statistics_history_.view,
+        normal_depth_history_.view};
+
+    std::array<VkDescriptorImageInfo, history_image_count> image_infos{};
+    std::array<VkWriteDescriptorSet, history_image_count + 1>
+        descriptor_writes{};
+    for (uint32_t i{}; i != history_image_count; ++i)
+    {
+        image_infos[i].imageView = views[i];
+        image_infos[i].imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+        descriptor_writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptor_writes[i].dstSet = descriptor_set_;
+        descriptor_writes[i].dstBinding = i;
+        descriptor_writes[i].dstArrayElement = 0;
+        descriptor_writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        descriptor_writes[i].descriptorCount = 1;
+        descriptor_writes[i].pImageInfo = &image_infos[i];
+    }
+
+    VkDescriptorBufferInfo const settings_info{
+        .buffer = settings_buffer_.buffer,
+        .offset = 0,
+        .range = settings_buffer_.size};
+
+    VkWriteDescriptorSet& settings_write{descriptor_writes.back()};
+    settings_write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    settings_write.dstSet = descriptor_set_;
+    settings_write.dstBinding = history_image_count;
+    settings_write.dstArrayElement = 0;
+    settings_write.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    settings_write.descriptorCount = 1;
+    settings_write.pBufferInfo = &settings_info;
+
+    vkUpdateDescriptorSets(device_->logical,
+        vkrndr::count_cast(descriptor_writes.size()),
+        descriptor_writes.data(),
+        0,
+        nullptr);
+}
@@ -0,0 +1,104 @@
+#ifndef BEAM_REPROJECTION_INCLUDED
+#define BEAM_REPROJECTION_INCLUDED
+
+#include <vulkan_buffer.hpp>
+#include <vulkan_image.hpp>
+
+#include <glm/vec3.hpp>
+
+#include <vulkan/vulkan_core.h>
+
+#include <cstdint>
+#include <memory>
+
+namespace vkrndr
+{
+    struct vulkan_device;
+    struct vulkan_pipeline;
+} // namespace vkrndr
+
+namespace beam
+{
+    struct push_constants;
+} // namespace beam
+
+namespace beam
+{
+    // Camera parameters in the same form as in frame uniforms, front is the
+    // point the camera looks at
+    struct [[nodiscard]] camera_pose final
+    {
+        glm::vec3 position;
+        glm::vec3 front;
+        glm::vec3 up;
+    };
+
+    // Carries accumulated samples over camera movement. First hits of the
+    // new camera are projected into the image of the previous one, history
+    // of pixels that see the same surface is kept with a capped sample count
+    // and the rest of the image starts from zero. Works on the per pixel
+    // statistics of the megakernel.
+    class [[nodiscard]] reprojection final
+    {
+    public:
+        reprojection(vkrndr::vulkan_device* device,
+            VkDescriptorSetLayout scene_layout,
+            VkExtent2D extent);
+
+        reprojection(reprojection const&) = delete;
+
+        reprojection(reprojection&&) noexcept = delete;
+
+    public:
+        ~reprojection();
+
+    public:
+        void resize(VkExtent2D extent);
+
+        // Rewrites the color, statistics and feature images bound in the
+        // scene descriptor set from the previous camera to the current one,
+        // both are taken from frame uniforms. Images have to be in general
+        // layout.
+        void reproject(VkCommandBuffer command_buffer,
+            VkDescriptorSet scene_descriptor_set,
+            uint32_t frame_offset,
+            push_constants const& constants,
+            vkrndr::vulkan_image const& color_image,
+            vkrndr::vulkan_image const& statistics_image,
+            vkrndr::vulkan_image const& normal_depth_image);
+
+        void draw_imgui();
+
+    public:
+        reprojection& operator=(reprojection const&) = delete;
+
+        reprojection& operator=(reprojection&&) noexcept = delete;
+
+    private:
+        void create_resources(VkExtent2D extent);
+
+        void destroy_resources();
+
+        void update_descriptor_set();
+
+    private:
+        vkrndr::vulkan_device* device_;
+
+        VkDescriptorPool descriptor_pool_;
+        VkDescriptorSetLayout descriptor_layout_;
+        VkDescriptorSet descriptor_set_{VK_NULL_HANDLE};
+
+        std::unique_ptr<vkrndr::vulkan_pipeline> pipeline_;
+
+        vkrndr::vulkan_image color_history_;
+        vkrndr::vulkan_image statistics_history_;
+        vkrndr::vulkan_image normal_depth_history_;
+        vkrndr::vulkan_buffer settings_buffer_;
+
+        int max_age_{32};
+        float depth_tolerance_{0.05f};
+        float normal_tolerance_{0.9f};
+    };
+} // namespace beam
+
+#endif
@@ -0,0 +1,202 @@
+#include <sample_scheduler.hpp>
+
+#include <cppext_cycled_buffer.hpp>
+#include <cppext_numeric.hpp>
+
+#include <vulkan_device.hpp>
+#include <vulkan_query.hpp>
+#include <vulkan_queue.hpp>
+#include <vulkan_utility.hpp>
+
+#include <imgui.h>
+
+#include <vulkan/vulkan_core.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+
+namespace
+{
+    // Results are read a few frames later, enough slots for all frames in
+    // flight to be measured
+    constexpr uint32_t query_slots{4};
+
+    constexpr uint32_t max_samples{64};
+
+    // Bands are made of whole tile rows of the megakernel
+    constexpr uint32_t band_granularity{16};
+
+    constexpr float cost_smoothing{0.2f};
+} // namespace
+
+beam::sample_scheduler::sample_scheduler(vkrndr::vulkan_device* const device)
+    : device_{device}
+    , timestamp_period_{vkrndr::timestamp_period(*device_,
+          device_->present_queue->family)}
+    , queries_{query_slots, query_slots}
+{
+    if (supported())
+    {
+        query_pool_ = vkrndr::create_query_pool(device_,
+            VK_QUERY_TYPE_TIMESTAMP,
+            2 * query_slots);
+    }
+}
+
+beam::sample_scheduler::~sample_scheduler()
+{
+    vkDestroyQueryPool(device_->logical, query_pool_, nullptr);
+}
+
+bool beam::sample_scheduler::supported() const
+{
+    return timestamp_period_ > 0.0f;
+}
+
+beam::sample_region beam::sample_scheduler::next_region(
+    VkExtent2D const extent,
+    bool const restart,
+    bool const bands)
+{
+    read_queries();
+
+    if (restart || !bands || next_row_ >= extent.height)
+    {
+        next_row_ = 0;
+    }
+
+    sample_region rv{.samples = 1,
+        .first_row = next_row_,
+        .row_count = extent.height - next_row_};
+
+    // Until the first measurement arrives a single sample of the whole image
+    // is traced
+    if (sample_cost_ > 0.0f)
+    {
+        float const pixel_samples{budget_ / sample_cost_};
+        float const pixels{
+            cppext::as_fp(extent.width) * cppext::as_fp(extent.height)};
+
+        if (!bands || (next_row_ == 0 && pixel_samples >= pixels))
+        {
+            rv.samples = std::clamp(
+                static_cast<uint32_t>(std::floor(pixel_samples / pixels)),
+                1u,
+                max_samples);
+        }
+        else
+        {
+            auto const rows{static_cast<uint32_t>(
+                pixel_samples / cppext::as_fp(extent.width))};
+            rv.row_count = std::min(
+                std::max(rows / band_granularity, 1u) * band_granularity,
+                extent.height - next_row_);
+        }
+    }
+
+    next_row_ = rv.first_row + rv.row_count;
+    last_region_ = rv;
+
+    return rv;
+}
+
+float beam::sample_scheduler::sample_cost()
+{
+    read_queries();
+    return sample_cost_;
+}
+
+void beam::sample_scheduler::begin(VkCommandBuffer command_buffer)
+{
+    uint32_t const first_query{
+        2 * cppext::narrow<uint32_t>(queries_.index())};
+
+    vkCmdResetQueryPool(command_buffer, query_pool_, first_query, 2);
+    vkCmdWriteTimestamp2(command_buffer,
+        VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+        query_pool_,
+        first_query);
+}
+
+void beam::sample_scheduler::end(VkCommandBuffer command_buffer,
+    uint64_t const pixel_samples)
+{
+    uint32_t const first_query{
+        2 * cppext::narrow<uint32_t>(queries_.index())};
+
+    vkCmdWriteTimestamp2(command_buffer,
+        VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+        query_pool_,
+        first_query + 1);
+
+    *queries_ = {.pixel_samples = pixel_samples, .pending = true};
+    queries_.cycle();
+}
+
+void beam::sample_scheduler::draw_imgui(VkExtent2D const extent)
+{
+    ImGui::SliderFloat("Budget (ms)", &budget_, 1.0f, 33.0f);
+    ImGui::Text("Raytrace: %.2f ms", cppext::as_fp<double>(last_time_));
+    if (last_region_.row_count < extent.height)
+    {
+        ImGui::Text("Band: %u rows, pass %.0f%%",
+            last_region_.row_count,
+            cppext::as_fp<double>(
+                cppext::as_fp(last_region_.first_row +
+                    last_region_.row_count) /
+                cppext::as_fp(extent.height) * 100.0f));
+    }
+    else
+    {
+        ImGui::Text("Samples per frame: %u", last_region_.samples);
+    }
+
+    if (sample_cost_ > 0.0f)
+    {
+        ImGui::Text("Throughput: %.2f Msamples/s",
+            cppext::as_fp<double>(1e-3f / sample_cost_));
+    }
+}
+
+void beam::sample_scheduler::read_queries()
+{
+    for (uint32_t slot{}; frame_query& query : queries_.as_span())
+    {
+        uint32_t const first_query{2 * slot++};
+        if (!query.pending)
+        {
+            continue;
+        }
+
+        std::array<uint64_t, 2> timestamps{};
+        VkResult const result{vkGetQueryPoolResults(device_->logical,
+            query_pool_,
+            first_query,
+            2,
+            sizeof(timestamps),
+            timestamps.data(),
+            sizeof(uint64_t),
+            VK_QUERY_RESULT_64_BIT)};
+        if (result == VK_NOT_READY)
+        {
+            continue;
+        }
+        vkrndr::check_result(result);
+
+        query.pending = false;
+        if (query.pixel_samples == 0)
+        {
+            continue;
+        }
+
+        last_time_ = cppext::as_fp(timestamps[1] - timestamps[0]) *
+            timestamp_period_ / 1e6f;
+
+        float const cost{last_time_ / cppext::as_fp(query.pixel_samples)};
+        sample_cost_ = sample_cost_ > 0.0f
+            ? std::lerp(sample_cost_, cost, cost_smoothing)
+            : cost;
+    }
+}
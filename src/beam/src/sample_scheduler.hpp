@@ -0,0 +1,95 @@
+#ifndef BEAM_SAMPLE_SCHEDULER_INCLUDED
+#define BEAM_SAMPLE_SCHEDULER_INCLUDED
+
+#include <cppext_cycled_buffer.hpp>
+
+#include <vulkan/vulkan_core.h>
+
+#include <cstdint>
+
+namespace vkrndr
+{
+    struct vulkan_device;
+} // namespace vkrndr
+
+namespace beam
+{
+    // Work of a single raytracer dispatch, rows of the image starting at
+    // first_row are sampled samples times
+    struct [[nodiscard]] sample_region final
+    {
+        uint32_t samples{1};
+        uint32_t first_row{};
+        uint32_t row_count{};
+    };
+
+    // Keeps the raytracing cost of a frame inside a time budget. GPU time of
+    // each dispatch is measured with timestamp queries and used to estimate
+    // the cost of a pixel sample. Frames get as many samples per pixel as fit
+    // into the budget, when even a single sample doesn't fit the image is
+    // traced in bands of tile rows over several frames.
+    class [[nodiscard]] sample_scheduler final
+    {
+    public:
+        explicit sample_scheduler(vkrndr::vulkan_device* device);
+
+        sample_scheduler(sample_scheduler const&) = delete;
+
+        sample_scheduler(sample_scheduler&&) noexcept = delete;
+
+    public:
+        ~sample_scheduler();
+
+    public:
+        // Timestamps are supported by the queue used for raytracing
+        [[nodiscard]] bool supported() const;
+
+        // Region to trace in the next frame. With restart the next band
+        // starts at the top of the image, without bands the whole image is
+        // traced every frame.
+        [[nodiscard]] sample_region next_region(VkExtent2D extent,
+            bool restart,
+            bool bands);
+
+        // Milliseconds per sample of a single pixel, smoothed over frames.
+        // Finished measurements are read first, zero until one arrives.
+        [[nodiscard]] float sample_cost();
+
+        void begin(VkCommandBuffer command_buffer);
+
+        void end(VkCommandBuffer command_buffer, uint64_t pixel_samples);
+
+        void draw_imgui(VkExtent2D extent);
+
+    public:
+        sample_scheduler& operator=(sample_scheduler const&) = delete;
+
+        sample_scheduler& operator=(sample_scheduler&&) noexcept = delete;
+
+    private:
+        struct [[nodiscard]] frame_query final
+        {
+            uint64_t pixel_samples{};
+            bool pending{};
+        };
+
+    private:
+        void read_queries();
+
+    private:
+        vkrndr::vulkan_device* device_;
+
+        float timestamp_period_;
+        VkQueryPool query_pool_{VK_NULL_HANDLE};
+        cppext::cycled_buffer<frame_query> queries_;
+
+        float budget_{12.0f};
+        float last_time_{};
+        // Milliseconds per sample of a single pixel, smoothed over frames
+        float sample_cost_{};
+        sample_region last_region_;
+        uint32_t next_row_{};
+    };
+} // namespace beam
+
+#endif
@@ -0,0 +1,229 @@
+#include <scene_buffer.hpp>
+
+#include <vulkan_buffer.hpp>
+#include <vulkan_commands.hpp>
+#include <vulkan_device.hpp>
+#include <vulkan_memory.hpp>
+#include <vulkan_renderer.hpp>
+
+#include <vulkan/vulkan_core.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <ranges>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace
+{
+    // Storage buffers can't be empty
+    constexpr VkDeviceSize min_capacity{256};
+
+    // Limit of a single vkCmdUpdateBuffer
+    constexpr size_t max_update_size{65536};
+
+    // Updates are copied into the command buffer, larger ones go through a
+    // staging buffer
+    constexpr size_t max_recorded_bytes{256 * 1024};
+
+    // Ranges closer than this are uploaded as one, the extra bytes are
+    // cheaper than another command
+    constexpr size_t coalesce_gap{256};
+
+    [[nodiscard]] size_t align_down(size_t const value)
+    {
+        return value & ~size_t{3};
+    }
+
+    [[nodiscard]] size_t align_up(size_t const value)
+    {
+        return (value + 3) & ~size_t{3};
+    }
+} // namespace
+
+std::vector<std::pair<size_t, size_t>> beam::coalesce_ranges(
+    std::vector<std::pair<size_t, size_t>> ranges,
+    size_t const gap)
+{
+    if (ranges.empty())
+    {
+        return ranges;
+    }
+
+    std::ranges::sort(ranges);
+
+    std::vector<std::pair<size_t, size_t>> rv{ranges.front()};
+    for (auto const& [begin, end] : std::views::drop(ranges, 1))
+    {
+        if (begin <= rv.back().second + gap)
+        {
+            rv.back().second = std::max(rv.back().second, end);
+        }
+        else
+        {
+            rv.emplace_back(begin, end);
+        }
+    }
+
+    return rv;
+}
+
+beam::scene_buffer::scene_buffer(vkrndr::vulkan_device* const device,
+    vkrndr::vulkan_renderer* const renderer)
+    : device_{device}
+    , renderer_{renderer}
+{
+}
+
+beam::scene_buffer::~scene_buffer() { destroy(device_, &buffer_); }
+
+VkDescriptorBufferInfo beam::scene_buffer::descriptor_info() const
+{
+    return {.buffer = buffer_.buffer, .offset = 0, .range = buffer_.size};
+}
+
+bool beam::scene_buffer::needs_transfer() const
+{
+    return full_transfer_ || dirty_bytes_ > max_recorded_bytes;
+}
+
+bool beam::scene_buffer::transfer()
+{
+    if (!needs_transfer())
+    {
+        return false;
+    }
+
+    bool const recreate{
+        buffer_.buffer == VK_NULL_HANDLE || data_.size() > buffer_.size};
+    if (recreate)
+    {
+        destroy(device_, &buffer_);
+        buffer_ = vkrndr::create_buffer(*device_,
+            std::max({VkDeviceSize{data_.size()},
+                2 * buffer_.size,
+                min_capacity}),
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    }
+
+    if (!data_.empty())
+    {
+        vkrndr::vulkan_buffer staging_buffer{vkrndr::create_buffer(*device_,
+            data_.size(),
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)};
+
+        {
+            auto staging_map{vkrndr::map_memory(*device_, staging_buffer)};
+            std::ranges::copy(data_, staging_map.as<std::byte>());
+            unmap_memory(*device_, &staging_map);
+        }
+
+        renderer_->transfer_buffer(staging_buffer, buffer_);
+
+        destroy(device_, &staging_buffer);
+    }
+
+    dirty_.clear();
+    dirty_bytes_ = 0;
+    full_transfer_ = false;
+
+    return recreate;
+}
+
+void beam::scene_buffer::upload(VkCommandBuffer command_buffer)
+{
+    assert(!needs_transfer());
+    if (dirty_.empty())
+    {
+        return;
+    }
+
+    std::vector<std::pair<size_t, size_t>> const ranges{
+        coalesce_ranges(std::move(dirty_), coalesce_gap)};
+
+    // Frames in flight may still read the buffer
+    vkrndr::memory_barrier(command_buffer,
+        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+        VK_ACCESS_2_SHADER_STORAGE_READ_BIT,
+        VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+        VK_ACCESS_2_TRANSFER_WRITE_BIT);
+
+    for (auto const& [begin, end] : ranges)
+    {
+        size_t offset{align_down(begin)};
+        size_t const last{std::min(align_up(end), data_.size())};
+        while (offset < last)
+        {
+            size_t const size{std::min(last - offset, max_update_size)};
+            vkCmdUpdateBuffer(command_buffer,
+                buffer_.buffer,
+                offset,
+                size,
+                std::span{data_}.subspan(offset).data());
+            offset += size;
+        }
+    }
+
+    vkrndr::memory_barrier(command_buffer,
+        VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+        VK_ACCESS_2_TRANSFER_WRITE_BIT,
+        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+        VK_ACCESS_2_SHADER_STORAGE_READ_BIT);
+
+    dirty_.clear();
+    dirty_bytes_ = 0;
+}
+
+void beam::scene_buffer::assign_bytes(std::span<std::byte const> const data)
+{
+    data_.assign(data.begin(), data.end());
+    dirty_.clear();
+    dirty_bytes_ = 0;
+
+    if (buffer_.buffer == VK_NULL_HANDLE || data_.size() > buffer_.size)
+    {
+        full_transfer_ = true;
+    }
+    else if (!full_transfer_)
+    {
+        dirty_.emplace_back(0, data_.size());
+        dirty_bytes_ = data_.size();
+    }
+}
+
+void beam::scene_buffer::write_bytes(size_t const offset,
+    std::span<std::byte const> const data)
+{
+    assert(offset + data.size() <= data_.size());
+    std::ranges::copy(data, std::span{data_}.subspan(offset).begin());
+
+    if (!full_transfer_)
+    {
+        dirty_.emplace_back(offset, offset + data.size());
+        dirty_bytes_ += data.size();
+    }
+}
+
+size_t beam::scene_buffer::append_bytes(std::span<std::byte const> const data)
+{
+    size_t const offset{data_.size()};
+    data_.insert(data_.end(), data.begin(), data.end());
+
+    if (data_.size() > buffer_.size)
+    {
+        full_transfer_ = true;
+    }
+    else if (!full_transfer_)
+    {
+        dirty_.emplace_back(offset, data_.size());
+        dirty_bytes_ += data.size();
+    }
+
+    return offset;
+}
@@ -0,0 +1,124 @@
+#ifndef BEAM_SCENE_BUFFER_INCLUDED
+#define BEAM_SCENE_BUFFER_INCLUDED
+
+#include <vulkan_buffer.hpp>
+
+#include <vulkan/vulkan_core.h>
+
+#include <cstddef>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace vkrndr
+{
+    struct vulkan_device;
+    class vulkan_renderer;
+} // namespace vkrndr
+
+namespace beam
+{
+    // Sorts [begin, end) byte ranges and merges overlapping ones and those
+    // separated by at most gap bytes
+    [[nodiscard]] std::vector<std::pair<size_t, size_t>> coalesce_ranges(
+        std::vector<std::pair<size_t, size_t>> ranges,
+        size_t gap);
+
+    // Device local storage buffer with a host copy of its contents. Writes
+    // go to the host copy and are tracked as dirty byte ranges which are
+    // coalesced and recorded into the frame command buffer. Capacity grows
+    // geometrically so that appending rarely needs a new buffer.
+    class [[nodiscard]] scene_buffer final
+    {
+    public:
+        scene_buffer(vkrndr::vulkan_device* device,
+            vkrndr::vulkan_renderer* renderer);
+
+        scene_buffer(scene_buffer const&) = delete;
+
+        scene_buffer(scene_buffer&&) noexcept = delete;
+
+    public:
+        ~scene_buffer();
+
+    public:
+        template<typename T>
+        void assign(std::span<T const> elements);
+
+        template<typename T>
+        void write(size_t index, T const& element);
+
+        // Returns the index of the element
+        template<typename T>
+        size_t append(T const& element);
+
+        template<typename T>
+        [[nodiscard]] std::span<T const> view() const;
+
+        [[nodiscard]] VkDescriptorBufferInfo descriptor_info() const;
+
+        // Changes are too large to be recorded into a command buffer or the
+        // contents outgrew the buffer
+        [[nodiscard]] bool needs_transfer() const;
+
+        // Uploads the whole contents with a blocking transfer, the device
+        // has to be idle. Returns true if the buffer was recreated and
+        // descriptors referencing it have to be updated.
+        bool transfer();
+
+        // Records updates of the dirty ranges, synchronized with compute
+        // shader reads before and after
+        void upload(VkCommandBuffer command_buffer);
+
+    public:
+        scene_buffer& operator=(scene_buffer const&) = delete;
+
+        scene_buffer& operator=(scene_buffer&&) noexcept = delete;
+
+    private:
+        void assign_bytes(std::span<std::byte const> data);
+
+        void write_bytes(size_t offset, std::span<std::byte const> data);
+
+        size_t append_bytes(std::span<std::byte const> data);
+
+    private:
+        vkrndr::vulkan_device* device_;
+        vkrndr::vulkan_renderer* renderer_;
+
+        vkrndr::vulkan_buffer buffer_;
+        std::vector<std::byte> data_;
+        // Byte ranges written since the last upload, [begin, end)
+        std::vector<std::pair<size_t, size_t>> dirty_;
+        size_t dirty_bytes_{};
+        bool full_transfer_{true};
+    };
+} // namespace beam
+
+template<typename T>
+void beam::scene_buffer::assign(std::span<T const> const elements)
+{
+    assign_bytes(std::as_bytes(elements));
+}
+
+template<typename T>
+void beam::scene_buffer::write(size_t const index, T const& element)
+{
+    write_bytes(index * sizeof(T), std::as_bytes(std::span{&element, 1}));
+}
+
+template<typename T>
+size_t beam::scene_buffer::append(T const& element)
+{
+    return append_bytes(std::as_bytes(std::span{&element, 1})) / sizeof(T);
+}
+
+template<typename T>
+std::span<T const> beam::scene_buffer::view() const
+{
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    return {reinterpret_cast<T const*>(data_.data()),
+        data_.size() / sizeof(T)};
+}
+
+#endif
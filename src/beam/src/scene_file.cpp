@@ -0,0 +1,569 @@
+#include <scene_file.hpp>
+
+#include <bvh.hpp>
+#include <mesh.hpp>
+#include <sphere.hpp>
+
+#include <cppext_numeric.hpp>
+
+#include <fmt/format.h>
+#include <fmt/std.h> // IWYU pragma: keep
+
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    constexpr std::array<char, 8> magic{'B', 'E', 'A', 'M', 'S', 'C', 'N', 0};
+
+    constexpr uint32_t version{1};
+
+    constexpr size_t section_alignment{32};
+
+    enum class section_type : uint32_t
+    {
+        center_radius,
+        sphere_materials,
+        materials,
+        nodes,
+        triangles,
+        lights,
+    };
+
+    constexpr size_t section_count{6};
+
+    struct [[nodiscard]] file_header final
+    {
+        std::array<char, 8> magic;
+        uint32_t version;
+        uint32_t section_count;
+        uint32_t triangle_root;
+        std::array<uint32_t, 3> reserved;
+    };
+
+    struct [[nodiscard]] file_section final
+    {
+        section_type type;
+        uint32_t element_size;
+        uint64_t offset;
+        uint64_t count;
+        uint64_t reserved;
+    };
+
+    static_assert(sizeof(file_header) == section_alignment);
+    static_assert(sizeof(file_section) == section_alignment);
+
+    [[nodiscard]] constexpr uint64_t align(uint64_t const value)
+    {
+        return (value + section_alignment - 1) / section_alignment *
+            section_alignment;
+    }
+
+    template<typename T>
+    [[nodiscard]] std::span<std::byte const> section_bytes(
+        std::span<T const> const elements)
+    {
+        return std::as_bytes(elements);
+    }
+
+    [[nodiscard]] std::array<std::span<std::byte const>, section_count>
+    sections_of(beam::scene_view const& scene)
+    {
+        return {section_bytes(scene.center_radius),
+            section_bytes(scene.sphere_materials),
+            section_bytes(scene.materials),
+            section_bytes(scene.nodes),
+            section_bytes(scene.triangles),
+            section_bytes(scene.lights)};
+    }
+
+    constexpr std::array<uint32_t, section_count> element_sizes{
+        sizeof(glm::vec4),
+        sizeof(uint32_t),
+        sizeof(beam::packed_material),
+        sizeof(beam::bvh_node),
+        sizeof(beam::triangle),
+        sizeof(uint32_t)};
+
+    template<typename T>
+    [[nodiscard]] std::span<T const> typed_section(std::byte const* data,
+        size_t const file_size,
+        file_section const& section,
+        std::filesystem::path const& path)
+    {
+        if (section.element_size != sizeof(T) ||
+            section.offset % section_alignment != 0 ||
+            section.offset > file_size ||
+            section.count > (file_size - section.offset) / sizeof(T))
+        {
+            throw std::runtime_error{
+                fmt::format("Corrupt section in scene file {}", path)};
+        }
+
+        // NOLINTBEGIN(cppcoreguidelines-pro-type-reinterpret-cast)
+        // NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        return {reinterpret_cast<T const*>(data + section.offset),
+            cppext::narrow<size_t>(section.count)};
+        // NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        // NOLINTEND(cppcoreguidelines-pro-type-reinterpret-cast)
+    }
+
+    // Nodes reached from the root are inside the node buffer, leaves inside
+    // the primitives and no node is reached twice. Visited nodes are shared
+    // between hierarchies so they don't overlap either.
+    [[nodiscard]] bool valid_hierarchy(
+        std::span<beam::bvh_node const> const nodes,
+        uint32_t const root,
+        size_t const primitive_count,
+        std::vector<bool>& visited)
+    {
+        std::vector<uint32_t> stack{root};
+        while (!stack.empty())
+        {
+            uint32_t const index{stack.back()};
+            stack.pop_back();
+
+            if (index >= nodes.size() || visited[index])
+            {
+                return false;
+            }
+            visited[index] = true;
+
+            beam::bvh_node const& node{nodes[index]};
+            if (node.count != 0)
+            {
+                if (node.left_first > primitive_count ||
+                    node.count > primitive_count - node.left_first)
+                {
+                    return false;
+                }
+            }
+            else if (node.left_first + size_t{1} < nodes.size())
+            {
+                stack.push_back(node.left_first);
+                stack.push_back(node.left_first + 1);
+            }
+            else
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // Every node belongs to one of the hierarchies and every index points
+    // into the section it refers to
+    [[nodiscard]] bool valid_indices(beam::scene_view const& scene)
+    {
+        std::vector<bool> visited(scene.nodes.size());
+        if ((!scene.center_radius.empty() &&
+                !valid_hierarchy(scene.nodes,
+                    0,
+                    scene.center_radius.size(),
+                    visited)) ||
+            (!scene.triangles.empty() &&
+                !valid_hierarchy(scene.nodes,
+                    scene.triangle_root,
+                    scene.triangles.size(),
+                    visited)) ||
+            !std::ranges::all_of(visited, std::identity{}))
+        {
+            return false;
+        }
+
+        auto const below = [](size_t const count)
+        {
+            return [count](uint32_t const index) { return index < count; };
+        };
+
+        auto const known_type = [](beam::packed_material const& m)
+        { return beam::unpack_material(m).type < beam::material_type_count; };
+
+        return std::ranges::all_of(scene.materials, known_type) &&
+            std::ranges::all_of(scene.sphere_materials,
+                below(scene.materials.size())) &&
+            std::ranges::all_of(scene.triangles,
+                below(scene.materials.size()),
+                &beam::triangle::material) &&
+            std::ranges::all_of(scene.lights,
+                below(scene.center_radius.size()));
+    }
+
+    // Deepest of the sphere and triangle hierarchies
+    [[nodiscard]] uint32_t scene_depth(beam::scene_view const& scene)
+    {
+        return std::max(beam::bvh_depth(scene.nodes, 0),
+            beam::bvh_depth(scene.nodes, scene.triangle_root));
+    }
+} // namespace
+
+beam::scene_view beam::scene_data::view() const
+{
+    return {.center_radius = center_radius,
+        .sphere_materials = sphere_materials,
+        .materials = materials,
+        .nodes = nodes,
+        .triangles = triangles,
+        .lights = lights,
+        .triangle_root = triangle_root};
+}
+
+beam::scene_data beam::build_scene(std::span<sphere const> const spheres,
+    std::span<material const> const materials,
+    mesh const& mesh)
+{
+    static constexpr uint32_t emissive{3};
+
+    scene_data rv;
+
+    std::vector<aabb> bounds;
+    bounds.reserve(spheres.size());
+    std::ranges::transform(spheres,
+        std::back_inserter(bounds),
+        [](sphere const& s)
+        {
+            return aabb{.min = s.center - glm::vec3{s.radius},
+                .max = s.center + glm::vec3{s.radius}};
+        });
+
+    auto const sphere_start{std::chrono::steady_clock::now()};
+
+    bvh const hierarchy{build_bvh(bounds)};
+
+    std::chrono::duration<float> const sphere_elapsed{
+        std::chrono::steady_clock::now() - sphere_start};
+    rv.sphere_bvh_build_time = sphere_elapsed.count();
+
+    rv.center_radius.reserve(spheres.size());
+    rv.sphere_materials.reserve(spheres.size());
+    for (uint32_t i{}; uint32_t const index : hierarchy.indices)
+    {
+        sphere const& s{spheres[index]};
+        rv.center_radius.emplace_back(s.center, s.radius);
+        rv.sphere_materials.push_back(s.material);
+        if (s.radius > 0.0f && materials[s.material].type == emissive)
+        {
+            rv.lights.push_back(i);
+        }
+        ++i;
+    }
+
+    rv.materials = pack_materials(materials);
+
+    rv.nodes = hierarchy.nodes;
+    rv.triangle_root = cppext::narrow<uint32_t>(rv.nodes.size());
+    if (!mesh.triangles.empty())
+    {
+        auto const start{std::chrono::steady_clock::now()};
+
+        std::vector<aabb> triangle_bounds;
+        triangle_bounds.reserve(mesh.triangles.size());
+        std::ranges::transform(mesh.triangles,
+            std::back_inserter(triangle_bounds),
+            [](triangle const& t)
+            {
+                aabb box;
+                grow(box, t.v0);
+                grow(box, t.v0 + t.edge1);
+                grow(box, t.v0 + t.edge2);
+                return box;
+            });
+
+        bvh const triangle_hierarchy{build_bvh(triangle_bounds)};
+
+        std::chrono::duration<float> const elapsed{
+            std::chrono::steady_clock::now() - start};
+        rv.triangle_bvh_build_time = elapsed.count();
+
+        // Both hierarchies share the node buffer, inner nodes of the
+        // triangle one need to point past the sphere nodes
+        std::ranges::transform(triangle_hierarchy.nodes,
+            std::back_inserter(rv.nodes),
+            [root = rv.triangle_root](bvh_node node)
+            {
+                if (node.count == 0)
+                {
+                    node.left_first += root;
+                }
+                return node;
+            });
+
+        auto const material_offset{
+            cppext::narrow<uint32_t>(rv.materials.size())};
+        std::ranges::transform(mesh.materials,
+            std::back_inserter(rv.materials),
+            pack_material);
+
+        rv.triangles.reserve(mesh.triangles.size());
+        std::ranges::transform(triangle_hierarchy.indices,
+            std::back_inserter(rv.triangles),
+            [&mesh, material_offset](uint32_t const index)
+            {
+                triangle t{mesh.triangles[index]};
+                t.material += material_offset;
+                return t;
+            });
+    }
+
+    if (uint32_t const depth{scene_depth(rv.view())}; depth > bvh_stack_size)
+    {
+        throw std::runtime_error{
+            fmt::format("Scene hierarchy depth {} exceeds the {} entries of "
+                        "the traversal stack",
+                depth,
+                bvh_stack_size)};
+    }
+
+    return rv;
+}
+
+void beam::write_scene_file(std::filesystem::path const& path,
+    scene_view const& scene)
+{
+    std::ofstream stream{path, std::ios::binary | std::ios::trunc};
+    if (!stream)
+    {
+        throw std::runtime_error{
+            fmt::format("Unable to open {} for writing", path)};
+    }
+
+    auto const sections{sections_of(scene)};
+
+    file_header const header{.magic = magic,
+        .version = version,
+        .section_count = section_count,
+        .triangle_root = scene.triangle_root,
+        .reserved = {}};
+
+    std::array<file_section, section_count> table{};
+    uint64_t offset{sizeof(file_header) + sizeof(table)};
+    for (size_t i{}; i != section_count; ++i)
+    {
+        table[i] = {.type = static_cast<section_type>(i),
+            .element_size = element_sizes[i],
+            .offset = offset,
+            .count = sections[i].size() / element_sizes[i],
+            .reserved = 0};
+        offset = align(offset + sections[i].size());
+    }
+
+    auto const write = [&stream](std::span<std::byte const> const bytes)
+    {
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+        stream.write(reinterpret_cast<char const*>(bytes.data()),
+            cppext::narrow<std::streamsize>(bytes.size()));
+    };
+
+    write(std::as_bytes(std::span{&header, 1}));
+    write(std::as_bytes(std::span{table}));
+
+    std::array<std::byte, section_alignment> const padding{};
+    for (size_t i{}; i != section_count; ++i)
+    {
+        write(sections[i]);
+
+        uint64_t const end{table[i].offset + sections[i].size()};
+        write(std::span{padding}.first(
+            cppext::narrow<size_t>(align(end) - end)));
+    }
+
+    if (!stream)
+    {
+        throw std::runtime_error{fmt::format("Unable to write {}", path)};
+    }
+}
+
+beam::scene_file::scene_file(std::filesystem::path const& path)
+{
+#if defined(_WIN32)
+    HANDLE const file{CreateFileW(path.c_str(),
+        GENERIC_READ,
+        FILE_SHARE_READ,
+        nullptr,
+        OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+        nullptr)};
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        throw std::runtime_error{fmt::format("Unable to open {}", path)};
+    }
+
+    LARGE_INTEGER file_size; // NOLINT
+    if (GetFileSizeEx(file, &file_size) && file_size.QuadPart > 0)
+    {
+        size_ = cppext::narrow<size_t>(file_size.QuadPart);
+        mapping_ =
+            CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping_)
+        {
+            data_ = static_cast<std::byte const*>(
+                MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+        }
+    }
+    CloseHandle(file);
+#else
+    int const file{open(path.c_str(), O_RDONLY | O_CLOEXEC)};
+    if (file == -1)
+    {
+        throw std::runtime_error{fmt::format("Unable to open {}", path)};
+    }
+
+    struct stat status; // NOLINT
+    if (fstat(file, &status) == 0 && status.st_size > 0)
+    {
+        size_ = cppext::narrow<size_t>(status.st_size);
+        void* const mapped{
+            mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, file, 0)};
+        if (mapped != MAP_FAILED)
+        {
+            // Everything is read once front to back, advice values aren't
+            // flags and are given one at a time
+            madvise(mapped, size_, MADV_SEQUENTIAL);
+            madvise(mapped, size_, MADV_WILLNEED);
+            data_ = static_cast<std::byte const*>(mapped);
+        }
+    }
+    close(file);
+#endif
+
+    if (data_ == nullptr)
+    {
+        unmap();
+        throw std::runtime_error{fmt::format("Unable to map {}", path)};
+    }
+
+    // The destructor doesn't run when the constructor throws
+    try
+    {
+        file_header header; // NOLINT
+        if (size_ < sizeof(header) + section_count * sizeof(file_section))
+        {
+            throw std::runtime_error{
+                fmt::format("{} is not a scene file", path)};
+        }
+        std::ranges::copy_n(data_,
+            sizeof(header),
+            reinterpret_cast<std::byte*>(&header)); // NOLINT
+
+        if (header.magic != magic)
+        {
+            throw std::runtime_error{
+                fmt::format("{} is not a scene file", path)};
+        }
+
+        if (header.version != version ||
+            header.section_count != section_count)
+        {
+            throw std::runtime_error{
+                fmt::format("Scene file {} has unsupported version {}",
+                    path,
+                    header.version)};
+        }
+
+        std::array<file_section, section_count> table; // NOLINT
+        std::ranges::copy_n(std::next(data_, sizeof(header)),
+            sizeof(table),
+            reinterpret_cast<std::byte*>(table.data())); // NOLINT
+
+        for (size_t i{}; i != section_count; ++i)
+        {
+            if (table[i].type != static_cast<section_type>(i))
+            {
+                throw std::runtime_error{
+                    fmt::format("Corrupt section in scene file {}", path)};
+            }
+        }
+
+        view_ = {.center_radius =
+                     typed_section<glm::vec4>(data_, size_, table[0], path),
+            .sphere_materials =
+                typed_section<uint32_t>(data_, size_, table[1], path),
+            .materials =
+                typed_section<packed_material>(data_, size_, table[2], path),
+            .nodes = typed_section<bvh_node>(data_, size_, table[3], path),
+            .triangles =
+                typed_section<triangle>(data_, size_, table[4], path),
+            .lights = typed_section<uint32_t>(data_, size_, table[5], path),
+            .triangle_root = header.triangle_root};
+
+        if (view_.sphere_materials.size() != view_.center_radius.size() ||
+            view_.triangle_root > view_.nodes.size())
+        {
+            throw std::runtime_error{
+                fmt::format("Inconsistent sections in scene file {}", path)};
+        }
+
+        if (!valid_indices(view_))
+        {
+            throw std::runtime_error{
+                fmt::format("Scene file {} has indices outside of its sections",
+                    path)};
+        }
+
+        if (uint32_t const depth{scene_depth(view_)}; depth > bvh_stack_size)
+        {
+            throw std::runtime_error{
+                fmt::format("Scene file {} has hierarchy depth {} exceeding "
+                            "the {} entries of the traversal stack",
+                    path,
+                    depth,
+                    bvh_stack_size)};
+        }
+    }
+    catch (...)
+    {
+        unmap();
+        throw;
+    }
+}
+
+beam::scene_file::~scene_file() { unmap(); }
+
+beam::scene_view const& beam::scene_file::view() const { return view_; }
+
+void beam::scene_file::unmap()
+{
+#if defined(_WIN32)
+    if (data_)
+    {
+        UnmapViewOfFile(data_);
+    }
+    if (mapping_)
+    {
+        CloseHandle(mapping_);
+    }
+    mapping_ = nullptr;
+#else
+    if (data_)
+    {
+        munmap(const_cast<std::byte*>(data_), size_); // NOLINT
+    }
+#endif
+    data_ = nullptr;
+}
@@ -0,0 +1,100 @@
+#ifndef BEAM_SCENE_FILE_INCLUDED
+#define BEAM_SCENE_FILE_INCLUDED
+
+#include <bvh.hpp>
+#include <mesh.hpp>
+#include <sphere.hpp>
+
+#include <glm/vec4.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <vector>
+
+namespace beam
+{
+    // Contents of the scene storage buffers in the order they are uploaded.
+    // Spheres and triangles are sorted for the leaf ranges of their
+    // hierarchies, both share the node array with the triangle one starting
+    // at triangle_root.
+    struct [[nodiscard]] scene_view final
+    {
+        std::span<glm::vec4 const> center_radius;
+        std::span<uint32_t const> sphere_materials;
+        std::span<packed_material const> materials;
+        std::span<bvh_node const> nodes;
+        std::span<triangle const> triangles;
+        // Indices of spheres with an emissive material
+        std::span<uint32_t const> lights;
+        uint32_t triangle_root{};
+    };
+
+    struct [[nodiscard]] scene_data final
+    {
+        std::vector<glm::vec4> center_radius;
+        std::vector<uint32_t> sphere_materials;
+        std::vector<packed_material> materials;
+        std::vector<bvh_node> nodes;
+        std::vector<triangle> triangles;
+        std::vector<uint32_t> lights;
+        uint32_t triangle_root{};
+
+        // Seconds spent building the hierarchies, not stored in files
+        float sphere_bvh_build_time{};
+        float triangle_bvh_build_time{};
+
+        [[nodiscard]] scene_view view() const;
+    };
+
+    // Builds hierarchies over the spheres and triangles of the mesh.
+    // Materials of the mesh are appended after the sphere ones.
+    [[nodiscard]] scene_data build_scene(std::span<sphere const> spheres,
+        std::span<material const> materials,
+        mesh const& mesh);
+
+    // Binary scene file: a header followed by a table of sections and the
+    // section contents, each one starting at a multiple of 32 bytes. Section
+    // contents are the storage buffer contents, a loader copies them without
+    // looking at the elements. Numbers are little endian.
+    void write_scene_file(std::filesystem::path const& path,
+        scene_view const& scene);
+
+    // Read only memory mapping of a scene file, the views point into the
+    // mapping and are valid while the object lives. Throws when the file
+    // can't be mapped or isn't a scene file of a supported version.
+    class [[nodiscard]] scene_file final
+    {
+    public:
+        explicit scene_file(std::filesystem::path const& path);
+
+        scene_file(scene_file const&) = delete;
+
+        scene_file(scene_file&&) noexcept = delete;
+
+    public:
+        ~scene_file();
+
+    public:
+        [[nodiscard]] scene_view const& view() const;
+
+    public:
+        scene_file& operator=(scene_file const&) = delete;
+
+        scene_file& operator=(scene_file&&) noexcept = delete;
+
+    private:
+        void unmap();
+
+    private:
+        std::byte const* data_{};
+        size_t size_{};
+#if defined(_WIN32)
+        void* mapping_{};
+#endif
+        scene_view view_;
+    };
+} // namespace beam
+
+#endif
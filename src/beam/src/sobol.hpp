@@ -0,0 +1,35 @@
+#ifndef BEAM_SOBOL_INCLUDED
+#define BEAM_SOBOL_INCLUDED
+
+#include <cstdint>
+
+namespace beam
+{
+    // Host versions of the sampling functions of random.glsl, the same
+    // inputs give the same bits as the shaders
+
+    [[nodiscard]] uint32_t hash_pcg(uint32_t x);
+
+    // Unscrambled Sobol point of one of the first four dimensions, a fixed
+    // point fraction of 32 bits
+    [[nodiscard]] uint32_t sobol(uint32_t index, uint32_t dimension);
+
+    // Owen scrambling of the bits from the most significant one down
+    [[nodiscard]] uint32_t nested_uniform_scramble(uint32_t x, uint32_t seed);
+
+    // Scramble of the sequence of a pixel, initSampler in the shaders
+    [[nodiscard]] uint32_t pixel_seed(uint32_t x,
+        uint32_t y,
+        uint32_t sequence_seed);
+
+    // Owen scrambled Sobol sequence with hash based scrambling, Burley 2020
+    // "Practical Hash-based Owen Scrambling". Dimensions past the first four
+    // are padded with independently shuffled copies of them. Consecutive
+    // indices of a pixel stay stratified in every dimension. Scramble is the
+    // pixel_seed() of the pixel.
+    [[nodiscard]] uint32_t scrambled_sobol(uint32_t scramble,
+        uint32_t index,
+        uint32_t dimension);
+} // namespace beam
+
+#endif
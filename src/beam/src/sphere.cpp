@@ -0,0 +1,286 @@
+#include <sphere.hpp>
+
+#include <bvh.hpp>
+
+#include <cppext_numeric.hpp>
+
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+#include <glm/gtc/packing.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace
+{
+    constexpr float no_hit{std::numeric_limits<float>::infinity()};
+
+    constexpr float min_distance{0.001f};
+
+    // Sizes of the layout used before spheres and materials were packed
+    constexpr size_t unpacked_sphere_size{32};
+    constexpr size_t unpacked_material_size{32};
+
+    [[nodiscard]] float hit_aabb(beam::bvh_node const& node,
+        glm::vec3 const& origin,
+        glm::vec3 const& inv_direction,
+        float const tmax)
+    {
+        glm::vec3 const t0{(node.min - origin) * inv_direction};
+        glm::vec3 const t1{(node.max - origin) * inv_direction};
+
+        glm::vec3 const smaller{glm::min(t0, t1)};
+        glm::vec3 const bigger{glm::max(t0, t1)};
+
+        float const entry{
+            std::max({min_distance, smaller.x, smaller.y, smaller.z})};
+        float const exit{std::min({tmax, bigger.x, bigger.y, bigger.z})};
+
+        return entry <= exit ? entry : no_hit;
+    }
+
+    [[nodiscard]] bool hit_sphere(glm::vec4 const& sphere,
+        glm::vec3 const& origin,
+        glm::vec3 const& direction,
+        float const tmax,
+        float& t)
+    {
+        glm::vec3 const oc{glm::vec3{sphere} - origin};
+
+        float const a{glm::dot(direction, direction)};
+        float const h{glm::dot(direction, oc)};
+        float const c{glm::dot(oc, oc) - sphere.w * sphere.w};
+        float const discriminant{h * h - a * c};
+        if (discriminant < 0.0f)
+        {
+            return false;
+        }
+
+        float const sqrtd{std::sqrt(discriminant)};
+        for (float const root : {(h - sqrtd) / a, (h + sqrtd) / a})
+        {
+            if (min_distance < root && root < tmax)
+            {
+                t = root;
+                return true;
+            }
+        }
+        return false;
+    }
+} // namespace
+
+beam::packed_material beam::pack_material(material const& m)
+{
+    return {.color = m.color,
+        .value_type = uint32_t{glm::packHalf1x16(m.value)} | (m.type << 16)};
+}
+
+beam::material beam::unpack_material(packed_material const& m)
+{
+    return {.color = m.color,
+        .value = glm::unpackHalf1x16(static_cast<uint16_t>(m.value_type)),
+        .type = m.value_type >> 16};
+}
+
+std::vector<beam::packed_material> beam::pack_materials(
+    std::span<material const> const materials)
+{
+    std::vector<packed_material> rv;
+    rv.reserve(materials.size());
+    std::ranges::transform(materials, std::back_inserter(rv), pack_material);
+    return rv;
+}
+
+beam::ray_fetch beam::measure_ray_fetch(std::span<bvh_node const> const nodes,
+    std::span<glm::vec4 const> const center_radius,
+    glm::vec3 const& origin,
+    glm::vec3 const& direction)
+{
+    if (nodes.empty())
+    {
+        return {};
+    }
+
+    glm::vec3 const inv_direction{1.0f / direction};
+
+    // Follows hitBvh() in scene.glsl, a node is read when it is visited and
+    // again when it is tested as a child of its parent
+    size_t node_reads{1};
+    size_t sphere_tests{};
+    bool hit{};
+
+    float closest{no_hit};
+    if (hit_aabb(nodes[0], origin, inv_direction, closest) != no_hit)
+    {
+        std::array<uint32_t, bvh_stack_size> stack; // NOLINT
+        size_t stack_size{};
+        uint32_t index{};
+        while (true)
+        {
+            bvh_node const& node{nodes[index]};
+            ++node_reads;
+
+            if (node.count != 0)
+            {
+                for (uint32_t i{node.left_first};
+                     i != node.left_first + node.count;
+                     ++i)
+                {
+                    ++sphere_tests;
+                    float t; // NOLINT
+                    if (hit_sphere(center_radius[i],
+                            origin,
+                            direction,
+                            closest,
+                            t))
+                    {
+                        closest = t;
+                        hit = true;
+                    }
+                }
+
+                if (stack_size == 0)
+                {
+                    break;
+                }
+                index = stack[--stack_size];
+                continue;
+            }
+
+            uint32_t near_child{node.left_first};
+            uint32_t far_child{node.left_first + 1};
+            node_reads += 2;
+
+            float near_t{
+                hit_aabb(nodes[near_child], origin, inv_direction, closest)};
+            float far_t{
+                hit_aabb(nodes[far_child], origin, inv_direction, closest)};
+            if (near_t > far_t)
+            {
+                std::swap(near_t, far_t);
+                std::swap(near_child, far_child);
+            }
+
+            if (near_t == no_hit)
+            {
+                if (stack_size == 0)
+                {
+                    break;
+                }
+                index = stack[--stack_size];
+            }
+            else
+            {
+                index = near_child;
+                if (far_t != no_hit)
+                {
+                    stack[stack_size++] = far_child;
+                }
+            }
+        }
+    }
+
+    size_t const node_bytes{node_reads * sizeof(bvh_node)};
+    return {.packed = node_bytes + sphere_tests * sizeof(glm::vec4) +
+            (hit ? sizeof(uint32_t) + sizeof(packed_material) : 0),
+        .unpacked = node_bytes + sphere_tests * unpacked_sphere_size +
+            (hit ? unpacked_material_size : 0)};
+}
+
+beam::procedural_scene beam::generate_procedural_scene(uint32_t const seed,
+    int const extent,
+    bool const small_lights)
+{
+    static constexpr uint32_t lambertian{0};
+    static constexpr uint32_t metal{1};
+    static constexpr uint32_t dielectric{2};
+    static constexpr uint32_t emissive{3};
+
+    // Fixed seed so the same settings give the same scene
+    std::default_random_engine scene_rng{seed};
+
+    std::uniform_real_distribution<float> dist{0.0f, 1.0f};
+    std::uniform_real_distribution<float> lower_dist{0.0f, 0.5f};
+    std::uniform_real_distribution<float> upper_dist{0.5f, 1.0f};
+
+    procedural_scene rv;
+    std::vector<sphere>& spheres{rv.spheres};
+    std::vector<material>& materials{rv.materials};
+    materials.emplace_back(glm::vec3{0.5f, 0.5f, 0.5f}, 0.0f, lambertian);
+    spheres.emplace_back(glm::vec3{0.0f, -1000.0f, 0.0f},
+        1000.0f,
+        cppext::narrow<uint32_t>(materials.size() - 1));
+
+    auto gen_color = [&]()
+    { return glm::vec3{dist(scene_rng), dist(scene_rng), dist(scene_rng)}; };
+
+    for (int a = -extent; a < extent; a++)
+    {
+        for (int b = -extent; b < extent; b++)
+        {
+            auto const choose_mat{dist(scene_rng)};
+            glm::vec3 const center{cppext::as_fp(a) + 0.9f * dist(scene_rng),
+                0.2f,
+                cppext::as_fp(b) + 0.9f * dist(scene_rng)};
+
+            if (glm::length(center - glm::vec3{4.0f, 0.2f, 0.0f}) > 0.9f)
+            {
+                if (small_lights && choose_mat < 0.04f)
+                {
+                    // light, brighter than it is saturated
+                    glm::vec3 const color{
+                        glm::vec3{0.5f} + 0.5f * gen_color()};
+                    materials.emplace_back(color, 8.0f, emissive);
+                }
+                else if (choose_mat < 0.8f)
+                {
+                    // diffuse
+                    glm::vec3 const albedo{gen_color() * gen_color()};
+                    materials.emplace_back(albedo, 0.0f, lambertian);
+                }
+                else if (choose_mat < 0.95f)
+                {
+                    // metal
+                    glm::vec3 const albedo{upper_dist(scene_rng),
+                        upper_dist(scene_rng),
+                        upper_dist(scene_rng)};
+                    float const fuzz{lower_dist(scene_rng)};
+                    materials.emplace_back(albedo, fuzz, metal);
+                }
+                else
+                {
+                    materials.emplace_back(glm::vec3{}, 1.5f, dielectric);
+                }
+
+                spheres.emplace_back(center,
+                    0.2f,
+                    cppext::narrow<uint32_t>(materials.size() - 1));
+            }
+        }
+    }
+
+    materials.emplace_back(glm::vec3{}, 1.5f, dielectric);
+    spheres.emplace_back(glm::vec3{0.0f, 1.0f, 0.0f},
+        1.0f,
+        cppext::narrow<uint32_t>(materials.size() - 1));
+
+    materials.emplace_back(glm::vec3{0.4f, 0.2f, 0.1f}, 0.0f, lambertian);
+    spheres.emplace_back(glm::vec3{-4.0f, 1.0f, 0.0f},
+        1.0f,
+        cppext::narrow<uint32_t>(materials.size() - 1));
+
+    materials.emplace_back(glm::vec3{0.7f, 0.6f, 0.5f}, 0.0f, metal);
+    spheres.emplace_back(glm::vec3{4.0f, 1.0f, 0.0f},
+        1.0f,
+        cppext::narrow<uint32_t>(materials.size() - 1));
+
+    return rv;
+}
@@ -1,33 +1,75 @@
 #ifndef BEAM_SPHERE_INCLUDED
 #define BEAM_SPHERE_INCLUDED
 
-#include <cppext_pragma_warning.hpp>
+#include <bvh.hpp>
 
 #include <glm/vec3.hpp>
 #include <glm/vec4.hpp>
 
+#include <cstddef>
 #include <cstdint>
+#include <span>
+#include <vector>
 
 namespace beam
 {
-    DISABLE_WARNING_PUSH
-
-    DISABLE_WARNING_STRUCTURE_WAS_PADDED_DUE_TO_ALIGNMENT_SPECIFIER
-    struct [[nodiscard]] alignas(32) sphere final
+    // Scene description as it is built, packed before the upload
+    struct [[nodiscard]] sphere final
     {
         glm::vec3 center;
         float radius;
         uint32_t material;
     };
 
-    struct [[nodiscard]] alignas(32) material final
+    struct [[nodiscard]] material final
     {
         glm::vec3 color;
         float value;
         uint32_t type;
     };
 
-    DISABLE_WARNING_POP
+    // Lambertian, metal, dielectric and emissive
+    inline constexpr uint32_t material_type_count{4};
+
+    // Matches the std430 layout of Material in the shaders. Value is a half
+    // float in the low 16 bits of value_type, type is in the high ones.
+    struct [[nodiscard]] alignas(16) packed_material final
+    {
+        glm::vec3 color;
+        uint32_t value_type;
+    };
+
+    [[nodiscard]] packed_material pack_material(material const& m);
+
+    [[nodiscard]] material unpack_material(packed_material const& m);
+
+    [[nodiscard]] std::vector<packed_material> pack_materials(
+        std::span<material const> materials);
+
+    struct [[nodiscard]] procedural_scene final
+    {
+        std::vector<sphere> spheres;
+        std::vector<material> materials;
+    };
+
+    // Ground, three large spheres and small random ones on a grid of
+    // 2 * extent cells per side. The same seed gives the same scene.
+    [[nodiscard]] procedural_scene generate_procedural_scene(uint32_t seed,
+        int extent,
+        bool small_lights);
+
+    // Bytes the closest hit BVH traversal of the shaders requests from the
+    // scene buffers for a ray, caches aren't accounted for. Unpacked is the
+    // same traversal over 32 byte spheres and materials.
+    struct [[nodiscard]] ray_fetch final
+    {
+        size_t packed{};
+        size_t unpacked{};
+    };
 
+    [[nodiscard]] ray_fetch measure_ray_fetch(std::span<bvh_node const> nodes,
+        std::span<glm::vec4 const> center_radius,
+        glm::vec3 const& origin,
+        glm::vec3 const& direction);
 } // namespace beam
 #endif
@@ -0,0 +1,348 @@
+#include <wavefront.hpp>
+
+#include <push_constants.hpp>
+
+#include <cppext_numeric.hpp>
+
+#include <vulkan_buffer.hpp>
+#include <vulkan_commands.hpp>
+#include <vulkan_descriptors.hpp>
+#include <vulkan_device.hpp>
+#include <vulkan_pipeline.hpp>
+#include <vulkan_utility.hpp>
+
+#include <vulkan/vulkan_core.h>
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <utility>
+
+namespace
+{
+    constexpr uint32_t binding_count{4};
+
+    // Sizes of the std430 structures in wavefront.glsl
+    constexpr VkDeviceSize path_size{64};
+    constexpr VkDeviceSize hit_size{48};
+    constexpr uint32_t material_type_count{3};
+    constexpr VkDeviceSize queue_count{2 + material_type_count};
+    constexpr VkDeviceSize counter_buffer_size{96};
+
+    // Offsets of dispatch arguments in CounterBuffer
+    constexpr VkDeviceSize queue_counters_size{32};
+    constexpr VkDeviceSize extend_arguments_offset{32};
+    constexpr VkDeviceSize shade_arguments_offset{48};
+    constexpr VkDeviceSize dispatch_arguments_size{16};
+
+    constexpr uint32_t any_material{~0u};
+
+    enum class [[nodiscard]] dispatch_stage : uint32_t
+    {
+        extend,
+        shade
+    };
+
+    [[nodiscard]] VkDescriptorPool create_descriptor_pool(
+        vkrndr::vulkan_device const* const device)
+    {
+        VkDescriptorPoolSize storage_buffer_pool_size{};
+        storage_buffer_pool_size.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        storage_buffer_pool_size.descriptorCount = binding_count;
+
+        VkDescriptorPoolCreateInfo pool_info{};
+        pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        pool_info.poolSizeCount = 1;
+        pool_info.pPoolSizes = &storage_buffer_pool_size;
+        pool_info.maxSets = 1;
+
+        VkDescriptorPool rv; // NOLINT
+        vkrndr::check_result(
+            vkCreateDescriptorPool(device->logical, &pool_info, nullptr, &rv));
+
+        return rv;
+    }
+
+    [[nodiscard]] VkDescriptorSetLayout create_descriptor_set_layout(
+        vkrndr::vulkan_device const* const device)
+    {
+        std::array<VkDescriptorSetLayoutBinding, binding_count> bindings{};
+        for (uint32_t i{}; VkDescriptorSetLayoutBinding & binding : bindings)
+        {
+            binding.binding = i++;
+            binding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            binding.descriptorCount = 1;
+            binding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        }
+
+        VkDescriptorSetLayoutCreateInfo layout_info{};
+        layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        layout_info.bindingCount = vkrndr::count_cast(bindings.size());
+        layout_info.pBindings = bindings.data();
+
+        VkDescriptorSetLayout rv; // NOLINT
+        vkrndr::check_result(vkCreateDescriptorSetLayout(device->logical,
+            &layout_info,
+            nullptr,
+            &rv));
+
+        return rv;
+    }
+
+    void push(VkCommandBuffer command_buffer,
+        vkrndr::vulkan_pipeline const& pipeline,
+        beam::push_constants const& constants)
+    {
+        vkCmdPushConstants(command_buffer,
+            *pipeline.layout,
+            VK_SHADER_STAGE_COMPUTE_BIT,
+            0,
+            sizeof(beam::push_constants),
+            &constants);
+    }
+
+    // Kernels communicate only through storage buffers and the indirect
+    // arguments, a global barrier between each of them is enough
+    void wavefront_barrier(VkCommandBuffer command_buffer)
+    {
+        vkrndr::memory_barrier(command_buffer,
+            VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT |
+                VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT,
+            VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT |
+                VK_ACCESS_2_TRANSFER_WRITE_BIT,
+            VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT |
+                VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT |
+                VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT,
+            VK_ACCESS_2_SHADER_STORAGE_READ_BIT |
+                VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT |
+                VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT |
+                VK_ACCESS_2_TRANSFER_WRITE_BIT);
+    }
+} // namespace
+
+beam::wavefront::wavefront(vkrndr::vulkan_device* const device,
+    VkDescriptorSetLayout const scene_layout,
+    VkExtent2D const extent)
+    : device_{device}
+    , descriptor_pool_{create_descriptor_pool(device_)}
+    , descriptor_layout_{create_descriptor_set_layout(device_)}
+{
+    vkrndr::create_descriptor_sets(device_,
+        descriptor_layout_,
+        descriptor_pool_,
+        std::span{&descriptor_set_, 1});
+
+    auto const layout{vkrndr::vulkan_pipeline_layout_builder{device_}
+            .add_descriptor_set_layout(scene_layout)
+            .add_descriptor_set_layout(descriptor_layout_)
+            .add_push_constants(VkPushConstantRange{
+                .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+                .offset = 0,
+                .size = sizeof(push_constants),
+            })
+            .build()};
+
+    auto const create_pipeline = [this, &layout](char const* const shader)
+    {
+        return std::make_unique<vkrndr::vulkan_pipeline>(
+            vkrndr::vulkan_compute_pipeline_builder{device_, layout}
+                .with_shader(shader, "main")
+                .build());
+    };
+
+    generate_pipeline_ = create_pipeline("wavefront_generate.comp.spv");
+    dispatch_pipeline_ = create_pipeline("wavefront_dispatch.comp.spv");
+    extend_pipeline_ = create_pipeline("wavefront_extend.comp.spv");
+    shade_pipeline_ = create_pipeline("wavefront_shade.comp.spv");
+    accumulate_pipeline_ = create_pipeline("wavefront_accumulate.comp.spv");
+
+    create_buffers(extent);
+    update_descriptor_set();
+}
+
+beam::wavefront::~wavefront()
+{
+    destroy_buffers();
+
+    // Pipelines share the layout, it's destroyed with the last one
+    for (auto* const pipeline : {&generate_pipeline_,
+             &dispatch_pipeline_,
+             &extend_pipeline_,
+             &shade_pipeline_,
+             &accumulate_pipeline_})
+    {
+        destroy(device_, pipeline->get());
+        pipeline->reset();
+    }
+
+    vkDestroyDescriptorSetLayout(device_->logical, descriptor_layout_, nullptr);
+    vkDestroyDescriptorPool(device_->logical, descriptor_pool_, nullptr);
+}
+
+void beam::wavefront::resize(VkExtent2D const extent)
+{
+    destroy_buffers();
+    create_buffers(extent);
+    update_descriptor_set();
+}
+
+void beam::wavefront::dispatch(VkCommandBuffer command_buffer,
+    VkDescriptorSet const scene_descriptor_set,
+    uint32_t const frame_offset,
+    push_constants const& constants,
+    uint32_t const max_depth,
+    VkExtent2D const extent,
+    bool const bin_materials)
+{
+    std::array const descriptor_sets{scene_descriptor_set, descriptor_set_};
+
+    auto const bind = [&](vkrndr::vulkan_pipeline const& pipeline,
+                          push_constants const& pc)
+    {
+        vkrndr::bind_pipeline(command_buffer,
+            pipeline,
+            0,
+            descriptor_sets,
+            std::span{&frame_offset, 1});
+        push(command_buffer, pipeline, pc);
+    };
+
+    auto const groups_x{static_cast<uint32_t>(
+        std::ceil(cppext::as_fp(extent.width) / 16.0f))};
+    auto const groups_y{static_cast<uint32_t>(
+        std::ceil(cppext::as_fp(extent.height) / 16.0f))};
+
+    push_constants pc{constants};
+    pc.material_bins = bin_materials ? 1u : 0u;
+    pc.shade_material = any_material;
+    for (uint32_t sample{}; sample != constants.samples_per_pixel; ++sample)
+    {
+        pc.sample_index = sample;
+        pc.bounce = 0;
+
+        wavefront_barrier(command_buffer);
+        vkCmdFillBuffer(command_buffer,
+            counter_buffer_.buffer,
+            0,
+            queue_counters_size,
+            0);
+        wavefront_barrier(command_buffer);
+
+        bind(*generate_pipeline_, pc);
+        vkCmdDispatch(command_buffer, groups_x, groups_y, 1);
+
+        for (uint32_t bounce{}; bounce != max_depth; ++bounce)
+        {
+            pc.bounce = bounce;
+
+            wavefront_barrier(command_buffer);
+            pc.wavefront_stage = std::to_underlying(dispatch_stage::extend);
+            bind(*dispatch_pipeline_, pc);
+            vkCmdDispatch(command_buffer, 1, 1, 1);
+
+            wavefront_barrier(command_buffer);
+            bind(*extend_pipeline_, pc);
+            vkCmdDispatchIndirect(command_buffer,
+                counter_buffer_.buffer,
+                extend_arguments_offset);
+
+            wavefront_barrier(command_buffer);
+            pc.wavefront_stage = std::to_underlying(dispatch_stage::shade);
+            bind(*dispatch_pipeline_, pc);
+            vkCmdDispatch(command_buffer, 1, 1, 1);
+
+            wavefront_barrier(command_buffer);
+            if (bin_materials)
+            {
+                // Shaded paths are disjoint, dispatches per material type
+                // don't need to be ordered
+                for (uint32_t type{}; type != material_type_count; ++type)
+                {
+                    pc.shade_material = type;
+                    bind(*shade_pipeline_, pc);
+                    vkCmdDispatchIndirect(command_buffer,
+                        counter_buffer_.buffer,
+                        shade_arguments_offset +
+                            type * dispatch_arguments_size);
+                }
+                pc.shade_material = any_material;
+            }
+            else
+            {
+                bind(*shade_pipeline_, pc);
+                vkCmdDispatchIndirect(command_buffer,
+                    counter_buffer_.buffer,
+                    shade_arguments_offset);
+            }
+        }
+    }
+
+    wavefront_barrier(command_buffer);
+    bind(*accumulate_pipeline_, pc);
+    vkCmdDispatch(command_buffer, groups_x, groups_y, 1);
+}
+
+void beam::wavefront::create_buffers(VkExtent2D const extent)
+{
+    VkDeviceSize const pixels{
+        VkDeviceSize{extent.width} * VkDeviceSize{extent.height}};
+
+    auto const create = [this](VkDeviceSize const size,
+                            VkBufferUsageFlags const usage)
+    {
+        return vkrndr::create_buffer(*device_,
+            size,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | usage,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    };
+
+    path_buffer_ = create(pixels * path_size, 0);
+    hit_buffer_ = create(pixels * hit_size, 0);
+    queue_buffer_ = create(pixels * queue_count * sizeof(uint32_t), 0);
+    counter_buffer_ = create(counter_buffer_size,
+        VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT |
+            VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+}
+
+void beam::wavefront::destroy_buffers()
+{
+    destroy(device_, &counter_buffer_);
+    destroy(device_, &queue_buffer_);
+    destroy(device_, &hit_buffer_);
+    destroy(device_, &path_buffer_);
+}
+
+void beam::wavefront::update_descriptor_set()
+{
+    std::array const buffers{&path_buffer_,
+        &hit_buffer_,
+        &queue_buffer_,
+        &counter_buffer_};
+
+    std::array<VkDescriptorBufferInfo, binding_count> buffer_infos{};
+    std::array<VkWriteDescriptorSet, binding_count> descriptor_writes{};
+    for (size_t i{}; i != binding_count; ++i)
+    {
+        buffer_infos[i].buffer = buffers[i]->buffer;
+        buffer_infos[i].offset = 0;
+        buffer_infos[i].range = buffers[i]->size;
+
+        descriptor_writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptor_writes[i].dstSet = descriptor_set_;
+        descriptor_writes[i].dstBinding = cppext::narrow<uint32_t>(i);
+        descriptor_writes[i].dstArrayElement = 0;
+        descriptor_writes[i].descriptorType =
+            VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        descriptor_writes[i].descriptorCount = 1;
+        descriptor_writes[i].pBufferInfo = &buffer_infos[i];
+    }
+
+    vkUpdateDescriptorSets(device_->logical,
+        vkrndr::count_cast(descriptor_writes.size()),
+        descriptor_writes.data(),
+        0,
+        nullptr);
+}
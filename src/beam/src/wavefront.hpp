@@ -0,0 +1,89 @@
+#ifndef BEAM_WAVEFRONT_INCLUDED
+#define BEAM_WAVEFRONT_INCLUDED
+
+#include <vulkan_buffer.hpp>
+
+#include <vulkan/vulkan_core.h>
+
+#include <cstdint>
+#include <memory>
+
+namespace vkrndr
+{
+    struct vulkan_device;
+    struct vulkan_pipeline;
+} // namespace vkrndr
+
+namespace beam
+{
+    struct push_constants;
+} // namespace beam
+
+namespace beam
+{
+    // Path tracer split into generate, extend and shade kernels working on
+    // ray queues kept in storage buffers. Scene bindings are shared with the
+    // megakernel in descriptor set 0, path state lives in set 1.
+    class [[nodiscard]] wavefront final
+    {
+    public:
+        wavefront(vkrndr::vulkan_device* device,
+            VkDescriptorSetLayout scene_layout,
+            VkExtent2D extent);
+
+        wavefront(wavefront const&) = delete;
+
+        wavefront(wavefront&&) noexcept = delete;
+
+    public:
+        ~wavefront();
+
+    public:
+        void resize(VkExtent2D extent);
+
+        // Traces samples_per_pixel samples of every pixel and accumulates them
+        // into the target image the same way as the megakernel. Bounces are
+        // recorded on the host, max_depth has to match the one in frame
+        // uniforms. With bin_materials hits are queued and shaded per
+        // material type.
+        void dispatch(VkCommandBuffer command_buffer,
+            VkDescriptorSet scene_descriptor_set,
+            uint32_t frame_offset,
+            push_constants const& constants,
+            uint32_t max_depth,
+            VkExtent2D extent,
+            bool bin_materials);
+
+    public:
+        wavefront& operator=(wavefront const&) = delete;
+
+        wavefront& operator=(wavefront&&) noexcept = delete;
+
+    private:
+        void create_buffers(VkExtent2D extent);
+
+        void destroy_buffers();
+
+        void update_descriptor_set();
+
+    private:
+        vkrndr::vulkan_device* device_;
+
+        VkDescriptorPool descriptor_pool_;
+        VkDescriptorSetLayout descriptor_layout_;
+        VkDescriptorSet descriptor_set_{VK_NULL_HANDLE};
+
+        std::unique_ptr<vkrndr::vulkan_pipeline> generate_pipeline_;
+        std::unique_ptr<vkrndr::vulkan_pipeline> dispatch_pipeline_;
+        std::unique_ptr<vkrndr::vulkan_pipeline> extend_pipeline_;
+        std::unique_ptr<vkrndr::vulkan_pipeline> shade_pipeline_;
+        std::unique_ptr<vkrndr::vulkan_pipeline> accumulate_pipeline_;
+
+        vkrndr::vulkan_buffer path_buffer_;
+        vkrndr::vulkan_buffer hit_buffer_;
+        vkrndr::vulkan_buffer queue_buffer_;
+        vkrndr::vulkan_buffer counter_buffer_;
+    };
+} // namespace beam
+
+#endif
@@ -0,0 +1,218 @@
+#include <bvh.hpp>
+
+#include <cppext_numeric.hpp>
+
+#include <glm/vec3.hpp>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace
+{
+    // Unit boxes on a grid, shuffled so that the build has to sort them
+    [[nodiscard]] std::vector<beam::aabb> grid_bounds(int const side)
+    {
+        std::vector<beam::aabb> rv;
+        for (int i{}; i != side * side * side; ++i)
+        {
+            int const cell{(i * 7919) % (side * side * side)};
+            glm::vec3 const min{cppext::as_fp(cell % side),
+                cppext::as_fp(cell / side % side),
+                cppext::as_fp(cell / (side * side))};
+            rv.push_back({.min = min, .max = min + 0.5f});
+        }
+        return rv;
+    }
+
+    [[nodiscard]] bool contains(beam::bvh_node const& node,
+        beam::aabb const& box)
+    {
+        return node.min.x <= box.min.x && node.min.y <= box.min.y &&
+            node.min.z <= box.min.z && node.max.x >= box.max.x &&
+            node.max.y >= box.max.y && node.max.z >= box.max.z;
+    }
+
+    [[nodiscard]] beam::aabb bounds_of(beam::bvh_node const& node)
+    {
+        return {.min = node.min, .max = node.max};
+    }
+
+    // Leaves reached from the root in traversal order, inner node bounds are
+    // checked to contain their children on the way
+    [[nodiscard]] std::vector<uint32_t> reachable_leaves(
+        std::span<beam::bvh_node const> const nodes)
+    {
+        std::vector<uint32_t> rv;
+        std::vector<uint32_t> stack{0};
+        while (!stack.empty())
+        {
+            uint32_t const index{stack.back()};
+            stack.pop_back();
+
+            beam::bvh_node const& node{nodes[index]};
+            if (node.count != 0)
+            {
+                rv.push_back(index);
+                continue;
+            }
+
+            REQUIRE(node.left_first + size_t{1} < nodes.size());
+            for (uint32_t const child : {node.left_first, node.left_first + 1})
+            {
+                CHECK(contains(node, bounds_of(nodes[child])));
+                stack.push_back(child);
+            }
+        }
+        return rv;
+    }
+} // namespace
+
+TEST_CASE("build_bvh", "[beam][bvh]")
+{
+    std::vector<beam::aabb> const bounds{grid_bounds(6)};
+
+    SECTION("empty input gives an empty hierarchy")
+    {
+        beam::bvh const hierarchy{beam::build_bvh({})};
+        CHECK(hierarchy.nodes.empty());
+        CHECK(hierarchy.indices.empty());
+    }
+
+    SECTION("leaves cover every primitive once")
+    {
+        uint32_t const max_leaf_size{4};
+        beam::bvh const hierarchy{beam::build_bvh(bounds, max_leaf_size)};
+
+        REQUIRE(hierarchy.indices.size() == bounds.size());
+        CHECK(hierarchy.nodes.size() <= 2 * bounds.size() - 1);
+
+        std::vector<uint32_t> sorted{hierarchy.indices};
+        std::ranges::sort(sorted);
+        for (size_t i{}; i != sorted.size(); ++i)
+        {
+            CHECK(sorted[i] == i);
+        }
+
+        std::vector<int> covered(bounds.size());
+        for (uint32_t const leaf : reachable_leaves(hierarchy.nodes))
+        {
+            beam::bvh_node const& node{hierarchy.nodes[leaf]};
+            CHECK(node.count <= max_leaf_size);
+            for (uint32_t i{node.left_first}; i != node.left_first + node.count;
+                ++i)
+            {
+                ++covered[i];
+                CHECK(contains(node, bounds[hierarchy.indices[i]]));
+            }
+        }
+        CHECK(std::ranges::all_of(covered, [](int c) { return c == 1; }));
+    }
+
+    SECTION("leaves of one hold a single primitive")
+    {
+        beam::bvh const hierarchy{beam::build_bvh(bounds, 1)};
+        for (uint32_t const leaf : reachable_leaves(hierarchy.nodes))
+        {
+            CHECK(hierarchy.nodes[leaf].count == 1);
+        }
+    }
+
+    SECTION("identical primitives stay in one leaf")
+    {
+        std::vector<beam::aabb> const same(8, bounds.front());
+        beam::bvh const hierarchy{beam::build_bvh(same, 1)};
+        REQUIRE(hierarchy.nodes.size() == 1);
+        CHECK(hierarchy.nodes.front().count == same.size());
+    }
+}
+
+TEST_CASE("bvh_depth", "[beam][bvh]")
+{
+    std::vector<beam::aabb> const bounds{grid_bounds(6)};
+    beam::bvh const hierarchy{beam::build_bvh(bounds, 1)};
+
+    uint32_t const depth{beam::bvh_depth(hierarchy.nodes, 0)};
+    // A balanced split of 216 primitives needs 8 levels, SAH on a regular
+    // grid stays close to that
+    CHECK(depth >= 8);
+    CHECK(depth <= 16);
+    CHECK(depth <= beam::bvh_stack_size);
+
+    CHECK(beam::bvh_depth({}, 0) == 0);
+
+    beam::bvh const single{beam::build_bvh(std::span{bounds}.first(1))};
+    CHECK(beam::bvh_depth(single.nodes, 0) == 0);
+
+    // Chain where each level holds one leaf, bounds don't matter
+    auto const node = [](uint32_t const left_first, uint32_t const count)
+    {
+        return beam::bvh_node{.min = glm::vec3{},
+            .left_first = left_first,
+            .max = glm::vec3{},
+            .count = count};
+    };
+
+    std::vector<beam::bvh_node> chain;
+    uint32_t const levels{10};
+    for (uint32_t i{}; i != levels; ++i)
+    {
+        chain.push_back(node(2 * i + 1, 0));
+        chain.push_back(node(i, 1));
+    }
+    chain.push_back(node(levels, 1));
+    CHECK(beam::bvh_depth(chain, 0) == levels);
+}
+
+TEST_CASE("build_indexed_bvh", "[beam][bvh]")
+{
+    std::vector<beam::aabb> bounds{grid_bounds(5)};
+    // Primitives the SAH can't separate are halved
+    beam::aabb const duplicate{bounds.front()};
+    bounds.insert(bounds.end(), 5, duplicate);
+
+    std::vector<beam::bvh_node> const nodes{beam::build_indexed_bvh(bounds)};
+    CHECK(nodes.size() == 2 * bounds.size() - 1);
+
+    std::vector<int> covered(bounds.size());
+    for (uint32_t const leaf : reachable_leaves(nodes))
+    {
+        beam::bvh_node const& node{nodes[leaf]};
+        REQUIRE(node.count == 1);
+        REQUIRE(node.left_first < bounds.size());
+        ++covered[node.left_first];
+        CHECK(contains(node, bounds[node.left_first]));
+    }
+    CHECK(std::ranges::all_of(covered, [](int c) { return c == 1; }));
+}
+
+TEST_CASE("link_bvh", "[beam][bvh]")
+{
+    std::vector<beam::aabb> const bounds{grid_bounds(4)};
+    std::vector<beam::bvh_node> const nodes{beam::build_indexed_bvh(bounds)};
+
+    beam::bvh_links const links{beam::link_bvh(nodes, 0, bounds.size())};
+    REQUIRE(links.parents.size() == nodes.size());
+    REQUIRE(links.leaves.size() == bounds.size());
+
+    CHECK(links.parents[0] == beam::no_parent);
+    for (size_t i{}; i != nodes.size(); ++i)
+    {
+        if (nodes[i].count == 0)
+        {
+            CHECK(links.parents[nodes[i].left_first] == i);
+            CHECK(links.parents[nodes[i].left_first + 1] == i);
+        }
+    }
+
+    for (size_t i{}; i != bounds.size(); ++i)
+    {
+        beam::bvh_node const& leaf{nodes[links.leaves[i]]};
+        CHECK(leaf.count == 1);
+        CHECK(leaf.left_first == i);
+    }
+}
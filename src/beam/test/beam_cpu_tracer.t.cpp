@@ -0,0 +1,210 @@
+#include <cpu_tracer.hpp>
+#include <frame_uniforms.hpp>
+#include <headless.hpp>
+#include <mesh.hpp>
+#include <raytracer.hpp>
+#include <scene_file.hpp>
+#include <sphere.hpp>
+
+#include <cppext_numeric.hpp>
+
+#include <glm/geometric.hpp>
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+
+#include <vulkan/vulkan_core.h>
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers_floating_point.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace
+{
+    constexpr VkExtent2D extent{64, 48};
+
+    constexpr uint32_t tile_size{16};
+
+    // Small procedural scene, every material type is present
+    constexpr uint32_t scene_seed{0};
+    constexpr int scene_extent{2};
+
+    [[nodiscard]] float luminance(glm::vec4 const& color)
+    {
+        return glm::dot(glm::vec3{color}, glm::vec3{0.2126f, 0.7152f, 0.0722f});
+    }
+
+    // Mean luminance of every tile, tiles cover the image exactly
+    [[nodiscard]] std::vector<double> tile_means(
+        std::span<glm::vec4 const> const pixels)
+    {
+        uint32_t const tiles_x{extent.width / tile_size};
+        uint32_t const tiles_y{extent.height / tile_size};
+
+        std::vector<double> rv(size_t{tiles_x} * tiles_y);
+        for (uint32_t y{}; y != extent.height; ++y)
+        {
+            for (uint32_t x{}; x != extent.width; ++x)
+            {
+                rv[(y / tile_size) * tiles_x + x / tile_size] +=
+                    luminance(pixels[size_t{y} * extent.width + x]);
+            }
+        }
+
+        for (double& mean : rv)
+        {
+            mean /= tile_size * tile_size;
+        }
+        return rv;
+    }
+
+    [[nodiscard]] beam::frame_uniforms test_uniforms(
+        beam::scene_view const& scene)
+    {
+        return {.camera_position = {13.0f, 2.0f, 3.0f},
+            .world_count = cppext::narrow<uint32_t>(scene.center_radius.size()),
+            .camera_front = {0.0f, 0.0f, 0.0f},
+            .material_count = cppext::narrow<uint32_t>(scene.materials.size()),
+            .camera_up = {0.0f, 1.0f, 0.0f},
+            .max_depth = 5,
+            .previous_position = {13.0f, 2.0f, 3.0f},
+            .defocus_angle = 0.6f,
+            .previous_front = {0.0f, 0.0f, 0.0f},
+            .focus_distance = 10.0f,
+            .previous_up = {0.0f, 1.0f, 0.0f},
+            .fovy = 20.0f,
+            .sequence_seed = 0,
+            .triangle_count = cppext::narrow<uint32_t>(scene.triangles.size()),
+            .triangle_root = scene.triangle_root,
+            .light_count = cppext::narrow<uint32_t>(scene.lights.size()),
+            .sky_intensity = 1.0f};
+    }
+} // namespace
+
+TEST_CASE("cpu_tracer image doesn't depend on the thread count",
+    "[beam][cpu_tracer]")
+{
+    beam::procedural_scene const spheres{
+        beam::generate_procedural_scene(scene_seed, scene_extent, false)};
+    beam::scene_data const scene{
+        beam::build_scene(spheres.spheres, spheres.materials, beam::mesh{})};
+    beam::frame_uniforms const uniforms{test_uniforms(scene.view())};
+
+    beam::cpu_tracer single{scene.view(), extent, 1};
+    beam::cpu_tracer multiple{scene.view(), extent, 3};
+    for (int i{}; i != 2; ++i)
+    {
+        single.trace(uniforms, 2);
+        multiple.trace(uniforms, 2);
+    }
+
+    CHECK(single.total_samples() == 4);
+    CHECK(std::ranges::equal(single.image(), multiple.image()));
+
+    single.reset();
+    CHECK(single.total_samples() == 0);
+    CHECK(std::ranges::all_of(single.image(),
+        [](glm::vec4 const& pixel) { return pixel == glm::vec4{0.0f}; }));
+}
+
+TEST_CASE("cpu_tracer band samples match the accumulated image",
+    "[beam][cpu_tracer]")
+{
+    constexpr uint32_t samples{2};
+    constexpr uint32_t first_row{tile_size};
+    constexpr uint32_t row_count{tile_size};
+
+    beam::procedural_scene const spheres{
+        beam::generate_procedural_scene(scene_seed, scene_extent, false)};
+    beam::scene_data const scene{
+        beam::build_scene(spheres.spheres, spheres.materials, beam::mesh{})};
+    beam::frame_uniforms const uniforms{test_uniforms(scene.view())};
+
+    beam::cpu_tracer accumulated{scene.view(), extent, 1};
+    accumulated.trace(uniforms, samples);
+
+    beam::cpu_tracer band{scene.view(), extent, 3};
+    std::vector<uint32_t> const first_samples(row_count, 0);
+    std::vector<glm::vec4> colors(size_t{extent.width} * row_count);
+    std::vector<glm::vec4> statistics(colors.size());
+    band.trace_band(uniforms,
+        first_samples,
+        samples,
+        first_row,
+        row_count,
+        colors,
+        statistics);
+    CHECK(band.total_samples() == 0);
+
+    for (size_t i{}; i != colors.size(); ++i)
+    {
+        INFO("pixel " << i);
+        glm::vec4 const& pixel{
+            accumulated.image()[size_t{first_row} * extent.width + i]};
+
+        CHECK(colors[i] / cppext::as_fp(samples) == pixel);
+        CHECK(statistics[i].z == cppext::as_fp(samples));
+        CHECK_THAT(statistics[i].x,
+            Catch::Matchers::WithinAbs(luminance(pixel), 1e-4));
+    }
+}
+
+TEST_CASE("cpu_tracer converges to the image of the GPU raytracer",
+    "[beam][cpu_tracer][gpu]")
+{
+    constexpr uint32_t samples_per_frame{4};
+    constexpr uint32_t frames{16};
+
+    std::unique_ptr<beam::offline_renderer> offline;
+    try
+    {
+        offline = std::make_unique<beam::offline_renderer>(extent, false);
+    }
+    catch (std::exception const& e)
+    {
+        SKIP("No usable Vulkan device: " << e.what());
+    }
+
+    beam::raytracer& tracer{offline->tracer()};
+    tracer.generate_scene(scene_seed, scene_extent);
+    offline->set_camera({13.0f, 2.0f, 3.0f}, {-167.0f, -3.0f});
+    tracer.set_sampling(samples_per_frame, 5);
+
+    // Both trace the same scene with the same uniforms, sample sequences
+    // match and paths only differ by rounding. Uniforms are taken after
+    // every frame, anything the frame updated in them is followed.
+    beam::cpu_tracer cpu{tracer.current_scene(), extent};
+    for (uint32_t i{}; i != frames; ++i)
+    {
+        offline->trace_frame();
+        cpu.trace(tracer.current_frame_uniforms(), samples_per_frame);
+    }
+
+    std::vector<glm::vec4> const gpu{offline->read_back()};
+    REQUIRE(gpu.size() == cpu.image().size());
+
+    std::vector<double> const gpu_tiles{tile_means(gpu)};
+    std::vector<double> const cpu_tiles{tile_means(cpu.image())};
+
+    double gpu_mean{};
+    double cpu_mean{};
+    for (size_t i{}; i != gpu_tiles.size(); ++i)
+    {
+        INFO("tile " << i);
+        CHECK_THAT(cpu_tiles[i],
+            Catch::Matchers::WithinRel(gpu_tiles[i], 0.05) ||
+                Catch::Matchers::WithinAbs(gpu_tiles[i], 0.01));
+
+        gpu_mean += gpu_tiles[i];
+        cpu_mean += cpu_tiles[i];
+    }
+
+    CHECK_THAT(cpu_mean, Catch::Matchers::WithinRel(gpu_mean, 0.02));
+}
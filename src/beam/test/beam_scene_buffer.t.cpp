@@ -0,0 +1,57 @@
+#include <scene_buffer.hpp>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+TEST_CASE("coalesce_ranges", "[beam][scene_buffer]")
+{
+    using ranges = std::vector<std::pair<size_t, size_t>>;
+
+    CHECK(beam::coalesce_ranges({}, 256).empty());
+
+    SECTION("ranges are sorted")
+    {
+        CHECK(beam::coalesce_ranges({{2000, 2010}, {0, 16}, {1000, 1004}},
+                  256) == ranges{{0, 16}, {1000, 1004}, {2000, 2010}});
+    }
+
+    SECTION("overlapping and contained ranges are merged")
+    {
+        CHECK(beam::coalesce_ranges({{0, 64}, {32, 96}, {40, 48}}, 0) ==
+            ranges{{0, 96}});
+    }
+
+    SECTION("ranges within the gap are merged")
+    {
+        CHECK(beam::coalesce_ranges({{0, 16}, {272, 288}}, 256) ==
+            ranges{{0, 288}});
+        CHECK(beam::coalesce_ranges({{0, 16}, {273, 288}}, 256) ==
+            ranges{{0, 16}, {273, 288}});
+    }
+
+    SECTION("adjacent ranges are merged without a gap")
+    {
+        CHECK(beam::coalesce_ranges({{16, 32}, {0, 16}}, 0) ==
+            ranges{{0, 32}});
+    }
+
+    SECTION("repeated writes of one element upload it once")
+    {
+        ranges const writes(10, {48, 64});
+        CHECK(beam::coalesce_ranges(writes, 256) == ranges{{48, 64}});
+    }
+
+    SECTION("chains merge transitively")
+    {
+        ranges writes;
+        for (size_t i{}; i != 8; ++i)
+        {
+            writes.emplace_back(i * 280, i * 280 + 32);
+        }
+        CHECK(beam::coalesce_ranges(writes, 256) == ranges{{0, 1992}});
+        CHECK(beam::coalesce_ranges(writes, 200).size() == writes.size());
+    }
+}
@@ -0,0 +1,232 @@
+#include <bvh.hpp>
+#include <mesh.hpp>
+#include <scene_file.hpp>
+#include <sphere.hpp>
+
+#include <cppext_numeric.hpp>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+    // Layout of scene_file.cpp, a 32 byte header followed by the section
+    // table of 32 byte entries
+    constexpr size_t header_size{32};
+    constexpr size_t table_entry_size{32};
+    constexpr size_t offset_field{8};
+
+    constexpr size_t sphere_materials_section{1};
+    constexpr size_t materials_section{2};
+    constexpr size_t nodes_section{3};
+    constexpr size_t lights_section{5};
+
+    [[nodiscard]] std::vector<char> read_file(
+        std::filesystem::path const& path)
+    {
+        std::ifstream stream{path, std::ios::binary};
+        return {std::istreambuf_iterator<char>{stream},
+            std::istreambuf_iterator<char>{}};
+    }
+
+    void write_file(std::filesystem::path const& path,
+        std::span<char const> const bytes)
+    {
+        std::ofstream stream{path, std::ios::binary | std::ios::trunc};
+        stream.write(bytes.data(), std::ssize(bytes));
+    }
+
+    template<typename T>
+    void write_value(std::vector<char>& bytes,
+        size_t const offset,
+        T const& value)
+    {
+        REQUIRE(offset + sizeof(T) <= bytes.size());
+        std::memcpy(
+            std::next(bytes.data(), cppext::narrow<std::ptrdiff_t>(offset)),
+            &value,
+            sizeof(T));
+    }
+
+    [[nodiscard]] size_t section_offset(std::vector<char> const& bytes,
+        size_t const section)
+    {
+        uint64_t rv{};
+        std::memcpy(&rv,
+            std::next(bytes.data(),
+                cppext::narrow<std::ptrdiff_t>(
+                    header_size + section * table_entry_size + offset_field)),
+            sizeof(rv));
+        return cppext::narrow<size_t>(rv);
+    }
+
+    [[nodiscard]] size_t element_offset(std::vector<char> const& bytes,
+        size_t const section,
+        size_t const element_size,
+        size_t const index)
+    {
+        return section_offset(bytes, section) + index * element_size;
+    }
+
+    template<typename T>
+    [[nodiscard]] bool same_bytes(std::span<T const> const a,
+        std::span<T const> const b)
+    {
+        return std::ranges::equal(std::as_bytes(a), std::as_bytes(b));
+    }
+} // namespace
+
+TEST_CASE("scene_file", "[beam][scene_file]")
+{
+    beam::procedural_scene const spheres{
+        beam::generate_procedural_scene(3, 2, true)};
+    beam::scene_data const scene{
+        beam::build_scene(spheres.spheres, spheres.materials, beam::mesh{})};
+    REQUIRE(!scene.lights.empty());
+
+    std::filesystem::path const directory{
+        std::filesystem::temp_directory_path()};
+    std::filesystem::path const valid_path{directory / "beam_test_valid.beam"};
+    std::filesystem::path const path{directory / "beam_test_corrupt.beam"};
+
+    beam::write_scene_file(valid_path, scene.view());
+    std::vector<char> const valid{read_file(valid_path)};
+    REQUIRE(valid.size() > header_size + 6 * table_entry_size);
+
+    auto const load_modified = [&](auto const& modify)
+    {
+        std::vector<char> bytes{valid};
+        modify(bytes);
+        write_file(path, bytes);
+        beam::scene_file const file{path};
+    };
+
+    SECTION("contents are read back")
+    {
+        beam::scene_file const file{valid_path};
+        beam::scene_view const& view{file.view()};
+        CHECK(same_bytes(view.center_radius, std::span{scene.center_radius}));
+        CHECK(same_bytes(view.sphere_materials,
+            std::span{scene.sphere_materials}));
+        CHECK(same_bytes(view.materials, std::span{scene.materials}));
+        CHECK(same_bytes(view.nodes, std::span{scene.nodes}));
+        CHECK(view.triangles.empty());
+        CHECK(same_bytes(view.lights, std::span{scene.lights}));
+        CHECK(view.triangle_root == scene.triangle_root);
+    }
+
+    SECTION("unmodified copy loads")
+    {
+        CHECK_NOTHROW(load_modified([](std::vector<char>&) { }));
+    }
+
+    SECTION("wrong magic")
+    {
+        auto const modify = [](std::vector<char>& b) { b[0] = 'X'; };
+        CHECK_THROWS_AS(load_modified(modify), std::runtime_error);
+    }
+
+    SECTION("truncated file")
+    {
+        auto const table = [](std::vector<char>& b)
+        { b.resize(header_size + 3 * table_entry_size); };
+        CHECK_THROWS_AS(load_modified(table), std::runtime_error);
+
+        auto const section = [](std::vector<char>& b)
+        { b.resize(b.size() - 32); };
+        CHECK_THROWS_AS(load_modified(section), std::runtime_error);
+    }
+
+    SECTION("section table out of order")
+    {
+        auto const modify = [](std::vector<char>& b)
+        { write_value(b, header_size, uint32_t{5}); };
+        CHECK_THROWS_AS(load_modified(modify), std::runtime_error);
+    }
+
+    SECTION("unknown material type")
+    {
+        auto const modify = [](std::vector<char>& b)
+        {
+            size_t const offset{element_offset(b,
+                materials_section,
+                sizeof(beam::packed_material),
+                0)};
+            write_value(b,
+                offset + offsetof(beam::packed_material, value_type),
+                beam::material_type_count << 16u);
+        };
+        CHECK_THROWS_AS(load_modified(modify), std::runtime_error);
+    }
+
+    SECTION("sphere material outside of the materials")
+    {
+        auto const modify = [&](std::vector<char>& b)
+        {
+            write_value(b,
+                section_offset(b, sphere_materials_section),
+                cppext::narrow<uint32_t>(scene.materials.size()));
+        };
+        CHECK_THROWS_AS(load_modified(modify), std::runtime_error);
+    }
+
+    SECTION("light outside of the spheres")
+    {
+        auto const modify = [&](std::vector<char>& b)
+        {
+            write_value(b,
+                section_offset(b, lights_section),
+                cppext::narrow<uint32_t>(scene.center_radius.size()));
+        };
+        CHECK_THROWS_AS(load_modified(modify), std::runtime_error);
+    }
+
+    SECTION("node reached twice")
+    {
+        // First child of the root points back at the root
+        REQUIRE(scene.nodes.front().count == 0);
+        uint32_t const child{scene.nodes.front().left_first};
+        auto const modify = [&](std::vector<char>& b)
+        {
+            beam::bvh_node node{scene.nodes[child]};
+            node.left_first = 0;
+            node.count = 0;
+            write_value(b,
+                element_offset(b, nodes_section, sizeof(node), child),
+                node);
+        };
+        CHECK_THROWS_AS(load_modified(modify), std::runtime_error);
+    }
+
+    SECTION("leaf range outside of the spheres")
+    {
+        auto const leaf{std::ranges::find_if(scene.nodes,
+            [](beam::bvh_node const& n) { return n.count != 0; })};
+        REQUIRE(leaf != scene.nodes.end());
+        auto const index{
+            cppext::narrow<size_t>(std::distance(scene.nodes.begin(), leaf))};
+        auto const modify = [&](std::vector<char>& b)
+        {
+            beam::bvh_node node{*leaf};
+            node.left_first =
+                cppext::narrow<uint32_t>(scene.center_radius.size());
+            write_value(b,
+                element_offset(b, nodes_section, sizeof(node), index),
+                node);
+        };
+        CHECK_THROWS_AS(load_modified(modify), std::runtime_error);
+    }
+
+    std::filesystem::remove(valid_path);
+    std::filesystem::remove(path);
+}
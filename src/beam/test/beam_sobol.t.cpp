@@ -0,0 +1,187 @@
+#include <sobol.hpp>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <set>
+#include <vector>
+
+namespace
+{
+    [[nodiscard]] uint32_t reversed(uint32_t const x)
+    {
+        uint32_t rv{};
+        for (uint32_t bit{}; bit != 32; ++bit)
+        {
+            rv |= ((x >> bit) & 1u) << (31u - bit);
+        }
+        return rv;
+    }
+
+    // The first 2^bits points fall into different intervals of width 2^-bits
+    [[nodiscard]] bool stratified(uint32_t const scramble,
+        uint32_t const dimension,
+        uint32_t const bits)
+    {
+        std::set<uint32_t> strata;
+        for (uint32_t i{}; i != 1u << bits; ++i)
+        {
+            strata.insert(
+                beam::scrambled_sobol(scramble, i, dimension) >> (32u - bits));
+        }
+        return strata.size() == 1u << bits;
+    }
+
+    // The first 16 points of a pair of dimensions fall into different cells
+    // of a 4x4 grid
+    [[nodiscard]] bool stratified_pair(uint32_t const scramble,
+        uint32_t const dimension)
+    {
+        std::set<uint32_t> cells;
+        for (uint32_t i{}; i != 16; ++i)
+        {
+            uint32_t const x{
+                beam::scrambled_sobol(scramble, i, dimension) >> 30u};
+            uint32_t const y{
+                beam::scrambled_sobol(scramble, i, dimension + 1) >> 30u};
+            cells.insert(y * 4 + x);
+        }
+        return cells.size() == 16;
+    }
+} // namespace
+
+TEST_CASE("sobol", "[beam][sobol]")
+{
+    SECTION("first dimension is the van der Corput sequence")
+    {
+        for (uint32_t i{}; i != 1024; ++i)
+        {
+            CHECK(beam::sobol(i, 0) == reversed(i));
+        }
+    }
+
+    SECTION("first points of every dimension are stratified")
+    {
+        for (uint32_t dimension{}; dimension != 4; ++dimension)
+        {
+            std::set<uint32_t> strata;
+            for (uint32_t i{}; i != 256; ++i)
+            {
+                strata.insert(beam::sobol(i, dimension) >> 24u);
+            }
+            CHECK(strata.size() == 256);
+        }
+    }
+}
+
+TEST_CASE("nested_uniform_scramble", "[beam][sobol]")
+{
+    constexpr uint32_t seed{0x9e3779b9u};
+
+    SECTION("values sharing leading bits keep sharing them")
+    {
+        for (uint32_t x{}; x != 4096; x += 7)
+        {
+            uint32_t const a{x << 20u};
+            uint32_t const b{a | 0x000fffffu};
+            CHECK((beam::nested_uniform_scramble(a, seed) >> 20u) ==
+                (beam::nested_uniform_scramble(b, seed) >> 20u));
+        }
+    }
+
+    SECTION("leading bits are permuted")
+    {
+        std::set<uint32_t> leading;
+        for (uint32_t x{}; x != 256; ++x)
+        {
+            leading.insert(beam::nested_uniform_scramble(x << 24u, seed) >> 24u);
+        }
+        CHECK(leading.size() == 256);
+    }
+
+    SECTION("different seeds give different scrambles")
+    {
+        std::vector<uint32_t> first;
+        std::vector<uint32_t> second;
+        for (uint32_t x{}; x != 16; ++x)
+        {
+            first.push_back(beam::nested_uniform_scramble(x << 28u, seed));
+            second.push_back(beam::nested_uniform_scramble(x << 28u, seed + 1));
+        }
+        CHECK(first != second);
+    }
+}
+
+TEST_CASE("scrambled_sobol", "[beam][sobol]")
+{
+    uint32_t const scramble{beam::pixel_seed(3, 5, 7)};
+
+    SECTION("sequence is deterministic")
+    {
+        // Same bits as the shaders produce for the pixel, accumulated images
+        // of the host and device tracers depend on them
+        CHECK(scramble == 0xa01a70b3u);
+        CHECK(beam::hash_pcg(0) == 0x07bb2fe2u);
+        CHECK(beam::hash_pcg(1) == 0xa8beea3cu);
+
+        constexpr std::array<std::array<uint32_t, 4>, 6> expected{{
+            {0x438d35e0u, 0xfe095a91u, 0x9b98814du, 0x3d6d79f3u},
+            {0xbab17fa5u, 0x4b421360u, 0xc84b6933u, 0x195ac091u},
+            {0xfb15c42fu, 0x3847c0dau, 0xb6782575u, 0x47c4ca33u},
+            {0xb5738b2bu, 0x44976648u, 0xc782632eu, 0x15ac5d16u},
+            {0x27004f89u, 0x8461753cu, 0x796f46dbu, 0xc98e10ebu},
+            {0xe3f452efu, 0x20486e88u, 0x5806565fu, 0xae9b6ce3u},
+        }};
+        for (uint32_t dimension{}; dimension != expected.size(); ++dimension)
+        {
+            for (uint32_t i{}; i != expected[dimension].size(); ++i)
+            {
+                CHECK(beam::scrambled_sobol(scramble, i, dimension) ==
+                    expected[dimension][i]);
+            }
+        }
+    }
+
+    SECTION("pixels and sequence seeds have different scrambles")
+    {
+        std::set<uint32_t> seeds;
+        for (uint32_t y{}; y != 16; ++y)
+        {
+            for (uint32_t x{}; x != 16; ++x)
+            {
+                seeds.insert(beam::pixel_seed(x, y, 0));
+                seeds.insert(beam::pixel_seed(x, y, 1));
+            }
+        }
+        CHECK(seeds.size() == 2 * 16 * 16);
+    }
+
+    SECTION("padding dimensions are shuffled independently")
+    {
+        std::vector<uint32_t> first;
+        std::vector<uint32_t> padded;
+        for (uint32_t i{}; i != 16; ++i)
+        {
+            first.push_back(beam::scrambled_sobol(scramble, i, 0));
+            padded.push_back(beam::scrambled_sobol(scramble, i, 4));
+        }
+        CHECK(first != padded);
+    }
+
+    SECTION("scrambled points stay stratified")
+    {
+        for (uint32_t pixel{}; pixel != 8; ++pixel)
+        {
+            uint32_t const seed{beam::pixel_seed(pixel, 0, 0)};
+            for (uint32_t dimension{}; dimension != 8; ++dimension)
+            {
+                CHECK(stratified(seed, dimension, 8));
+            }
+            CHECK(stratified_pair(seed, 0));
+            CHECK(stratified_pair(seed, 2));
+            CHECK(stratified_pair(seed, 4));
+        }
+    }
+}
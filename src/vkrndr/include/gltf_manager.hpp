@@ -7,6 +7,7 @@
 #include <glm/gtc/quaternion.hpp> // IWYU pragma: keep
 #include <glm/mat4x4.hpp> // IWYU pragma: keep
 #include <glm/vec3.hpp> // IWYU pragma: keep
+#include <glm/vec4.hpp> // IWYU pragma: keep
 
 #include <cstdint>
 #include <filesystem>
@@ -48,6 +49,9 @@ namespace vkrndr
         uint32_t index{};
         gltf_texture* base_color_texture{};
         uint8_t base_color_coord_set{};
+        glm::fvec4 base_color_factor{1.0f};
+        float metallic_factor{1.0f};
+        float roughness_factor{1.0f};
     };
 
     struct [[nodiscard]] gltf_primitive final
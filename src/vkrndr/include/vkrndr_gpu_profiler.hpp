@@ -0,0 +1,122 @@
+#ifndef VKRNDR_GPU_PROFILER_INCLUDED
+#define VKRNDR_GPU_PROFILER_INCLUDED
+
+#include <cppext_cycled_buffer.hpp>
+
+#include <vulkan/vulkan_core.h>
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace vkrndr
+{
+    struct vulkan_device;
+} // namespace vkrndr
+
+namespace vkrndr
+{
+    struct [[nodiscard]] gpu_scope_timing final
+    {
+        std::string name;
+        // Scopes begun while this one was open are nested in it
+        uint32_t depth{};
+        // Smoothed over recent frames
+        float milliseconds{};
+        // Milliseconds of recent frames, oldest at the current index
+        cppext::cycled_buffer<float> history;
+        // Zero unless the scope collects pipeline statistics
+        uint64_t fragment_invocations{};
+        uint64_t compute_invocations{};
+    };
+
+    // Named scopes of a frame measured with timestamp queries and,
+    // if the device supports them, pipeline statistics queries. Every frame
+    // in flight has its own query pools. Results of a frame are read when
+    // its pools are reused, after the frame was waited for, so reading
+    // doesn't stall.
+    class [[nodiscard]] gpu_profiler final
+    {
+    public: // Construction
+        gpu_profiler(vulkan_device* device,
+            uint32_t frames_in_flight,
+            uint32_t max_scopes = 32);
+
+        gpu_profiler(gpu_profiler const&) = delete;
+
+        gpu_profiler(gpu_profiler&&) noexcept = delete;
+
+    public: // Destruction
+        ~gpu_profiler();
+
+    public: // Interface
+        // Recorded first in a frame, queries of the frame slot are reset
+        void begin_frame(VkCommandBuffer command_buffer);
+
+        // Scopes are matched by name with earlier frames. Pipeline
+        // statistics queries can't be nested, statistics of a scope begun
+        // inside of another collecting them are skipped. A scope is begun
+        // and ended in the same command buffer.
+        [[nodiscard]] uint32_t begin_scope(VkCommandBuffer command_buffer,
+            std::string_view name,
+            bool statistics = false);
+
+        void end_scope(VkCommandBuffer command_buffer, uint32_t scope);
+
+        // Recorded last in a frame, command buffers of the frame can be
+        // recorded in any order but this one has to be submitted last
+        void end_frame(VkCommandBuffer command_buffer);
+
+        [[nodiscard]] std::span<gpu_scope_timing const> timings() const;
+
+        // Time from the beginning to the end of the frame
+        [[nodiscard]] float frame_milliseconds() const;
+
+        void draw_imgui();
+
+    public: // Operators
+        gpu_profiler& operator=(gpu_profiler const&) = delete;
+
+        gpu_profiler& operator=(gpu_profiler&&) noexcept = delete;
+
+    private: // Types
+        struct [[nodiscard]] recorded_scope final
+        {
+            uint32_t timing{};
+            bool statistics{};
+        };
+
+        struct [[nodiscard]] frame_queries final
+        {
+            VkQueryPool timestamps{VK_NULL_HANDLE};
+            VkQueryPool statistics{VK_NULL_HANDLE};
+            std::vector<recorded_scope> scopes;
+            bool pending{};
+        };
+
+    private:
+        void read_results(frame_queries& queries);
+
+        [[nodiscard]] uint32_t find_timing(std::string_view name,
+            uint32_t depth);
+
+    private: // Data
+        vulkan_device* device_;
+        uint32_t max_scopes_;
+        float timestamp_period_;
+        bool statistics_supported_;
+
+        cppext::cycled_buffer<frame_queries> frames_;
+        bool recording_{};
+        uint32_t depth_{};
+        bool statistics_active_{};
+
+        std::vector<gpu_scope_timing> timings_;
+        float frame_milliseconds_{};
+        cppext::cycled_buffer<float> frame_history_;
+    };
+} // namespace vkrndr
+
+#endif // !VKRNDR_GPU_PROFILER_INCLUDED
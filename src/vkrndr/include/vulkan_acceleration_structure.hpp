@@ -0,0 +1,44 @@
+#ifndef VKRNDR_VULKAN_ACCELERATION_STRUCTURE_INCLUDED
+#define VKRNDR_VULKAN_ACCELERATION_STRUCTURE_INCLUDED
+
+#include <vulkan_buffer.hpp>
+
+#include <vulkan/vulkan_core.h>
+
+#include <cstdint>
+#include <span>
+
+namespace vkrndr
+{
+    struct vulkan_device;
+} // namespace vkrndr
+
+namespace vkrndr
+{
+    struct [[nodiscard]] vulkan_acceleration_structure final
+    {
+        VkAccelerationStructureKHR handle{VK_NULL_HANDLE};
+        VkDeviceAddress device_address{};
+        vulkan_buffer buffer;
+    };
+
+    void destroy(vulkan_device const* device,
+        vulkan_acceleration_structure* structure);
+
+    // Requires a device created with ray query support
+    [[nodiscard]] VkDeviceAddress device_address(vulkan_device const& device,
+        vulkan_buffer const& buffer);
+
+    // Creates the acceleration structure and records its build into the
+    // command buffer. Scratch buffer has to be kept alive until the command
+    // buffer completes execution.
+    [[nodiscard]] vulkan_acceleration_structure create_acceleration_structure(
+        vulkan_device const& device,
+        VkCommandBuffer command_buffer,
+        VkAccelerationStructureTypeKHR type,
+        std::span<VkAccelerationStructureGeometryKHR const> geometries,
+        std::span<uint32_t const> primitive_counts,
+        vulkan_buffer& scratch_buffer);
+} // namespace vkrndr
+
+#endif // !VKRNDR_VULKAN_ACCELERATION_STRUCTURE_INCLUDED
@@ -23,6 +23,12 @@ namespace vkrndr
         VkAccessFlags2 dst_access_mask,
         uint32_t mip_levels);
 
+    void memory_barrier(VkCommandBuffer command_buffer,
+        VkPipelineStageFlags2 src_stage_mask,
+        VkAccessFlags2 src_access_mask,
+        VkPipelineStageFlags2 dst_stage_mask,
+        VkAccessFlags2 dst_access_mask);
+
     void create_command_buffers(vkrndr::vulkan_device const& device,
         VkCommandPool command_pool,
         uint32_t count,
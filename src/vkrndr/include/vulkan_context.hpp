@@ -17,6 +17,8 @@ namespace vkrndr
         VkDebugUtilsMessengerEXT debug_messenger{VK_NULL_HANDLE};
     };
 
+    // Without a window no surface is created, devices are selected only by
+    // their compute support then
     vulkan_context create_context(vulkan_window const* window,
         bool setup_validation_layers);
 
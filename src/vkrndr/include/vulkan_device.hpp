@@ -7,6 +7,7 @@
 
 #include <vulkan/vulkan_core.h>
 
+#include <cstddef>
 #include <vector>
 
 namespace vkrndr
@@ -24,7 +25,24 @@ namespace vkrndr
         std::vector<vulkan_queue> queues;
         vulkan_queue* transfer_queue{nullptr};
         vulkan_queue* present_queue{nullptr};
+        // Queue of a dedicated compute family if there is one, otherwise
+        // the present queue. Shares the queue with transfers when they use
+        // the same family.
+        vulkan_queue* compute_queue{nullptr};
         VmaAllocator allocator{VK_NULL_HANDLE};
+        // VK_KHR_acceleration_structure and VK_KHR_ray_query are enabled,
+        // together with buffer device addresses they depend on
+        bool ray_query{false};
+        // Pipeline statistics queries can be created
+        bool pipeline_statistics{false};
+        // Used by all pipeline builders. Loaded from pipeline_cache.bin in
+        // the vkrndr directory of the per user cache directory when it was
+        // written for the same device and driver, saved back when the
+        // device is destroyed.
+        VkPipelineCache pipeline_cache{VK_NULL_HANDLE};
+        // Bytes of cache data the pipeline cache was created with, zero
+        // when nothing was loaded
+        size_t pipeline_cache_loaded{};
     };
 
     vulkan_device create_device(vulkan_context const& context);
@@ -6,6 +6,7 @@
 #include <vulkan/vulkan_core.h>
 
 #include <cstdint>
+#include <span>
 
 namespace vkrndr
 {
@@ -27,6 +28,8 @@ namespace vkrndr
 
     void destroy(vulkan_device const* device, vulkan_image* image);
 
+    // Images are shared concurrently between queue families when more than
+    // one is given, otherwise they are owned by one family at a time
     vulkan_image create_image(vulkan_device const& device,
         VkExtent2D extent,
         uint32_t mip_levels,
@@ -34,7 +37,8 @@ namespace vkrndr
         VkFormat format,
         VkImageTiling tiling,
         VkImageUsageFlags usage,
-        VkMemoryPropertyFlags properties);
+        VkMemoryPropertyFlags properties,
+        std::span<uint32_t const> queue_families = {});
 
     [[nodiscard]] VkImageView create_image_view(vulkan_device const& device,
         VkImage image,
@@ -50,7 +54,8 @@ namespace vkrndr
         VkImageTiling tiling,
         VkImageUsageFlags usage,
         VkMemoryPropertyFlags properties,
-        VkImageAspectFlags aspect_flags);
+        VkImageAspectFlags aspect_flags,
+        std::span<uint32_t const> queue_families = {});
 } // namespace vkrndr
 
 #endif
@@ -3,6 +3,7 @@
 
 #include <vulkan/vulkan_core.h>
 
+#include <cstddef>
 #include <cstdint>
 #include <filesystem>
 #include <memory>
@@ -32,6 +33,14 @@ namespace vkrndr
         uint32_t first_set,
         std::span<VkDescriptorSet const> descriptor_sets);
 
+    // Dynamic offsets are consumed in order of the dynamic descriptors in
+    // the bound sets
+    void bind_pipeline(VkCommandBuffer command_buffer,
+        vulkan_pipeline const& pipeline,
+        uint32_t first_set,
+        std::span<VkDescriptorSet const> descriptor_sets,
+        std::span<uint32_t const> dynamic_offsets);
+
     inline void bind_pipeline(VkCommandBuffer command_buffer,
         vulkan_pipeline const& pipeline)
     {
@@ -177,6 +186,16 @@ namespace vkrndr
             std::filesystem::path const& path,
             std::string_view entry_point);
 
+        // 32 bit specialization constant, e.g. a workgroup size
+        vulkan_compute_pipeline_builder& add_specialization_constant(
+            uint32_t constant_id,
+            uint32_t value);
+
+        // Entries and data are copied and appended to constants added
+        // before, the info doesn't have to outlive the call
+        vulkan_compute_pipeline_builder& with_specialization(
+            VkSpecializationInfo const& info);
+
     public: // Operators
         vulkan_compute_pipeline_builder& operator=(
             vulkan_compute_pipeline_builder const&) = delete;
@@ -192,6 +211,8 @@ namespace vkrndr
         std::shared_ptr<VkPipelineLayout> pipeline_layout_;
         VkShaderModule shader_module_{VK_NULL_HANDLE};
         std::string shader_entry_point_;
+        std::vector<VkSpecializationMapEntry> specialization_entries_;
+        std::vector<std::byte> specialization_data_;
     };
 } // namespace vkrndr
 
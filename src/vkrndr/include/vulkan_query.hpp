@@ -0,0 +1,26 @@
+#ifndef VKRNDR_VULKAN_QUERY_INCLUDED
+#define VKRNDR_VULKAN_QUERY_INCLUDED
+
+#include <vulkan/vulkan_core.h>
+
+#include <cstdint>
+
+namespace vkrndr
+{
+    struct vulkan_device;
+} // namespace vkrndr
+
+namespace vkrndr
+{
+    [[nodiscard]] VkQueryPool create_query_pool(vulkan_device const* device,
+        VkQueryType type,
+        uint32_t count,
+        VkQueryPipelineStatisticFlags statistics = 0);
+
+    // Nanoseconds per timestamp tick, zero if the queue family doesn't
+    // support timestamps
+    [[nodiscard]] float timestamp_period(vulkan_device const& device,
+        uint32_t queue_family);
+} // namespace vkrndr
+
+#endif // !VKRNDR_VULKAN_QUERY_INCLUDED
@@ -25,8 +25,12 @@ namespace vkrndr
 
     struct [[nodiscard]] queue_families final
     {
+        // First compute capable family when there is no surface
         std::optional<uint32_t> present_family;
         std::optional<uint32_t> dedicated_transfer_family;
+        // Compute family without graphics support, work submitted to it can
+        // run alongside the present queue
+        std::optional<uint32_t> dedicated_compute_family;
     };
 
     queue_families find_queue_families(VkPhysicalDevice physical_device,
@@ -23,6 +23,7 @@
 namespace vkrndr
 {
     class font_manager;
+    class gpu_profiler;
     class imgui_render_layer;
     struct vulkan_buffer;
     class scene;
@@ -36,6 +37,9 @@ namespace vkrndr
     class [[nodiscard]] vulkan_renderer final
     {
     public: // Construction
+        // Window is null for headless rendering. There is no swap chain and
+        // no ImGui layer then, frame functions and swap chain properties
+        // can't be used, work is submitted by the caller.
         vulkan_renderer(vulkan_window* window,
             render_settings const& settings,
             bool debug);
@@ -59,12 +63,25 @@ namespace vkrndr
 
         [[nodiscard]] uint32_t image_count() const;
 
+        // Frames recorded ahead of the GPU, resources written by the host
+        // every frame need this many copies
+        [[nodiscard]] uint32_t frames_in_flight() const;
+
         [[nodiscard]] VkExtent2D extent() const;
 
         [[nodiscard]] bool imgui_layer() const;
 
         void imgui_layer(bool state);
 
+        // Submission of the current frame waits for the semaphore, work of
+        // the scene submitted to other queues is handed off this way
+        void wait_semaphore(VkSemaphore semaphore, VkPipelineStageFlags stage);
+
+        // Profiler of the frames. Its frame is begun and ended by the
+        // renderer, scenes add their scopes. Scopes recorded outside of a
+        // frame, as in headless rendering, are ignored.
+        [[nodiscard]] gpu_profiler* profiler();
+
         [[nodiscard]] bool begin_frame(scene* scene);
 
         void end_frame();
@@ -134,10 +151,14 @@ namespace vkrndr
 
         bool imgui_layer_enabled_;
         std::unique_ptr<imgui_render_layer> imgui_layer_;
+        std::unique_ptr<gpu_profiler> profiler_;
         std::unique_ptr<font_manager> font_manager_;
         std::unique_ptr<gltf_manager> gltf_manager_;
 
         uint32_t image_index_{};
+
+        std::vector<VkSemaphore> wait_semaphores_;
+        std::vector<VkPipelineStageFlags> wait_stages_;
     };
 } // namespace vkrndr
 
@@ -279,13 +279,27 @@ namespace
         {
             vkrndr::gltf_material new_material;
 
-            tinygltf::TextureInfo const& texture{
-                material.pbrMetallicRoughness.baseColorTexture};
+            tinygltf::PbrMetallicRoughness const& pbr{
+                material.pbrMetallicRoughness};
 
-            new_material.base_color_texture =
-                &new_model.textures[size_cast(texture.index)];
-            new_material.base_color_coord_set =
-                cppext::narrow<uint8_t>(texture.texCoord);
+            tinygltf::TextureInfo const& texture{pbr.baseColorTexture};
+            if (texture.index >= 0)
+            {
+                new_material.base_color_texture =
+                    &new_model.textures[size_cast(texture.index)];
+                new_material.base_color_coord_set =
+                    cppext::narrow<uint8_t>(texture.texCoord);
+            }
+
+            if (pbr.baseColorFactor.size() == 4)
+            {
+                new_material.base_color_factor =
+                    glm::fvec4{glm::make_vec4(pbr.baseColorFactor.data())};
+            }
+            new_material.metallic_factor =
+                static_cast<float>(pbr.metallicFactor);
+            new_material.roughness_factor =
+                static_cast<float>(pbr.roughnessFactor);
 
             new_material.index =
                 cppext::narrow<uint32_t>(new_model.materials.size());
@@ -350,7 +364,9 @@ std::unique_ptr<vkrndr::gltf_model> vkrndr::gltf_manager::load(
             {
                 gltf_primitive new_primitive{
                     .vertices = load_vertices(model, primitive),
-                    .indices = load_indices(model, primitive),
+                    .indices = primitive.indices >= 0
+                        ? load_indices(model, primitive)
+                        : std::vector<uint32_t>{},
                     .bounding_box = load_bounding_box(model, primitive),
                     .material = primitive.material >= 0
                         ? &rv->materials[size_cast(primitive.material)]
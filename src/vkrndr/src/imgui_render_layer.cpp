@@ -1,5 +1,6 @@
 #include <imgui_render_layer.hpp>
 
+#include <vkrndr_gpu_profiler.hpp>
 #include <vulkan_commands.hpp>
 #include <vulkan_context.hpp>
 #include <vulkan_device.hpp>
@@ -15,6 +16,7 @@
 #include <spdlog/spdlog.h>
 
 #include <cassert>
+#include <cstdint>
 #include <utility>
 
 // IWYU pragma: no_include <span>
@@ -123,12 +125,15 @@ void vkrndr::imgui_render_layer::begin_frame()
 void vkrndr::imgui_render_layer::draw(VkCommandBuffer command_buffer,
     VkImage target_image,
     VkImageView target_image_view,
-    VkExtent2D extent)
+    VkExtent2D extent,
+    gpu_profiler* const profiler)
 {
     VkCommandBufferBeginInfo begin_info{};
     begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
     check_result(vkBeginCommandBuffer(command_buffer, &begin_info));
 
+    uint32_t const scope{profiler->begin_scope(command_buffer, "ImGui")};
+
     VkRenderingAttachmentInfo color_attachment_info{};
 
     color_attachment_info.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
@@ -157,6 +162,9 @@ void vkrndr::imgui_render_layer::draw(VkCommandBuffer command_buffer,
 
     transition_to_present_layout(target_image, command_buffer);
 
+    profiler->end_scope(command_buffer, scope);
+    profiler->end_frame(command_buffer);
+
     check_result(vkEndCommandBuffer(command_buffer));
 }
 
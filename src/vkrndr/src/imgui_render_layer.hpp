@@ -5,6 +5,7 @@
 
 namespace vkrndr
 {
+    class gpu_profiler;
     class vulkan_window;
     struct vulkan_device;
     struct vulkan_context;
@@ -31,10 +32,13 @@ namespace vkrndr
     public: // Interface
         void begin_frame();
 
+        // Recorded commands are the last ones of the frame, the profiler
+        // frame is ended with them
         void draw(VkCommandBuffer command_buffer,
             VkImage target_image,
             VkImageView target_image_view,
-            VkExtent2D extent);
+            VkExtent2D extent,
+            gpu_profiler* profiler);
 
         void end_frame();
 
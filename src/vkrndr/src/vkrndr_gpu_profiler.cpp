@@ -0,0 +1,364 @@
+#include <vkrndr_gpu_profiler.hpp>
+
+#include <vulkan_device.hpp>
+#include <vulkan_query.hpp>
+#include <vulkan_queue.hpp>
+#include <vulkan_utility.hpp>
+
+#include <cppext_cycled_buffer.hpp>
+#include <cppext_numeric.hpp>
+
+#include <imgui.h>
+
+#include <vulkan/vulkan_core.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace
+{
+    // Timestamps of the frame beginning and end precede the scope ones
+    constexpr uint32_t frame_timestamps{2};
+
+    constexpr uint32_t invalid_scope{std::numeric_limits<uint32_t>::max()};
+
+    constexpr VkQueryPipelineStatisticFlags statistics_flags{
+        VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT |
+        VK_QUERY_PIPELINE_STATISTIC_COMPUTE_SHADER_INVOCATIONS_BIT};
+
+    constexpr size_t history_length{120};
+
+    constexpr float smoothing{0.1f};
+
+    [[nodiscard]] uint32_t timestamp_query(uint32_t const scope)
+    {
+        return frame_timestamps + 2 * scope;
+    }
+
+    void add_sample(float& smoothed,
+        cppext::cycled_buffer<float>& history,
+        float const milliseconds)
+    {
+        smoothed = smoothed > 0.0f
+            ? std::lerp(smoothed, milliseconds, smoothing)
+            : milliseconds;
+        *history = milliseconds;
+        history.cycle();
+    }
+} // namespace
+
+vkrndr::gpu_profiler::gpu_profiler(vulkan_device* const device,
+    uint32_t const frames_in_flight,
+    uint32_t const max_scopes)
+    : device_{device}
+    , max_scopes_{max_scopes}
+    , timestamp_period_{
+          timestamp_period(*device_, device_->present_queue->family)}
+    , statistics_supported_{device_->pipeline_statistics}
+    , frames_{frames_in_flight, frames_in_flight}
+    , frame_history_{history_length, history_length}
+{
+    if (timestamp_period_ == 0.0f)
+    {
+        return;
+    }
+
+    for (frame_queries& queries : frames_.as_span())
+    {
+        queries.timestamps = create_query_pool(device_,
+            VK_QUERY_TYPE_TIMESTAMP,
+            timestamp_query(max_scopes_));
+        if (statistics_supported_)
+        {
+            queries.statistics = create_query_pool(device_,
+                VK_QUERY_TYPE_PIPELINE_STATISTICS,
+                max_scopes_,
+                statistics_flags);
+        }
+        queries.scopes.reserve(max_scopes_);
+    }
+}
+
+vkrndr::gpu_profiler::~gpu_profiler()
+{
+    for (frame_queries const& queries : frames_.as_span())
+    {
+        vkDestroyQueryPool(device_->logical, queries.statistics, nullptr);
+        vkDestroyQueryPool(device_->logical, queries.timestamps, nullptr);
+    }
+}
+
+void vkrndr::gpu_profiler::begin_frame(VkCommandBuffer command_buffer)
+{
+    frame_queries& queries{*frames_};
+    if (queries.timestamps == VK_NULL_HANDLE)
+    {
+        return;
+    }
+
+    if (queries.pending)
+    {
+        read_results(queries);
+    }
+
+    queries.scopes.clear();
+    queries.pending = false;
+
+    vkCmdResetQueryPool(command_buffer,
+        queries.timestamps,
+        0,
+        timestamp_query(max_scopes_));
+    if (queries.statistics != VK_NULL_HANDLE)
+    {
+        vkCmdResetQueryPool(command_buffer,
+            queries.statistics,
+            0,
+            max_scopes_);
+    }
+
+    vkCmdWriteTimestamp2(command_buffer,
+        VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+        queries.timestamps,
+        0);
+
+    recording_ = true;
+    depth_ = 0;
+    statistics_active_ = false;
+}
+
+uint32_t vkrndr::gpu_profiler::begin_scope(VkCommandBuffer command_buffer,
+    std::string_view const name,
+    bool const statistics)
+{
+    frame_queries& queries{*frames_};
+    if (!recording_ || queries.scopes.size() == max_scopes_)
+    {
+        return invalid_scope;
+    }
+
+    auto const scope{cppext::narrow<uint32_t>(queries.scopes.size())};
+    recorded_scope& recorded{queries.scopes.emplace_back(
+        find_timing(name, depth_),
+        statistics && queries.statistics != VK_NULL_HANDLE &&
+            !statistics_active_)};
+    ++depth_;
+
+    vkCmdWriteTimestamp2(command_buffer,
+        VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+        queries.timestamps,
+        timestamp_query(scope));
+
+    if (recorded.statistics)
+    {
+        vkCmdBeginQuery(command_buffer, queries.statistics, scope, 0);
+        statistics_active_ = true;
+    }
+
+    return scope;
+}
+
+void vkrndr::gpu_profiler::end_scope(VkCommandBuffer command_buffer,
+    uint32_t const scope)
+{
+    if (scope == invalid_scope)
+    {
+        return;
+    }
+
+    frame_queries const& queries{*frames_};
+
+    if (queries.scopes[scope].statistics)
+    {
+        vkCmdEndQuery(command_buffer, queries.statistics, scope);
+        statistics_active_ = false;
+    }
+
+    vkCmdWriteTimestamp2(command_buffer,
+        VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+        queries.timestamps,
+        timestamp_query(scope) + 1);
+    --depth_;
+}
+
+void vkrndr::gpu_profiler::end_frame(VkCommandBuffer command_buffer)
+{
+    if (!recording_)
+    {
+        return;
+    }
+
+    vkCmdWriteTimestamp2(command_buffer,
+        VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+        frames_->timestamps,
+        1);
+
+    frames_->pending = true;
+    frames_.cycle();
+    recording_ = false;
+}
+
+std::span<vkrndr::gpu_scope_timing const>
+vkrndr::gpu_profiler::timings() const
+{
+    return timings_;
+}
+
+float vkrndr::gpu_profiler::frame_milliseconds() const
+{
+    return frame_milliseconds_;
+}
+
+void vkrndr::gpu_profiler::draw_imgui()
+{
+    ImGui::Begin("GPU profiler");
+
+    if (timestamp_period_ == 0.0f)
+    {
+        ImGui::TextUnformatted("Timestamps aren't supported");
+        ImGui::End();
+        return;
+    }
+
+    ImGui::Text("Frame: %.3f ms",
+        cppext::as_fp<double>(frame_milliseconds_));
+    ImGui::PlotLines("##frame",
+        frame_history_.data(),
+        cppext::narrow<int>(history_length),
+        cppext::narrow<int>(frame_history_.index()),
+        nullptr,
+        0.0f,
+        std::numeric_limits<float>::max(),
+        ImVec2{0.0f, 40.0f});
+
+    if (ImGui::BeginTable("Scopes", 3))
+    {
+        ImGui::TableSetupColumn("Scope");
+        ImGui::TableSetupColumn("ms");
+        ImGui::TableSetupColumn("Invocations");
+        ImGui::TableHeadersRow();
+
+        for (gpu_scope_timing const& timing : timings_)
+        {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            // Zero indent is the default spacing of ImGui
+            float const indent{cppext::as_fp(timing.depth) * 8.0f};
+            if (indent > 0.0f)
+            {
+                ImGui::Indent(indent);
+            }
+            ImGui::TextUnformatted(timing.name.c_str());
+            if (indent > 0.0f)
+            {
+                ImGui::Unindent(indent);
+            }
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", cppext::as_fp<double>(timing.milliseconds));
+            ImGui::TableNextColumn();
+            if (timing.compute_invocations != 0)
+            {
+                ImGui::Text("%llu cs",
+                    static_cast<unsigned long long>(
+                        timing.compute_invocations));
+            }
+            else if (timing.fragment_invocations != 0)
+            {
+                ImGui::Text("%llu fs",
+                    static_cast<unsigned long long>(
+                        timing.fragment_invocations));
+            }
+        }
+        ImGui::EndTable();
+    }
+
+    ImGui::End();
+}
+
+void vkrndr::gpu_profiler::read_results(frame_queries& queries)
+{
+    uint32_t const query_count{timestamp_query(
+        cppext::narrow<uint32_t>(queries.scopes.size()))};
+
+    std::vector<uint64_t> timestamps(query_count);
+    VkResult const result{vkGetQueryPoolResults(device_->logical,
+        queries.timestamps,
+        0,
+        query_count,
+        timestamps.size() * sizeof(uint64_t),
+        timestamps.data(),
+        sizeof(uint64_t),
+        VK_QUERY_RESULT_64_BIT)};
+    // Frame fence was waited for before its slot is reused, results are
+    // only missing when a frame was abandoned
+    if (result == VK_NOT_READY)
+    {
+        return;
+    }
+    check_result(result);
+
+    auto const to_milliseconds = [this](uint64_t const begin,
+                                     uint64_t const end)
+    {
+        return cppext::as_fp(end - begin) * timestamp_period_ / 1e6f;
+    };
+
+    add_sample(frame_milliseconds_,
+        frame_history_,
+        to_milliseconds(timestamps[0], timestamps[1]));
+
+    for (uint32_t scope{}; recorded_scope const& recorded : queries.scopes)
+    {
+        gpu_scope_timing& timing{timings_[recorded.timing]};
+
+        uint32_t const query{timestamp_query(scope)};
+        add_sample(timing.milliseconds,
+            timing.history,
+            to_milliseconds(timestamps[query], timestamps[query + 1]));
+
+        if (recorded.statistics)
+        {
+            // Values are ordered by statistic bits
+            std::array<uint64_t, 2> statistics{};
+            check_result(vkGetQueryPoolResults(device_->logical,
+                queries.statistics,
+                scope,
+                1,
+                sizeof(statistics),
+                statistics.data(),
+                sizeof(statistics),
+                VK_QUERY_RESULT_64_BIT));
+            timing.fragment_invocations = statistics[0];
+            timing.compute_invocations = statistics[1];
+        }
+
+        ++scope;
+    }
+}
+
+uint32_t vkrndr::gpu_profiler::find_timing(std::string_view const name,
+    uint32_t const depth)
+{
+    auto const it{std::ranges::find(timings_, name, &gpu_scope_timing::name)};
+    if (it != timings_.cend())
+    {
+        it->depth = depth;
+        return cppext::narrow<uint32_t>(std::distance(timings_.begin(), it));
+    }
+
+    timings_.push_back({.name = std::string{name},
+        .depth = depth,
+        .milliseconds = 0.0f,
+        .history = cppext::cycled_buffer<float>{history_length,
+            history_length},
+        .fragment_invocations = 0,
+        .compute_invocations = 0});
+    return cppext::narrow<uint32_t>(timings_.size() - 1);
+}
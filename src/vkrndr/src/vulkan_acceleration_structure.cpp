@@ -0,0 +1,163 @@
+#include <vulkan_acceleration_structure.hpp>
+
+#include <vulkan_buffer.hpp>
+#include <vulkan_device.hpp>
+#include <vulkan_utility.hpp>
+
+#include <cassert>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace
+{
+    // Extension entry points aren't exported by the loader
+    template<typename T>
+    [[nodiscard]] T load_function(VkDevice const device, char const* const name)
+    {
+        // NOLINTNEXTLINE
+        auto const rv{reinterpret_cast<T>(vkGetDeviceProcAddr(device, name))};
+        assert(rv);
+        return rv;
+    }
+
+    [[nodiscard]] VkDeviceSize scratch_alignment(
+        vkrndr::vulkan_device const& device)
+    {
+        VkPhysicalDeviceAccelerationStructurePropertiesKHR
+            acceleration_structure_properties{};
+        acceleration_structure_properties.sType =
+            VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ACCELERATION_STRUCTURE_PROPERTIES_KHR;
+
+        VkPhysicalDeviceProperties2 properties{};
+        properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+        properties.pNext = &acceleration_structure_properties;
+        vkGetPhysicalDeviceProperties2(device.physical, &properties);
+
+        return acceleration_structure_properties
+            .minAccelerationStructureScratchOffsetAlignment;
+    }
+} // namespace
+
+void vkrndr::destroy(vulkan_device const* const device,
+    vulkan_acceleration_structure* const structure)
+{
+    if (structure)
+    {
+        if (structure->handle != VK_NULL_HANDLE)
+        {
+            load_function<PFN_vkDestroyAccelerationStructureKHR>(
+                device->logical,
+                "vkDestroyAccelerationStructureKHR")(device->logical,
+                structure->handle,
+                nullptr);
+        }
+        destroy(device, &structure->buffer);
+    }
+}
+
+VkDeviceAddress vkrndr::device_address(vulkan_device const& device,
+    vulkan_buffer const& buffer)
+{
+    VkBufferDeviceAddressInfo info{};
+    info.sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO;
+    info.buffer = buffer.buffer;
+
+    return vkGetBufferDeviceAddress(device.logical, &info);
+}
+
+vkrndr::vulkan_acceleration_structure
+vkrndr::create_acceleration_structure(vulkan_device const& device,
+    VkCommandBuffer const command_buffer,
+    VkAccelerationStructureTypeKHR const type,
+    std::span<VkAccelerationStructureGeometryKHR const> const geometries,
+    std::span<uint32_t const> const primitive_counts,
+    vulkan_buffer& scratch_buffer)
+{
+    assert(geometries.size() == primitive_counts.size());
+
+    VkAccelerationStructureBuildGeometryInfoKHR build_info{};
+    build_info.sType =
+        VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_BUILD_GEOMETRY_INFO_KHR;
+    build_info.type = type;
+    build_info.flags =
+        VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_TRACE_BIT_KHR;
+    build_info.mode = VK_BUILD_ACCELERATION_STRUCTURE_MODE_BUILD_KHR;
+    build_info.geometryCount = count_cast(geometries.size());
+    build_info.pGeometries = geometries.data();
+
+    VkAccelerationStructureBuildSizesInfoKHR sizes{};
+    sizes.sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_BUILD_SIZES_INFO_KHR;
+    load_function<PFN_vkGetAccelerationStructureBuildSizesKHR>(device.logical,
+        "vkGetAccelerationStructureBuildSizesKHR")(device.logical,
+        VK_ACCELERATION_STRUCTURE_BUILD_TYPE_DEVICE_KHR,
+        &build_info,
+        primitive_counts.data(),
+        &sizes);
+
+    vulkan_acceleration_structure rv;
+    rv.buffer = create_buffer(device,
+        sizes.accelerationStructureSize,
+        VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_STORAGE_BIT_KHR |
+            VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+    VkAccelerationStructureCreateInfoKHR create_info{};
+    create_info.sType =
+        VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_CREATE_INFO_KHR;
+    create_info.buffer = rv.buffer.buffer;
+    create_info.size = sizes.accelerationStructureSize;
+    create_info.type = type;
+    check_result(load_function<PFN_vkCreateAccelerationStructureKHR>(
+        device.logical,
+        "vkCreateAccelerationStructureKHR")(device.logical,
+        &create_info,
+        nullptr,
+        &rv.handle));
+
+    // Allocation alignment isn't guaranteed to satisfy the scratch offset
+    // alignment, over allocate and align the address instead
+    VkDeviceSize const alignment{scratch_alignment(device)};
+    scratch_buffer = create_buffer(device,
+        sizes.buildScratchSize + alignment,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+            VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    VkDeviceAddress const scratch_address{
+        device_address(device, scratch_buffer)};
+
+    build_info.dstAccelerationStructure = rv.handle;
+    build_info.scratchData.deviceAddress = alignment == 0
+        ? scratch_address
+        : (scratch_address + alignment - 1) / alignment * alignment;
+
+    std::vector<VkAccelerationStructureBuildRangeInfoKHR> ranges;
+    ranges.reserve(primitive_counts.size());
+    for (uint32_t const count : primitive_counts)
+    {
+        ranges.push_back({.primitiveCount = count,
+            .primitiveOffset = 0,
+            .firstVertex = 0,
+            .transformOffset = 0});
+    }
+    VkAccelerationStructureBuildRangeInfoKHR const* const range_infos{
+        ranges.data()};
+
+    load_function<PFN_vkCmdBuildAccelerationStructuresKHR>(device.logical,
+        "vkCmdBuildAccelerationStructuresKHR")(command_buffer,
+        1,
+        &build_info,
+        &range_infos);
+
+    VkAccelerationStructureDeviceAddressInfoKHR address_info{};
+    address_info.sType =
+        VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_DEVICE_ADDRESS_INFO_KHR;
+    address_info.accelerationStructure = rv.handle;
+    rv.device_address =
+        load_function<PFN_vkGetAccelerationStructureDeviceAddressKHR>(
+            device.logical,
+            "vkGetAccelerationStructureDeviceAddressKHR")(device.logical,
+            &address_info);
+
+    return rv;
+}
@@ -44,6 +44,27 @@ void vkrndr::transition_image(VkImage const image,
     vkCmdPipelineBarrier2(command_buffer, &dependency);
 }
 
+void vkrndr::memory_barrier(VkCommandBuffer const command_buffer,
+    VkPipelineStageFlags2 const src_stage_mask,
+    VkAccessFlags2 const src_access_mask,
+    VkPipelineStageFlags2 const dst_stage_mask,
+    VkAccessFlags2 const dst_access_mask)
+{
+    VkMemoryBarrier2 barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2;
+    barrier.srcStageMask = src_stage_mask;
+    barrier.srcAccessMask = src_access_mask;
+    barrier.dstStageMask = dst_stage_mask;
+    barrier.dstAccessMask = dst_access_mask;
+
+    VkDependencyInfo dependency{};
+    dependency.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+    dependency.memoryBarrierCount = 1;
+    dependency.pMemoryBarriers = &barrier;
+
+    vkCmdPipelineBarrier2(command_buffer, &dependency);
+}
+
 void vkrndr::create_command_buffers(vulkan_device const& device,
     VkCommandPool const command_pool,
     uint32_t const count,
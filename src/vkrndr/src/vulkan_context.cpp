@@ -166,7 +166,11 @@ vkrndr::vulkan_context vkrndr::create_context(
     create_info.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
     create_info.pApplicationInfo = &app_info;
 
-    std::vector<char const*> required_extensions{window->required_extensions()};
+    std::vector<char const*> required_extensions;
+    if (window)
+    {
+        required_extensions = window->required_extensions();
+    }
 
     bool has_debug_utils_extension{setup_validation_layers};
     VkDebugUtilsMessengerCreateInfoEXT debug_create_info;
@@ -200,7 +204,10 @@ vkrndr::vulkan_context vkrndr::create_context(
         check_result(create_debug_messenger(rv.instance, rv.debug_messenger));
     }
 
-    check_result(window->create_surface(rv.instance, rv.surface));
+    if (window)
+    {
+        check_result(window->create_surface(rv.instance, rv.surface));
+    }
 
     return rv;
 }
@@ -209,7 +216,10 @@ void vkrndr::destroy(vulkan_context* const context)
 {
     if (context)
     {
-        vkDestroySurfaceKHR(context->instance, context->surface, nullptr);
+        if (context->surface != VK_NULL_HANDLE)
+        {
+            vkDestroySurfaceKHR(context->instance, context->surface, nullptr);
+        }
 
         destroy_debug_utils_messenger_ext(context->instance,
             context->debug_messenger,
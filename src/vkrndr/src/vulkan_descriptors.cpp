@@ -3,16 +3,25 @@
 #include <vulkan_device.hpp>
 #include <vulkan_utility.hpp>
 
+#include <vulkan/vulkan_core.h>
+
+#include <span>
+#include <vector>
+
 void vkrndr::create_descriptor_sets(vulkan_device const* const device,
     VkDescriptorSetLayout const layout,
     VkDescriptorPool const descriptor_pool,
     std::span<VkDescriptorSet> descriptor_sets)
 {
+    // Every allocated set needs its own layout entry
+    std::vector<VkDescriptorSetLayout> const layouts{descriptor_sets.size(),
+        layout};
+
     VkDescriptorSetAllocateInfo alloc_info{};
     alloc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
     alloc_info.descriptorPool = descriptor_pool;
     alloc_info.descriptorSetCount = count_cast(descriptor_sets.size());
-    alloc_info.pSetLayouts = &layout;
+    alloc_info.pSetLayouts = layouts.data();
 
     check_result(vkAllocateDescriptorSets(device->logical,
         &alloc_info,
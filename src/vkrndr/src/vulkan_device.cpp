@@ -5,17 +5,27 @@
 #include <vulkan_swap_chain.hpp>
 #include <vulkan_utility.hpp>
 
+#include <cppext_numeric.hpp>
 #include <cppext_pragma_warning.hpp>
 
 #include <vma_impl.hpp>
 
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
 #include <array>
+#include <cstddef>
 #include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
 #include <optional>
 #include <ranges>
 #include <set>
+#include <span>
 #include <stdexcept>
 #include <string_view>
+#include <system_error>
 #include <vector>
 
 // IWYU pragma: no_include <functional>
@@ -24,9 +34,209 @@
 namespace
 {
     constexpr std::array const device_extensions = {
-        VK_KHR_SWAPCHAIN_EXTENSION_NAME,
         VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME};
 
+    constexpr char const* pipeline_cache_file{"pipeline_cache.bin"};
+
+    // Value of an environment variable, empty when it isn't set
+    [[nodiscard]] std::filesystem::path environment_path(char const* name)
+    {
+#if defined(_WIN32)
+        char* value{nullptr};
+        size_t length{};
+        if (_dupenv_s(&value, &length, name) != 0 || value == nullptr)
+        {
+            return {};
+        }
+        std::filesystem::path rv{value};
+        free(value); // NOLINT(cppcoreguidelines-no-malloc)
+        return rv;
+#else
+        // NOLINTNEXTLINE(concurrency-mt-unsafe)
+        char const* const value{std::getenv(name)};
+        return value ? std::filesystem::path{value} : std::filesystem::path{};
+#endif
+    }
+
+    // Per user cache directory of the platform, the cache is shared by all
+    // working directories an application is started from. Falls back to the
+    // temporary directory.
+    [[nodiscard]] std::filesystem::path pipeline_cache_path()
+    {
+#if defined(_WIN32)
+        std::filesystem::path directory{environment_path("LOCALAPPDATA")};
+#else
+        std::filesystem::path directory{environment_path("XDG_CACHE_HOME")};
+        if (directory.empty())
+        {
+            if (std::filesystem::path const home{environment_path("HOME")};
+                !home.empty())
+            {
+                directory = home / ".cache";
+            }
+        }
+#endif
+        if (directory.empty())
+        {
+            std::error_code error;
+            directory = std::filesystem::temp_directory_path(error);
+        }
+
+        return directory / "vkrndr" / pipeline_cache_file;
+    }
+
+    // Prefix of the cache file, the driver validates its own header of the
+    // data but an older driver could reject the data without recompiling
+    struct [[nodiscard]] pipeline_cache_header final
+    {
+        std::array<char, 8> magic{'V', 'K', 'R', 'P', 'C', 'C', 'H', '\0'};
+        uint32_t vendor_id{};
+        uint32_t device_id{};
+        uint32_t driver_version{};
+        uint32_t data_size{};
+        std::array<uint8_t, VK_UUID_SIZE> cache_uuid{};
+    };
+
+    [[nodiscard]] pipeline_cache_header make_cache_header(
+        VkPhysicalDevice const device)
+    {
+        VkPhysicalDeviceProperties properties; // NOLINT
+        vkGetPhysicalDeviceProperties(device, &properties);
+
+        pipeline_cache_header rv;
+        rv.vendor_id = properties.vendorID;
+        rv.device_id = properties.deviceID;
+        rv.driver_version = properties.driverVersion;
+        std::ranges::copy(properties.pipelineCacheUUID, rv.cache_uuid.begin());
+        return rv;
+    }
+
+    [[nodiscard]] bool same_device(pipeline_cache_header const& lhs,
+        pipeline_cache_header const& rhs)
+    {
+        return lhs.magic == rhs.magic && lhs.vendor_id == rhs.vendor_id &&
+            lhs.device_id == rhs.device_id &&
+            lhs.driver_version == rhs.driver_version &&
+            lhs.cache_uuid == rhs.cache_uuid;
+    }
+
+    // Contents of the cache file, empty when it is missing or was written
+    // for a different device or driver
+    [[nodiscard]] std::vector<std::byte> read_pipeline_cache(
+        VkPhysicalDevice const device)
+    {
+        std::filesystem::path const path{pipeline_cache_path()};
+        std::ifstream file{path, std::ios::binary};
+        if (!file)
+        {
+            return {};
+        }
+
+        pipeline_cache_header header;
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+        if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+            !same_device(header, make_cache_header(device)))
+        {
+            spdlog::info("Ignoring pipeline cache of a different device");
+            return {};
+        }
+
+        std::error_code error;
+        auto const file_size{
+            std::filesystem::file_size(path, error)};
+        if (error || header.data_size > file_size - sizeof(header))
+        {
+            spdlog::info("Ignoring truncated pipeline cache");
+            return {};
+        }
+
+        std::vector<std::byte> rv(header.data_size);
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+        if (!file.read(reinterpret_cast<char*>(rv.data()),
+                static_cast<std::streamsize>(rv.size())))
+        {
+            spdlog::info("Ignoring truncated pipeline cache");
+            return {};
+        }
+
+        return rv;
+    }
+
+    void create_pipeline_cache(vkrndr::vulkan_device& device)
+    {
+        std::vector<std::byte> const data{
+            read_pipeline_cache(device.physical)};
+
+        VkPipelineCacheCreateInfo create_info{};
+        create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+        create_info.initialDataSize = data.size();
+        create_info.pInitialData = data.data();
+
+        vkrndr::check_result(vkCreatePipelineCache(device.logical,
+            &create_info,
+            nullptr,
+            &device.pipeline_cache));
+        device.pipeline_cache_loaded = data.size();
+    }
+
+    // Written to a temporary file first, other instances never see a
+    // partially written cache
+    void save_pipeline_cache(vkrndr::vulkan_device const& device)
+    {
+        size_t size{};
+        vkrndr::check_result(vkGetPipelineCacheData(device.logical,
+            device.pipeline_cache,
+            &size,
+            nullptr));
+
+        std::vector<std::byte> data(size);
+        vkrndr::check_result(vkGetPipelineCacheData(device.logical,
+            device.pipeline_cache,
+            &size,
+            data.data()));
+
+        pipeline_cache_header header{make_cache_header(device.physical)};
+        header.data_size = cppext::narrow<uint32_t>(size);
+
+        std::filesystem::path const path{pipeline_cache_path()};
+        std::filesystem::path temporary{path};
+        temporary += ".tmp";
+
+        std::error_code error;
+        std::filesystem::create_directories(path.parent_path(), error);
+
+        {
+            std::ofstream file{temporary, std::ios::binary | std::ios::trunc};
+            // NOLINTBEGIN(cppcoreguidelines-pro-type-reinterpret-cast)
+            file.write(reinterpret_cast<char const*>(&header), sizeof(header));
+            file.write(reinterpret_cast<char const*>(data.data()),
+                static_cast<std::streamsize>(size));
+            // NOLINTEND(cppcoreguidelines-pro-type-reinterpret-cast)
+            if (!file)
+            {
+                spdlog::warn("Unable to write pipeline cache");
+                return;
+            }
+        }
+
+        std::filesystem::rename(temporary, path, error);
+        if (error)
+        {
+            spdlog::warn("Unable to replace pipeline cache: {}",
+                error.message());
+        }
+    }
+
+    // Required only when presenting to a surface
+    constexpr std::array const swap_chain_extensions = {
+        VK_KHR_SWAPCHAIN_EXTENSION_NAME};
+
+    // Optional, enabled when the device supports all of them
+    constexpr std::array const ray_query_extensions = {
+        VK_KHR_ACCELERATION_STRUCTURE_EXTENSION_NAME,
+        VK_KHR_RAY_QUERY_EXTENSION_NAME,
+        VK_KHR_DEFERRED_HOST_OPERATIONS_EXTENSION_NAME};
+
     DISABLE_WARNING_PUSH
     DISABLE_WARNING_MISSING_FIELD_INITIALIZERS
     constexpr VkPhysicalDeviceFeatures device_features{
@@ -40,7 +250,8 @@ namespace
         .dynamicRendering = VK_TRUE};
     DISABLE_WARNING_POP
 
-    [[nodiscard]] bool extensions_supported(VkPhysicalDevice device)
+    [[nodiscard]] bool extensions_supported(VkPhysicalDevice device,
+        std::span<char const* const> const extensions)
     {
         uint32_t count{};
         vkEnumerateDeviceExtensionProperties(device, nullptr, &count, nullptr);
@@ -51,9 +262,8 @@ namespace
             &count,
             available_extensions.data());
 
-        std::set<std::string_view> required_extensions(
-            device_extensions.cbegin(),
-            device_extensions.cend());
+        std::set<std::string_view> required_extensions(extensions.begin(),
+            extensions.end());
         for (auto const& extension : available_extensions)
         {
             // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-array-to-pointer-decay)
@@ -63,11 +273,42 @@ namespace
         return required_extensions.empty();
     }
 
+    [[nodiscard]] bool ray_query_supported(VkPhysicalDevice device)
+    {
+        if (!extensions_supported(device, ray_query_extensions))
+        {
+            return false;
+        }
+
+        VkPhysicalDeviceRayQueryFeaturesKHR ray_query_features{};
+        ray_query_features.sType =
+            VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_RAY_QUERY_FEATURES_KHR;
+
+        VkPhysicalDeviceAccelerationStructureFeaturesKHR
+            acceleration_structure_features{};
+        acceleration_structure_features.sType =
+            VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ACCELERATION_STRUCTURE_FEATURES_KHR;
+        acceleration_structure_features.pNext = &ray_query_features;
+
+        VkPhysicalDeviceVulkan12Features features_12{};
+        features_12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+        features_12.pNext = &acceleration_structure_features;
+
+        VkPhysicalDeviceFeatures2 features{};
+        features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        features.pNext = &features_12;
+        vkGetPhysicalDeviceFeatures2(device, &features);
+
+        return features_12.bufferDeviceAddress == VK_TRUE &&
+            acceleration_structure_features.accelerationStructure == VK_TRUE &&
+            ray_query_features.rayQuery == VK_TRUE;
+    }
+
     [[nodiscard]] bool is_device_suitable(VkPhysicalDevice device,
         VkSurfaceKHR surface,
         vkrndr::queue_families& indices)
     {
-        if (!extensions_supported(device))
+        if (!extensions_supported(device, device_extensions))
         {
             return false;
         }
@@ -78,13 +319,22 @@ namespace
             return false;
         }
 
-        auto const swap_chain{
-            vkrndr::query_swap_chain_support(device, surface)};
-        bool const swap_chain_adequate = {!swap_chain.surface_formats.empty() &&
-            !swap_chain.present_modes.empty()};
-        if (!swap_chain_adequate)
+        if (surface != VK_NULL_HANDLE)
         {
-            return false;
+            if (!extensions_supported(device, swap_chain_extensions))
+            {
+                return false;
+            }
+
+            auto const swap_chain{
+                vkrndr::query_swap_chain_support(device, surface)};
+            bool const swap_chain_adequate = {
+                !swap_chain.surface_formats.empty() &&
+                !swap_chain.present_modes.empty()};
+            if (!swap_chain_adequate)
+            {
+                return false;
+            }
         }
 
         VkPhysicalDeviceFeatures supported_features; // NOLINT
@@ -155,9 +405,13 @@ vkrndr::vulkan_device vkrndr::create_device(vulkan_context const& context)
     auto const present_family{device_indices.present_family.value_or(0)};
     auto const transfer_family{
         device_indices.dedicated_transfer_family.value_or(present_family)};
+    auto const compute_family{
+        device_indices.dedicated_compute_family.value_or(present_family)};
 
     auto const priority{1.0f};
-    std::set<uint32_t> const unique_families{present_family, transfer_family};
+    std::set<uint32_t> const unique_families{present_family,
+        transfer_family,
+        compute_family};
     std::vector<VkDeviceQueueCreateInfo> queue_create_infos;
     for (uint32_t const family : unique_families)
     {
@@ -174,11 +428,59 @@ vkrndr::vulkan_device vkrndr::create_device(vulkan_context const& context)
     create_info.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
     create_info.queueCreateInfoCount = count_cast(queue_create_infos.size());
     create_info.pQueueCreateInfos = queue_create_infos.data();
+    rv.ray_query = ray_query_supported(rv.physical);
+
+    std::vector<char const*> extensions{device_extensions.cbegin(),
+        device_extensions.cend()};
+    if (context.surface != VK_NULL_HANDLE)
+    {
+        extensions.insert(extensions.cend(),
+            swap_chain_extensions.cbegin(),
+            swap_chain_extensions.cend());
+    }
+
+    VkPhysicalDeviceVulkan13Features features_13{device_13_features};
+
+    VkPhysicalDeviceVulkan12Features features_12{};
+    features_12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+    features_13.pNext = &features_12;
+
+    VkPhysicalDeviceAccelerationStructureFeaturesKHR
+        acceleration_structure_features{};
+    acceleration_structure_features.sType =
+        VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ACCELERATION_STRUCTURE_FEATURES_KHR;
+
+    VkPhysicalDeviceRayQueryFeaturesKHR ray_query_features{};
+    ray_query_features.sType =
+        VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_RAY_QUERY_FEATURES_KHR;
+
+    if (rv.ray_query)
+    {
+        extensions.insert(extensions.cend(),
+            ray_query_extensions.cbegin(),
+            ray_query_extensions.cend());
+
+        features_12.bufferDeviceAddress = VK_TRUE;
+        features_12.pNext = &acceleration_structure_features;
+        acceleration_structure_features.accelerationStructure = VK_TRUE;
+        acceleration_structure_features.pNext = &ray_query_features;
+        ray_query_features.rayQuery = VK_TRUE;
+    }
+
     create_info.enabledLayerCount = 0;
-    create_info.enabledExtensionCount = count_cast(device_extensions.size());
-    create_info.ppEnabledExtensionNames = device_extensions.data();
-    create_info.pEnabledFeatures = &device_features;
-    create_info.pNext = &device_13_features;
+    create_info.enabledExtensionCount = count_cast(extensions.size());
+    create_info.ppEnabledExtensionNames = extensions.data();
+    VkPhysicalDeviceFeatures supported_features; // NOLINT
+    vkGetPhysicalDeviceFeatures(rv.physical, &supported_features);
+
+    VkPhysicalDeviceFeatures features{device_features};
+    features.pipelineStatisticsQuery =
+        supported_features.pipelineStatisticsQuery;
+    rv.pipeline_statistics =
+        supported_features.pipelineStatisticsQuery == VK_TRUE;
+
+    create_info.pEnabledFeatures = &features;
+    create_info.pNext = &features_13;
 
     check_result(
         vkCreateDevice(*device_it, &create_info, nullptr, &rv.logical));
@@ -188,9 +490,15 @@ vkrndr::vulkan_device vkrndr::create_device(vulkan_context const& context)
     allocator_info.physicalDevice = rv.physical;
     allocator_info.device = rv.logical;
     allocator_info.vulkanApiVersion = VK_API_VERSION_1_3;
+    if (rv.ray_query)
+    {
+        allocator_info.flags |= VMA_ALLOCATOR_CREATE_BUFFER_DEVICE_ADDRESS_BIT;
+    }
 
     check_result(vmaCreateAllocator(&allocator_info, &rv.allocator));
 
+    create_pipeline_cache(rv);
+
     rv.queues.reserve(unique_families.size());
     for (uint32_t const family : unique_families)
     {
@@ -205,6 +513,11 @@ vkrndr::vulkan_device vkrndr::create_device(vulkan_context const& context)
         {
             rv.transfer_queue = &queue;
         }
+
+        if (queue.family == compute_family)
+        {
+            rv.compute_queue = &queue;
+        }
     }
 
     return rv;
@@ -214,6 +527,14 @@ void vkrndr::destroy(vulkan_device* const device)
 {
     if (device)
     {
+        if (device->pipeline_cache != VK_NULL_HANDLE)
+        {
+            save_pipeline_cache(*device);
+            vkDestroyPipelineCache(device->logical,
+                device->pipeline_cache,
+                nullptr);
+        }
+
         vmaDestroyAllocator(device->allocator);
         vkDestroyDevice(device->logical, nullptr);
     }
@@ -5,6 +5,11 @@
 
 #include <vma_impl.hpp>
 
+#include <vulkan/vulkan_core.h>
+
+#include <cstdint>
+#include <span>
+
 void vkrndr::destroy(vulkan_device const* device, vulkan_image* const image)
 {
     if (image)
@@ -21,7 +26,8 @@ vkrndr::vulkan_image vkrndr::create_image(vulkan_device const& device,
     VkFormat const format,
     VkImageTiling const tiling,
     VkImageUsageFlags const usage,
-    VkMemoryPropertyFlags const properties)
+    VkMemoryPropertyFlags const properties,
+    std::span<uint32_t const> const queue_families)
 {
     vulkan_image rv;
     rv.format = format;
@@ -39,7 +45,16 @@ vkrndr::vulkan_image vkrndr::create_image(vulkan_device const& device,
     image_info.tiling = tiling;
     image_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
     image_info.usage = usage;
-    image_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    if (queue_families.size() > 1)
+    {
+        image_info.sharingMode = VK_SHARING_MODE_CONCURRENT;
+        image_info.queueFamilyIndexCount = count_cast(queue_families.size());
+        image_info.pQueueFamilyIndices = queue_families.data();
+    }
+    else
+    {
+        image_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    }
     image_info.samples = samples;
     image_info.flags = 0;
 
@@ -95,7 +110,8 @@ vkrndr::vulkan_image vkrndr::create_image_and_view(vulkan_device const& device,
     VkImageTiling const tiling,
     VkImageUsageFlags const usage,
     VkMemoryPropertyFlags const properties,
-    VkImageAspectFlags const aspect_flags)
+    VkImageAspectFlags const aspect_flags,
+    std::span<uint32_t const> const queue_families)
 {
     vulkan_image rv{create_image(device,
         extent,
@@ -104,7 +120,8 @@ vkrndr::vulkan_image vkrndr::create_image_and_view(vulkan_device const& device,
         format,
         tiling,
         usage,
-        properties)};
+        properties,
+        queue_families)};
     rv.view =
         create_image_view(device, rv.image, format, aspect_flags, mip_levels);
     return rv;
@@ -68,6 +68,19 @@ void vkrndr::bind_pipeline(VkCommandBuffer command_buffer,
     vulkan_pipeline const& pipeline,
     uint32_t const first_set,
     std::span<VkDescriptorSet const> descriptor_sets)
+{
+    bind_pipeline(command_buffer,
+        pipeline,
+        first_set,
+        descriptor_sets,
+        std::span<uint32_t const>{});
+}
+
+void vkrndr::bind_pipeline(VkCommandBuffer command_buffer,
+    vulkan_pipeline const& pipeline,
+    uint32_t const first_set,
+    std::span<VkDescriptorSet const> descriptor_sets,
+    std::span<uint32_t const> dynamic_offsets)
 {
     if (!descriptor_sets.empty())
     {
@@ -77,8 +90,8 @@ void vkrndr::bind_pipeline(VkCommandBuffer command_buffer,
             first_set,
             count_cast(descriptor_sets.size()),
             descriptor_sets.data(),
-            0,
-            nullptr);
+            count_cast(dynamic_offsets.size()),
+            dynamic_offsets.data());
     }
 
     vkCmdBindPipeline(command_buffer, pipeline.type, pipeline.pipeline);
@@ -272,7 +285,7 @@ vkrndr::vulkan_pipeline vkrndr::vulkan_pipeline_builder::build()
 
     VkPipeline pipeline; // NOLINT
     check_result(vkCreateGraphicsPipelines(device_->logical,
-        VK_NULL_HANDLE,
+        device_->pipeline_cache,
         1,
         &create_info,
         nullptr,
@@ -475,6 +488,17 @@ vkrndr::vulkan_pipeline vkrndr::vulkan_compute_pipeline_builder::build()
     stage_info.module = shader_module_;
     stage_info.pName = shader_entry_point_.c_str();
 
+    VkSpecializationInfo specialization_info{};
+    if (!specialization_entries_.empty())
+    {
+        specialization_info.mapEntryCount =
+            count_cast(specialization_entries_.size());
+        specialization_info.pMapEntries = specialization_entries_.data();
+        specialization_info.dataSize = specialization_data_.size();
+        specialization_info.pData = specialization_data_.data();
+        stage_info.pSpecializationInfo = &specialization_info;
+    }
+
     VkComputePipelineCreateInfo create_info{};
     create_info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
     create_info.layout = *pipeline_layout_;
@@ -482,7 +506,7 @@ vkrndr::vulkan_pipeline vkrndr::vulkan_compute_pipeline_builder::build()
 
     VkPipeline pipeline; // NOLINT
     check_result(vkCreateComputePipelines(device_->logical,
-        nullptr,
+        device_->pipeline_cache,
         1,
         &create_info,
         nullptr,
@@ -508,6 +532,42 @@ vkrndr::vulkan_compute_pipeline_builder::with_shader(
     return *this;
 }
 
+vkrndr::vulkan_compute_pipeline_builder&
+vkrndr::vulkan_compute_pipeline_builder::add_specialization_constant(
+    uint32_t const constant_id,
+    uint32_t const value)
+{
+    VkSpecializationMapEntry const entry{.constantID = constant_id,
+        .offset = 0,
+        .size = sizeof(value)};
+
+    return with_specialization({.mapEntryCount = 1,
+        .pMapEntries = &entry,
+        .dataSize = sizeof(value),
+        .pData = &value});
+}
+
+vkrndr::vulkan_compute_pipeline_builder&
+vkrndr::vulkan_compute_pipeline_builder::with_specialization(
+    VkSpecializationInfo const& info)
+{
+    uint32_t const base{count_cast(specialization_data_.size())};
+
+    for (VkSpecializationMapEntry entry :
+        std::span{info.pMapEntries, info.mapEntryCount})
+    {
+        entry.offset += base;
+        specialization_entries_.push_back(entry);
+    }
+
+    auto const* const data{static_cast<std::byte const*>(info.pData)};
+    specialization_data_.insert(specialization_data_.end(),
+        data,
+        data + info.dataSize); // NOLINT
+
+    return *this;
+}
+
 void vkrndr::vulkan_compute_pipeline_builder::cleanup()
 {
     vkDestroyShaderModule(device_->logical,
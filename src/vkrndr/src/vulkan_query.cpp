@@ -0,0 +1,47 @@
+#include <vulkan_query.hpp>
+
+#include <vulkan_device.hpp>
+#include <vulkan_utility.hpp>
+
+#include <cstdint>
+#include <vector>
+
+VkQueryPool vkrndr::create_query_pool(vulkan_device const* const device,
+    VkQueryType const type,
+    uint32_t const count,
+    VkQueryPipelineStatisticFlags const statistics)
+{
+    VkQueryPoolCreateInfo pool_info{};
+    pool_info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    pool_info.queryType = type;
+    pool_info.queryCount = count;
+    pool_info.pipelineStatistics = statistics;
+
+    VkQueryPool rv; // NOLINT
+    check_result(
+        vkCreateQueryPool(device->logical, &pool_info, nullptr, &rv));
+
+    return rv;
+}
+
+float vkrndr::timestamp_period(vulkan_device const& device,
+    uint32_t const queue_family)
+{
+    uint32_t count{};
+    vkGetPhysicalDeviceQueueFamilyProperties(device.physical, &count, nullptr);
+
+    std::vector<VkQueueFamilyProperties> families{count};
+    vkGetPhysicalDeviceQueueFamilyProperties(device.physical,
+        &count,
+        families.data());
+
+    if (queue_family >= count || families[queue_family].timestampValidBits == 0)
+    {
+        return 0.0f;
+    }
+
+    VkPhysicalDeviceProperties properties; // NOLINT
+    vkGetPhysicalDeviceProperties(device.physical, &properties);
+
+    return properties.limits.timestampPeriod;
+}
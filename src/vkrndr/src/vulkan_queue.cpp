@@ -38,15 +38,36 @@ vkrndr::queue_families vkrndr::find_queue_families(
             (queue_family.queueFlags & VK_QUEUE_TRANSFER_BIT) != 0};
         auto const has_graphics{
             (queue_family.queueFlags & VK_QUEUE_GRAPHICS_BIT) != 0};
-        if (has_transfer && !has_graphics)
+        auto const has_compute{
+            (queue_family.queueFlags & VK_QUEUE_COMPUTE_BIT) != 0};
+        if (has_transfer && !has_graphics &&
+            !indices.dedicated_transfer_family)
         {
             indices.dedicated_transfer_family = index;
-            break;
+        }
+        if (has_compute && !has_graphics && !indices.dedicated_compute_family)
+        {
+            indices.dedicated_compute_family = index;
         }
         ++index;
     }
 
     index = 0;
+    if (surface == VK_NULL_HANDLE)
+    {
+        for (auto const& queue_family : queue_families)
+        {
+            if ((queue_family.queueFlags & VK_QUEUE_COMPUTE_BIT) != 0)
+            {
+                indices.present_family = index;
+                break;
+            }
+            ++index;
+        }
+
+        return indices;
+    }
+
     for (auto const& queue_family : queue_families)
     {
         if ((queue_family.queueFlags &
@@ -4,6 +4,7 @@
 #include <global_data.hpp>
 #include <gltf_manager.hpp>
 #include <imgui_render_layer.hpp>
+#include <vkrndr_gpu_profiler.hpp>
 #include <vkrndr_scene.hpp>
 #include <vulkan_buffer.hpp>
 #include <vulkan_commands.hpp>
@@ -23,6 +24,7 @@
 #include <stb_image.h>
 
 #include <array>
+#include <cstdint>
 #include <cstring>
 #include <span>
 #include <stdexcept>
@@ -43,18 +45,29 @@ namespace
         uniform_buffer_pool_size.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
         uniform_buffer_pool_size.descriptorCount = 3 * count;
 
+        VkDescriptorPoolSize dynamic_uniform_buffer_pool_size{};
+        dynamic_uniform_buffer_pool_size.type =
+            VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+        dynamic_uniform_buffer_pool_size.descriptorCount = count;
+
         VkDescriptorPoolSize storage_buffer_pool_size{};
         storage_buffer_pool_size.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-        storage_buffer_pool_size.descriptorCount = 6 * count;
+        storage_buffer_pool_size.descriptorCount = 7 * count;
 
         VkDescriptorPoolSize texture_sampler_pool_size{};
         texture_sampler_pool_size.type =
             VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
         texture_sampler_pool_size.descriptorCount = 2 * count;
 
+        VkDescriptorPoolSize storage_image_pool_size{};
+        storage_image_pool_size.type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        storage_image_pool_size.descriptorCount = 4 * count;
+
         std::array pool_sizes{uniform_buffer_pool_size,
+            dynamic_uniform_buffer_pool_size,
             storage_buffer_pool_size,
-            texture_sampler_pool_size};
+            texture_sampler_pool_size,
+            storage_image_pool_size};
 
         VkDescriptorPoolCreateInfo pool_info{};
         pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
@@ -78,14 +91,18 @@ vkrndr::vulkan_renderer::vulkan_renderer(vulkan_window* const window,
     , window_{window}
     , context_{vkrndr::create_context(window, debug)}
     , device_{vkrndr::create_device(context_)}
-    , swap_chain_{std::make_unique<vulkan_swap_chain>(window_,
-          &context_,
-          &device_,
-          &render_settings_)}
+    , swap_chain_{window_
+              ? std::make_unique<vulkan_swap_chain>(window_,
+                    &context_,
+                    &device_,
+                    &render_settings_)
+              : nullptr}
     , frame_data_{vulkan_swap_chain::max_frames_in_flight,
           vulkan_swap_chain::max_frames_in_flight}
     , descriptor_pool_{create_descriptor_pool(device_)}
-    , imgui_layer_enabled_{debug}
+    , imgui_layer_enabled_{debug && window_ != nullptr}
+    , profiler_{std::make_unique<gpu_profiler>(&device_,
+          count_cast(vulkan_swap_chain::max_frames_in_flight))}
     , font_manager_{std::make_unique<font_manager>()}
     , gltf_manager_{std::make_unique<gltf_manager>(this)}
 {
@@ -116,6 +133,7 @@ vkrndr::vulkan_renderer::vulkan_renderer(vulkan_window* const window,
 
 vkrndr::vulkan_renderer::~vulkan_renderer()
 {
+    profiler_.reset();
     imgui_layer_.reset();
 
     for (frame_data const& fd : frame_data_.as_span())
@@ -147,6 +165,11 @@ uint32_t vkrndr::vulkan_renderer::image_count() const
     return swap_chain_->image_count();
 }
 
+uint32_t vkrndr::vulkan_renderer::frames_in_flight() const
+{
+    return count_cast(vulkan_swap_chain::max_frames_in_flight);
+}
+
 VkExtent2D vkrndr::vulkan_renderer::extent() const
 {
     return swap_chain_->extent();
@@ -157,8 +180,10 @@ bool vkrndr::vulkan_renderer::imgui_layer() const
     return imgui_layer_enabled_;
 }
 
-void vkrndr::vulkan_renderer::imgui_layer(bool const state)
+void vkrndr::vulkan_renderer::imgui_layer(bool state)
 {
+    // ImGui draws to the swap chain
+    state = state && swap_chain_ != nullptr;
     if (state && !imgui_layer_)
     {
         imgui_layer_ = std::make_unique<imgui_render_layer>(window_,
@@ -169,6 +194,18 @@ void vkrndr::vulkan_renderer::imgui_layer(bool const state)
     imgui_layer_enabled_ = state;
 }
 
+void vkrndr::vulkan_renderer::wait_semaphore(VkSemaphore const semaphore,
+    VkPipelineStageFlags const stage)
+{
+    wait_semaphores_.push_back(semaphore);
+    wait_stages_.push_back(stage);
+}
+
+vkrndr::gpu_profiler* vkrndr::vulkan_renderer::profiler()
+{
+    return profiler_.get();
+}
+
 bool vkrndr::vulkan_renderer::begin_frame(scene* const scene)
 {
     if (swap_chain_refresh.load())
@@ -198,6 +235,8 @@ bool vkrndr::vulkan_renderer::begin_frame(scene* const scene)
     begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
     check_result(vkBeginCommandBuffer(primary_buffer, &begin_info));
 
+    profiler_->begin_frame(primary_buffer);
+
     if (imgui_layer_enabled_)
     {
         imgui_layer_->begin_frame();
@@ -235,16 +274,25 @@ void vkrndr::vulkan_renderer::draw(scene* const scene)
         .mip_levels = 0,
         .extent = extent()};
 
+    uint32_t const scene_scope{profiler_->begin_scope(command_buffer, "Scene")};
     scene->draw(target_image, command_buffer, extent());
+    profiler_->end_scope(command_buffer, scene_scope);
 
     if (imgui_layer_enabled_)
     {
         scene->draw_imgui();
+        profiler_->draw_imgui();
+        // ImGui command buffer is submitted last, it ends the frame
         VkCommandBuffer imgui_command_buffer{request_command_buffer(false)};
         imgui_layer_->draw(imgui_command_buffer,
             swap_chain_->image(image_index_),
             swap_chain_->image_view(image_index_),
-            extent());
+            extent(),
+            profiler_.get());
+    }
+    else
+    {
+        profiler_->end_frame(command_buffer);
     }
 
     check_result(vkEndCommandBuffer(command_buffer));
@@ -253,7 +301,11 @@ void vkrndr::vulkan_renderer::draw(scene* const scene)
         std::span{frame_data_->present_command_buffers.data(),
             frame_data_->used_present_command_buffers_},
         frame_data_.index(),
-        image_index_);
+        image_index_,
+        wait_semaphores_,
+        wait_stages_);
+    wait_semaphores_.clear();
+    wait_stages_.clear();
 }
 
 vkrndr::vulkan_image vkrndr::vulkan_renderer::load_texture(
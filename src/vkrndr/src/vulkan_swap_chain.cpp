@@ -11,12 +11,12 @@
 #include <vulkan_window.hpp>
 
 #include <algorithm>
-#include <array>
 #include <cstddef>
 #include <cstdint>
 #include <limits>
 #include <ranges>
 #include <span>
+#include <vector>
 
 // IWYU pragma: no_include <functional>
 
@@ -150,20 +150,26 @@ bool vkrndr::vulkan_swap_chain::acquire_next_image(size_t const current_frame,
 void vkrndr::vulkan_swap_chain::submit_command_buffers(
     std::span<VkCommandBuffer const> command_buffers,
     size_t const current_frame,
-    uint32_t const image_index)
+    uint32_t const image_index,
+    std::span<VkSemaphore const> const wait_semaphores,
+    std::span<VkPipelineStageFlags const> const wait_stages)
 {
     auto const& frame{frames_[current_frame]};
 
-    auto const* const wait_semaphores{&frame.image_available};
-    std::array<VkPipelineStageFlags, 1> const wait_stages{
+    std::vector<VkSemaphore> semaphores{frame.image_available};
+    semaphores.insert(semaphores.cend(),
+        wait_semaphores.begin(),
+        wait_semaphores.end());
+    std::vector<VkPipelineStageFlags> stages{
         VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
+    stages.insert(stages.cend(), wait_stages.begin(), wait_stages.end());
     auto const* const signal_semaphores{&frame.render_finished};
 
     VkSubmitInfo submit_info{};
     submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-    submit_info.waitSemaphoreCount = 1;
-    submit_info.pWaitSemaphores = wait_semaphores;
-    submit_info.pWaitDstStageMask = wait_stages.data();
+    submit_info.waitSemaphoreCount = count_cast(semaphores.size());
+    submit_info.pWaitSemaphores = semaphores.data();
+    submit_info.pWaitDstStageMask = stages.data();
     submit_info.commandBufferCount = count_cast(command_buffers.size());
     submit_info.pCommandBuffers = command_buffers.data();
     submit_info.signalSemaphoreCount = 1;
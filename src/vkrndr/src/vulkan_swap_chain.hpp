@@ -83,10 +83,14 @@ namespace vkrndr
         [[nodiscard]] bool acquire_next_image(size_t current_frame,
             uint32_t& image_index);
 
+        // Submission waits for the acquired image and for the given
+        // semaphores at their stages
         void submit_command_buffers(
             std::span<VkCommandBuffer const> command_buffers,
             size_t current_frame,
-            uint32_t image_index);
+            uint32_t image_index,
+            std::span<VkSemaphore const> wait_semaphores = {},
+            std::span<VkPipelineStageFlags const> wait_stages = {});
 
         void recreate();
 